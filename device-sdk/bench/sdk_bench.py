@@ -0,0 +1,462 @@
+#!/usr/bin/env python3
+"""
+atCloud365 cross-SDK benchmark
+
+Runs the output-device client of each SDK (C++ host build, Node.js, Python)
+against the same local stand-in server, one at a time, with the same
+workload, and prints one comparison table:
+
+  boot        process start to Socket.IO connect
+  cmd rtt     "output" app-cmd sent to the dev-data that reports the new
+              state, one command at a time
+  emit        a burst of "sync" app-cmds: dev-data received per second,
+              and how many of the requested dev-data came back
+  idle cpu    CPU use while connected and idle (pings only)
+  reconnect   server closes the connection to the next Socket.IO connect
+  memory      resident set at the end, and its peak
+  cpu / cmd   CPU time of the client over the rtt and emit phases, per
+              command
+
+The stand-in speaks plain HTTP and WebSocket (no TLS) on 127.0.0.1: the
+auth endpoint, the Engine.IO v4 handshake and pings, and Socket.IO
+connect. Only the Python standard library is needed. Each client runs as
+shipped, logging included, with its output sent to /dev/null.
+
+Usage:
+  python3 sdk_bench.py                      # every SDK that is set up
+  python3 sdk_bench.py --sdk cpp --commands 1000 --json result.json
+"""
+
+import argparse
+import asyncio
+import base64
+import glob
+import hashlib
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SDK_ROOT = os.path.dirname(HERE)
+WS_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+PING_INTERVAL_MS = 25000
+PING_TIMEOUT_MS = 20000
+CLK_TCK = os.sysconf("SC_CLK_TCK")
+
+
+# ==================================================
+# Stand-in Server
+# ==================================================
+class Session:
+    """One WebSocket connection from a device."""
+
+    def __init__(self, server, reader, writer):
+        self.server = server
+        self.reader = reader
+        self.writer = writer
+        self.sid = f"bench{server.next_sid}"
+        server.next_sid += 1
+
+    def send(self, text: str):
+        data = text.encode()
+        head = bytearray([0x81])
+        if len(data) < 126:
+            head.append(len(data))
+        elif len(data) < 65536:
+            head.append(126)
+            head += len(data).to_bytes(2, "big")
+        else:
+            head.append(127)
+            head += len(data).to_bytes(8, "big")
+        self.writer.write(bytes(head) + data)
+
+    def emit(self, event: str, data):
+        self.send("42" + json.dumps([event, data], separators=(",", ":")))
+
+    def abort(self):
+        self.writer.transport.abort()
+
+    async def read_frame(self):
+        head = await self.reader.readexactly(2)
+        fin = bool(head[0] & 0x80)
+        opcode = head[0] & 0x0F
+        length = head[1] & 0x7F
+        if length == 126:
+            length = int.from_bytes(await self.reader.readexactly(2), "big")
+        elif length == 127:
+            length = int.from_bytes(await self.reader.readexactly(8), "big")
+        mask = await self.reader.readexactly(4) if head[1] & 0x80 else None
+        payload = bytearray(await self.reader.readexactly(length))
+        if mask:
+            for i in range(len(payload)):
+                payload[i] ^= mask[i & 3]
+        return fin, opcode, bytes(payload)
+
+    async def run(self):
+        self.send("0" + json.dumps({"sid": self.sid, "upgrades": [], "pingInterval": PING_INTERVAL_MS,
+                                    "pingTimeout": PING_TIMEOUT_MS, "maxPayload": 1000000}))
+        pinger = asyncio.ensure_future(self.ping())
+        message = b""
+        try:
+            while True:
+                fin, opcode, payload = await self.read_frame()
+                if opcode == 0x8:
+                    break
+                if opcode == 0x9:
+                    self.writer.write(bytes([0x8A, len(payload)]) + payload)
+                    continue
+                if opcode not in (0x0, 0x1):
+                    continue
+                message += payload
+                if fin:
+                    self.handle(message.decode(errors="replace"))
+                    message = b""
+        except (asyncio.IncompleteReadError, ConnectionError):
+            pass
+        finally:
+            pinger.cancel()
+            self.writer.close()
+            self.server.event("close", self)
+
+    async def ping(self):
+        while True:
+            await asyncio.sleep(PING_INTERVAL_MS / 1000)
+            self.send("2")
+
+    def handle(self, text: str):
+        if text == "2":
+            self.send("3")
+        elif text.startswith("40"):
+            self.send("40" + json.dumps({"sid": self.sid + "-sio"}))
+            self.emit("connected", {})
+            self.server.session = self
+            self.server.event("connect", self)
+        elif text.startswith("42"):
+            try:
+                name, *args = json.loads(text[2:])
+            except (ValueError, TypeError):
+                return
+            self.server.event(name, args[0] if args else None)
+
+
+class StandIn:
+    """Auth endpoint and Socket.IO sessions on one port."""
+
+    def __init__(self):
+        self.events = asyncio.Queue()
+        self.session = None
+        self.next_sid = 1
+        self.port = 0
+
+    async def start(self):
+        server = await asyncio.start_server(self.accept, "127.0.0.1", 0)
+        self.port = server.sockets[0].getsockname()[1]
+        return server
+
+    def event(self, name, data):
+        self.events.put_nowait((time.monotonic(), name, data))
+
+    async def accept(self, reader, writer):
+        try:
+            head = (await reader.readuntil(b"\r\n\r\n")).decode(errors="replace")
+        except (asyncio.IncompleteReadError, asyncio.LimitOverrunError, ConnectionError):
+            writer.close()
+            return
+        lines = head.split("\r\n")
+        method, path = (lines[0].split(" ") + ["", ""])[:2]
+        headers = {}
+        for line in lines[1:]:
+            if ":" in line:
+                key, value = line.split(":", 1)
+                headers[key.strip().lower()] = value.strip()
+
+        if method == "POST" and path.startswith("/api/v3/devices/auth"):
+            await reader.readexactly(int(headers.get("content-length", "0")))
+            body = json.dumps({"token": "bench-token"}).encode()
+            writer.write(b"HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nConnection: close\r\n"
+                         b"Content-Length: %d\r\n\r\n%s" % (len(body), body))
+            await writer.drain()
+            writer.close()
+        elif headers.get("upgrade", "").lower() == "websocket" and "transport=websocket" in path:
+            accept = base64.b64encode(hashlib.sha1((headers["sec-websocket-key"] + WS_GUID).encode()).digest())
+            writer.write(b"HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                         b"Sec-WebSocket-Accept: " + accept + b"\r\n\r\n")
+            await Session(self, reader, writer).run()
+        else:
+            writer.write(b"HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\nConnection: close\r\n\r\n")
+            writer.close()
+
+    async def wait(self, match, timeout):
+        """The first event that match() accepts, or None after timeout s."""
+        deadline = time.monotonic() + timeout
+        while True:
+            left = deadline - time.monotonic()
+            if left <= 0:
+                return None
+            try:
+                at, name, data = await asyncio.wait_for(self.events.get(), left)
+            except asyncio.TimeoutError:
+                return None
+            if match(name, data):
+                return at, data
+
+    def flush(self):
+        while not self.events.empty():
+            self.events.get_nowait()
+
+
+# ==================================================
+# Clients
+# ==================================================
+def find_cpp_client():
+    """fw_net_output in the README's host build, else in any other build
+    directory under device-sdk/c/host (the newest wins)"""
+    host = os.path.join(SDK_ROOT, "c", "host")
+    documented = os.path.join(host, "build", "fw_net_output")
+    if os.path.exists(documented):
+        return documented
+    found = glob.glob(os.path.join(host, "*", "fw_net_output"))
+    return max(found, key=os.path.getmtime) if found else documented
+
+
+def cpp_client(args, url):
+    path = args.cpp or find_cpp_client()
+    if not os.path.exists(path):
+        return None, f"{path} not built (cmake -S . -B build && cmake --build build in device-sdk/c/host)"
+    return ([path, "--server", url], None, None), None
+
+
+def node_client(args, url):
+    root = os.path.join(SDK_ROOT, "nodejs", "output-device")
+    if not os.path.isdir(os.path.join(root, "node_modules", "socket.io-client")) or \
+            not os.path.exists(os.path.join(root, "dist", "index.js")):
+        return None, "run npm install && npm run build in nodejs/output-device"
+    env = dict(os.environ, DEVICE_SN="BENCH-NODE", CLIENT_SECRET_KEY="bench", SERVER_URL=url,
+               API_PATH="/api/dev/io/", DEVICE_AUTH_URI=url + "/api/v3/devices/auth")
+    return ([args.node, "dist/index.js"], env, root), None
+
+
+def python_client(args, url, workdir):
+    root = os.path.join(SDK_ROOT, "python", "output-device")
+    missing = subprocess.run([args.python, "-c", "import socketio, requests, websocket"],
+                             stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL).returncode
+    if missing:
+        return None, "pip install -r python/output-device/requirements.txt"
+    with open(os.path.join(root, "config.example.py")) as example:
+        config = example.read()
+    with open(os.path.join(workdir, "config.py"), "w") as out:
+        out.write(config + f'\nDEVICE_SN = "BENCH-PYTHON"\nSERVER_URL = "{url}"\n'
+                           f'SERVER_PORT = {url.rsplit(":", 1)[1]}\n'
+                           f'DEVICE_AUTH_URI = "{url}/api/v3/devices/auth"\n')
+    # config.py from workdir, not one the user may keep next to main.py
+    runner = "import runpy, sys; sys.path.insert(0, sys.argv[1]); runpy.run_path(sys.argv[2], run_name='__main__')"
+    return ([args.python, "-c", runner, workdir, os.path.join(root, "main.py")], None, workdir), None
+
+
+# ==================================================
+# Measurements
+# ==================================================
+def cpu_seconds(pid):
+    try:
+        with open(f"/proc/{pid}/stat") as f:
+            fields = f.read().rsplit(")", 1)[1].split()
+        return (int(fields[11]) + int(fields[12])) / CLK_TCK
+    except OSError:
+        return 0.0
+
+
+def memory_kb(pid):
+    out = {}
+    try:
+        with open(f"/proc/{pid}/status") as f:
+            for line in f:
+                if line.startswith(("VmRSS:", "VmHWM:")):
+                    out[line.split(":")[0]] = int(line.split()[1])
+    except OSError:
+        pass
+    return out.get("VmRSS", 0), out.get("VmHWM", 0)
+
+
+def pct(values, p):
+    if not values:
+        return None
+    values = sorted(values)
+    return values[min(len(values) - 1, int(p * len(values)))]
+
+
+async def bench(server, name, launch, args):
+    argv, env, cwd = launch
+    result = {"sdk": name}
+    server.flush()
+    log = tempfile.TemporaryFile()
+    started = time.monotonic()
+    proc = await asyncio.create_subprocess_exec(*argv, env=env, cwd=cwd, stdout=subprocess.DEVNULL, stderr=log)
+    try:
+        connected = await server.wait(lambda n, d: n == "connect", args.boot_timeout)
+        if not connected:
+            log.seek(0)
+            result["error"] = "no connect: " + log.read().decode(errors="replace").strip()[-200:]
+            return result
+        result["boot_ms"] = (connected[0] - started) * 1e3
+        await asyncio.sleep(1)
+        server.flush()
+
+        # Command round trip, one at a time
+        cpu_start = cpu_seconds(proc.pid)
+        state = [0, 0, 0]
+        rtt, lost = [], 0
+        for i in range(args.commands):
+            index = i % 3
+            state[index] ^= 1
+            sent = time.monotonic()
+            server.session.emit("app-cmd", {"operation": {"customCmd": "output", "fieldIndex": index,
+                                                          "fieldValue": state[index]}})
+            want = state[index]
+            reply = await server.wait(lambda n, d: n == "dev-data" and isinstance(d, dict) and
+                                      len(d.get("content", [])) > index and d["content"][index] == want,
+                                      args.cmd_timeout)
+            if reply:
+                rtt.append((reply[0] - sent) * 1e3)
+            else:
+                lost += 1
+        result.update(rtt_p50_ms=pct(rtt, 0.5), rtt_p99_ms=pct(rtt, 0.99), rtt_max_ms=pct(rtt, 1.0), lost=lost)
+
+        # Emit burst
+        await asyncio.sleep(1)
+        server.flush()
+        sent = time.monotonic()
+        for _ in range(args.burst):
+            server.session.emit("app-cmd", {"operation": {"customCmd": "sync"}})
+        received, last = 0, sent
+        while received < args.burst:
+            reply = await server.wait(lambda n, d: n == "dev-data", 2)
+            if not reply:
+                break
+            received, last = received + 1, reply[0]
+        result.update(emitted=received, emit_per_s=received / (last - sent) if received else 0)
+        cpu_busy = cpu_seconds(proc.pid) - cpu_start
+        result["cpu_ms_per_cmd"] = cpu_busy * 1e3 / (args.commands + args.burst)
+
+        # Idle
+        await asyncio.sleep(1)
+        cpu_start = cpu_seconds(proc.pid)
+        await asyncio.sleep(args.idle)
+        result["idle_cpu_pct"] = (cpu_seconds(proc.pid) - cpu_start) * 100 / args.idle
+
+        # Reconnect after the server drops the connection
+        reconnect = []
+        for _ in range(args.drops):
+            server.flush()
+            dropped = time.monotonic()
+            server.session.abort()
+            back = await server.wait(lambda n, d: n == "connect", args.reconnect_timeout)
+            if back:
+                reconnect.append(back[0] - dropped)
+            await asyncio.sleep(1)
+        result.update(reconnect_p50_s=pct(reconnect, 0.5), reconnect_max_s=pct(reconnect, 1.0),
+                      reconnects=len(reconnect))
+        result["rss_kb"], result["peak_rss_kb"] = memory_kb(proc.pid)
+        return result
+    finally:
+        if proc.returncode is None:
+            proc.terminate()
+            try:
+                await asyncio.wait_for(proc.wait(), 3)
+            except asyncio.TimeoutError:
+                proc.kill()
+                await proc.wait()
+        log.close()
+
+
+# ==================================================
+# Report
+# ==================================================
+ROWS = [
+    ("boot", "boot_ms", "{:.0f} ms"),
+    ("cmd rtt p50", "rtt_p50_ms", "{:.2f} ms"),
+    ("cmd rtt p99", "rtt_p99_ms", "{:.2f} ms"),
+    ("cmd rtt max", "rtt_max_ms", "{:.2f} ms"),
+    ("cmds lost", "lost", "{}"),
+    ("emit", "emit_per_s", "{:.0f} /s"),
+    ("emitted of burst", "emitted", "{}"),
+    ("cpu / cmd", "cpu_ms_per_cmd", "{:.3f} ms"),
+    ("idle cpu", "idle_cpu_pct", "{:.2f} %"),
+    ("reconnect p50", "reconnect_p50_s", "{:.2f} s"),
+    ("reconnect max", "reconnect_max_s", "{:.2f} s"),
+    ("rss", "rss_kb", "{:.1f} MB", 1 / 1024),
+    ("peak rss", "peak_rss_kb", "{:.1f} MB", 1 / 1024),
+]
+
+
+def report(results, args):
+    print(f"workload: {args.commands} output cmds one at a time, burst of {args.burst} sync, "
+          f"{args.idle:g} s idle, {args.drops} server drops")
+    width = 18
+    print(" " * 18 + "".join(f"{r['sdk']:>{width}}" for r in results))
+    for label, key, fmt, *scale in ROWS:
+        cells = []
+        for r in results:
+            value = r.get(key)
+            if "error" in r or value is None:
+                cells.append("-")
+            else:
+                cells.append(fmt.format(value * scale[0] if scale else value))
+        print(f"{label:<18}" + "".join(f"{c:>{width}}" for c in cells))
+    for r in results:
+        if "error" in r:
+            print(f"{r['sdk']}: {r['error']}")
+
+
+async def main():
+    parser = argparse.ArgumentParser(description="Benchmark the SDKs' output-device clients against one stand-in.")
+    parser.add_argument("--sdk", action="append", choices=["cpp", "node", "python"],
+                        help="SDK to run (repeatable; default all)")
+    parser.add_argument("--commands", type=int, default=200, help="app-cmds for the round trip (200)")
+    parser.add_argument("--burst", type=int, default=1000, help="sync app-cmds in the emit burst (1000)")
+    parser.add_argument("--idle", type=float, default=5, help="seconds of idle CPU measurement (5)")
+    parser.add_argument("--drops", type=int, default=3, help="server-side drops to time reconnects (3)")
+    parser.add_argument("--cmd-timeout", type=float, default=3, help="seconds before a command is lost (3)")
+    parser.add_argument("--boot-timeout", type=float, default=30)
+    parser.add_argument("--reconnect-timeout", type=float, default=60)
+    parser.add_argument("--cpp", help="fw_net_output of the host build (default: found under device-sdk/c/host)")
+    parser.add_argument("--node", default="node")
+    parser.add_argument("--python", default=sys.executable)
+    parser.add_argument("--json", help="also write the results here")
+    args = parser.parse_args()
+
+    standin = StandIn()
+    server = await standin.start()
+    url = f"http://127.0.0.1:{standin.port}"
+    results = []
+    with tempfile.TemporaryDirectory() as workdir:
+        for sdk in args.sdk or ["cpp", "node", "python"]:
+            if sdk == "cpp":
+                launch, skipped = cpp_client(args, url)
+            elif sdk == "node":
+                launch, skipped = node_client(args, url)
+            else:
+                launch, skipped = python_client(args, url, workdir)
+            if skipped:
+                if args.sdk:
+                    # Asked for by name: a missing client is an error, not a row
+                    print(f"[BENCH] {sdk}: {skipped}", file=sys.stderr)
+                    server.close()
+                    return 2
+                print(f"[BENCH] {sdk} skipped: {skipped}", file=sys.stderr)
+                results.append({"sdk": sdk, "error": "skipped: " + skipped})
+                continue
+            print(f"[BENCH] {sdk} ...", file=sys.stderr)
+            results.append(await bench(standin, sdk, launch, args))
+    server.close()
+    report(results, args)
+    if args.json:
+        with open(args.json, "w") as out:
+            json.dump(results, out, indent=2)
+    return 0 if all("error" not in r for r in results) else 1
+
+
+if __name__ == "__main__":
+    sys.exit(asyncio.run(main()))
@@ -0,0 +1,48 @@
+#include "bench_alloc.h"
+
+#include <cstdlib>
+#include <new>
+
+// Single-threaded benchmarks: plain counters
+static uint64_t allocations = 0;
+static uint64_t allocated = 0;
+
+namespace bench
+{
+    uint64_t allocCount() { return allocations; }
+    uint64_t allocBytes() { return allocated; }
+}
+
+void *operator new(size_t size)
+{
+    allocations++;
+    allocated += size;
+    if (void *p = malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+    free(p);
+}
@@ -0,0 +1,34 @@
+// Heap allocation counts for the firmware benchmarks. bench_alloc.cpp
+// replaces the global operator new/delete of the benchmark binaries, which
+// is where String, std::string and ArduinoJson's pool get their memory.
+#pragma once
+
+#include <cstdint>
+
+#include <benchmark/benchmark.h>
+
+namespace bench
+{
+    uint64_t allocCount();
+    uint64_t allocBytes();
+
+    // Counts from construction to report(), which adds allocs/op and
+    // bytes/op to the benchmark's counters
+    class AllocCounter
+    {
+    public:
+        AllocCounter() : count(allocCount()), bytes(allocBytes()) {}
+
+        void report(benchmark::State &state) const
+        {
+            state.counters["allocs/op"] =
+                benchmark::Counter((double)(allocCount() - count), benchmark::Counter::kAvgIterations);
+            state.counters["bytes/op"] =
+                benchmark::Counter((double)(allocBytes() - bytes), benchmark::Counter::kAvgIterations);
+        }
+
+    private:
+        uint64_t count;
+        uint64_t bytes;
+    };
+}
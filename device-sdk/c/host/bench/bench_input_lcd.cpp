@@ -0,0 +1,198 @@
+// Google Benchmark suite for input-device-lcd: the packet handler per
+// packet type, dev-data and auth payload building, and the LCD text and
+// dashboard paths against the simulated panel. Firmware sources are linked
+// unmodified; frames the firmware sends go to a WebSocket peer that drops
+// them. Each benchmark reports allocs/op and bytes/op next to the time.
+//
+// Built once per sensor count (bench_input_lcd, _s32, _s256). The sweep
+// builds (BENCH_SENSOR_SWEEP) only register what scales with SENSOR_COUNT.
+#include <benchmark/benchmark.h>
+
+#include <WiFi.h>
+
+#include "bench_alloc.h"
+#include "dev_log.h"
+#include "host.h"
+#include "lcd.h"
+#include "lcd_app.h"
+#include "main.h"
+
+#define STR_(x) #x
+#define STR(x) STR_(x)
+
+// Deferred log records pile up in the ring; drain them off the clock.
+// (State::iterations() does not advance inside the loop, hence the count.)
+static void drainLogs(benchmark::State &state, uint32_t &count)
+{
+    if ((++count & 63) == 0)
+    {
+        state.PauseTiming();
+        logDrain();
+        state.ResumeTiming();
+    }
+}
+
+// setup() without the blocking parts: WiFi up, a token, the socket open
+static void firmwareUp()
+{
+    static bool up = false;
+    if (up)
+        return;
+    up = true;
+
+    static host::WsPeer sink; // accepts and ignores everything
+    host::setSerialOutput(nullptr);
+    host::setWsPeer(&sink);
+    host::setHttpHandler([](const host::HttpRequest &)
+                         {
+        host::HttpResponse response;
+        response.code = 200;
+        response.body = "{\"token\":\"eyJhbGciOiJIUzI1NiJ9.bench.token\"}";
+        return response; });
+    logBegin();
+    setupMetrics();
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+    authToken = "eyJhbGciOiJIUzI1NiJ9.bench.token";
+    connectSocketIO();
+    socketIo.loop();
+    socketConnected = true;
+#ifndef BENCH_SENSOR_SWEEP
+    LCD::begin();
+    LCD::setRotation(2);
+    lcdUiInit();
+#endif
+}
+
+static void BM_handleSocketIOPacket(benchmark::State &state, const char *packet)
+{
+    firmwareUp();
+    const size_t length = strlen(packet);
+    uint32_t count = 0;
+    bench::AllocCounter allocs;
+    for (auto _ : state)
+    {
+        handleSocketIOPacket(packet, length);
+        drainLogs(state, count);
+    }
+    allocs.report(state);
+}
+
+#ifndef BENCH_SENSOR_SWEEP
+BENCHMARK_CAPTURE(BM_handleSocketIOPacket, open,
+                  "0{\"sid\":\"Lbo5JLzTotvW3g2LAAAA\",\"upgrades\":[],\"pingInterval\":25000,\"pingTimeout\":20000,"
+                  "\"maxPayload\":1000000}");
+BENCHMARK_CAPTURE(BM_handleSocketIOPacket, ping, "2");
+BENCHMARK_CAPTURE(BM_handleSocketIOPacket, pong, "3");
+BENCHMARK_CAPTURE(BM_handleSocketIOPacket, connect_ack, "40{\"sid\":\"NwE5JLzTotvW3g2LAAAB\"}");
+BENCHMARK_CAPTURE(BM_handleSocketIOPacket, time_ack, "4317[1771000123456]");
+BENCHMARK_CAPTURE(BM_handleSocketIOPacket, event_connected, "42[\"connected\",{}]");
+BENCHMARK_CAPTURE(BM_handleSocketIOPacket, unknown, "6");
+#endif
+BENCHMARK_CAPTURE(BM_handleSocketIOPacket, app_cmd_output,
+                  "42[\"app-cmd\",{\"operation\":{\"customCmd\":\"output\",\"fieldIndex\":1,\"fieldValue\":1}}]")
+    ->Name("BM_handleSocketIOPacket/app_cmd_output/sensors:" STR(SENSOR_COUNT));
+
+static void BM_emitDevData(benchmark::State &state)
+{
+    firmwareUp();
+    bench::AllocCounter allocs;
+    for (auto _ : state)
+        emitDevData();
+    allocs.report(state);
+}
+BENCHMARK(BM_emitDevData)->Name("BM_emitDevData/sensors:" STR(SENSOR_COUNT));
+
+// The whole request: payload, the HTTPClient shim (no latency) and parsing
+// the token out of the response
+static void BM_authenticateDevice(benchmark::State &state)
+{
+    firmwareUp();
+    uint32_t count = 0;
+    bench::AllocCounter allocs;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(authenticateDevice());
+        drainLogs(state, count);
+    }
+    allocs.report(state);
+}
+BENCHMARK(BM_authenticateDevice)->Name("BM_authenticateDevice/sensors:" STR(SENSOR_COUNT));
+
+#ifndef BENCH_SENSOR_SWEEP
+// Composition only: the recorded strips are flushed to the panel off the clock
+static void BM_lcdDrawText(benchmark::State &state)
+{
+    firmwareUp();
+    const uint8_t scale = (uint8_t)state.range(0);
+    uint32_t count = 0;
+    bench::AllocCounter allocs;
+    for (auto _ : state)
+    {
+        lcdDrawText("Sensor 2  ON", 8, 120, 0xFFFF, 0x0000, scale);
+        if ((++count & 15) == 0)
+        {
+            state.PauseTiming();
+            LCD::flush();
+            LCD::waitIdle();
+            state.ResumeTiming();
+        }
+    }
+    allocs.report(state);
+}
+BENCHMARK(BM_lcdDrawText)->ArgName("scale")->Arg(1)->Arg(2);
+
+static UiSnapshot dashboard()
+{
+    UiSnapshot s;
+    s.wifiConnected = true;
+    s.wifiRssi = -58;
+    s.socketConnected = true;
+    for (int i = 0; i < SENSOR_COUNT; i++)
+        s.sensors[i] = false;
+    s.dateText = "2026-02-13";
+    s.timeText = "10:24:30";
+    s.ip = IPAddress(192, 168, 0, 42);
+    return s;
+}
+
+// A full render including the flush into the simulated panel.
+// idle: nothing changed; clock: the time text changes every frame;
+// sensor: one sensor card (and its sparkline) flips every frame
+static void BM_lcdUiRender(benchmark::State &state, int change)
+{
+    firmwareUp();
+    lcdUiSetPage(UI_PAGE_DASHBOARD);
+    UiSnapshot ui = dashboard();
+    lcdUiRender(ui);
+    LCD::waitIdle();
+    static const char *const times[2] = {"10:24:30", "10:24:31"};
+    uint32_t count = 0;
+    bench::AllocCounter allocs;
+    for (auto _ : state)
+    {
+        if (change == 1)
+            ui.timeText = times[++count & 1];
+        else if (change == 2)
+            ui.sensors[0] = !ui.sensors[0];
+        lcdUiRender(ui);
+        LCD::waitIdle();
+    }
+    allocs.report(state);
+}
+BENCHMARK_CAPTURE(BM_lcdUiRender, idle, 0);
+BENCHMARK_CAPTURE(BM_lcdUiRender, clock, 1);
+BENCHMARK_CAPTURE(BM_lcdUiRender, sensor, 2);
+#endif
+
+int main(int argc, char **argv)
+{
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::AddCustomContext("firmware", "input-device-lcd");
+    benchmark::AddCustomContext("sensors", STR(SENSOR_COUNT));
+    benchmark::AddCustomContext("json", BENCH_JSON);
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,111 @@
+// Google Benchmark suite for output-device: the packet handler per packet
+// type, processAppCmd per command, dev-data and auth payload building.
+// Firmware sources are linked unmodified, DEBUG_PRINTF included (Serial
+// goes nowhere); frames the firmware sends go to a WebSocket peer that
+// drops them. Each benchmark reports allocs/op and bytes/op.
+#include <benchmark/benchmark.h>
+
+#include <WiFi.h>
+
+#include "bench_alloc.h"
+#include "host.h"
+#include "main.h"
+
+#define STR_(x) #x
+#define STR(x) STR_(x)
+
+// setup() without the blocking parts: WiFi up, a token, the socket open
+static void firmwareUp()
+{
+    static bool up = false;
+    if (up)
+        return;
+    up = true;
+
+    static host::WsPeer sink; // accepts and ignores everything
+    host::setSerialOutput(nullptr);
+    host::setWsPeer(&sink);
+    host::setHttpHandler([](const host::HttpRequest &)
+                         {
+        host::HttpResponse response;
+        response.code = 200;
+        response.body = "{\"token\":\"eyJhbGciOiJIUzI1NiJ9.bench.token\"}";
+        return response; });
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+    authToken = "eyJhbGciOiJIUzI1NiJ9.bench.token";
+    connectSocketIO();
+    webSocket.loop();
+    socketConnected = true;
+}
+
+static void BM_handleSocketIOPacket(benchmark::State &state, const char *packet)
+{
+    firmwareUp();
+    const size_t length = strlen(packet);
+    bench::AllocCounter allocs;
+    for (auto _ : state)
+        handleSocketIOPacket(packet, length);
+    allocs.report(state);
+}
+BENCHMARK_CAPTURE(BM_handleSocketIOPacket, open,
+                  "0{\"sid\":\"Lbo5JLzTotvW3g2LAAAA\",\"upgrades\":[],\"pingInterval\":25000,\"pingTimeout\":20000,"
+                  "\"maxPayload\":1000000}");
+BENCHMARK_CAPTURE(BM_handleSocketIOPacket, ping, "2");
+BENCHMARK_CAPTURE(BM_handleSocketIOPacket, pong, "3");
+BENCHMARK_CAPTURE(BM_handleSocketIOPacket, connect_ack, "40{\"sid\":\"NwE5JLzTotvW3g2LAAAB\"}");
+BENCHMARK_CAPTURE(BM_handleSocketIOPacket, event_connected, "42[\"connected\",{}]");
+BENCHMARK_CAPTURE(BM_handleSocketIOPacket, app_cmd_output,
+                  "42[\"app-cmd\",{\"operation\":{\"customCmd\":\"output\",\"fieldIndex\":1,\"fieldValue\":1}}]");
+BENCHMARK_CAPTURE(BM_handleSocketIOPacket, unknown, "6");
+
+static void BM_processAppCmd(benchmark::State &state, const char *operation)
+{
+    firmwareUp();
+    const String data = String("{\"operation\":") + operation + "}";
+    bench::AllocCounter allocs;
+    for (auto _ : state)
+        processAppCmd(data);
+    allocs.report(state);
+    setStateAll(false);
+}
+BENCHMARK_CAPTURE(BM_processAppCmd, output, "{\"customCmd\":\"output\",\"fieldIndex\":1,\"fieldValue\":1}");
+BENCHMARK_CAPTURE(BM_processAppCmd, output_all, "{\"customCmd\":\"output-all\",\"fieldValue\":1}");
+BENCHMARK_CAPTURE(BM_processAppCmd, blink, "{\"customCmd\":\"blinkLed\",\"fieldIndex\":2,\"fieldValue\":3}");
+BENCHMARK_CAPTURE(BM_processAppCmd, sync, "{\"customCmd\":\"sync\"}");
+BENCHMARK_CAPTURE(BM_processAppCmd, index_value, "{\"fieldIndex\":0,\"fieldValue\":1}");
+BENCHMARK_CAPTURE(BM_processAppCmd, unknown, "{\"customCmd\":\"no-such-cmd\",\"fieldIndex\":0}");
+
+static void BM_emitDevData(benchmark::State &state)
+{
+    firmwareUp();
+    bench::AllocCounter allocs;
+    for (auto _ : state)
+        emitDevData();
+    allocs.report(state);
+}
+BENCHMARK(BM_emitDevData)->Name("BM_emitDevData/sensors:" STR(SENSOR_COUNT));
+
+// The whole request: payload, the HTTPClient shim (no latency) and parsing
+// the token out of the response
+static void BM_authenticateDevice(benchmark::State &state)
+{
+    firmwareUp();
+    bench::AllocCounter allocs;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(authenticateDevice());
+    allocs.report(state);
+}
+BENCHMARK(BM_authenticateDevice)->Name("BM_authenticateDevice/sensors:" STR(SENSOR_COUNT));
+
+int main(int argc, char **argv)
+{
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::AddCustomContext("firmware", "output-device");
+    benchmark::AddCustomContext("sensors", STR(SENSOR_COUNT));
+    benchmark::AddCustomContext("json", BENCH_JSON);
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
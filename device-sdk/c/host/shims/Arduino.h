@@ -0,0 +1,186 @@
+// Host shim of the Arduino-ESP32 core subset used by the firmware sources.
+// Time is virtual: millis()/micros() only move when delay() is called or
+// the host harness advances the clock (see host.h).
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdarg>
+#include <string>
+#include <algorithm>
+
+#include "Esp.h"
+#include "esp_system.h"
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define INPUT_PULLDOWN 0x09
+
+#define IRAM_ATTR
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+using std::max;
+using std::min;
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+void ledcSetup(uint8_t channel, uint32_t freq, uint8_t resolution);
+void ledcAttachPin(uint8_t pin, uint8_t channel);
+void ledcWrite(uint8_t channel, uint32_t duty);
+
+bool psramFound();
+uint32_t getCpuFrequencyMhz();
+
+// Sets TZ; SNTP itself is driven by host::deliverSntp()
+void configTzTime(const char *tz, const char *server1, const char *server2 = nullptr, const char *server3 = nullptr);
+
+// ------------------------------------------------------------
+// String (std::string backed, Arduino semantics where they differ)
+// ------------------------------------------------------------
+class String
+{
+public:
+    String(const char *s = "") : str(s ? s : "") {}
+    String(const std::string &s) : str(s) {}
+    String(char c) : str(1, c) {}
+    String(int v) : str(std::to_string(v)) {}
+    String(unsigned int v) : str(std::to_string(v)) {}
+    String(long v) : str(std::to_string(v)) {}
+    String(unsigned long v) : str(std::to_string(v)) {}
+    String(long long v) : str(std::to_string(v)) {}
+    String(unsigned long long v) : str(std::to_string(v)) {}
+    String(double v, unsigned int decimals = 2);
+
+    const char *c_str() const { return str.c_str(); }
+    unsigned int length() const { return (unsigned int)str.size(); }
+    bool isEmpty() const { return str.empty(); }
+    void reserve(unsigned int size) { str.reserve(size); }
+
+    char charAt(unsigned int i) const { return i < str.size() ? str[i] : 0; }
+    char operator[](unsigned int i) const { return charAt(i); }
+
+    String &operator+=(const String &rhs)
+    {
+        str += rhs.str;
+        return *this;
+    }
+    String &operator+=(const char *rhs)
+    {
+        str += rhs ? rhs : "";
+        return *this;
+    }
+    String &operator+=(char c)
+    {
+        str += c;
+        return *this;
+    }
+    bool concat(const String &rhs)
+    {
+        str += rhs.str;
+        return true;
+    }
+    bool concat(const char *rhs, unsigned int len)
+    {
+        str.append(rhs, len);
+        return true;
+    }
+
+    bool operator==(const String &rhs) const { return str == rhs.str; }
+    bool operator==(const char *rhs) const { return str == (rhs ? rhs : ""); }
+    bool operator!=(const String &rhs) const { return str != rhs.str; }
+    bool operator!=(const char *rhs) const { return !(*this == rhs); }
+    bool operator<(const String &rhs) const { return str < rhs.str; }
+    bool equals(const String &rhs) const { return str == rhs.str; }
+
+    int indexOf(char c, unsigned int from = 0) const;
+    int indexOf(const String &s, unsigned int from = 0) const;
+    bool startsWith(const String &prefix) const { return str.compare(0, prefix.str.size(), prefix.str) == 0; }
+    bool endsWith(const String &suffix) const;
+    String substring(unsigned int begin) const { return begin < str.size() ? String(str.substr(begin)) : String(); }
+    String substring(unsigned int begin, unsigned int end) const;
+    void replace(const String &find, const String &with);
+    void remove(unsigned int index, unsigned int count = (unsigned int)-1);
+    void trim();
+    void toUpperCase();
+    void toLowerCase();
+    long toInt() const { return strtol(str.c_str(), nullptr, 10); }
+    float toFloat() const { return strtof(str.c_str(), nullptr); }
+
+    // ArduinoJson writes into String through these
+    size_t write(uint8_t c)
+    {
+        str += (char)c;
+        return 1;
+    }
+    size_t write(const uint8_t *buf, size_t n)
+    {
+        str.append((const char *)buf, n);
+        return n;
+    }
+
+    const std::string &std() const { return str; }
+
+private:
+    std::string str;
+};
+
+String operator+(const String &lhs, const String &rhs);
+String operator+(const String &lhs, const char *rhs);
+String operator+(const char *lhs, const String &rhs);
+String operator+(const String &lhs, char rhs);
+
+// ------------------------------------------------------------
+// Serial
+// ------------------------------------------------------------
+class HardwareSerial;
+
+class Printable
+{
+public:
+    virtual ~Printable() = default;
+    virtual size_t printTo(HardwareSerial &out) const = 0;
+};
+
+class HardwareSerial
+{
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    size_t print(const char *s);
+    size_t print(const String &s) { return print(s.c_str()); }
+    size_t print(char c);
+    size_t print(int v) { return printf("%d", v); }
+    size_t print(unsigned int v) { return printf("%u", v); }
+    size_t print(long v) { return printf("%ld", v); }
+    size_t print(unsigned long v) { return printf("%lu", v); }
+    size_t print(double v) { return printf("%.2f", v); }
+    size_t print(const Printable &p) { return p.printTo(*this); }
+    template <typename T>
+    size_t println(const T &v)
+    {
+        size_t n = print(v);
+        return n + print("\n");
+    }
+    size_t println() { return print("\n"); }
+    size_t printf(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+    size_t write(const uint8_t *data, size_t length);
+    int available() { return 0; }
+    int read() { return -1; }
+};
+
+extern HardwareSerial Serial;
@@ -0,0 +1,18 @@
+// Host shim of the Arduino-ESP32 EspClass subset used by the firmware.
+#pragma once
+
+#include <cstdint>
+
+class EspClass
+{
+public:
+    // Throws host::Restart, so a harness can catch the reboot and start the
+    // firmware again (see host.h)
+    [[noreturn]] void restart();
+    uint32_t getCycleCount();
+    uint32_t getCpuFreqMHz() { return 240; }
+    uint32_t getFreeHeap();
+    uint32_t getMaxAllocHeap();
+};
+
+extern EspClass ESP;
@@ -0,0 +1,41 @@
+// Host shim of the Arduino-ESP32 HTTPClient subset used by the firmware.
+// Requests go to the handler set with host::setHttpHandler(); without one
+// every request fails with HTTPC_ERROR_CONNECTION_REFUSED.
+#pragma once
+
+#include "Arduino.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#define HTTP_CODE_OK 200
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+class HTTPClient
+{
+public:
+    bool begin(const String &url)
+    {
+        requestUrl = url.std();
+        headers.clear();
+        body.clear();
+        return true;
+    }
+    void end() {}
+    void setTimeout(uint16_t ms) { timeoutMs = ms; }
+    void addHeader(const String &name, const String &value) { headers.emplace_back(name.std(), value.std()); }
+
+    int GET();
+    int POST(const String &payload);
+    String getString() { return String(body); }
+
+private:
+    int send(const char *method, const std::string &payload);
+
+    std::string requestUrl;
+    std::vector<std::pair<std::string, std::string>> headers;
+    std::string body;
+    uint16_t timeoutMs = 5000;
+};
@@ -0,0 +1,263 @@
+// Host shim of the LovyanGFX subset used by input-device-lcd/src/lcd.cpp.
+//
+// Drawing goes to SimPanel as address windows, the way Panel_ST7789 does
+// on the device: each primitive is one transaction of CASET/PASET/RAMWR
+// followed by pixel data. Rotation is recorded but not applied, so the
+// simulated framebuffer is in logical (drawing) coordinates. DMA pushes
+// complete immediately.
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "sim_panel.h"
+
+#define VSPI_HOST 2
+#define HSPI_HOST 1
+#ifndef SPI_DMA_CH_AUTO
+#define SPI_DMA_CH_AUTO 3
+#endif
+
+namespace lgfx
+{
+    // Native-endian RGB565
+    struct rgb565_t
+    {
+        uint16_t raw;
+    };
+    // RGB565 stored byte-swapped (wire order)
+    struct swap565_t
+    {
+        uint16_t raw;
+    };
+
+    class Bus_SPI
+    {
+    public:
+        struct config_t
+        {
+            int spi_host = VSPI_HOST;
+            uint32_t freq_write = 16000000;
+            uint32_t freq_read = 8000000;
+            int pin_sclk = -1;
+            int pin_mosi = -1;
+            int pin_miso = -1;
+            int pin_dc = -1;
+            int dma_channel = 0;
+            uint8_t spi_mode = 0;
+            bool spi_3wire = true;
+            bool use_lock = true;
+        };
+
+        const config_t &config() const { return cfg; }
+        void config(const config_t &c)
+        {
+            cfg = c;
+            SimPanel::get().setClockHz(cfg.freq_write);
+        }
+        bool init() { return true; }
+        void release() {}
+
+    private:
+        config_t cfg;
+    };
+
+    class Panel_ST7789P3
+    {
+    public:
+        struct config_t
+        {
+            int pin_cs = -1;
+            int pin_rst = -1;
+            int pin_busy = -1;
+            uint16_t panel_width = 240;
+            uint16_t panel_height = 320;
+            uint8_t offset_rotation = 0;
+            int16_t offset_x = 0;
+            int16_t offset_y = 0;
+            bool rgb_order = false;
+            bool readable = true;
+            bool invert = false;
+            bool bus_shared = true;
+        };
+
+        const config_t &config() const { return cfg; }
+        void config(const config_t &c) { cfg = c; }
+        void setBus(Bus_SPI *b) { bus = b; }
+
+    private:
+        config_t cfg;
+        Bus_SPI *bus = nullptr;
+    };
+
+    class LGFX_Device
+    {
+    public:
+        virtual ~LGFX_Device() {}
+
+        bool init() { return true; }
+        void setPanel(Panel_ST7789P3 *p) { panel = p; }
+        void setSwapBytes(bool swap) { swapBytes = swap; }
+        void setRotation(uint8_t r)
+        {
+            rotation = r & 3;
+            SimPanel::get().setRotation(rotation);
+        }
+        uint8_t getRotation() const { return rotation; }
+        int32_t width() const { return SimPanel::WIDTH; }
+        int32_t height() const { return SimPanel::HEIGHT; }
+
+        void startWrite() { ++writeDepth; }
+        void endWrite()
+        {
+            if (writeDepth > 0)
+                --writeDepth;
+        }
+        void waitDMA() {}
+
+        void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color)
+        {
+            if (!clip(x, y, w, h))
+                return;
+            window(x, y, w, h);
+            SimPanel::get().fillPixels(color, (size_t)w * h);
+        }
+        void fillScreen(uint16_t color) { fillRect(0, 0, SimPanel::WIDTH, SimPanel::HEIGHT, color); }
+        void drawPixel(int32_t x, int32_t y, uint16_t color) { fillRect(x, y, 1, 1, color); }
+        void drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color)
+        {
+            fillRect(x, y, w, 1, color);
+            fillRect(x, y + h - 1, w, 1, color);
+            fillRect(x, y + 1, 1, h - 2, color);
+            fillRect(x + w - 1, y + 1, 1, h - 2, color);
+        }
+
+        // Raw command and parameter bytes, each command its own transaction
+        void writeCommand(uint_fast16_t cmd)
+        {
+            const uint8_t b = (uint8_t)cmd;
+            SimPanel::get().beginTransaction();
+            SimPanel::get().write(false, &b, 1);
+        }
+        void writeData(uint_fast8_t data)
+        {
+            const uint8_t b = (uint8_t)data;
+            SimPanel::get().write(true, &b, 1);
+        }
+
+        void setAddrWindow(int32_t x, int32_t y, int32_t w, int32_t h) { window(x, y, w, h); }
+        void writePixels(const rgb565_t *data, int32_t len)
+        {
+            SimPanel::get().pushPixels(reinterpret_cast<const uint16_t *>(data), (size_t)len);
+        }
+        void writePixels(const swap565_t *data, int32_t len)
+        {
+            for (int32_t i = 0; i < len; ++i)
+            {
+                const uint16_t c = (uint16_t)((data[i].raw >> 8) | (data[i].raw << 8));
+                SimPanel::get().pushPixels(&c, 1);
+            }
+        }
+
+        template <typename T>
+        void readRect(int32_t x, int32_t y, int32_t w, int32_t h, T *data)
+        {
+            static_assert(sizeof(T) == 2, "RGB565 readback only");
+            if (!data || w <= 0 || h <= 0)
+                return;
+            SimPanel::get().readPixels(x, y, w, h, reinterpret_cast<uint16_t *>(data));
+            for (int32_t i = 0; i < w * h; ++i)
+                toNative(data[i]);
+        }
+
+        template <typename T>
+        void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const T *data)
+        {
+            pushRows(x, y, w, h, data);
+        }
+        template <typename T>
+        void pushImageDMA(int32_t x, int32_t y, int32_t w, int32_t h, const T *data)
+        {
+            pushRows(x, y, w, h, data);
+        }
+
+    private:
+        static void toNative(rgb565_t &) {}
+        static void toNative(swap565_t &c) { c.raw = (uint16_t)((c.raw >> 8) | (c.raw << 8)); }
+
+        static bool clip(int32_t &x, int32_t &y, int32_t &w, int32_t &h)
+        {
+            if (x < 0)
+            {
+                w += x;
+                x = 0;
+            }
+            if (y < 0)
+            {
+                h += y;
+                y = 0;
+            }
+            if (x + w > SimPanel::WIDTH)
+                w = SimPanel::WIDTH - x;
+            if (y + h > SimPanel::HEIGHT)
+                h = SimPanel::HEIGHT - y;
+            return w > 0 && h > 0;
+        }
+
+        void window(int32_t x, int32_t y, int32_t w, int32_t h)
+        {
+            SimPanel::get().beginTransaction();
+            SimPanel::get().setWindow(x, y, w, h);
+        }
+
+        template <typename T>
+        void pushRows(int32_t x, int32_t y, int32_t w, int32_t h, const T *data)
+        {
+            int32_t cx = x, cy = y, cw = w, ch = h;
+            if (!data || !clip(cx, cy, cw, ch))
+                return;
+            window(cx, cy, cw, ch);
+            for (int32_t row = 0; row < ch; ++row)
+                writePixels(data + (size_t)(cy - y + row) * w + (cx - x), cw);
+        }
+
+        Panel_ST7789P3 *panel = nullptr;
+        bool swapBytes = false;
+        uint8_t rotation = 0;
+        int writeDepth = 0;
+    };
+
+    class LGFX_Sprite
+    {
+    public:
+        explicit LGFX_Sprite(LGFX_Device *parent = nullptr) { (void)parent; }
+        ~LGFX_Sprite() { deleteSprite(); }
+
+        void setColorDepth(int bits) { (void)bits; }
+        void setPsram(bool enabled) { psram = enabled; }
+        void *createSprite(int32_t w, int32_t h)
+        {
+            deleteSprite();
+            buffer = (uint16_t *)calloc((size_t)w * h, sizeof(uint16_t));
+            width = buffer ? w : 0;
+            height = buffer ? h : 0;
+            return buffer;
+        }
+        void deleteSprite()
+        {
+            free(buffer);
+            buffer = nullptr;
+            width = height = 0;
+        }
+        void *getBuffer() { return buffer; }
+
+    private:
+        uint16_t *buffer = nullptr;
+        int32_t width = 0;
+        int32_t height = 0;
+        bool psram = false;
+    };
+}
+
+using lgfx::LGFX_Sprite;
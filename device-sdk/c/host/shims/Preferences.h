@@ -0,0 +1,64 @@
+// Host shim of the Arduino-ESP32 Preferences (NVS) API. Values live in
+// memory for the life of the process; host::clearPreferences() wipes them.
+#pragma once
+
+#include "Arduino.h"
+
+#include <map>
+#include <string>
+
+namespace host
+{
+    std::map<std::string, std::string> &preferencesStore();
+    void clearPreferences();
+}
+
+class Preferences
+{
+public:
+    bool begin(const char *name, bool readOnly = false)
+    {
+        ns = name ? name : "";
+        ro = readOnly;
+        return true;
+    }
+    void end() { ns.clear(); }
+
+    bool isKey(const char *key) { return host::preferencesStore().count(path(key)) != 0; }
+    bool remove(const char *key) { return !ro && host::preferencesStore().erase(path(key)) != 0; }
+    bool clear();
+
+    size_t putUInt(const char *key, uint32_t value) { return put(key, std::to_string(value)) ? 4 : 0; }
+    uint32_t getUInt(const char *key, uint32_t defaultValue = 0)
+    {
+        std::string v;
+        return get(key, v) ? (uint32_t)strtoul(v.c_str(), nullptr, 10) : defaultValue;
+    }
+    size_t putString(const char *key, const String &value) { return put(key, value.std()) ? value.length() : 0; }
+    String getString(const char *key, const String &defaultValue = String())
+    {
+        std::string v;
+        return get(key, v) ? String(v) : defaultValue;
+    }
+
+private:
+    std::string path(const char *key) const { return ns + "/" + (key ? key : ""); }
+    bool put(const char *key, const std::string &value)
+    {
+        if (ro || ns.empty())
+            return false;
+        host::preferencesStore()[path(key)] = value;
+        return true;
+    }
+    bool get(const char *key, std::string &value)
+    {
+        auto it = host::preferencesStore().find(path(key));
+        if (ns.empty() || it == host::preferencesStore().end())
+            return false;
+        value = it->second;
+        return true;
+    }
+
+    std::string ns;
+    bool ro = false;
+};
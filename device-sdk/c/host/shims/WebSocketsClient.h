@@ -0,0 +1,74 @@
+// Host shim of the arduinoWebSockets client API used by the firmware.
+//
+// There is no network: the server side is a host::WsPeer (host.h) that
+// accepts connections and receives the frames the firmware sends, and
+// frames for the firmware are queued with host::wsPush(). Everything is
+// delivered from loop(), on the virtual clock, as the library delivers
+// events from its loop(). Any number of clients may be connected; the
+// single-client host:: calls address the last one to call begin().
+#pragma once
+
+#include <functional>
+#include <map>
+
+#include "Arduino.h"
+
+typedef enum
+{
+    WStype_ERROR,
+    WStype_DISCONNECTED,
+    WStype_CONNECTED,
+    WStype_TEXT,
+    WStype_BIN,
+    WStype_FRAGMENT_TEXT_START,
+    WStype_FRAGMENT_BIN_START,
+    WStype_FRAGMENT,
+    WStype_FRAGMENT_FIN,
+    WStype_PING,
+    WStype_PONG,
+} WStype_t;
+
+class WebSocketsClient
+{
+public:
+    // std::function as in the library's non-AVR builds
+    typedef std::function<void(WStype_t type, uint8_t *payload, size_t length)> WebSocketClientEvent;
+
+    ~WebSocketsClient();
+
+    void begin(const char *host, uint16_t port, const char *url = "/", const char *protocol = "arduino");
+    void beginSSL(const char *host, uint16_t port, const char *url = "/", const char *fingerprint = "",
+                  const char *protocol = "arduino")
+    {
+        (void)fingerprint;
+        begin(host, port, url, protocol);
+    }
+    void onEvent(WebSocketClientEvent cbEvent) { eventCb = cbEvent; }
+    void setReconnectInterval(unsigned long ms) { reconnectMs = ms; }
+    void loop();
+    bool sendTXT(const char *payload, size_t length = 0);
+    bool sendTXT(const String &payload) { return sendTXT(payload.c_str(), payload.length()); }
+    void disconnect();
+    bool isConnected() const { return connected; }
+    // Host only: see host::wsPush(), host::wsDrop(), host::wsNextEventMicros()
+    void hostPush(const std::string &text, uint64_t atMicros);
+    void hostDrop();
+    uint64_t nextEventMicros() const;
+
+protected:
+    WebSocketClientEvent eventCb = nullptr;
+
+private:
+    void event(WStype_t type, const char *payload, size_t length);
+    void close();
+
+    std::string serverHost;
+    uint16_t port = 0;
+    std::string url;
+    bool started = false;
+    bool connected = false;
+    unsigned long reconnectMs = 500;
+    uint64_t nextAttemptUs = 0;
+    bool dropPending = false;
+    std::multimap<uint64_t, std::pair<uint64_t, std::string>> inbox; // due time -> (seq, text)
+};
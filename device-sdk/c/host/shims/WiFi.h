@@ -0,0 +1,56 @@
+// Host shim of the Arduino-ESP32 WiFi API subset used by the firmware.
+#pragma once
+
+#include "Arduino.h"
+
+class IPAddress : public Printable
+{
+public:
+    IPAddress() : octets{0, 0, 0, 0} {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : octets{a, b, c, d} {}
+
+    uint8_t operator[](int i) const { return octets[i & 3]; }
+    bool operator==(const IPAddress &rhs) const { return memcmp(octets, rhs.octets, 4) == 0; }
+    String toString() const;
+    size_t printTo(HardwareSerial &out) const override { return out.print(toString()); }
+
+private:
+    uint8_t octets[4];
+};
+
+typedef enum
+{
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED = 6,
+} wl_status_t;
+
+typedef enum
+{
+    WIFI_OFF = 0,
+    WIFI_STA = 1,
+    WIFI_AP = 2,
+    WIFI_AP_STA = 3,
+} wifi_mode_t;
+
+// Association follows host::setWifi(): begin() connects at once when the
+// access point is up, and the link drops whenever the harness takes it down.
+class WiFiClass
+{
+public:
+    bool mode(wifi_mode_t m)
+    {
+        (void)m;
+        return true;
+    }
+    wl_status_t begin(const char *ssid, const char *passphrase = nullptr);
+    bool disconnect(bool wifiOff = false);
+    wl_status_t status();
+    IPAddress localIP();
+    int8_t RSSI();
+};
+
+extern WiFiClass WiFi;
@@ -0,0 +1,445 @@
+// Host implementations of the Arduino core, WiFi value types and ESP-IDF
+// GPIO shims.
+#include "Arduino.h"
+#include "Preferences.h"
+#include "WiFi.h"
+#include "driver/gpio.h"
+#include "esp_heap_caps.h"
+#include "esp_sntp.h"
+#include "esp_timer.h"
+#include "freertos/task.h"
+#include "host.h"
+#include "mbedtls/base64.h"
+
+#include <cctype>
+#include <chrono>
+#include <ctime>
+
+static uint64_t virtualMicros = 0;
+static FILE *serialOut = stdout;
+static bool psramPresent = false;
+static uint8_t pinLevels[64];
+static int8_t pinInputs[64]; // level driven by the harness, -1 for none
+static int lastLevel = 0;
+static std::function<void(uint8_t, int)> gpioWriteHook;
+static uint32_t randomState = 0x9E3779B9;
+static uint32_t heapFree = 200 * 1024;
+static uint32_t heapBlock = 110 * 1024;
+static sntp_sync_time_cb_t sntpCallback = nullptr;
+
+HardwareSerial Serial;
+EspClass ESP;
+
+static struct PinInputsInit
+{
+    PinInputsInit() { memset(pinInputs, -1, sizeof(pinInputs)); }
+} pinInputsInit;
+
+// ------------------------------------------------------------
+// host:: control surface
+// ------------------------------------------------------------
+namespace host
+{
+    uint64_t nowMicros() { return virtualMicros; }
+    void setMicros(uint64_t us) { virtualMicros = us; }
+    void advanceMicros(uint64_t us) { virtualMicros += us; }
+    void setSerialOutput(FILE *out) { serialOut = out; }
+
+    void deliverSntp(int64_t unixMicros)
+    {
+        if (!sntpCallback)
+            return;
+        struct timeval tv;
+        tv.tv_sec = (time_t)(unixMicros / 1000000);
+        tv.tv_usec = (suseconds_t)(unixMicros % 1000000);
+        sntpCallback(&tv);
+    }
+    void setPsram(bool present) { psramPresent = present; }
+    int lastGpioLevel() { return lastLevel; }
+    int gpioLevel(uint8_t pin) { return pin < sizeof(pinLevels) ? pinLevels[pin] : 0; }
+
+    void setGpioInput(uint8_t pin, int level)
+    {
+        if (pin < sizeof(pinInputs))
+            pinInputs[pin] = level ? HIGH : LOW;
+    }
+    void releaseGpioInput(uint8_t pin)
+    {
+        if (pin < sizeof(pinInputs))
+            pinInputs[pin] = -1;
+    }
+    void setGpioWriteHook(std::function<void(uint8_t pin, int level)> hook) { gpioWriteHook = std::move(hook); }
+
+    void seedRandom(uint32_t seed) { randomState = seed ? seed : 1; }
+    void setHeap(uint32_t freeBytes, uint32_t largestBlock)
+    {
+        heapFree = freeBytes;
+        heapBlock = largestBlock;
+    }
+
+    std::map<std::string, std::string> &preferencesStore()
+    {
+        static std::map<std::string, std::string> store;
+        return store;
+    }
+    void clearPreferences() { preferencesStore().clear(); }
+}
+
+bool Preferences::clear()
+{
+    if (ro || ns.empty())
+        return false;
+    auto &store = host::preferencesStore();
+    const std::string prefix = ns + "/";
+    for (auto it = store.begin(); it != store.end();)
+        it = it->first.compare(0, prefix.size(), prefix) == 0 ? store.erase(it) : std::next(it);
+    return true;
+}
+
+// ------------------------------------------------------------
+// Core
+// ------------------------------------------------------------
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    if (pin < sizeof(pinLevels) && (mode == INPUT_PULLUP || mode == INPUT_PULLDOWN))
+        pinLevels[pin] = mode == INPUT_PULLUP ? HIGH : LOW;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+    if (pin < sizeof(pinLevels))
+        pinLevels[pin] = val ? HIGH : LOW;
+    lastLevel = val ? HIGH : LOW;
+    if (gpioWriteHook)
+        gpioWriteHook(pin, lastLevel);
+}
+
+int digitalRead(uint8_t pin)
+{
+    if (pin < sizeof(pinInputs) && pinInputs[pin] >= 0)
+        return pinInputs[pin];
+    return host::gpioLevel(pin);
+}
+
+int gpio_set_level(gpio_num_t gpio_num, uint32_t level)
+{
+    digitalWrite((uint8_t)gpio_num, (uint8_t)(level ? HIGH : LOW));
+    return 0;
+}
+
+int gpio_get_level(gpio_num_t gpio_num)
+{
+    return digitalRead((uint8_t)gpio_num);
+}
+
+// Truncated to 32 bits like the real counters, so wraparound is reachable
+unsigned long millis() { return (unsigned long)(uint32_t)(virtualMicros / 1000); }
+unsigned long micros() { return (unsigned long)(uint32_t)virtualMicros; }
+void delay(uint32_t ms) { virtualMicros += (uint64_t)ms * 1000; }
+void delayMicroseconds(uint32_t us) { virtualMicros += us; }
+
+void ledcSetup(uint8_t channel, uint32_t freq, uint8_t resolution)
+{
+    (void)channel;
+    (void)freq;
+    (void)resolution;
+}
+
+void ledcAttachPin(uint8_t pin, uint8_t channel)
+{
+    (void)pin;
+    (void)channel;
+}
+
+void ledcWrite(uint8_t channel, uint32_t duty)
+{
+    (void)channel;
+    (void)duty;
+}
+
+bool psramFound() { return psramPresent; }
+uint32_t getCpuFrequencyMhz() { return ESP.getCpuFreqMHz(); }
+
+// ------------------------------------------------------------
+// ESP
+// ------------------------------------------------------------
+void EspClass::restart()
+{
+    throw host::Restart();
+}
+
+// Real time, unlike millis(), so the loop profiler measures host CPU work
+uint32_t EspClass::getCycleCount()
+{
+    const auto ns = std::chrono::steady_clock::now().time_since_epoch();
+    return (uint32_t)(std::chrono::duration_cast<std::chrono::nanoseconds>(ns).count() * getCpuFreqMHz() / 1000);
+}
+
+uint32_t EspClass::getFreeHeap() { return heapFree; }
+uint32_t EspClass::getMaxAllocHeap() { return heapBlock; }
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+    (void)caps;
+    return heapFree;
+}
+size_t heap_caps_get_largest_free_block(uint32_t caps)
+{
+    (void)caps;
+    return heapBlock;
+}
+
+// xorshift32: the same sequence for the same host::seedRandom()
+uint32_t esp_random()
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+// ------------------------------------------------------------
+// Time (esp_timer, SNTP hook)
+// ------------------------------------------------------------
+int64_t esp_timer_get_time() { return (int64_t)virtualMicros; }
+
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t callback) { sntpCallback = callback; }
+
+void configTzTime(const char *tz, const char *server1, const char *server2, const char *server3)
+{
+    (void)server1;
+    (void)server2;
+    (void)server3;
+    setenv("TZ", tz, 1);
+    tzset();
+}
+
+// ------------------------------------------------------------
+// Serial
+// ------------------------------------------------------------
+size_t HardwareSerial::print(const char *s)
+{
+    if (!serialOut || !s)
+        return 0;
+    return fputs(s, serialOut) >= 0 ? strlen(s) : 0;
+}
+
+size_t HardwareSerial::print(char c)
+{
+    if (!serialOut)
+        return 0;
+    fputc(c, serialOut);
+    return 1;
+}
+
+size_t HardwareSerial::printf(const char *fmt, ...)
+{
+    if (!serialOut)
+        return 0;
+    va_list args;
+    va_start(args, fmt);
+    int n = vfprintf(serialOut, fmt, args);
+    va_end(args);
+    return n > 0 ? (size_t)n : 0;
+}
+
+size_t HardwareSerial::write(const uint8_t *data, size_t length)
+{
+    if (!serialOut)
+        return 0;
+    return fwrite(data, 1, length, serialOut);
+}
+
+// ------------------------------------------------------------
+// mbedTLS base64
+// ------------------------------------------------------------
+static const char BASE64_ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+int mbedtls_base64_decode(unsigned char *dst, size_t dlen, size_t *olen, const unsigned char *src, size_t slen)
+{
+    size_t digits = 0, pad = 0;
+    for (size_t i = 0; i < slen; ++i)
+    {
+        const unsigned char c = src[i];
+        if (c == ' ' || c == '\r' || c == '\n')
+            continue;
+        if (c == '=')
+        {
+            if (++pad > 2)
+                return MBEDTLS_ERR_BASE64_INVALID_CHARACTER;
+            continue;
+        }
+        if (pad || !strchr(BASE64_ALPHABET, c) || c == '\0')
+            return MBEDTLS_ERR_BASE64_INVALID_CHARACTER;
+        digits++;
+    }
+    if ((digits + pad) % 4 != 0)
+        return MBEDTLS_ERR_BASE64_INVALID_CHARACTER;
+    const size_t needed = digits * 3 / 4;
+    if (!dst || dlen < needed)
+    {
+        *olen = needed;
+        return MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL;
+    }
+
+    uint32_t acc = 0;
+    size_t bits = 0, n = 0;
+    for (size_t i = 0; i < slen; ++i)
+    {
+        const char *p = strchr(BASE64_ALPHABET, src[i]);
+        if (!p || src[i] == '\0')
+            continue;
+        acc = (acc << 6) | (uint32_t)(p - BASE64_ALPHABET);
+        bits += 6;
+        if (bits >= 8)
+        {
+            bits -= 8;
+            dst[n++] = (unsigned char)(acc >> bits);
+        }
+    }
+    *olen = n;
+    return 0;
+}
+
+int mbedtls_base64_encode(unsigned char *dst, size_t dlen, size_t *olen, const unsigned char *src, size_t slen)
+{
+    const size_t needed = (slen + 2) / 3 * 4 + 1;
+    if (!dst || dlen < needed)
+    {
+        *olen = needed;
+        return MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL;
+    }
+    size_t n = 0;
+    for (size_t i = 0; i < slen; i += 3)
+    {
+        const uint32_t v = (uint32_t)src[i] << 16 | (i + 1 < slen ? (uint32_t)src[i + 1] << 8 : 0) |
+                           (i + 2 < slen ? src[i + 2] : 0);
+        dst[n++] = BASE64_ALPHABET[(v >> 18) & 63];
+        dst[n++] = BASE64_ALPHABET[(v >> 12) & 63];
+        dst[n++] = i + 1 < slen ? BASE64_ALPHABET[(v >> 6) & 63] : '=';
+        dst[n++] = i + 2 < slen ? BASE64_ALPHABET[v & 63] : '=';
+    }
+    dst[n] = '\0';
+    *olen = n;
+    return 0;
+}
+
+// ------------------------------------------------------------
+// FreeRTOS
+// ------------------------------------------------------------
+BaseType_t xTaskCreate(TaskFunction_t task, const char *name, uint32_t stackDepth, void *arg, UBaseType_t priority,
+                       TaskHandle_t *handle)
+{
+    (void)task;
+    (void)name;
+    (void)stackDepth;
+    (void)arg;
+    (void)priority;
+    if (handle)
+        *handle = nullptr;
+    return pdFAIL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char *name, uint32_t stackDepth, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core)
+{
+    (void)core;
+    return xTaskCreate(task, name, stackDepth, arg, priority, handle);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    delay(ticks);
+}
+
+// ------------------------------------------------------------
+// String
+// ------------------------------------------------------------
+String::String(double v, unsigned int decimals)
+{
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", (int)decimals, v);
+    str = buf;
+}
+
+int String::indexOf(char c, unsigned int from) const
+{
+    size_t pos = str.find(c, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::indexOf(const String &s, unsigned int from) const
+{
+    size_t pos = str.find(s.str, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+bool String::endsWith(const String &suffix) const
+{
+    return str.size() >= suffix.str.size() &&
+           str.compare(str.size() - suffix.str.size(), suffix.str.size(), suffix.str) == 0;
+}
+
+String String::substring(unsigned int begin, unsigned int end) const
+{
+    if (begin > end)
+        std::swap(begin, end);
+    if (begin >= str.size())
+        return String();
+    return String(str.substr(begin, end - begin));
+}
+
+void String::replace(const String &find, const String &with)
+{
+    if (find.str.empty())
+        return;
+    size_t pos = 0;
+    while ((pos = str.find(find.str, pos)) != std::string::npos)
+    {
+        str.replace(pos, find.str.size(), with.str);
+        pos += with.str.size();
+    }
+}
+
+void String::remove(unsigned int index, unsigned int count)
+{
+    if (index < str.size())
+        str.erase(index, count);
+}
+
+void String::trim()
+{
+    size_t b = 0;
+    while (b < str.size() && isspace((unsigned char)str[b]))
+        ++b;
+    size_t e = str.size();
+    while (e > b && isspace((unsigned char)str[e - 1]))
+        --e;
+    str = str.substr(b, e - b);
+}
+
+void String::toUpperCase()
+{
+    for (auto &c : str)
+        c = (char)toupper((unsigned char)c);
+}
+
+void String::toLowerCase()
+{
+    for (auto &c : str)
+        c = (char)tolower((unsigned char)c);
+}
+
+String operator+(const String &lhs, const String &rhs) { return String(lhs.std() + rhs.std()); }
+String operator+(const String &lhs, const char *rhs) { return String(lhs.std() + (rhs ? rhs : "")); }
+String operator+(const char *lhs, const String &rhs) { return String((lhs ? lhs : "") + rhs.std()); }
+String operator+(const String &lhs, char rhs) { return String(lhs.std() + rhs); }
+
+// ------------------------------------------------------------
+// WiFi value types
+// ------------------------------------------------------------
+String IPAddress::toString() const
+{
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", octets[0], octets[1], octets[2], octets[3]);
+    return String(buf);
+}
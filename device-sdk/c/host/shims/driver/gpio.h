@@ -0,0 +1,9 @@
+// Host shim of the ESP-IDF GPIO driver subset used by the firmware.
+#pragma once
+
+#include <cstdint>
+
+typedef int gpio_num_t;
+
+int gpio_set_level(gpio_num_t gpio_num, uint32_t level);
+int gpio_get_level(gpio_num_t gpio_num);
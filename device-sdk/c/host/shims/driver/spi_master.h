@@ -0,0 +1,104 @@
+// Host shim of the ESP-IDF SPI master driver.
+//
+// Transactions are executed at queue time against SimPanel: pre_cb runs
+// first (it drives DC through gpio_set_level), then the bytes are clocked
+// into the panel. Results are handed back in order by
+// spi_device_get_trans_result(). The queue_size limit of the real driver
+// is enforced so a caller that overfills the queue fails loudly here
+// instead of blocking forever on the device.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "driver/gpio.h"
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_INVALID_STATE 0x103
+#define ESP_ERR_TIMEOUT 0x107
+
+#ifndef portMAX_DELAY
+#define portMAX_DELAY 0xffffffffUL
+#endif
+typedef uint32_t TickType_t;
+
+typedef int spi_host_device_t;
+#ifndef VSPI_HOST
+#define VSPI_HOST 2
+#endif
+#ifndef HSPI_HOST
+#define HSPI_HOST 1
+#endif
+#ifndef SPI_DMA_CH_AUTO
+#define SPI_DMA_CH_AUTO 3
+#endif
+
+#define SPI_TRANS_USE_RXDATA (1 << 2)
+#define SPI_TRANS_USE_TXDATA (1 << 3)
+
+struct spi_transaction_t
+{
+    uint32_t flags;
+    uint16_t cmd;
+    uint64_t addr;
+    size_t length;   // total data length, in bits
+    size_t rxlength; // in bits
+    void *user;
+    union
+    {
+        const void *tx_buffer;
+        uint8_t tx_data[4];
+    };
+    union
+    {
+        void *rx_buffer;
+        uint8_t rx_data[4];
+    };
+};
+
+typedef void (*transaction_cb_t)(spi_transaction_t *trans);
+
+struct spi_bus_config_t
+{
+    int mosi_io_num;
+    int miso_io_num;
+    int sclk_io_num;
+    int quadwp_io_num;
+    int quadhd_io_num;
+    int max_transfer_sz;
+    uint32_t flags;
+    int intr_flags;
+};
+
+struct spi_device_interface_config_t
+{
+    uint8_t command_bits;
+    uint8_t address_bits;
+    uint8_t dummy_bits;
+    uint8_t mode;
+    uint16_t duty_cycle_pos;
+    uint16_t cs_ena_pretrans;
+    uint8_t cs_ena_posttrans;
+    int clock_speed_hz;
+    int input_delay_ns;
+    int spics_io_num;
+    uint32_t flags;
+    int queue_size;
+    transaction_cb_t pre_cb;
+    transaction_cb_t post_cb;
+};
+
+typedef struct spi_device_t *spi_device_handle_t;
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *bus_config, int dma_chan);
+esp_err_t spi_bus_free(spi_host_device_t host);
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t *dev_config,
+                             spi_device_handle_t *handle);
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle);
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *trans_desc, TickType_t ticks_to_wait);
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans_desc,
+                                      TickType_t ticks_to_wait);
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t *trans_desc);
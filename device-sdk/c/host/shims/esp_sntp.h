@@ -0,0 +1,9 @@
+// Host shim of the ESP-IDF SNTP notification hook. Nothing talks to a
+// server; harnesses deliver syncs with host::deliverSntp().
+#pragma once
+
+#include <sys/time.h>
+
+typedef void (*sntp_sync_time_cb_t)(struct timeval *tv);
+
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t callback);
@@ -0,0 +1,6 @@
+// Host shim of esp_random(): a seeded deterministic generator (see host.h).
+#pragma once
+
+#include <cstdint>
+
+uint32_t esp_random();
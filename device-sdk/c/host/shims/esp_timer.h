@@ -0,0 +1,6 @@
+// Host shim of esp_timer: the virtual clock of host.h, in microseconds.
+#pragma once
+
+#include <cstdint>
+
+int64_t esp_timer_get_time();
@@ -0,0 +1,12 @@
+// Host shim of the FreeRTOS types and macros used by the firmware.
+#pragma once
+
+#include <cstdint>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdPASS 1
+#define pdFAIL 0
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms)) // 1 kHz tick
@@ -0,0 +1,16 @@
+// Host shim of the FreeRTOS task API. There is no scheduler on the host:
+// xTaskCreate() and xTaskCreatePinnedToCore() fail, and harnesses call what the task would do instead
+// (e.g. logDrain()).
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void *);
+typedef void *TaskHandle_t;
+
+BaseType_t xTaskCreate(TaskFunction_t task, const char *name, uint32_t stackDepth, void *arg, UBaseType_t priority,
+                       TaskHandle_t *handle);
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char *name, uint32_t stackDepth, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core);
+// delay() on the virtual clock
+void vTaskDelay(TickType_t ticks);
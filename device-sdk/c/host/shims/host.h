@@ -0,0 +1,119 @@
+// Control surface of the host shims for harnesses and simulators.
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+class WebSocketsClient;
+
+namespace host
+{
+    // Virtual clock behind millis()/micros(). It only moves through
+    // delay()/delayMicroseconds() or these calls, so runs are deterministic.
+    uint64_t nowMicros();
+    void setMicros(uint64_t us);
+    void advanceMicros(uint64_t us);
+
+    // Hands the SNTP notification callback a sync at unixMicros (UTC), as
+    // if a server reply had just arrived. Does nothing before the firmware
+    // registered one.
+    void deliverSntp(int64_t unixMicros);
+
+    // Where Serial output goes (nullptr silences it). Defaults to stdout.
+    void setSerialOutput(FILE *out);
+
+    // Result of psramFound()
+    void setPsram(bool present);
+
+    // Last level written by digitalWrite()/gpio_set_level() to any pin,
+    // and per-pin levels
+    int lastGpioLevel();
+    int gpioLevel(uint8_t pin);
+
+    // Drives an input: digitalRead() returns level until released. A pin
+    // nobody drives reads what was last written, or HIGH after INPUT_PULLUP.
+    void setGpioInput(uint8_t pin, int level);
+    void releaseGpioInput(uint8_t pin);
+    // Called on every digitalWrite()/gpio_set_level(), e.g. to timestamp
+    // relay edges; nullptr removes it
+    void setGpioWriteHook(std::function<void(uint8_t pin, int level)> hook);
+
+    // ESP.restart() throws this; catch it and call setup() again to reboot
+    struct Restart
+    {
+    };
+
+    // Generator behind esp_random()
+    void seedRandom(uint32_t seed);
+    // Figures returned by heap_caps_get_free_size() and friends
+    void setHeap(uint32_t freeBytes, uint32_t largestBlock);
+
+    // Access point state behind WiFi.status() and WiFi.RSSI(); up by default
+    void setWifi(bool up, int8_t rssi = -55);
+
+    // HTTPClient requests go to the handler, which may take virtual time
+    // (latencyMs is added to the clock before the call returns)
+    struct HttpRequest
+    {
+        std::string method;
+        std::string url;
+        std::vector<std::pair<std::string, std::string>> headers;
+        std::string body;
+    };
+    struct HttpResponse
+    {
+        int code = -1; // HTTPC_ERROR_CONNECTION_REFUSED
+        std::string body;
+        uint32_t latencyMs = 0;
+    };
+    void setHttpHandler(std::function<HttpResponse(const HttpRequest &)> handler);
+
+    // Server side of the WebSocketsClient shim. conn identifies the client
+    // connection; it stays valid until closed().
+    class WsPeer
+    {
+    public:
+        virtual ~WsPeer() = default;
+        // A connection attempt; false refuses it and the client retries
+        // after its reconnect interval
+        virtual bool accept(WebSocketsClient *conn, const std::string &host, uint16_t port, const std::string &url)
+        {
+            (void)conn;
+            (void)host;
+            (void)port;
+            (void)url;
+            return true;
+        }
+        // After the client saw WStype_CONNECTED
+        virtual void opened(WebSocketsClient *conn) { (void)conn; }
+        // A text frame sent by the firmware
+        virtual void received(WebSocketsClient *conn, const char *text, size_t length)
+        {
+            (void)conn;
+            (void)text;
+            (void)length;
+        }
+        // The connection closed, from either side
+        virtual void closed(WebSocketsClient *conn) { (void)conn; }
+    };
+    void setWsPeer(WsPeer *peer);
+    // Queues a text frame for conn, delivered by the first loop() at or
+    // after atMicros (0: the next loop()). Frames queued while
+    // disconnected are dropped.
+    void wsPush(WebSocketsClient *conn, const std::string &text, uint64_t atMicros = 0);
+    // Closes conn from the server side; the client sees WStype_DISCONNECTED
+    // in its next loop() and reconnects later
+    void wsDrop(WebSocketsClient *conn);
+
+    // The same for the last client to call begin(), for single-device runs
+    void wsPush(const std::string &text, uint64_t atMicros = 0);
+    void wsDrop();
+    bool wsConnected();
+    // Earliest time something is due in the client's loop() (a queued
+    // frame, a drop or a reconnect attempt), or UINT64_MAX
+    uint64_t wsNextEventMicros();
+}
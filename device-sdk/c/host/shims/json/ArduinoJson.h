@@ -0,0 +1,473 @@
+// Host shim of the ArduinoJson 7 API subset used by the firmware (plus the
+// v6 DynamicJsonDocument/createNestedArray that input-device still uses).
+//
+// Used when CMake is not given a real ArduinoJson (ARDUINOJSON_DIR). It is
+// a plain tree of heap nodes, so it parses and serializes the same JSON as
+// the library but its time and allocation costs are not the library's.
+//
+// Writing through a member of a missing object (doc["a"]["b"] = 1 with no
+// "a") is ignored; the firmware only writes one level deep.
+#pragma once
+
+#include "Arduino.h"
+
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace host_json
+{
+    struct Node
+    {
+        enum Kind : uint8_t
+        {
+            Null,
+            Bool,
+            Int,
+            Float,
+            Str,
+            Array,
+            Object,
+        };
+
+        Kind kind = Null;
+        bool b = false;
+        int64_t i = 0;
+        double f = 0;
+        std::string s;
+        std::vector<std::unique_ptr<Node>> items;
+        std::vector<std::string> keys; // objects: keys[n] names items[n]
+
+        void reset(Kind k);
+        Node *member(const char *key) const;
+        Node *addMember(const char *key);
+        Node *addItem();
+    };
+
+    void set(Node &node, bool v);
+    void set(Node &node, int64_t v);
+    void set(Node &node, uint64_t v);
+    void set(Node &node, double v);
+    void set(Node &node, const char *v);
+    void set(Node &node, const Node &v);
+    template <typename T>
+    void setValue(Node &node, const T &v)
+    {
+        if constexpr (std::is_same_v<T, bool>)
+            set(node, v);
+        else if constexpr (std::is_integral_v<T> || std::is_enum_v<T>)
+        {
+            if constexpr (std::is_signed_v<T> || std::is_enum_v<T>)
+                set(node, (int64_t)v);
+            else
+                set(node, (uint64_t)v);
+        }
+        else if constexpr (std::is_floating_point_v<T>)
+            set(node, (double)v);
+        else if constexpr (std::is_same_v<T, String>)
+            set(node, v.c_str());
+        else
+            set(node, (const char *)v);
+    }
+
+    void serialize(const Node *node, std::string &out);
+}
+
+class JsonArray;
+class JsonObject;
+class JsonVariantConst;
+
+// Read side shared by JsonVariant and JsonVariantConst
+template <typename Derived>
+class JsonReadable
+{
+public:
+    bool isNull() const { return !node() || node()->kind == host_json::Node::Null; }
+
+    template <typename T>
+    bool is() const
+    {
+        using host_json::Node;
+        const Node *n = node();
+        if (!n)
+            return false;
+        if constexpr (std::is_same_v<T, bool>)
+            return n->kind == Node::Bool;
+        else if constexpr (std::is_integral_v<T>)
+            return n->kind == Node::Int && n->i >= (int64_t)std::numeric_limits<T>::min() &&
+                   (std::is_same_v<T, uint64_t> || n->i <= (int64_t)std::numeric_limits<T>::max());
+        else if constexpr (std::is_floating_point_v<T>)
+            return n->kind == Node::Int || n->kind == Node::Float;
+        else if constexpr (std::is_same_v<T, const char *> || std::is_same_v<T, String>)
+            return n->kind == Node::Str;
+        else if constexpr (std::is_same_v<T, JsonArray>)
+            return n->kind == Node::Array;
+        else if constexpr (std::is_same_v<T, JsonObject>)
+            return n->kind == Node::Object;
+        else
+            static_assert(sizeof(T) == 0, "unsupported type");
+    }
+
+    template <typename T>
+    T as() const;
+
+    // Value if it has type T, otherwise the default
+    template <typename T>
+    auto operator|(const T &fallback) const
+    {
+        if constexpr (std::is_array_v<T> || std::is_same_v<std::decay_t<T>, const char *> ||
+                      std::is_same_v<std::decay_t<T>, char *>)
+            return is<const char *>() ? node()->s.c_str() : (const char *)fallback;
+        else
+            return is<T>() ? as<T>() : fallback;
+    }
+
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+    bool operator==(T v) const
+    {
+        using host_json::Node;
+        const Node *n = node();
+        if (!n)
+            return false;
+        if (n->kind == Node::Int)
+            return std::is_floating_point_v<T> ? (double)n->i == (double)v : n->i == (int64_t)v;
+        if (n->kind == Node::Float)
+            return n->f == (double)v;
+        if (n->kind == Node::Bool)
+            return n->b == (bool)v;
+        return false;
+    }
+    bool operator==(const char *v) const { return is<const char *>() && v && node()->s == v; }
+    template <typename T>
+    bool operator!=(const T &v) const
+    {
+        return !(*this == v);
+    }
+
+    size_t size() const { return node() ? node()->items.size() : 0; }
+    bool containsKey(const char *key) const { return node() && node()->member(key); }
+
+private:
+    const host_json::Node *node() const { return static_cast<const Derived *>(this)->resolve(); }
+};
+
+class JsonVariantConst : public JsonReadable<JsonVariantConst>
+{
+public:
+    JsonVariantConst(const host_json::Node *node = nullptr) : n(node) {}
+
+    JsonVariantConst operator[](const char *key) const;
+    JsonVariantConst operator[](const String &key) const { return (*this)[key.c_str()]; }
+    JsonVariantConst operator[](size_t index) const;
+    JsonVariantConst operator[](int index) const { return (*this)[(size_t)index]; }
+
+    const host_json::Node *resolve() const { return n; }
+
+private:
+    const host_json::Node *n;
+};
+
+// A value in a document: a node, or a member or element that may not exist
+// yet and is created when written
+class JsonVariant : public JsonReadable<JsonVariant>
+{
+public:
+    JsonVariant() = default;
+    static JsonVariant direct(host_json::Node *node);
+    static JsonVariant member(host_json::Node *owner, const char *key);
+    static JsonVariant element(host_json::Node *owner, size_t index);
+
+    template <typename T>
+    JsonVariant &operator=(const T &value)
+    {
+        if (host_json::Node *n = ensure())
+            host_json::setValue(*n, value);
+        return *this;
+    }
+    JsonVariant &operator=(const char *value)
+    {
+        if (host_json::Node *n = ensure())
+            host_json::set(*n, value);
+        return *this;
+    }
+    JsonVariant &operator=(JsonVariantConst value);
+    JsonVariant &operator=(const JsonVariant &value) { return *this = (JsonVariantConst)value; }
+    JsonVariant(const JsonVariant &) = default;
+
+    // Replaces the value with an empty array or object
+    template <typename T>
+    T to();
+
+    JsonVariant operator[](const char *key) const;
+    JsonVariant operator[](const String &key) const { return (*this)[key.c_str()]; }
+    JsonVariant operator[](size_t index) const;
+    JsonVariant operator[](int index) const { return (*this)[(size_t)index]; }
+
+    template <typename T>
+    bool add(const T &value);
+
+    operator JsonVariantConst() const { return JsonVariantConst(resolve()); }
+    operator JsonObject() const;
+    operator JsonArray() const;
+
+    host_json::Node *resolve() const;
+    host_json::Node *ensure() const;
+
+private:
+    enum Mode : uint8_t
+    {
+        Direct,
+        Member,
+        Element,
+    };
+    Mode mode = Direct;
+    host_json::Node *n = nullptr; // the node, or the owner of the member/element
+    std::string key;
+    size_t index = 0;
+};
+
+class JsonArray
+{
+public:
+    JsonArray(host_json::Node *node = nullptr) : n(node && node->kind == host_json::Node::Array ? node : nullptr) {}
+
+    size_t size() const { return n ? n->items.size() : 0; }
+    bool isNull() const { return n == nullptr; }
+    JsonVariant operator[](size_t index) const { return JsonVariant::element(n, index); }
+    JsonVariant operator[](int index) const { return (*this)[(size_t)index]; }
+
+    template <typename T>
+    bool add(const T &value)
+    {
+        if (!n)
+            return false;
+        host_json::setValue(*n->addItem(), value);
+        return true;
+    }
+    bool add(const char *value)
+    {
+        if (!n)
+            return false;
+        host_json::set(*n->addItem(), value);
+        return true;
+    }
+    template <typename T>
+    T add();
+
+    host_json::Node *node() const { return n; }
+
+private:
+    host_json::Node *n;
+};
+
+class JsonObject
+{
+public:
+    JsonObject(host_json::Node *node = nullptr) : n(node && node->kind == host_json::Node::Object ? node : nullptr) {}
+
+    size_t size() const { return n ? n->items.size() : 0; }
+    bool isNull() const { return n == nullptr; }
+    JsonVariant operator[](const char *key) const { return JsonVariant::member(n, key); }
+    JsonVariant operator[](const String &key) const { return (*this)[key.c_str()]; }
+    bool containsKey(const char *key) const { return n && n->member(key); }
+
+    host_json::Node *node() const { return n; }
+
+private:
+    host_json::Node *n;
+};
+
+template <typename T>
+T JsonArray::add()
+{
+    if (!n)
+        return T();
+    return JsonVariant::direct(n->addItem()).to<T>();
+}
+
+template <typename T>
+T JsonVariant::to()
+{
+    host_json::Node *node = ensure();
+    if (!node)
+        return T();
+    if constexpr (std::is_same_v<T, JsonArray>)
+        node->reset(host_json::Node::Array);
+    else if constexpr (std::is_same_v<T, JsonObject>)
+        node->reset(host_json::Node::Object);
+    else
+        static_assert(sizeof(T) == 0, "to<JsonArray>() or to<JsonObject>()");
+    return T(node);
+}
+
+template <typename T>
+bool JsonVariant::add(const T &value)
+{
+    host_json::Node *node = ensure();
+    if (!node)
+        return false;
+    if (node->kind == host_json::Node::Null)
+        node->reset(host_json::Node::Array);
+    return JsonArray(node).add(value);
+}
+
+template <typename Derived>
+template <typename T>
+T JsonReadable<Derived>::as() const
+{
+    using host_json::Node;
+    const Node *n = node();
+    if constexpr (std::is_same_v<T, String>)
+    {
+        if (n && n->kind == Node::Str)
+            return String(n->s);
+        std::string out;
+        host_json::serialize(n, out);
+        return String(out);
+    }
+    else if constexpr (std::is_same_v<T, const char *>)
+        return n && n->kind == Node::Str ? n->s.c_str() : nullptr;
+    else if constexpr (std::is_same_v<T, bool>)
+        return n && (n->kind == Node::Bool ? n->b : n->kind == Node::Int ? n->i != 0 : false);
+    else if constexpr (std::is_arithmetic_v<T>)
+    {
+        if (!n)
+            return T();
+        if (n->kind == Node::Int)
+            return (T)n->i;
+        if (n->kind == Node::Float)
+            return (T)n->f;
+        if (n->kind == Node::Bool)
+            return (T)n->b;
+        return T();
+    }
+    else if constexpr (std::is_same_v<T, JsonArray> || std::is_same_v<T, JsonObject>)
+        return T(const_cast<Node *>(n));
+    else if constexpr (std::is_same_v<T, JsonVariantConst>)
+        return JsonVariantConst(n);
+    else
+        static_assert(sizeof(T) == 0, "unsupported type");
+}
+
+class JsonDocument
+{
+public:
+    JsonDocument() = default;
+    JsonDocument(const JsonDocument &) = delete;
+    JsonDocument &operator=(const JsonDocument &) = delete;
+
+    JsonVariant operator[](const char *key) { return JsonVariant::member(&root, key); }
+    JsonVariant operator[](const String &key) { return (*this)[key.c_str()]; }
+    JsonVariant operator[](size_t index) { return JsonVariant::element(&root, index); }
+    JsonVariant operator[](int index) { return (*this)[(size_t)index]; }
+    JsonVariantConst operator[](const char *key) const { return JsonVariantConst(&root)[key]; }
+    JsonVariantConst operator[](size_t index) const { return JsonVariantConst(&root)[index]; }
+    bool containsKey(const char *key) const { return root.member(key); }
+
+    template <typename T>
+    bool is() const
+    {
+        return JsonVariantConst(&root).is<T>();
+    }
+    template <typename T>
+    T as()
+    {
+        return JsonVariant::direct(&root).as<T>();
+    }
+    template <typename T>
+    T to()
+    {
+        return JsonVariant::direct(&root).to<T>();
+    }
+    template <typename T>
+    bool add(const T &value)
+    {
+        return JsonVariant::direct(&root).add(value);
+    }
+
+    size_t size() const { return root.items.size(); }
+    bool isNull() const { return root.kind == host_json::Node::Null; }
+    void clear() { root.reset(host_json::Node::Null); }
+
+    // ArduinoJson 6
+    JsonArray createNestedArray(const char *key) { return (*this)[key].to<JsonArray>(); }
+    JsonObject createNestedObject(const char *key) { return (*this)[key].to<JsonObject>(); }
+
+    operator JsonVariant() { return JsonVariant::direct(&root); }
+    operator JsonVariantConst() const { return JsonVariantConst(&root); }
+
+    host_json::Node root;
+};
+
+// ArduinoJson 6: the capacity is ignored
+class DynamicJsonDocument : public JsonDocument
+{
+public:
+    explicit DynamicJsonDocument(size_t capacity) { (void)capacity; }
+};
+
+class DeserializationError
+{
+public:
+    enum Code
+    {
+        Ok,
+        EmptyInput,
+        IncompleteInput,
+        InvalidInput,
+        NoMemory,
+        TooDeep,
+    };
+
+    DeserializationError(Code code = Ok) : c(code) {}
+    explicit operator bool() const { return c != Ok; }
+    bool operator==(Code code) const { return c == code; }
+    bool operator!=(Code code) const { return c != code; }
+    Code code() const { return c; }
+    const char *c_str() const;
+
+private:
+    Code c;
+};
+
+// Parses the first JSON value of the input, like ArduinoJson with the
+// default nesting limit of 10
+DeserializationError deserializeJson(JsonDocument &doc, const char *input, size_t length);
+inline DeserializationError deserializeJson(JsonDocument &doc, const char *input)
+{
+    return deserializeJson(doc, input, input ? strlen(input) : 0);
+}
+inline DeserializationError deserializeJson(JsonDocument &doc, const String &input)
+{
+    return deserializeJson(doc, input.c_str(), input.length());
+}
+inline DeserializationError deserializeJson(JsonDocument &doc, char *input)
+{
+    return deserializeJson(doc, (const char *)input);
+}
+
+// Appends the minified JSON to out; returns the bytes written
+size_t serializeJson(JsonVariantConst value, String &out);
+size_t serializeJson(JsonVariantConst value, char *out, size_t size);
+size_t measureJson(JsonVariantConst value);
+inline size_t serializeJson(const JsonDocument &doc, String &out)
+{
+    return serializeJson((JsonVariantConst)doc, out);
+}
+inline size_t serializeJson(const JsonDocument &doc, char *out, size_t size)
+{
+    return serializeJson((JsonVariantConst)doc, out, size);
+}
+inline size_t serializeJson(const JsonVariant &value, String &out)
+{
+    return serializeJson((JsonVariantConst)value, out);
+}
+inline size_t serializeJson(JsonArray array, String &out)
+{
+    return serializeJson(JsonVariantConst(array.node()), out);
+}
+inline size_t serializeJson(JsonObject object, String &out)
+{
+    return serializeJson(JsonVariantConst(object.node()), out);
+}
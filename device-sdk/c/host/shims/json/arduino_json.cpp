@@ -0,0 +1,644 @@
+// Host implementation of the ArduinoJson shim: node tree, parser and
+// serializer.
+#include "ArduinoJson.h"
+
+#include <cerrno>
+#include <cmath>
+
+namespace host_json
+{
+    void Node::reset(Kind k)
+    {
+        kind = k;
+        b = false;
+        i = 0;
+        f = 0;
+        s.clear();
+        items.clear();
+        keys.clear();
+    }
+
+    Node *Node::member(const char *key) const
+    {
+        if (kind != Object || !key)
+            return nullptr;
+        for (size_t n = 0; n < keys.size(); ++n)
+            if (keys[n] == key)
+                return items[n].get();
+        return nullptr;
+    }
+
+    Node *Node::addMember(const char *key)
+    {
+        keys.emplace_back(key ? key : "");
+        items.emplace_back(new Node);
+        return items.back().get();
+    }
+
+    Node *Node::addItem()
+    {
+        items.emplace_back(new Node);
+        return items.back().get();
+    }
+
+    void set(Node &node, bool v)
+    {
+        node.reset(Node::Bool);
+        node.b = v;
+    }
+
+    void set(Node &node, int64_t v)
+    {
+        node.reset(Node::Int);
+        node.i = v;
+    }
+
+    void set(Node &node, uint64_t v)
+    {
+        if (v > (uint64_t)INT64_MAX)
+            return set(node, (double)v);
+        set(node, (int64_t)v);
+    }
+
+    void set(Node &node, double v)
+    {
+        node.reset(Node::Float);
+        node.f = v;
+    }
+
+    void set(Node &node, const char *v)
+    {
+        if (!v)
+            return node.reset(Node::Null);
+        node.reset(Node::Str);
+        node.s = v;
+    }
+
+    void set(Node &node, const Node &v)
+    {
+        if (&node == &v)
+            return;
+        node.reset(v.kind);
+        node.b = v.b;
+        node.i = v.i;
+        node.f = v.f;
+        node.s = v.s;
+        node.keys = v.keys;
+        for (const auto &item : v.items)
+        {
+            node.items.emplace_back(new Node);
+            set(*node.items.back(), *item);
+        }
+    }
+
+    static void serializeString(const std::string &s, std::string &out)
+    {
+        out += '"';
+        for (unsigned char c : s)
+        {
+            switch (c)
+            {
+            case '"':
+                out += "\\\"";
+                break;
+            case '\\':
+                out += "\\\\";
+                break;
+            case '\b':
+                out += "\\b";
+                break;
+            case '\f':
+                out += "\\f";
+                break;
+            case '\n':
+                out += "\\n";
+                break;
+            case '\r':
+                out += "\\r";
+                break;
+            case '\t':
+                out += "\\t";
+                break;
+            default:
+                if (c < 0x20)
+                {
+                    char esc[8];
+                    snprintf(esc, sizeof(esc), "\\u%04x", c);
+                    out += esc;
+                }
+                else
+                    out += (char)c;
+            }
+        }
+        out += '"';
+    }
+
+    void serialize(const Node *node, std::string &out)
+    {
+        if (!node)
+        {
+            out += "null";
+            return;
+        }
+        switch (node->kind)
+        {
+        case Node::Null:
+            out += "null";
+            break;
+        case Node::Bool:
+            out += node->b ? "true" : "false";
+            break;
+        case Node::Int:
+            out += std::to_string(node->i);
+            break;
+        case Node::Float:
+        {
+            if (!std::isfinite(node->f))
+            {
+                out += "null";
+                break;
+            }
+            char buf[32];
+            snprintf(buf, sizeof(buf), "%.9g", node->f);
+            out += buf;
+            break;
+        }
+        case Node::Str:
+            serializeString(node->s, out);
+            break;
+        case Node::Array:
+            out += '[';
+            for (size_t n = 0; n < node->items.size(); ++n)
+            {
+                if (n)
+                    out += ',';
+                serialize(node->items[n].get(), out);
+            }
+            out += ']';
+            break;
+        case Node::Object:
+            out += '{';
+            for (size_t n = 0; n < node->items.size(); ++n)
+            {
+                if (n)
+                    out += ',';
+                serializeString(node->keys[n], out);
+                out += ':';
+                serialize(node->items[n].get(), out);
+            }
+            out += '}';
+            break;
+        }
+    }
+
+    // --------------------------------------------------------
+    // Parser
+    // --------------------------------------------------------
+    struct Parser
+    {
+        const char *p;
+        const char *end;
+
+        static constexpr int NESTING_LIMIT = 10;
+
+        void skipSpace()
+        {
+            while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+                ++p;
+        }
+
+        DeserializationError::Code parseValue(Node &node, int depth)
+        {
+            skipSpace();
+            if (p >= end)
+                return DeserializationError::IncompleteInput;
+            switch (*p)
+            {
+            case '{':
+                return depth >= NESTING_LIMIT ? DeserializationError::TooDeep : parseObject(node, depth + 1);
+            case '[':
+                return depth >= NESTING_LIMIT ? DeserializationError::TooDeep : parseArray(node, depth + 1);
+            case '"':
+                node.reset(Node::Str);
+                return parseString(node.s);
+            case 't':
+                return parseLiteral("true", node, Node::Bool, true);
+            case 'f':
+                return parseLiteral("false", node, Node::Bool, false);
+            case 'n':
+                return parseLiteral("null", node, Node::Null, false);
+            default:
+                return parseNumber(node);
+            }
+        }
+
+        DeserializationError::Code parseLiteral(const char *word, Node &node, Node::Kind kind, bool value)
+        {
+            const size_t n = strlen(word);
+            if ((size_t)(end - p) < n)
+                return strncmp(p, word, end - p) == 0 ? DeserializationError::IncompleteInput
+                                                      : DeserializationError::InvalidInput;
+            if (strncmp(p, word, n) != 0)
+                return DeserializationError::InvalidInput;
+            p += n;
+            node.reset(kind);
+            node.b = value;
+            return DeserializationError::Ok;
+        }
+
+        DeserializationError::Code parseNumber(Node &node)
+        {
+            const char *start = p;
+            bool isFloat = false;
+            if (p < end && (*p == '-' || *p == '+'))
+                ++p;
+            while (p < end && ((*p >= '0' && *p <= '9') || *p == '.' || *p == 'e' || *p == 'E' ||
+                               ((*p == '-' || *p == '+') && (p[-1] == 'e' || p[-1] == 'E'))))
+            {
+                if (*p == '.' || *p == 'e' || *p == 'E')
+                    isFloat = true;
+                ++p;
+            }
+            if (p == start || (p == start + 1 && (*start == '-' || *start == '+')))
+                return p >= end ? DeserializationError::IncompleteInput : DeserializationError::InvalidInput;
+
+            const std::string text(start, p);
+            char *stop = nullptr;
+            if (!isFloat)
+            {
+                errno = 0;
+                const long long v = strtoll(text.c_str(), &stop, 10);
+                if (*stop == '\0' && errno == 0)
+                {
+                    set(node, (int64_t)v);
+                    return DeserializationError::Ok;
+                }
+            }
+            const double v = strtod(text.c_str(), &stop);
+            if (*stop != '\0')
+                return DeserializationError::InvalidInput;
+            set(node, v);
+            return DeserializationError::Ok;
+        }
+
+        static void appendUtf8(std::string &out, uint32_t cp)
+        {
+            if (cp < 0x80)
+                out += (char)cp;
+            else if (cp < 0x800)
+            {
+                out += (char)(0xC0 | (cp >> 6));
+                out += (char)(0x80 | (cp & 0x3F));
+            }
+            else if (cp < 0x10000)
+            {
+                out += (char)(0xE0 | (cp >> 12));
+                out += (char)(0x80 | ((cp >> 6) & 0x3F));
+                out += (char)(0x80 | (cp & 0x3F));
+            }
+            else
+            {
+                out += (char)(0xF0 | (cp >> 18));
+                out += (char)(0x80 | ((cp >> 12) & 0x3F));
+                out += (char)(0x80 | ((cp >> 6) & 0x3F));
+                out += (char)(0x80 | (cp & 0x3F));
+            }
+        }
+
+        bool parseHex4(uint32_t &cp)
+        {
+            if (end - p < 4)
+                return false;
+            cp = 0;
+            for (int n = 0; n < 4; ++n)
+            {
+                const char c = *p++;
+                cp <<= 4;
+                if (c >= '0' && c <= '9')
+                    cp |= c - '0';
+                else if (c >= 'a' && c <= 'f')
+                    cp |= c - 'a' + 10;
+                else if (c >= 'A' && c <= 'F')
+                    cp |= c - 'A' + 10;
+                else
+                    return false;
+            }
+            return true;
+        }
+
+        DeserializationError::Code parseString(std::string &out)
+        {
+            ++p; // opening quote
+            while (p < end && *p != '"')
+            {
+                if (*p != '\\')
+                {
+                    out += *p++;
+                    continue;
+                }
+                if (++p >= end)
+                    return DeserializationError::IncompleteInput;
+                const char c = *p++;
+                switch (c)
+                {
+                case '"':
+                case '\\':
+                case '/':
+                    out += c;
+                    break;
+                case 'b':
+                    out += '\b';
+                    break;
+                case 'f':
+                    out += '\f';
+                    break;
+                case 'n':
+                    out += '\n';
+                    break;
+                case 'r':
+                    out += '\r';
+                    break;
+                case 't':
+                    out += '\t';
+                    break;
+                case 'u':
+                {
+                    uint32_t cp;
+                    if (!parseHex4(cp))
+                        return p >= end ? DeserializationError::IncompleteInput : DeserializationError::InvalidInput;
+                    if (cp >= 0xD800 && cp < 0xDC00 && end - p >= 6 && p[0] == '\\' && p[1] == 'u')
+                    {
+                        p += 2;
+                        uint32_t low;
+                        if (!parseHex4(low))
+                            return DeserializationError::InvalidInput;
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendUtf8(out, cp);
+                    break;
+                }
+                default:
+                    return DeserializationError::InvalidInput;
+                }
+            }
+            if (p >= end)
+                return DeserializationError::IncompleteInput;
+            ++p; // closing quote
+            return DeserializationError::Ok;
+        }
+
+        DeserializationError::Code parseArray(Node &node, int depth)
+        {
+            node.reset(Node::Array);
+            ++p;
+            skipSpace();
+            if (p < end && *p == ']')
+            {
+                ++p;
+                return DeserializationError::Ok;
+            }
+            for (;;)
+            {
+                const auto err = parseValue(*node.addItem(), depth);
+                if (err != DeserializationError::Ok)
+                    return err;
+                skipSpace();
+                if (p >= end)
+                    return DeserializationError::IncompleteInput;
+                if (*p == ']')
+                {
+                    ++p;
+                    return DeserializationError::Ok;
+                }
+                if (*p++ != ',')
+                    return DeserializationError::InvalidInput;
+            }
+        }
+
+        DeserializationError::Code parseObject(Node &node, int depth)
+        {
+            node.reset(Node::Object);
+            ++p;
+            skipSpace();
+            if (p < end && *p == '}')
+            {
+                ++p;
+                return DeserializationError::Ok;
+            }
+            for (;;)
+            {
+                skipSpace();
+                if (p >= end)
+                    return DeserializationError::IncompleteInput;
+                if (*p != '"')
+                    return DeserializationError::InvalidInput;
+                std::string key;
+                auto err = parseString(key);
+                if (err != DeserializationError::Ok)
+                    return err;
+                skipSpace();
+                if (p >= end)
+                    return DeserializationError::IncompleteInput;
+                if (*p++ != ':')
+                    return DeserializationError::InvalidInput;
+                // A repeated key keeps the last value
+                Node *member = node.member(key.c_str());
+                if (!member)
+                    member = node.addMember(key.c_str());
+                err = parseValue(*member, depth);
+                if (err != DeserializationError::Ok)
+                    return err;
+                skipSpace();
+                if (p >= end)
+                    return DeserializationError::IncompleteInput;
+                if (*p == '}')
+                {
+                    ++p;
+                    return DeserializationError::Ok;
+                }
+                if (*p++ != ',')
+                    return DeserializationError::InvalidInput;
+            }
+        }
+    };
+}
+
+using host_json::Node;
+
+// ------------------------------------------------------------
+// Variants
+// ------------------------------------------------------------
+JsonVariantConst JsonVariantConst::operator[](const char *key) const
+{
+    return JsonVariantConst(n ? n->member(key) : nullptr);
+}
+
+JsonVariantConst JsonVariantConst::operator[](size_t index) const
+{
+    return JsonVariantConst(n && n->kind == Node::Array && index < n->items.size() ? n->items[index].get() : nullptr);
+}
+
+JsonVariant JsonVariant::direct(Node *node)
+{
+    JsonVariant v;
+    v.mode = Direct;
+    v.n = node;
+    return v;
+}
+
+JsonVariant JsonVariant::member(Node *owner, const char *key)
+{
+    JsonVariant v;
+    v.mode = Member;
+    v.n = owner;
+    v.key = key ? key : "";
+    return v;
+}
+
+JsonVariant JsonVariant::element(Node *owner, size_t index)
+{
+    JsonVariant v;
+    v.mode = Element;
+    v.n = owner;
+    v.index = index;
+    return v;
+}
+
+Node *JsonVariant::resolve() const
+{
+    if (!n)
+        return nullptr;
+    switch (mode)
+    {
+    case Direct:
+        return n;
+    case Member:
+        return n->member(key.c_str());
+    case Element:
+        return n->kind == Node::Array && index < n->items.size() ? n->items[index].get() : nullptr;
+    }
+    return nullptr;
+}
+
+Node *JsonVariant::ensure() const
+{
+    if (!n)
+        return nullptr;
+    switch (mode)
+    {
+    case Direct:
+        return n;
+    case Member:
+        if (n->kind == Node::Null)
+            n->reset(Node::Object);
+        if (n->kind != Node::Object)
+            return nullptr;
+        if (Node *m = n->member(key.c_str()))
+            return m;
+        return n->addMember(key.c_str());
+    case Element:
+        if (n->kind == Node::Null)
+            n->reset(Node::Array);
+        if (n->kind != Node::Array)
+            return nullptr;
+        while (n->items.size() <= index)
+            n->addItem();
+        return n->items[index].get();
+    }
+    return nullptr;
+}
+
+JsonVariant &JsonVariant::operator=(JsonVariantConst value)
+{
+    Node *node = ensure();
+    if (!node)
+        return *this;
+    if (value.resolve())
+        host_json::set(*node, *value.resolve());
+    else
+        node->reset(Node::Null);
+    return *this;
+}
+
+JsonVariant JsonVariant::operator[](const char *key) const
+{
+    return member(resolve(), key);
+}
+
+JsonVariant JsonVariant::operator[](size_t index) const
+{
+    return element(resolve(), index);
+}
+
+JsonVariant::operator JsonObject() const
+{
+    return JsonObject(resolve());
+}
+
+JsonVariant::operator JsonArray() const
+{
+    return JsonArray(resolve());
+}
+
+// ------------------------------------------------------------
+// Serialization
+// ------------------------------------------------------------
+const char *DeserializationError::c_str() const
+{
+    switch (c)
+    {
+    case Ok:
+        return "Ok";
+    case EmptyInput:
+        return "EmptyInput";
+    case IncompleteInput:
+        return "IncompleteInput";
+    case InvalidInput:
+        return "InvalidInput";
+    case NoMemory:
+        return "NoMemory";
+    case TooDeep:
+        return "TooDeep";
+    }
+    return "?";
+}
+
+DeserializationError deserializeJson(JsonDocument &doc, const char *input, size_t length)
+{
+    doc.clear();
+    host_json::Parser parser{input, input + length};
+    parser.skipSpace();
+    if (!input || parser.p >= parser.end || *parser.p == '\0')
+        return DeserializationError::EmptyInput;
+    const auto err = parser.parseValue(doc.root, 0);
+    if (err != DeserializationError::Ok)
+        doc.clear();
+    return err;
+}
+
+size_t serializeJson(JsonVariantConst value, String &out)
+{
+    std::string text;
+    host_json::serialize(value.resolve(), text);
+    out.concat(text.data(), (unsigned int)text.size());
+    return text.size();
+}
+
+size_t serializeJson(JsonVariantConst value, char *out, size_t size)
+{
+    std::string text;
+    host_json::serialize(value.resolve(), text);
+    if (size == 0)
+        return 0;
+    const size_t n = std::min(text.size(), size - 1);
+    memcpy(out, text.data(), n);
+    out[n] = '\0';
+    return n;
+}
+
+size_t measureJson(JsonVariantConst value)
+{
+    std::string text;
+    host_json::serialize(value.resolve(), text);
+    return text.size();
+}
@@ -0,0 +1,12 @@
+// Host shim of the mbedTLS base64 decoder (RFC 4648, with padding).
+#pragma once
+
+#include <cstddef>
+
+#define MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL -0x002A
+#define MBEDTLS_ERR_BASE64_INVALID_CHARACTER -0x002C
+
+// Decodes src into dst. With dst too small, returns
+// MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL and sets *olen to the size needed.
+int mbedtls_base64_decode(unsigned char *dst, size_t dlen, size_t *olen, const unsigned char *src, size_t slen);
+int mbedtls_base64_encode(unsigned char *dst, size_t dlen, size_t *olen, const unsigned char *src, size_t slen);
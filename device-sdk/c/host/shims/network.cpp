@@ -0,0 +1,244 @@
+// Host implementations of the WiFi, HTTPClient and WebSocketsClient shims.
+// Nothing leaves the process: the harness answers through host.h.
+#include "HTTPClient.h"
+#include "WebSocketsClient.h"
+#include "WiFi.h"
+#include "host.h"
+
+#include <climits>
+
+WiFiClass WiFi;
+
+static bool apUp = true;
+static int8_t apRssi = -55;
+static bool associated = false;
+
+static std::function<host::HttpResponse(const host::HttpRequest &)> httpHandler;
+
+// The last client to call begin(), for the single-client host:: calls
+static WebSocketsClient *wsClient = nullptr;
+static host::WsPeer *wsPeer = nullptr;
+static uint64_t wsSeq = 0;
+
+namespace host
+{
+    void setWifi(bool up, int8_t rssi)
+    {
+        apUp = up;
+        apRssi = rssi;
+        if (!up)
+            associated = false;
+    }
+
+    void setHttpHandler(std::function<HttpResponse(const HttpRequest &)> handler) { httpHandler = std::move(handler); }
+
+    void setWsPeer(WsPeer *peer) { wsPeer = peer; }
+
+    void wsPush(WebSocketsClient *conn, const std::string &text, uint64_t atMicros)
+    {
+        if (conn)
+            conn->hostPush(text, atMicros);
+    }
+
+    void wsDrop(WebSocketsClient *conn)
+    {
+        if (conn)
+            conn->hostDrop();
+    }
+
+    void wsPush(const std::string &text, uint64_t atMicros) { wsPush(wsClient, text, atMicros); }
+    void wsDrop() { wsDrop(wsClient); }
+
+    bool wsConnected() { return wsClient && wsClient->isConnected(); }
+    uint64_t wsNextEventMicros() { return wsClient ? wsClient->nextEventMicros() : UINT64_MAX; }
+}
+
+// ------------------------------------------------------------
+// WiFi
+// ------------------------------------------------------------
+wl_status_t WiFiClass::begin(const char *ssid, const char *passphrase)
+{
+    (void)ssid;
+    (void)passphrase;
+    associated = apUp;
+    return status();
+}
+
+bool WiFiClass::disconnect(bool wifiOff)
+{
+    (void)wifiOff;
+    associated = false;
+    return true;
+}
+
+wl_status_t WiFiClass::status()
+{
+    return associated && apUp ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+IPAddress WiFiClass::localIP()
+{
+    return status() == WL_CONNECTED ? IPAddress(192, 168, 0, 42) : IPAddress();
+}
+
+int8_t WiFiClass::RSSI()
+{
+    return status() == WL_CONNECTED ? apRssi : 0;
+}
+
+// ------------------------------------------------------------
+// HTTPClient
+// ------------------------------------------------------------
+int HTTPClient::send(const char *method, const std::string &payload)
+{
+    body.clear();
+    if (!httpHandler || WiFi.status() != WL_CONNECTED)
+        return HTTPC_ERROR_CONNECTION_REFUSED;
+    host::HttpRequest request{method, requestUrl, headers, payload};
+    host::HttpResponse response = httpHandler(request);
+    if (response.latencyMs > timeoutMs)
+    {
+        host::advanceMicros((uint64_t)timeoutMs * 1000);
+        return HTTPC_ERROR_READ_TIMEOUT;
+    }
+    host::advanceMicros((uint64_t)response.latencyMs * 1000);
+    body = std::move(response.body);
+    return response.code;
+}
+
+int HTTPClient::GET()
+{
+    return send("GET", std::string());
+}
+
+int HTTPClient::POST(const String &payload)
+{
+    return send("POST", payload.std());
+}
+
+// ------------------------------------------------------------
+// WebSocketsClient
+// ------------------------------------------------------------
+WebSocketsClient::~WebSocketsClient()
+{
+    if (connected)
+        close();
+    if (wsClient == this)
+        wsClient = nullptr;
+}
+
+void WebSocketsClient::close()
+{
+    connected = false;
+    inbox.clear();
+    dropPending = false;
+    if (wsPeer)
+        wsPeer->closed(this);
+}
+
+void WebSocketsClient::begin(const char *h, uint16_t p, const char *u, const char *protocol)
+{
+    (void)protocol;
+    if (connected)
+        close();
+    wsClient = this;
+    serverHost = h ? h : "";
+    port = p;
+    url = u ? u : "/";
+    started = true;
+    nextAttemptUs = host::nowMicros();
+}
+
+void WebSocketsClient::event(WStype_t type, const char *payload, size_t length)
+{
+    if (eventCb)
+        eventCb(type, (uint8_t *)payload, length);
+}
+
+void WebSocketsClient::loop()
+{
+    if (!started)
+        return;
+    const uint64_t now = host::nowMicros();
+
+    if (!connected)
+    {
+        if (now < nextAttemptUs)
+            return;
+        if (WiFi.status() != WL_CONNECTED || !wsPeer || !wsPeer->accept(this, serverHost, port, url))
+        {
+            nextAttemptUs = now + (uint64_t)reconnectMs * 1000;
+            return;
+        }
+        connected = true;
+        event(WStype_CONNECTED, url.c_str(), url.size());
+        if (connected && wsPeer)
+            wsPeer->opened(this);
+        return;
+    }
+
+    if (dropPending || WiFi.status() != WL_CONNECTED)
+    {
+        close();
+        nextAttemptUs = now + (uint64_t)reconnectMs * 1000;
+        event(WStype_DISCONNECTED, nullptr, 0);
+        return;
+    }
+
+    // Frames queued by the peer while these are handled wait for the next loop()
+    const uint64_t lastSeq = wsSeq;
+    while (connected && !inbox.empty())
+    {
+        auto it = inbox.begin();
+        while (it != inbox.end() && it->first <= now && it->second.first >= lastSeq)
+            ++it;
+        if (it == inbox.end() || it->first > now)
+            break;
+        std::string text = std::move(it->second.second);
+        inbox.erase(it);
+        event(WStype_TEXT, text.c_str(), text.size());
+    }
+}
+
+bool WebSocketsClient::sendTXT(const char *payload, size_t length)
+{
+    if (!connected || !payload)
+        return false;
+    if (length == 0)
+        length = strlen(payload);
+    if (wsPeer)
+        wsPeer->received(this, payload, length);
+    return true;
+}
+
+void WebSocketsClient::disconnect()
+{
+    started = false;
+    if (!connected)
+        return;
+    close();
+    event(WStype_DISCONNECTED, nullptr, 0);
+}
+
+void WebSocketsClient::hostPush(const std::string &text, uint64_t atMicros)
+{
+    if (connected)
+        inbox.emplace(atMicros ? atMicros : host::nowMicros(), std::make_pair(wsSeq++, text));
+}
+
+void WebSocketsClient::hostDrop()
+{
+    if (connected)
+        dropPending = true;
+}
+
+uint64_t WebSocketsClient::nextEventMicros() const
+{
+    if (!started)
+        return UINT64_MAX;
+    if (!connected)
+        return nextAttemptUs;
+    if (dropPending || WiFi.status() != WL_CONNECTED)
+        return host::nowMicros();
+    return inbox.empty() ? UINT64_MAX : inbox.begin()->first;
+}
@@ -0,0 +1,101 @@
+// Host implementation of the ESP-IDF SPI master shim (see driver/spi_master.h).
+#include "driver/spi_master.h"
+#include "host.h"
+#include "sim_panel.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+
+struct spi_device_t
+{
+    spi_device_interface_config_t cfg;
+    std::deque<spi_transaction_t *> done;
+};
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *bus_config, int dma_chan)
+{
+    (void)host;
+    (void)dma_chan;
+    return bus_config ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t spi_bus_free(spi_host_device_t host)
+{
+    (void)host;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t *dev_config,
+                             spi_device_handle_t *handle)
+{
+    (void)host;
+    if (!dev_config || !handle || dev_config->queue_size <= 0)
+        return ESP_ERR_INVALID_ARG;
+    *handle = new spi_device_t{*dev_config, {}};
+    SimPanel::get().setClockHz((uint32_t)dev_config->clock_speed_hz);
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle)
+{
+    delete handle;
+    return ESP_OK;
+}
+
+static void execute(spi_device_handle_t handle, spi_transaction_t *t)
+{
+    if (handle->cfg.pre_cb)
+        handle->cfg.pre_cb(t);
+
+    // The pre-transfer callback drives DC; whatever it set last applies
+    const bool dc = host::lastGpioLevel() != 0;
+    const uint8_t *bytes = (t->flags & SPI_TRANS_USE_TXDATA) ? t->tx_data : (const uint8_t *)t->tx_buffer;
+    SimPanel &panel = SimPanel::get();
+    panel.beginTransaction();
+    if (bytes)
+        panel.write(dc, bytes, t->length / 8);
+
+    if (handle->cfg.post_cb)
+        handle->cfg.post_cb(t);
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *trans_desc, TickType_t ticks_to_wait)
+{
+    (void)ticks_to_wait;
+    if (!handle || !trans_desc)
+        return ESP_ERR_INVALID_ARG;
+
+    if ((int)handle->done.size() >= handle->cfg.queue_size)
+    {
+        // On the device this would block until a result is collected,
+        // which never happens if the caller is the only consumer.
+        fprintf(stderr, "spi_device_queue_trans: queue_size %d exceeded\n", handle->cfg.queue_size);
+        abort();
+    }
+
+    execute(handle, trans_desc);
+    handle->done.push_back(trans_desc);
+    return ESP_OK;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans_desc,
+                                      TickType_t ticks_to_wait)
+{
+    (void)ticks_to_wait;
+    if (!handle || !trans_desc)
+        return ESP_ERR_INVALID_ARG;
+    if (handle->done.empty())
+        return ESP_ERR_TIMEOUT;
+    *trans_desc = handle->done.front();
+    handle->done.pop_front();
+    return ESP_OK;
+}
+
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t *trans_desc)
+{
+    if (!handle || !trans_desc)
+        return ESP_ERR_INVALID_ARG;
+    execute(handle, trans_desc);
+    return ESP_OK;
+}
@@ -0,0 +1,165 @@
+#include "firmware_sim.h"
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "host.h"
+#ifdef FW_DEV_LOG
+#include "dev_log.h"
+#endif
+
+void setup();
+void loop();
+
+static uint32_t failed = 0;
+
+FirmwareSim::FirmwareSim(uint64_t startUs, uint32_t stepUs, const SimServerOptions &opts)
+    : srv(opts), step(stepUs ? stepUs : 1000), levels(256, -1)
+{
+    host::setMicros(startUs);
+    srv.install();
+    srv.onFrame([this](SimServer::Conn conn, const char *text, size_t length)
+                {
+        lastConn = conn;
+        sent.push_back({host::nowMicros(), std::string(text, length)}); });
+    host::setGpioWriteHook([this](uint8_t pin, int level)
+                           {
+        if (levels[pin] != level)
+            changes.push_back({host::nowMicros(), pin, level});
+        levels[pin] = level; });
+}
+
+FirmwareSim::~FirmwareSim()
+{
+    host::setGpioWriteHook(nullptr);
+}
+
+uint64_t FirmwareSim::now() const
+{
+    return host::nowMicros();
+}
+
+void FirmwareSim::once()
+{
+    // ESP.restart() unwinds to here; setup() runs again with the globals
+    // as they were, which a real reboot would reset
+    try
+    {
+        if (!booted)
+        {
+            setup();
+            booted = true;
+        }
+        else
+        {
+            loop();
+            loopCount++;
+        }
+    }
+    catch (const host::Restart &)
+    {
+        restartCount++;
+        booted = false;
+    }
+#ifdef FW_DEV_LOG
+    logDrain();
+#endif
+    host::advanceMicros(step);
+    srv.service();
+}
+
+bool FirmwareSim::boot(uint64_t limitUs)
+{
+    return runUntil([this]()
+                    { return booted && srv.sessionOpen(); },
+                    limitUs);
+}
+
+void FirmwareSim::run(uint64_t us)
+{
+    const uint64_t endUs = host::nowMicros() + us;
+    while (host::nowMicros() < endUs)
+        once();
+}
+
+bool FirmwareSim::runUntil(const std::function<bool()> &done, uint64_t limitUs)
+{
+    const uint64_t endUs = host::nowMicros() + limitUs;
+    while (host::nowMicros() < endUs)
+    {
+        once();
+        if (done())
+            return true;
+    }
+    return false;
+}
+
+std::vector<FirmwareSim::Frame> FirmwareSim::framesOf(const char *event) const
+{
+    std::string prefix = event;
+    if (prefix != "3")
+        prefix = "42[\"" + prefix + "\"";
+    std::vector<Frame> out;
+    for (const Frame &frame : sent)
+        if (frame.text.compare(0, prefix.size(), prefix) == 0)
+            out.push_back(frame);
+    return out;
+}
+
+std::string devDataContent(const std::string &frame)
+{
+    const size_t start = frame.find("\"content\":[");
+    if (start == std::string::npos)
+        return "";
+    const size_t from = start + strlen("\"content\":[");
+    const size_t end = frame.find(']', from);
+    return end == std::string::npos ? "" : frame.substr(from, end - from);
+}
+
+bool expect(bool ok, const char *fmt, ...)
+{
+    char what[256];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(what, sizeof(what), fmt, args);
+    va_end(args);
+    printf("  %-4s %s\n", ok ? "ok" : "FAIL", what);
+    if (!ok)
+        failed++;
+    return ok;
+}
+
+uint32_t failures()
+{
+    return failed;
+}
+
+uint32_t runScenario(const char *name, const std::function<void()> &fn)
+{
+    printf("%s\n", name);
+    fflush(stdout);
+    const pid_t pid = fork();
+    if (pid < 0)
+    {
+        perror("fork");
+        return 1;
+    }
+    if (pid == 0)
+    {
+        fn();
+        fflush(stdout);
+        _exit(failed > 100 ? 100 : (int)failed);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status))
+    {
+        printf("  FAIL %s crashed\n", name);
+        return 1;
+    }
+    return (uint32_t)WEXITSTATUS(status);
+}
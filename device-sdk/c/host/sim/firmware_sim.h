@@ -0,0 +1,80 @@
+// Runs a firmware project's own setup() and loop() (linked in from its
+// firmware library) on the virtual clock against a SimServer, and keeps a
+// timestamped record of what the device did: every frame it sent and every
+// change of an output pin. Scenarios script socket events and GPIO inputs
+// between run() calls, then check the record with expect().
+//
+// The firmware's globals are not reset between runs, so each scenario is
+// meant to run in a process of its own (runScenario() forks one).
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "sim_server.h"
+
+class FirmwareSim
+{
+public:
+    struct Frame
+    {
+        uint64_t us;
+        std::string text;
+    };
+    struct Edge
+    {
+        uint64_t us;
+        uint8_t pin;
+        int level;
+    };
+
+    // Virtual time starts at startUs; loop() runs every stepUs
+    FirmwareSim(uint64_t startUs, uint32_t stepUs, const SimServerOptions &opts = SimServerOptions());
+    ~FirmwareSim();
+
+    // setup(), then loop() until a Socket.IO session is open or limitUs of
+    // virtual time passed; false if none opened
+    bool boot(uint64_t limitUs = 60000000);
+    // loop() for us of virtual time
+    void run(uint64_t us);
+    // loop() until done() holds, checked after every step, or limitUs passed
+    bool runUntil(const std::function<bool()> &done, uint64_t limitUs);
+
+    SimServer &server() { return srv; }
+    WebSocketsClient *conn() const { return lastConn; }
+    uint64_t now() const;
+    uint32_t stepUs() const { return step; }
+
+    const std::vector<Frame> &frames() const { return sent; }
+    const std::vector<Edge> &edges() const { return changes; }
+    // Frames of one Socket.IO event ("dev-data"), or "3" for pongs
+    std::vector<Frame> framesOf(const char *event) const;
+    uint64_t loops() const { return loopCount; }
+    uint32_t restarts() const { return restartCount; }
+
+private:
+    void once();
+
+    SimServer srv;
+    uint32_t step;
+    bool booted = false;
+    uint64_t loopCount = 0;
+    uint32_t restartCount = 0;
+    WebSocketsClient *lastConn = nullptr;
+    std::vector<Frame> sent;
+    std::vector<Edge> changes;
+    std::vector<int> levels;
+};
+
+// The "content" array of a dev-data frame as written ("1,0,0"), or ""
+std::string devDataContent(const std::string &frame);
+
+// Prints "  ok   what" or "  FAIL what" and counts the failures
+bool expect(bool ok, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+uint32_t failures();
+
+// Runs fn in a forked process, so it sees the firmware's globals as they are
+// at startup; returns the number of failed expectations (1 if it crashed)
+uint32_t runScenario(const char *name, const std::function<void()> &fn);
@@ -0,0 +1,199 @@
+#include "fleet_device.h"
+
+#include <ArduinoJson.h>
+
+// The firmware reboots 10 s after a failed auth, then spends ~100 ms in
+// setup() before it asks again
+static const uint64_t AUTH_RETRY_US = 10100000;
+
+FleetDevice::FleetDevice(SimServer &s, uint32_t index, uint64_t bootAtUs, Listener *l)
+    : server(s), listener(l), id(index), wakeUs(bootAtUs)
+{
+    char sn[32];
+    snprintf(sn, sizeof(sn), "SIM%08lu", (unsigned long)index);
+    serial = sn;
+    for (uint8_t &input : inputs)
+        input = HIGH;
+    ws.onEvent([this](WStype_t type, uint8_t *payload, size_t length)
+               { wsEvent(type, (const char *)payload, length); });
+}
+
+void FleetDevice::startAuth()
+{
+    // The request authenticateDevice() builds
+    JsonDocument doc;
+    doc["sn"] = serial.c_str();
+    doc["client_secret_key"] = CLIENT_SECRET_KEY;
+    JsonArray sensorIds = doc["sensorIds"].to<JsonArray>();
+    for (size_t i = 0; i < SENSOR_COUNT; i++)
+        sensorIds.add((uint32_t)(BASE_SENSOR_ID + i));
+    String payload;
+    serializeJson(doc, payload);
+
+    host::HttpRequest request{"POST", std::string(SERVER_URL) + "/api/v3/devices/auth",
+                              {{"Content-Type", "application/json"}}, payload.std()};
+    authResponse = server.authenticate(request);
+    if (authResponse.latencyMs > HTTP_TIMEOUT)
+    {
+        authResponse.latencyMs = HTTP_TIMEOUT;
+        authResponse.code = -11; // HTTPC_ERROR_READ_TIMEOUT
+    }
+    counters.auths++;
+    st = AUTHENTICATING;
+    wakeUs = host::nowMicros() + (uint64_t)authResponse.latencyMs * 1000;
+}
+
+void FleetDevice::finishAuth()
+{
+    JsonDocument doc;
+    if (authResponse.code == 200 && !deserializeJson(doc, authResponse.body) && doc["token"].is<const char *>())
+    {
+        authToken = doc["token"].as<String>();
+
+        // SocketIOClient::begin() with this device's serial
+        String domain = String(SERVER_URL);
+        domain.replace("https://", "");
+        domain.replace("http://", "");
+        String sensorIds = "[";
+        for (size_t i = 0; i < SENSOR_COUNT; i++)
+        {
+            sensorIds += String((uint32_t)(BASE_SENSOR_ID + i));
+            if (i + 1 < SENSOR_COUNT)
+                sensorIds += ",";
+        }
+        sensorIds += "]";
+        String socketPath = String(API_PATH) + "?sn=" + String(serial.c_str()) + "&clientType=device" +
+                            "&clientVersion=V4" + "&sensorIds=" + sensorIds + "&EIO=4&transport=websocket";
+        ws.beginSSL(domain.c_str(), SERVER_PORT, socketPath.c_str());
+        ws.setReconnectInterval(5000);
+        st = CONNECTING;
+        return;
+    }
+    counters.authFailures++;
+    st = BOOTING;
+    wakeUs = host::nowMicros() + AUTH_RETRY_US;
+}
+
+void FleetDevice::loop()
+{
+    switch (st)
+    {
+    case BOOTING:
+        if (host::nowMicros() >= wakeUs)
+            startAuth();
+        return;
+    case AUTHENTICATING:
+        if (host::nowMicros() >= wakeUs)
+            finishAuth();
+        return;
+    default:
+        break;
+    }
+
+    ws.loop();
+    if (st == ONLINE)
+    {
+        if (millis() - lastDataSend >= DATA_SEND_INTERVAL)
+            dataUpdateRequired = true;
+        if (dataUpdateRequired)
+        {
+            emitDevData();
+            dataUpdateRequired = false;
+            lastDataSend = millis();
+        }
+    }
+}
+
+void FleetDevice::wsEvent(WStype_t type, const char *payload, size_t length)
+{
+    switch (type)
+    {
+    case WStype_DISCONNECTED:
+        if (st == ONLINE)
+        {
+            counters.disconnects++;
+            counters.offlineUs = host::nowMicros();
+        }
+        st = CONNECTING;
+        if (listener)
+            listener->disconnected(*this);
+        break;
+    case WStype_TEXT:
+        if (payload && length > 0)
+            handlePacket(payload, length);
+        break;
+    default:
+        break;
+    }
+}
+
+void FleetDevice::sendPacket(const String &packet)
+{
+    ws.sendTXT(packet);
+}
+
+// handleSocketIOPacket() for the packets a fleet sees
+void FleetDevice::handlePacket(const char *packet, size_t length)
+{
+    switch (packet[0])
+    {
+    case '0':
+    {
+        JsonDocument doc;
+        if (deserializeJson(doc, packet + 1))
+            return;
+        sendPacket(String("40{\"token\":\"") + authToken + "\"}");
+        st = ONLINE;
+        counters.sessions++;
+        counters.onlineUs = host::nowMicros();
+        if (!bootupReady)
+        {
+            bootupReady = true;
+            sendPacket("42[\"dev-status\",\"Bootup & Ready\"]");
+        }
+        break;
+    }
+    case '2':
+        sendPacket("3");
+        break;
+    case '4':
+        if (length > 2 && packet[1] == '2')
+        {
+            JsonDocument doc;
+            if (deserializeJson(doc, packet + 2) || !doc.is<JsonArray>())
+                return;
+            JsonArray arr = doc.as<JsonArray>();
+            if (arr.size() < 2 || arr[0] != "app-cmd")
+                return;
+            JsonObject operation = arr[1]["operation"].as<JsonObject>();
+            String customCmd = operation["customCmd"] | "";
+            if (customCmd == "clear-call-bell" || customCmd == "output")
+            {
+                uint8_t fieldIndex = operation["fieldIndex"] | 0;
+                uint8_t fieldValue = operation["fieldValue"] | 0;
+                if (fieldIndex < SENSOR_COUNT)
+                    inputs[fieldIndex] = fieldValue == 1 ? LOW : HIGH;
+                counters.cmdsApplied++;
+                dataUpdateRequired = true;
+            }
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void FleetDevice::emitDevData()
+{
+    JsonDocument doc;
+    JsonArray content = doc["content"].to<JsonArray>();
+    for (uint8_t input : inputs)
+        content.add(input == LOW ? 1 : 0);
+    String jsonData;
+    serializeJson(doc, jsonData);
+    // Before sending: without link latency the server sees it right away
+    counters.emits++;
+    if (listener)
+        listener->emitted(*this, counters.cmdsApplied);
+    sendPacket("42[\"dev-data\"," + jsonData + "]");
+}
@@ -0,0 +1,87 @@
+// One device of a simulated fleet: the state machine of input-device-lcd's
+// main.cpp (auth, Socket.IO handshake, pongs, output app-cmds, periodic and
+// command-driven dev-data) without the firmware's globals, so that many
+// run in one process, each on its own WebSocketsClient. Auth does not block:
+// the device waits out the server's latency on the virtual clock while the
+// rest of the fleet keeps running. Reads SENSOR_COUNT, API_PATH and the
+// other settings from the firmware's config.h.
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <WebSocketsClient.h>
+
+#include "config.h"
+#include "sim_server.h"
+
+class FleetDevice
+{
+public:
+    enum State
+    {
+        BOOTING,        // waiting for bootAtUs or the reboot after a failed auth
+        AUTHENTICATING, // auth request in flight
+        CONNECTING,     // WebSocket or Socket.IO handshake not done
+        ONLINE,         // 40 sent, emitting
+    };
+
+    // Told about each dev-data sent and each disconnect, to match commands
+    // with the dev-data that confirms them
+    class Listener
+    {
+    public:
+        virtual ~Listener() = default;
+        // cmdsApplied: output commands applied before this dev-data
+        virtual void emitted(FleetDevice &device, uint32_t cmdsApplied) = 0;
+        virtual void disconnected(FleetDevice &device) = 0;
+    };
+
+    FleetDevice(SimServer &server, uint32_t index, uint64_t bootAtUs, Listener *listener = nullptr);
+    FleetDevice(const FleetDevice &) = delete;
+    FleetDevice &operator=(const FleetDevice &) = delete;
+
+    // One pass of the firmware's loop()
+    void loop();
+
+    State state() const { return st; }
+    uint32_t index() const { return id; }
+    const std::string &sn() const { return serial; }
+    WebSocketsClient *conn() { return &ws; }
+
+    struct Stats
+    {
+        uint32_t auths = 0;
+        uint32_t authFailures = 0;
+        uint32_t sessions = 0; // times ONLINE was reached
+        uint32_t disconnects = 0;
+        uint32_t emits = 0;       // dev-data sent
+        uint32_t cmdsApplied = 0; // output app-cmds
+        uint64_t onlineUs = 0;    // when the last session started
+        uint64_t offlineUs = 0;   // when the last one ended
+    };
+    const Stats &stats() const { return counters; }
+
+private:
+    void startAuth();
+    void finishAuth();
+    void wsEvent(WStype_t type, const char *payload, size_t length);
+    void handlePacket(const char *packet, size_t length);
+    void sendPacket(const String &packet);
+    void emitDevData();
+
+    SimServer &server;
+    Listener *listener;
+    uint32_t id;
+    std::string serial;
+    WebSocketsClient ws;
+    State st = BOOTING;
+    uint64_t wakeUs; // BOOTING: boot; AUTHENTICATING: response arrives
+    host::HttpResponse authResponse;
+    String authToken;
+    bool bootupReady = false;
+    bool dataUpdateRequired = false;
+    unsigned long lastDataSend = 0;
+    uint8_t inputs[SENSOR_COUNT]; // LOW: active, as the firmware keeps them
+    Stats counters;
+};
@@ -0,0 +1,118 @@
+#include "image_push.h"
+
+#include <cstring>
+
+static void putBe32(std::vector<uint8_t> &out, uint32_t v)
+{
+    for (int shift = 24; shift >= 0; shift -= 8)
+        out.push_back((uint8_t)(v >> shift));
+}
+
+// Reference encoder from the QOI specification
+std::vector<uint8_t> qoiEncode(const uint8_t *pixels, int width, int height, int channels)
+{
+    std::vector<uint8_t> out = {'q', 'o', 'i', 'f'};
+    putBe32(out, (uint32_t)width);
+    putBe32(out, (uint32_t)height);
+    out.push_back((uint8_t)channels);
+    out.push_back(0); // sRGB
+
+    uint8_t index[64][4] = {};
+    uint8_t prev[4] = {0, 0, 0, 255};
+    int run = 0;
+    const size_t count = (size_t)width * height;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const uint8_t *p = pixels + i * channels;
+        const uint8_t px[4] = {p[0], p[1], p[2], channels == 4 ? p[3] : (uint8_t)255};
+
+        if (memcmp(px, prev, 4) == 0)
+        {
+            if (++run == 62 || i + 1 == count)
+            {
+                out.push_back((uint8_t)(0xC0 | (run - 1)));
+                run = 0;
+            }
+            continue;
+        }
+        if (run > 0)
+        {
+            out.push_back((uint8_t)(0xC0 | (run - 1)));
+            run = 0;
+        }
+
+        const int hash = (px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64;
+        if (memcmp(index[hash], px, 4) == 0)
+        {
+            out.push_back((uint8_t)hash);
+        }
+        else
+        {
+            memcpy(index[hash], px, 4);
+            if (px[3] == prev[3])
+            {
+                const int8_t vr = (int8_t)(px[0] - prev[0]);
+                const int8_t vg = (int8_t)(px[1] - prev[1]);
+                const int8_t vb = (int8_t)(px[2] - prev[2]);
+                const int8_t vgr = (int8_t)(vr - vg);
+                const int8_t vgb = (int8_t)(vb - vg);
+                if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2)
+                {
+                    out.push_back((uint8_t)(0x40 | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2)));
+                }
+                else if (vgr > -9 && vgr < 8 && vg > -33 && vg < 32 && vgb > -9 && vgb < 8)
+                {
+                    out.push_back((uint8_t)(0x80 | (vg + 32)));
+                    out.push_back((uint8_t)((vgr + 8) << 4 | (vgb + 8)));
+                }
+                else
+                {
+                    out.push_back(0xFE);
+                    out.insert(out.end(), px, px + 3);
+                }
+            }
+            else
+            {
+                out.push_back(0xFF);
+                out.insert(out.end(), px, px + 4);
+            }
+        }
+        memcpy(prev, px, 4);
+    }
+
+    static const uint8_t END_MARKER[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+    out.insert(out.end(), END_MARKER, END_MARKER + 8);
+    return out;
+}
+
+std::string base64Encode(const uint8_t *data, size_t len)
+{
+    static const char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    out.reserve((len + 2) / 3 * 4);
+    for (size_t i = 0; i < len; i += 3)
+    {
+        const uint32_t v = (uint32_t)data[i] << 16 | (i + 1 < len ? (uint32_t)data[i + 1] << 8 : 0) |
+                           (i + 2 < len ? data[i + 2] : 0);
+        out += ALPHABET[(v >> 18) & 63];
+        out += ALPHABET[(v >> 12) & 63];
+        out += i + 1 < len ? ALPHABET[(v >> 6) & 63] : '=';
+        out += i + 2 < len ? ALPHABET[v & 63] : '=';
+    }
+    return out;
+}
+
+std::vector<std::string> imagePushOperations(const std::vector<uint8_t> &qoi, int x, int y, size_t chunkBytes)
+{
+    std::vector<std::string> ops;
+    for (size_t off = 0, seq = 0; off < qoi.size(); off += chunkBytes, ++seq)
+    {
+        const size_t n = qoi.size() - off < chunkBytes ? qoi.size() - off : chunkBytes;
+        std::string op = "{\"customCmd\":\"lcd-image\",\"seq\":" + std::to_string(seq);
+        if (seq == 0)
+            op += ",\"x\":" + std::to_string(x) + ",\"y\":" + std::to_string(y);
+        op += ",\"data\":\"" + base64Encode(qoi.data() + off, n) + "\"}";
+        ops.push_back(op);
+    }
+    return ops;
+}
@@ -0,0 +1,17 @@
+// Server side of the input-device-lcd "lcd-image" app-cmd: QOI encoding
+// and splitting into base64 chunks, for the simulator and the image_push
+// tool.
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// QOI of 8-bit pixels with channels 3 (RGB) or 4 (RGBA)
+std::vector<uint8_t> qoiEncode(const uint8_t *pixels, int width, int height, int channels);
+
+std::string base64Encode(const uint8_t *data, size_t len);
+
+// app-cmd operation objects ({"customCmd":"lcd-image",...}) carrying qoi
+// in chunks of at most chunkBytes before base64
+std::vector<std::string> imagePushOperations(const std::vector<uint8_t> &qoi, int x, int y, size_t chunkBytes);
@@ -0,0 +1,71 @@
+#include "legacy_ili9341.h"
+
+#include "sim_panel.h"
+
+#define ILI9341_CASET 0x2A
+#define ILI9341_PASET 0x2B
+#define ILI9341_RAMWR 0x2C
+
+namespace legacy_ili9341
+{
+    // SPI.transfer(): one byte, one transaction
+    static void transfer(bool dc, uint8_t value)
+    {
+        SimPanel &panel = SimPanel::get();
+        panel.beginTransaction();
+        panel.write(dc, &value, 1);
+    }
+
+    static void setAddrWindow(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1)
+    {
+        transfer(false, ILI9341_CASET);
+        transfer(true, x0 >> 8);
+        transfer(true, x0 & 0xFF);
+        transfer(true, x1 >> 8);
+        transfer(true, x1 & 0xFF);
+
+        transfer(false, ILI9341_PASET);
+        transfer(true, y0 >> 8);
+        transfer(true, y0 & 0xFF);
+        transfer(true, y1 >> 8);
+        transfer(true, y1 & 0xFF);
+
+        transfer(false, ILI9341_RAMWR);
+    }
+
+    static void drawPixel(int16_t x, int16_t y, uint16_t color)
+    {
+        setAddrWindow(x, y, x, y);
+        transfer(true, color >> 8);
+        transfer(true, color & 0xFF);
+    }
+
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+    {
+        setAddrWindow(x, y, x + w - 1, y + h - 1);
+        for (uint32_t i = 0; i < (uint32_t)w * h; ++i)
+        {
+            transfer(true, color >> 8);
+            transfer(true, color & 0xFF);
+        }
+    }
+
+    void fillScreen(uint16_t color)
+    {
+        fillRect(0, 0, SimPanel::WIDTH, SimPanel::HEIGHT, color);
+    }
+
+    void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+    {
+        for (int16_t i = 0; i < w; ++i)
+        {
+            drawPixel(x + i, y, color);
+            drawPixel(x + i, y + h - 1, color);
+        }
+        for (int16_t i = 0; i < h; ++i)
+        {
+            drawPixel(x, y + i, color);
+            drawPixel(x + w - 1, y + i, color);
+        }
+    }
+}
@@ -0,0 +1,21 @@
+// The output-device ILI9341 driver as it was before the queued DMA rewrite,
+// replayed on SimPanel so lcd_sim_output can cost the old and new paths
+// side by side. It mirrors the old lcd.cpp: every byte is its own
+// SPI.transfer() call (one bus transaction each), commands and parameters
+// are CS-framed one by one, and no clock is set, so the bus ran at the
+// Arduino-ESP32 SPI default.
+#pragma once
+
+#include <cstdint>
+
+namespace legacy_ili9341
+{
+    static const uint32_t DEFAULT_CLOCK_HZ = 1000000;
+
+    void fillScreen(uint16_t color);
+    // The old driver had no fillRect(); this is fillScreen()'s loop over a
+    // smaller window, the way a caller would have written it
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    // Two drawPixel() calls per edge pixel, as before
+    void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+}
@@ -0,0 +1,177 @@
+#include "png_io.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <zlib.h>
+
+static const uint8_t PNG_SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+static void putBe32(std::vector<uint8_t> &out, uint32_t v)
+{
+    out.push_back((uint8_t)(v >> 24));
+    out.push_back((uint8_t)(v >> 16));
+    out.push_back((uint8_t)(v >> 8));
+    out.push_back((uint8_t)v);
+}
+
+static uint32_t getBe32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void putChunk(std::vector<uint8_t> &out, const char *type, const std::vector<uint8_t> &data)
+{
+    putBe32(out, (uint32_t)data.size());
+    const size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    putBe32(out, (uint32_t)crc32(0, out.data() + start, (uInt)(out.size() - start)));
+}
+
+std::vector<uint8_t> rgb565ToRgb888(const uint16_t *pixels, int width, int height)
+{
+    std::vector<uint8_t> rgb((size_t)width * height * 3);
+    for (size_t i = 0; i < (size_t)width * height; ++i)
+    {
+        const uint16_t c = pixels[i];
+        const uint8_t r = (c >> 11) & 0x1F, g = (c >> 5) & 0x3F, b = c & 0x1F;
+        rgb[i * 3 + 0] = (uint8_t)((r << 3) | (r >> 2));
+        rgb[i * 3 + 1] = (uint8_t)((g << 2) | (g >> 4));
+        rgb[i * 3 + 2] = (uint8_t)((b << 3) | (b >> 2));
+    }
+    return rgb;
+}
+
+bool writeRgb565Png(const std::string &path, const uint16_t *pixels, int width, int height)
+{
+    const std::vector<uint8_t> rgb = rgb565ToRgb888(pixels, width, height);
+
+    // Scanlines with filter type 0
+    std::vector<uint8_t> raw;
+    raw.reserve((size_t)height * (width * 3 + 1));
+    for (int y = 0; y < height; ++y)
+    {
+        raw.push_back(0);
+        raw.insert(raw.end(), rgb.begin() + (size_t)y * width * 3, rgb.begin() + (size_t)(y + 1) * width * 3);
+    }
+
+    uLongf packed = compressBound((uLong)raw.size());
+    std::vector<uint8_t> idat(packed);
+    if (compress2(idat.data(), &packed, raw.data(), (uLong)raw.size(), Z_BEST_COMPRESSION) != Z_OK)
+        return false;
+    idat.resize(packed);
+
+    std::vector<uint8_t> ihdr;
+    putBe32(ihdr, (uint32_t)width);
+    putBe32(ihdr, (uint32_t)height);
+    ihdr.push_back(8); // bit depth
+    ihdr.push_back(2); // truecolour
+    ihdr.push_back(0); // deflate
+    ihdr.push_back(0); // adaptive filtering
+    ihdr.push_back(0); // no interlace
+
+    std::vector<uint8_t> file(PNG_SIGNATURE, PNG_SIGNATURE + sizeof(PNG_SIGNATURE));
+    putChunk(file, "IHDR", ihdr);
+    putChunk(file, "IDAT", idat);
+    putChunk(file, "IEND", {});
+
+    FILE *f = fopen(path.c_str(), "wb");
+    if (!f)
+        return false;
+    const bool ok = fwrite(file.data(), 1, file.size(), f) == file.size();
+    return fclose(f) == 0 && ok;
+}
+
+bool readRgbPng(const std::string &path, std::vector<uint8_t> &rgb, int &width, int &height)
+{
+    FILE *f = fopen(path.c_str(), "rb");
+    if (!f)
+        return false;
+    std::vector<uint8_t> file;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+        file.insert(file.end(), buf, buf + n);
+    fclose(f);
+
+    if (file.size() < 8 || memcmp(file.data(), PNG_SIGNATURE, 8) != 0)
+        return false;
+
+    std::vector<uint8_t> zdata;
+    width = height = 0;
+    for (size_t pos = 8; pos + 12 <= file.size();)
+    {
+        const uint32_t len = getBe32(&file[pos]);
+        if (pos + 12 + len > file.size())
+            return false;
+        const char *type = (const char *)&file[pos + 4];
+        const uint8_t *data = &file[pos + 8];
+        if (memcmp(type, "IHDR", 4) == 0)
+        {
+            if (len != 13 || data[8] != 8 || data[9] != 2 || data[12] != 0)
+                return false;
+            width = (int)getBe32(data);
+            height = (int)getBe32(data + 4);
+        }
+        else if (memcmp(type, "IDAT", 4) == 0)
+        {
+            zdata.insert(zdata.end(), data, data + len);
+        }
+        else if (memcmp(type, "IEND", 4) == 0)
+        {
+            break;
+        }
+        pos += 12 + len;
+    }
+    if (width <= 0 || height <= 0 || zdata.empty())
+        return false;
+
+    const size_t stride = (size_t)width * 3;
+    std::vector<uint8_t> raw((stride + 1) * height);
+    uLongf rawLen = (uLongf)raw.size();
+    if (uncompress(raw.data(), &rawLen, zdata.data(), (uLong)zdata.size()) != Z_OK || rawLen != raw.size())
+        return false;
+
+    // Undo the per-scanline filters (PNG spec 9.2), 3 bytes per pixel
+    rgb.resize(stride * height);
+    for (int y = 0; y < height; ++y)
+    {
+        const uint8_t filter = raw[y * (stride + 1)];
+        const uint8_t *src = &raw[y * (stride + 1) + 1];
+        uint8_t *dst = &rgb[y * stride];
+        const uint8_t *up = y > 0 ? &rgb[(y - 1) * stride] : nullptr;
+        for (size_t i = 0; i < stride; ++i)
+        {
+            const int a = i >= 3 ? dst[i - 3] : 0;
+            const int b = up ? up[i] : 0;
+            const int c = (up && i >= 3) ? up[i - 3] : 0;
+            int pred = 0;
+            switch (filter)
+            {
+            case 0:
+                break;
+            case 1:
+                pred = a;
+                break;
+            case 2:
+                pred = b;
+                break;
+            case 3:
+                pred = (a + b) / 2;
+                break;
+            case 4:
+            {
+                const int p = a + b - c, pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+                pred = (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+                break;
+            }
+            default:
+                return false;
+            }
+            dst[i] = (uint8_t)(src[i] + pred);
+        }
+    }
+    return true;
+}
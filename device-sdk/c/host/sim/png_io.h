@@ -0,0 +1,19 @@
+// Minimal PNG I/O for simulator output and golden images.
+//
+// Writes and reads non-interlaced 8-bit RGB PNGs, nothing else. Goldens
+// are produced by writeRgb565Png() and compared pixel-for-pixel after
+// RGB565 -> RGB888 expansion, which is lossless in that direction.
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+bool writeRgb565Png(const std::string &path, const uint16_t *pixels, int width, int height);
+
+// Returns false for anything but 8-bit RGB without interlacing. All five
+// scanline filters are accepted, so PNGs from other tools load too.
+bool readRgbPng(const std::string &path, std::vector<uint8_t> &rgb, int &width, int &height);
+
+// RGB565 framebuffer expanded the same way writeRgb565Png() does
+std::vector<uint8_t> rgb565ToRgb888(const uint16_t *pixels, int width, int height);
@@ -0,0 +1,243 @@
+#include "sim_panel.h"
+
+#include <cstring>
+
+// Commands shared by ILI9341 and ST7789
+#define CMD_CASET 0x2A
+#define CMD_PASET 0x2B
+#define CMD_RAMWR 0x2C
+#define CMD_RAMRD 0x2E
+#define CMD_VSCRDEF 0x33
+#define CMD_VSCSAD 0x37
+
+SimPanel &SimPanel::get()
+{
+    static SimPanel panel;
+    return panel;
+}
+
+SimPanel::SimPanel() : clockHz(40000000), clockOverrideHz(0), overheadNs(2000), signalLimitHz(0)
+{
+    reset();
+}
+
+void SimPanel::reset()
+{
+    memset(fb, 0, sizeof(fb));
+    resetStats();
+    currentCmd = 0;
+    paramCount = 0;
+    inRamWrite = false;
+    pendingByte = -1;
+    colStart = 0;
+    colEnd = WIDTH - 1;
+    rowStart = 0;
+    rowEnd = HEIGHT - 1;
+    cursorX = 0;
+    cursorY = 0;
+    rotation = 0;
+    scrollTfa = 0;
+    scrollVsa = HEIGHT;
+    scrollBfa = 0;
+    scrollVsp = 0;
+}
+
+void SimPanel::resetStats()
+{
+    memset(&counters, 0, sizeof(counters));
+}
+
+double SimPanel::busMicros() const
+{
+    const uint32_t hz = effectiveClockHz();
+    const double wire = hz ? (double)counters.bytes * 8.0 * 1e6 / hz : 0.0;
+    return wire + (double)counters.transactions * overheadNs / 1000.0;
+}
+
+uint16_t SimPanel::pixel(int x, int y) const
+{
+    if (x < 0 || y < 0 || x >= WIDTH || y >= HEIGHT)
+        return 0;
+    return fb[y * WIDTH + x];
+}
+
+void SimPanel::beginTransaction()
+{
+    counters.transactions++;
+}
+
+void SimPanel::write(bool dc, const uint8_t *bytes, size_t len)
+{
+    counters.bytes += len;
+    for (size_t i = 0; i < len; ++i)
+    {
+        if (!dc)
+            command(bytes[i]);
+        else if (inRamWrite)
+        {
+            if (pendingByte < 0)
+            {
+                pendingByte = bytes[i];
+            }
+            else
+            {
+                storePixel((uint16_t)((pendingByte << 8) | bytes[i]));
+                pendingByte = -1;
+            }
+        }
+        else
+        {
+            parameter(bytes[i]);
+        }
+    }
+}
+
+void SimPanel::command(uint8_t cmd)
+{
+    currentCmd = cmd;
+    paramCount = 0;
+    pendingByte = -1;
+    inRamWrite = (cmd == CMD_RAMWR);
+    if (inRamWrite)
+    {
+        counters.windows++;
+        cursorX = colStart;
+        cursorY = rowStart;
+    }
+}
+
+void SimPanel::parameter(uint8_t value)
+{
+    if (paramCount < (int)sizeof(params))
+        params[paramCount] = value;
+    paramCount++;
+
+    if (currentCmd == CMD_VSCRDEF && paramCount == 6)
+    {
+        const int tfa = (params[0] << 8) | params[1];
+        const int vsa = (params[2] << 8) | params[3];
+        const int bfa = (params[4] << 8) | params[5];
+        if (tfa + vsa + bfa == HEIGHT && vsa > 0) // the panel ignores anything else
+        {
+            scrollTfa = tfa;
+            scrollVsa = vsa;
+            scrollBfa = bfa;
+        }
+        return;
+    }
+    if (currentCmd == CMD_VSCSAD && paramCount == 2)
+    {
+        scrollVsp = (params[0] << 8) | params[1];
+        return;
+    }
+    if (paramCount != 4)
+        return;
+
+    const int start = (params[0] << 8) | params[1];
+    const int end = (params[2] << 8) | params[3];
+    if (currentCmd == CMD_CASET)
+    {
+        colStart = start;
+        colEnd = end;
+    }
+    else if (currentCmd == CMD_PASET)
+    {
+        rowStart = start;
+        rowEnd = end;
+    }
+}
+
+void SimPanel::storePixel(uint16_t color)
+{
+    counters.pixels++;
+    if (signalLimitHz && clockHz > signalLimitHz && counters.pixels % 61 == 0)
+        color ^= 0x0821;
+    if (cursorX < WIDTH && cursorY < HEIGHT)
+        fb[cursorY * WIDTH + cursorX] = color;
+
+    if (++cursorX > colEnd)
+    {
+        cursorX = colStart;
+        if (++cursorY > rowEnd)
+            cursorY = rowStart;
+    }
+}
+
+void SimPanel::setWindow(int x, int y, int w, int h)
+{
+    address(x, y, w, h, CMD_RAMWR);
+}
+
+void SimPanel::address(int x, int y, int w, int h, uint8_t memoryCmd)
+{
+    const uint8_t cmdCaset = CMD_CASET;
+    const uint8_t cmdPaset = CMD_PASET;
+    const int x1 = x + w - 1;
+    const int y1 = y + h - 1;
+    const uint8_t cols[4] = {(uint8_t)(x >> 8), (uint8_t)x, (uint8_t)(x1 >> 8), (uint8_t)x1};
+    const uint8_t rows[4] = {(uint8_t)(y >> 8), (uint8_t)y, (uint8_t)(y1 >> 8), (uint8_t)y1};
+
+    write(false, &cmdCaset, 1);
+    write(true, cols, 4);
+    write(false, &cmdPaset, 1);
+    write(true, rows, 4);
+    write(false, &memoryCmd, 1);
+}
+
+void SimPanel::pushPixels(const uint16_t *pixels, size_t count)
+{
+    uint8_t chunk[512];
+    while (count > 0)
+    {
+        const size_t n = count < sizeof(chunk) / 2 ? count : sizeof(chunk) / 2;
+        for (size_t i = 0; i < n; ++i)
+        {
+            chunk[2 * i] = (uint8_t)(pixels[i] >> 8);
+            chunk[2 * i + 1] = (uint8_t)pixels[i];
+        }
+        write(true, chunk, n * 2);
+        pixels += n;
+        count -= n;
+    }
+}
+
+void SimPanel::fillPixels(uint16_t color, size_t count)
+{
+    uint8_t chunk[512];
+    for (size_t i = 0; i < sizeof(chunk); i += 2)
+    {
+        chunk[i] = (uint8_t)(color >> 8);
+        chunk[i + 1] = (uint8_t)color;
+    }
+    while (count > 0)
+    {
+        const size_t n = count < sizeof(chunk) / 2 ? count : sizeof(chunk) / 2;
+        write(true, chunk, n * 2);
+        count -= n;
+    }
+}
+
+void SimPanel::readPixels(int x, int y, int w, int h, uint16_t *out)
+{
+    beginTransaction();
+    address(x, y, w, h, CMD_RAMRD);
+    counters.bytes += 1 + (uint64_t)w * h * 3; // dummy byte, RGB666 pixels
+    for (int row = 0; row < h; ++row)
+        for (int col = 0; col < w; ++col)
+            *out++ = pixel(x + col, y + row);
+}
+
+void SimPanel::visibleFrame(uint16_t *out) const
+{
+    const bool mirrored = rotation == 2;
+    for (int row = 0; row < HEIGHT; ++row)
+    {
+        // Scan line on the glass, then the panel row the scroll shows there
+        const int line = mirrored ? HEIGHT - 1 - row : row;
+        int panelRow = line;
+        if (line >= scrollTfa && line < scrollTfa + scrollVsa)
+            panelRow = scrollTfa + ((line - scrollTfa) + (scrollVsp - scrollTfa) % scrollVsa + scrollVsa) % scrollVsa;
+        const int y = mirrored ? HEIGHT - 1 - panelRow : panelRow;
+        memcpy(out + row * WIDTH, fb + y * WIDTH, WIDTH * sizeof(uint16_t));
+    }
+}
@@ -0,0 +1,103 @@
+// Simulated 240x320 RGB565 SPI panel (ILI9341 / ST7789 command subset).
+//
+// The host shims for both LCD backends end up here: the ESP-IDF SPI master
+// shim feeds raw command/data bytes, the LovyanGFX shim writes whole
+// address windows. Either way the panel decodes CASET/PASET/RAMWR into its
+// framebuffer and counts what crossed the bus, so drawing code can be
+// compared by transactions, bytes and simulated SPI time.
+//
+// The framebuffer is kept in drawing coordinates. Vertical scrolling
+// (VSCRDEF/VSCSAD) only changes what the glass shows, see visibleFrame().
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+class SimPanel
+{
+public:
+    static const int WIDTH = 240;
+    static const int HEIGHT = 320;
+
+    struct Stats
+    {
+        uint32_t transactions; // CS-framed bus transactions
+        uint32_t windows;      // RAMWR commands, i.e. address windows written
+        uint64_t bytes;        // command + parameter + pixel bytes on the wire
+        uint64_t pixels;       // pixels stored into panel RAM
+    };
+
+    static SimPanel &get();
+
+    // Black framebuffer, default registers, zeroed stats
+    void reset();
+    void resetStats();
+    const Stats &stats() const { return counters; }
+
+    // Bus model: every byte costs 8 clocks, every transaction a fixed
+    // overhead (CS/DC setup, driver bookkeeping). The driver shims set the
+    // clock the firmware configured; a harness may override it for the
+    // time estimate.
+    void setClockHz(uint32_t hz) { clockHz = hz; }
+    uint32_t getClockHz() const { return clockHz; }
+    void setClockOverrideHz(uint32_t hz) { clockOverrideHz = hz; }
+    uint32_t effectiveClockHz() const { return clockOverrideHz ? clockOverrideHz : clockHz; }
+    void setTransactionOverheadNs(uint32_t ns) { overheadNs = ns; }
+    uint32_t getTransactionOverheadNs() const { return overheadNs; }
+    double busMicros() const;
+
+    // Signal integrity model: above this write clock (0 = no limit) some
+    // stored pixels get bits flipped, like a marginal wire would.
+    void setSignalLimitHz(uint32_t hz) { signalLimitHz = hz; }
+
+    // RAMRD of a window into out (native RGB565), accounted as one
+    // transaction of command, dummy byte and 3 bytes per pixel.
+    void readPixels(int x, int y, int w, int h, uint16_t *out);
+
+    // Byte level, as clocked over SPI. dc == false marks command bytes.
+    void beginTransaction();
+    void write(bool dc, const uint8_t *bytes, size_t len);
+
+    // Window level helpers, accounted exactly like the equivalent bytes
+    void setWindow(int x, int y, int w, int h);
+    void pushPixels(const uint16_t *pixels, size_t count); // native RGB565
+    void fillPixels(uint16_t color, size_t count);
+
+    const uint16_t *framebuffer() const { return fb; }
+    uint16_t pixel(int x, int y) const;
+
+    // Rotation the driver set; 2 means panel rows run bottom to top in
+    // drawing coordinates, which matters for the scroll registers
+    void setRotation(uint8_t r) { rotation = r & 3; }
+
+    // What the glass shows: the framebuffer with the vertical scroll
+    // applied, WIDTH * HEIGHT pixels in drawing orientation
+    void visibleFrame(uint16_t *out) const;
+
+private:
+    SimPanel();
+
+    void address(int x, int y, int w, int h, uint8_t memoryCmd);
+    void command(uint8_t cmd);
+    void parameter(uint8_t value);
+    void storePixel(uint16_t color);
+
+    uint16_t fb[WIDTH * HEIGHT];
+    Stats counters;
+    uint32_t clockHz;
+    uint32_t clockOverrideHz;
+    uint32_t overheadNs;
+    uint32_t signalLimitHz;
+
+    uint8_t currentCmd;
+    uint8_t params[6];
+    int paramCount;
+    bool inRamWrite;
+    int pendingByte; // first byte of a pixel split across writes, or -1
+
+    int colStart, colEnd, rowStart, rowEnd;
+    int cursorX, cursorY;
+
+    uint8_t rotation;
+    int scrollTfa, scrollVsa, scrollBfa, scrollVsp; // panel rows
+};
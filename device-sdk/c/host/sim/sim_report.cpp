@@ -0,0 +1,145 @@
+#include "sim_report.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "png_io.h"
+
+static void usage(const char *prog, const char *extra)
+{
+    fprintf(stderr,
+            "usage: %s [--clock-hz N] [--overhead-ns N] [--signal-limit-hz N] [--psram] [--png-dir DIR]\n"
+            "          [--golden-dir DIR [--update-golden]] [--csv FILE]%s%s\n",
+            prog, extra ? " " : "", extra ? extra : "");
+}
+
+bool parseSimOptions(int argc, char **argv, SimOptions &opts, const char *extraUsage)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "--clock-hz") == 0 && hasValue)
+            opts.clockHz = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--overhead-ns") == 0 && hasValue)
+            opts.overheadNs = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--signal-limit-hz") == 0 && hasValue)
+            opts.signalLimitHz = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--psram") == 0)
+            opts.psram = true;
+        else if (strcmp(arg, "--png-dir") == 0 && hasValue)
+            opts.pngDir = argv[++i];
+        else if (strcmp(arg, "--golden-dir") == 0 && hasValue)
+            opts.goldenDir = argv[++i];
+        else if (strcmp(arg, "--update-golden") == 0)
+            opts.updateGolden = true;
+        else if (strcmp(arg, "--csv") == 0 && hasValue)
+            opts.csvPath = argv[++i];
+        else
+        {
+            usage(argv[0], extraUsage);
+            return false;
+        }
+    }
+    return true;
+}
+
+SimReport::SimReport(const SimOptions &o) : opts(o)
+{
+    SimPanel &panel = SimPanel::get();
+    panel.setClockOverrideHz(opts.clockHz);
+    panel.setTransactionOverheadNs(opts.overheadNs);
+    panel.setSignalLimitHz(opts.signalLimitHz);
+
+    printf("bus: %u ns per transaction%s\n\n", opts.overheadNs, opts.clockHz ? ", clock overridden" : "");
+    printf("%-22s %7s %8s %8s %10s %10s %10s  %s\n", "step", "mhz", "trans", "windows", "bytes", "pixels", "bus_us",
+           "");
+
+    if (!opts.csvPath.empty())
+    {
+        csv = fopen(opts.csvPath.c_str(), "w");
+        if (csv)
+            fprintf(csv, "step,clock_hz,transactions,windows,bytes,pixels,bus_us\n");
+        else
+            fprintf(stderr, "cannot write %s\n", opts.csvPath.c_str());
+    }
+}
+
+SimReport::~SimReport()
+{
+    if (csv)
+        fclose(csv);
+}
+
+void SimReport::begin(const char *name)
+{
+    step = name;
+    SimPanel::get().resetStats();
+}
+
+void SimReport::end(const char *extra)
+{
+    const SimPanel &panel = SimPanel::get();
+    const SimPanel::Stats &s = panel.stats();
+    const uint32_t hz = panel.effectiveClockHz();
+    printf("%-22s %7.2f %8u %8u %10llu %10llu %10.1f  %s\n", step.c_str(), hz / 1e6, s.transactions, s.windows,
+           (unsigned long long)s.bytes, (unsigned long long)s.pixels, panel.busMicros(), extra);
+    if (csv)
+        fprintf(csv, "%s,%u,%u,%u,%llu,%llu,%.1f\n", step.c_str(), hz, s.transactions, s.windows,
+                (unsigned long long)s.bytes, (unsigned long long)s.pixels, panel.busMicros());
+
+    // Compared as the glass shows it, so hardware scrolling is covered
+    std::vector<uint16_t> visible((size_t)SimPanel::WIDTH * SimPanel::HEIGHT);
+    panel.visibleFrame(visible.data());
+    const uint16_t *fb = visible.data();
+    if (!opts.pngDir.empty())
+        writeRgb565Png(opts.pngDir + "/" + step + ".png", fb, SimPanel::WIDTH, SimPanel::HEIGHT);
+
+    if (opts.goldenDir.empty())
+        return;
+    const std::string golden = opts.goldenDir + "/" + step + ".png";
+    if (opts.updateGolden)
+    {
+        if (!writeRgb565Png(golden, fb, SimPanel::WIDTH, SimPanel::HEIGHT))
+        {
+            fprintf(stderr, "  cannot write %s\n", golden.c_str());
+            failed++;
+        }
+        return;
+    }
+
+    std::vector<uint8_t> expected;
+    int w = 0, h = 0;
+    if (!readRgbPng(golden, expected, w, h))
+    {
+        fprintf(stderr, "  %s: golden missing or unreadable: %s\n", step.c_str(), golden.c_str());
+        failed++;
+        return;
+    }
+    const std::vector<uint8_t> actual = rgb565ToRgb888(fb, SimPanel::WIDTH, SimPanel::HEIGHT);
+    if (w != SimPanel::WIDTH || h != SimPanel::HEIGHT)
+    {
+        fprintf(stderr, "  %s: golden is %dx%d\n", step.c_str(), w, h);
+        failed++;
+        return;
+    }
+    size_t diff = 0, first = 0;
+    for (size_t i = 0; i < actual.size(); i += 3)
+    {
+        if (memcmp(&actual[i], &expected[i], 3) != 0 && diff++ == 0)
+            first = i / 3;
+    }
+    if (diff)
+    {
+        fprintf(stderr, "  %s: %zu pixels differ from golden, first at (%zu,%zu)\n", step.c_str(), diff,
+                first % SimPanel::WIDTH, first / SimPanel::WIDTH);
+        failed++;
+    }
+}
+
+void SimReport::fail(const char *what)
+{
+    fprintf(stderr, "  %s\n", what);
+    failed++;
+}
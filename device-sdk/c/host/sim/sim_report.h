@@ -0,0 +1,51 @@
+// Shared output of the LCD simulators: per-step bus cost table, optional
+// CSV, PNG snapshots and golden-image comparison.
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "sim_panel.h"
+
+struct SimOptions
+{
+    uint32_t clockHz = 0; // 0: the clock the firmware configured
+    uint32_t overheadNs = 2000;
+    uint32_t signalLimitHz = 0;
+    bool psram = false;
+    std::string pngDir;    // write <step>.png here when set
+    std::string goldenDir; // compare against <step>.png here when set
+    bool updateGolden = false;
+    std::string csvPath;
+};
+
+// Parses the flags common to both simulators. Unknown flags print usage
+// and return false.
+bool parseSimOptions(int argc, char **argv, SimOptions &opts, const char *extraUsage = nullptr);
+
+class SimReport
+{
+public:
+    explicit SimReport(const SimOptions &opts);
+    ~SimReport();
+
+    // Starts a measured step: resets the panel counters
+    void begin(const char *name);
+
+    // Ends the step: prints its cost, snapshots the framebuffer and checks
+    // it against the golden image. extra is appended to the table row.
+    void end(const char *extra = "");
+
+    // Records a failed check outside the golden comparison
+    void fail(const char *what);
+
+    // Number of golden mismatches (or missing goldens) and failed checks so far
+    int failures() const { return failed; }
+
+private:
+    const SimOptions &opts;
+    FILE *csv = nullptr;
+    std::string step;
+    int failed = 0;
+};
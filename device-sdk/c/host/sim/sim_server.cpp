@@ -0,0 +1,312 @@
+#include "sim_server.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+SimServer::SimServer(const SimServerOptions &o) : opts(o), rng(o.seed ? o.seed : 1)
+{
+    authWorkerFreeUs.assign(opts.authWorkers, 0);
+}
+
+SimServer::~SimServer()
+{
+    host::setWsPeer(nullptr);
+    host::setHttpHandler(nullptr);
+}
+
+void SimServer::install()
+{
+    host::setWsPeer(this);
+    host::setHttpHandler([this](const host::HttpRequest &request) { return authenticate(request); });
+}
+
+host::HttpResponse SimServer::authenticate(const host::HttpRequest &request)
+{
+    const uint64_t now = host::nowMicros();
+    host::HttpResponse response;
+    response.latencyMs = 2 * opts.linkLatencyMs;
+    if (request.url.find("/api/v3/devices/auth") == std::string::npos || request.method != "POST")
+    {
+        response.code = 404;
+        return response;
+    }
+    st.authRequests++;
+
+    // FIFO over authWorkers: start times never decrease, so the ones still
+    // in the future are the queue
+    while (!authStartsUs.empty() && authStartsUs.front() <= now)
+        authStartsUs.pop_front();
+    if (now < outageUntilUs || (opts.authQueueMax && authStartsUs.size() >= opts.authQueueMax))
+    {
+        st.authRejected++;
+        response.code = 503;
+        return response;
+    }
+    uint64_t startUs = now;
+    if (!authWorkerFreeUs.empty())
+    {
+        auto worker = std::min_element(authWorkerFreeUs.begin(), authWorkerFreeUs.end());
+        startUs = std::max(now, *worker);
+        *worker = startUs + (uint64_t)opts.authLatencyMs * 1000;
+        if (startUs > now)
+            authStartsUs.push_back(startUs);
+    }
+    response.latencyMs += (uint32_t)((startUs - now) / 1000) + opts.authLatencyMs;
+    st.authMs.push_back(response.latencyMs);
+
+    response.code = opts.authCode;
+    if (opts.authCode == 200)
+        response.body = "{\"token\":\"sim-token\"}";
+    return response;
+}
+
+uint64_t SimServer::linkDelayUs()
+{
+    uint64_t us = (uint64_t)opts.linkLatencyMs * 1000;
+    if (opts.linkJitterMs)
+    {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        us += rng % ((uint64_t)opts.linkJitterMs * 1000 + 1);
+    }
+    return us;
+}
+
+void SimServer::push(Conn conn, Session &session, const std::string &text)
+{
+    if (session.stalled)
+        return;
+    // Jitter may not reorder a connection's frames
+    const uint64_t due = std::max(host::nowMicros() + linkDelayUs(), session.lastDownUs);
+    session.lastDownUs = due;
+    host::wsPush(conn, text, due);
+    st.framesOut++;
+}
+
+bool SimServer::accept(Conn conn, const std::string &host, uint16_t port, const std::string &url)
+{
+    (void)host;
+    (void)port;
+    if (url.find("EIO=4") == std::string::npos)
+        return false;
+    const uint64_t now = host::nowMicros();
+    if (now < outageUntilUs)
+    {
+        st.refused++;
+        return false;
+    }
+    if (opts.acceptPerSec)
+    {
+        if (now >= acceptWindowUs + 1000000)
+        {
+            acceptWindowUs = now - now % 1000000;
+            acceptsInWindow = 0;
+        }
+        if (acceptsInWindow >= opts.acceptPerSec)
+        {
+            st.refused++;
+            return false;
+        }
+        acceptsInWindow++;
+    }
+    conns[conn] = Session();
+    st.connects++;
+    return true;
+}
+
+void SimServer::opened(Conn conn)
+{
+    auto it = conns.find(conn);
+    if (it == conns.end())
+        return;
+    char open[160];
+    snprintf(open, sizeof(open),
+             "0{\"sid\":\"sim%lu\",\"upgrades\":[],\"pingInterval\":%lu,\"pingTimeout\":%lu,\"maxPayload\":1000000}",
+             (unsigned long)st.connects, (unsigned long)opts.pingIntervalMs, (unsigned long)opts.pingTimeoutMs);
+    push(conn, it->second, open);
+    it->second.nextPingUs = host::nowMicros() + (uint64_t)opts.pingIntervalMs * 1000;
+}
+
+void SimServer::closed(Conn conn)
+{
+    auto it = conns.find(conn);
+    if (it == conns.end())
+        return;
+    if (it->second.open)
+        openSessions--;
+    conns.erase(it);
+    for (auto frame = uplink.begin(); frame != uplink.end();)
+        frame = frame->second.first == conn ? uplink.erase(frame) : std::next(frame);
+}
+
+void SimServer::drop(Conn conn)
+{
+    if (conns.count(conn))
+    {
+        st.drops++;
+        host::wsDrop(conn);
+    }
+}
+
+void SimServer::dropAll()
+{
+    for (auto &conn : conns)
+    {
+        st.drops++;
+        host::wsDrop(conn.first);
+    }
+}
+
+void SimServer::outage(uint32_t ms)
+{
+    dropAll();
+    outageUntilUs = host::nowMicros() + (uint64_t)ms * 1000;
+}
+
+void SimServer::stall(Conn conn)
+{
+    auto it = conns.find(conn);
+    if (it == conns.end())
+        return;
+    it->second.stalled = true;
+    it->second.pongDeadlineUs = 0;
+    for (auto frame = uplink.begin(); frame != uplink.end();)
+        frame = frame->second.first == conn ? uplink.erase(frame) : std::next(frame);
+}
+
+void SimServer::stallAll()
+{
+    for (auto &conn : conns)
+        stall(conn.first);
+}
+
+void SimServer::service()
+{
+    const uint64_t now = host::nowMicros();
+    while (!uplink.empty() && uplink.begin()->first <= now)
+    {
+        auto frame = uplink.begin();
+        const Conn conn = frame->second.first;
+        const std::string text = std::move(frame->second.second);
+        uplink.erase(frame);
+        handle(conn, text.c_str(), text.size());
+    }
+
+    std::vector<Conn> late;
+    for (auto &entry : conns)
+    {
+        Session &session = entry.second;
+        if (session.stalled)
+            continue;
+        if (session.pongDeadlineUs && now >= session.pongDeadlineUs)
+            late.push_back(entry.first);
+        else if (session.nextPingUs && now >= session.nextPingUs)
+        {
+            push(entry.first, session, "2");
+            st.pings++;
+            session.nextPingUs += (uint64_t)opts.pingIntervalMs * 1000;
+            session.pongDeadlineUs = now + (uint64_t)opts.pingTimeoutMs * 1000;
+        }
+    }
+    for (Conn conn : late)
+    {
+        st.pingTimeouts++;
+        drop(conn);
+        conns[conn].pongDeadlineUs = 0;
+    }
+}
+
+bool SimServer::sendEvent(Conn conn, const char *name, const std::string &json)
+{
+    auto it = conns.find(conn);
+    if (it == conns.end() || !it->second.open)
+        return false;
+    push(conn, it->second, std::string("42[\"") + name + "\"," + json + "]");
+    return true;
+}
+
+bool SimServer::sendAppCmd(Conn conn, const std::string &operation)
+{
+    return sendEvent(conn, "app-cmd", "{\"operation\":" + operation + "}");
+}
+
+uint32_t SimServer::sendEvent(const char *name, const std::string &json)
+{
+    uint32_t sent = 0;
+    for (auto &entry : conns)
+        sent += sendEvent(entry.first, name, json);
+    return sent;
+}
+
+uint32_t SimServer::sendAppCmd(const std::string &operation)
+{
+    return sendEvent("app-cmd", "{\"operation\":" + operation + "}");
+}
+
+void SimServer::received(Conn conn, const char *text, size_t length)
+{
+    auto it = conns.find(conn);
+    if (it == conns.end() || it->second.stalled)
+        return;
+    if (sentCb)
+        sentCb(conn, text, length);
+    if (!opts.linkLatencyMs && !opts.linkJitterMs)
+    {
+        handle(conn, text, length);
+        return;
+    }
+    Session &session = it->second;
+    const uint64_t due = std::max(host::nowMicros() + linkDelayUs(), session.lastUpUs);
+    session.lastUpUs = due;
+    uplink.emplace(due, std::make_pair(conn, std::string(text, length)));
+}
+
+void SimServer::handle(Conn conn, const char *text, size_t length)
+{
+    auto it = conns.find(conn);
+    if (it == conns.end())
+        return;
+    Session &session = it->second;
+    st.framesIn++;
+    st.bytesIn += length;
+    if (length >= 2 && text[0] == '4' && text[1] == '0')
+    {
+        // Socket.IO connect with the auth payload
+        if (!session.open)
+            openSessions++;
+        session.open = true;
+        st.sessions++;
+        char ack[48];
+        snprintf(ack, sizeof(ack), "40{\"sid\":\"sio%lu\"}", (unsigned long)st.sessions);
+        push(conn, session, ack);
+        push(conn, session, "42[\"connected\",{}]");
+    }
+    else if (length >= 1 && text[0] == '3')
+    {
+        st.pongs++;
+        session.pongDeadlineUs = 0;
+    }
+    else if (length >= 3 && text[0] == '4' && text[1] == '2')
+    {
+        // 42<ack id>["event",...]: the name is the first string of the array
+        const char *p = text + 2;
+        char *after = nullptr;
+        const unsigned long ackId = strtoul(p, &after, 10);
+        const bool wantsAck = after != p;
+        const char *q = strchr(after, '"');
+        const char *end = q ? strchr(q + 1, '"') : nullptr;
+        const std::string name = q && end ? std::string(q + 1, end) : std::string();
+        st.events[name]++;
+        if (wantsAck && name == "dev-time")
+        {
+            char reply[48];
+            snprintf(reply, sizeof(reply), "43%lu[%lld]", ackId,
+                     (long long)(opts.epochMs + (int64_t)(host::nowMicros() / 1000)));
+            push(conn, session, reply);
+        }
+    }
+    if (frameCb)
+        frameCb(conn, text, length);
+}
@@ -0,0 +1,136 @@
+// In-process stand-in for the atCloud365 server, for host builds of the
+// firmware: answers POST /api/v3/devices/auth through the HTTPClient shim
+// and plays the server side of the Engine.IO v4 / Socket.IO sessions on
+// the WebSocketsClient shim (open packet, connect ack, pings and ping
+// timeouts, dev-time acks), for one device or a fleet. The harness sends
+// app-cmd and other events with sendEvent() and injects trouble: link
+// latency, a slow auth service, admission limits, drops, stalled links and
+// outages.
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "host.h"
+
+struct SimServerOptions
+{
+    int authCode = 200;          // HTTP status for the auth request
+    uint32_t authLatencyMs = 150; // service time of one auth request
+    uint32_t authWorkers = 0;    // auth requests served at once; 0: no queueing
+    uint32_t authQueueMax = 0;   // requests waiting for a worker before 503; 0: unbounded
+    uint32_t acceptPerSec = 0;   // WebSocket connections admitted per second; 0: unlimited
+    uint32_t linkLatencyMs = 0;  // one way, both directions
+    uint32_t linkJitterMs = 0;   // up to this much more per frame, order kept
+    uint32_t pingIntervalMs = 25000; // Engine.IO pingInterval
+    uint32_t pingTimeoutMs = 20000;  // no pong by then closes the connection
+    int64_t epochMs = 1771000000000; // server clock at virtual time 0, for dev-time acks
+    uint32_t seed = 1;
+};
+
+class SimServer : public host::WsPeer
+{
+public:
+    using Conn = WebSocketsClient *;
+
+    explicit SimServer(const SimServerOptions &opts = SimServerOptions());
+    ~SimServer() override;
+
+    // Takes over the HTTP handler and WebSocket peer of the shims
+    void install();
+
+    // The auth endpoint. The HTTPClient shim blocks for latencyMs; fleet
+    // devices call this directly and wait for it themselves.
+    host::HttpResponse authenticate(const host::HttpRequest &request);
+
+    // Delivers device frames whose link delay is over and sends pings or
+    // closes connections that missed one; call as virtual time advances
+    void service();
+
+    // 42["name",json] to conn; false while it has no session
+    bool sendEvent(Conn conn, const char *name, const std::string &json);
+    // 42["app-cmd",{"operation":operation}]
+    bool sendAppCmd(Conn conn, const std::string &operation);
+    // The same to every open session; returns how many were sent
+    uint32_t sendEvent(const char *name, const std::string &json);
+    uint32_t sendAppCmd(const std::string &operation);
+
+    // Closes conn, or every connection, from the server side
+    void drop(Conn conn);
+    void dropAll();
+    // Drops everything and refuses connections and auth (503) for ms
+    void outage(uint32_t ms);
+    // Leaves conn, or every connection, half open: it stays up on both
+    // sides but nothing crosses it any more, pings included, until the
+    // device gives up on it
+    void stall(Conn conn);
+    void stallAll();
+
+    // Called with every frame a device sends, after the server handled it
+    void onFrame(std::function<void(Conn conn, const char *text, size_t length)> cb) { frameCb = std::move(cb); }
+    // Called with every frame a device sends as it sends it, before the link
+    // delay
+    void onSent(std::function<void(Conn conn, const char *text, size_t length)> cb) { sentCb = std::move(cb); }
+
+    bool sessionOpen() const { return openSessions > 0; }
+    uint32_t sessionCount() const { return openSessions; }
+    uint32_t connectionCount() const { return (uint32_t)conns.size(); }
+
+    struct Stats
+    {
+        uint32_t authRequests = 0;
+        uint32_t authRejected = 0; // 503: queue full or outage
+        uint32_t connects = 0;     // WebSocket connections accepted
+        uint32_t refused = 0;      // over acceptPerSec or during an outage
+        uint32_t sessions = 0;     // Socket.IO connects (40) acknowledged
+        uint32_t drops = 0;        // closed by the server
+        uint32_t pingTimeouts = 0;
+        uint32_t framesIn = 0; // from the devices
+        uint32_t framesOut = 0;
+        uint32_t pings = 0;
+        uint32_t pongs = 0;
+        uint64_t bytesIn = 0;
+        std::map<std::string, uint32_t> events; // device events by name
+        std::vector<uint32_t> authMs;            // latency of every answered auth request
+    };
+    const Stats &stats() const { return st; }
+
+    // host::WsPeer
+    bool accept(Conn conn, const std::string &host, uint16_t port, const std::string &url) override;
+    void opened(Conn conn) override;
+    void received(Conn conn, const char *text, size_t length) override;
+    void closed(Conn conn) override;
+
+private:
+    struct Session
+    {
+        bool open = false; // Socket.IO connect acknowledged
+        bool stalled = false;
+        uint64_t nextPingUs = 0;
+        uint64_t pongDeadlineUs = 0; // 0: no ping outstanding
+        uint64_t lastDownUs = 0;     // due time of the last frame to the device
+        uint64_t lastUpUs = 0;       // and from it
+    };
+
+    uint64_t linkDelayUs();
+    void push(Conn conn, Session &session, const std::string &text);
+    void handle(Conn conn, const char *text, size_t length);
+
+    SimServerOptions opts;
+    Stats st;
+    std::map<Conn, Session> conns;
+    uint32_t openSessions = 0;
+    std::multimap<uint64_t, std::pair<Conn, std::string>> uplink; // frames still on the wire
+    std::vector<uint64_t> authWorkerFreeUs;
+    std::deque<uint64_t> authStartsUs; // requests waiting for a worker
+    uint64_t outageUntilUs = 0;
+    uint64_t acceptWindowUs = 0;
+    uint32_t acceptsInWindow = 0;
+    uint32_t rng;
+    std::function<void(Conn, const char *, size_t)> frameCb;
+    std::function<void(Conn, const char *, size_t)> sentCb;
+};
@@ -0,0 +1,203 @@
+// Command-to-actuation latency of the output-device firmware, stage by
+// stage. Runs its own setup() and loop(), built with CMD_LATENCY, against
+// SimServer over a delayed link and sends thousands of output app-cmds,
+// then matches each command with the firmware's stamps (cmd_latency.h) and
+// with the dev-data that confirms it at the server:
+//
+//   downlink   server send to frame arrival in webSocketEvent (link delay,
+//              plus the wait for the next loop())
+//   parse      arrival to parameters parsed in processAppCmd
+//   write      parsed to digitalWrite in setState
+//   dev-data   digitalWrite to the confirming dev-data sent
+//   uplink     dev-data sent to received by the server
+//
+// and the totals from the server's send to the relay write and to the
+// confirmation. The in-loop stages are real host time; the link stages are
+// virtual time.
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+#include <Arduino.h>
+
+#include "cmd_latency.h"
+#include "config.h"
+#include "firmware_sim.h"
+#include "host.h"
+
+struct LatencyOptions
+{
+    uint32_t commands = 10000;
+    uint32_t intervalMs = 20; // mean gap between commands
+    uint32_t latencyMs = 20;
+    uint32_t jitterMs = 10;
+    uint32_t loopUs = 1000;
+    uint32_t seed = 1;
+    bool serial = false;
+};
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [--commands N] [--interval-ms N] [--latency-ms N] [--jitter-ms N] [--loop-us N] [--seed N]"
+            " [--serial]\n",
+            prog);
+}
+
+static bool parseOptions(int argc, char **argv, LatencyOptions &opts)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "--commands") == 0 && hasValue)
+            opts.commands = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--interval-ms") == 0 && hasValue)
+            opts.intervalMs = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--latency-ms") == 0 && hasValue)
+            opts.latencyMs = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--jitter-ms") == 0 && hasValue)
+            opts.jitterMs = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--loop-us") == 0 && hasValue)
+            opts.loopUs = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--seed") == 0 && hasValue)
+            opts.seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--serial") == 0)
+            opts.serial = true;
+        else
+        {
+            usage(argv[0]);
+            return false;
+        }
+    }
+    return opts.commands > 0 && opts.loopUs > 0;
+}
+
+static double percentile(std::vector<double> v, double p)
+{
+    if (v.empty())
+        return 0;
+    std::sort(v.begin(), v.end());
+    return v[std::min(v.size() - 1, (size_t)(p * v.size()))];
+}
+
+static void printStage(const char *what, const std::vector<double> &us)
+{
+    printf("%-16s p50 %10.2f  p99 %10.2f  p999 %10.2f  max %10.2f us\n", what, percentile(us, 0.5),
+           percentile(us, 0.99), percentile(us, 0.999), percentile(us, 1.0));
+}
+
+int main(int argc, char **argv)
+{
+    LatencyOptions opts;
+    if (!parseOptions(argc, argv, opts))
+        return 2;
+    host::setSerialOutput(opts.serial ? stdout : nullptr);
+    host::seedRandom(opts.seed);
+    srand(opts.seed);
+
+    SimServerOptions server;
+    server.linkLatencyMs = opts.latencyMs;
+    server.linkJitterMs = opts.jitterMs;
+    server.seed = opts.seed;
+    FirmwareSim sim(0, opts.loopUs, server);
+
+    // Device send time of every dev-data, in order; the server receives
+    // them in the same order (sim.framesOf)
+    std::vector<uint64_t> devDataSentUs;
+    sim.server().onSent([&](SimServer::Conn, const char *text, size_t length)
+                        {
+        if (length > 12 && strncmp(text, "42[\"dev-data\"", 13) == 0)
+            devDataSentUs.push_back(host::nowMicros()); });
+
+    if (!sim.boot())
+    {
+        fprintf(stderr, "no session after boot\n");
+        return 1;
+    }
+    sim.run(2000000);
+    while (true)
+    {
+        CmdLatencySample discard;
+        if (!cmdLatencyPop(discard))
+            break;
+    }
+
+    struct Command
+    {
+        uint64_t sentUs;
+        CmdLatencySample sample;
+        size_t devData; // index into devDataSentUs
+    };
+    std::deque<uint64_t> inFlight;
+    std::vector<Command> done;
+    auto collect = [&]()
+    {
+        CmdLatencySample sample;
+        while (cmdLatencyPop(sample))
+        {
+            if (inFlight.empty())
+                continue; // not one of ours
+            done.push_back({inFlight.front(), sample, devDataSentUs.size() - 1});
+            inFlight.pop_front();
+        }
+        return false;
+    };
+
+    const size_t devDataBefore = devDataSentUs.size();
+    const size_t framesBefore = sim.framesOf("dev-data").size();
+    bool on[3] = {false, false, false};
+    for (uint32_t n = 0; n < opts.commands; n++)
+    {
+        const uint8_t index = (uint8_t)(n % 3);
+        on[index] = !on[index];
+        char op[96];
+        snprintf(op, sizeof(op), "{\"customCmd\":\"output\",\"fieldIndex\":%u,\"fieldValue\":%u}", index,
+                 on[index] ? 1u : 0u);
+        inFlight.push_back(sim.now());
+        sim.server().sendAppCmd(sim.conn(), op);
+        const uint64_t gapUs = (uint64_t)rand() % (2000ull * opts.intervalMs + 1);
+        sim.runUntil(collect, std::max<uint64_t>(gapUs, opts.loopUs));
+    }
+    sim.runUntil(collect, 2000ull * (opts.latencyMs + opts.jitterMs) + 1000000);
+
+    // Server receipt of the i-th dev-data sent since the commands began
+    std::vector<FirmwareSim::Frame> received = sim.framesOf("dev-data");
+    received.erase(received.begin(), received.begin() + framesBefore);
+
+    std::vector<double> downlink, parse, write, devData, uplink, toWrite, toConfirm;
+    uint32_t unconfirmed = 0;
+    for (const Command &c : done)
+    {
+        const CmdLatencySample &s = c.sample;
+        const size_t at = c.devData - devDataBefore;
+        if (!s.writtenNs || c.devData < devDataBefore || at >= received.size())
+        {
+            unconfirmed++;
+            continue;
+        }
+        const double sentNs = c.sentUs * 1e3;
+        downlink.push_back((s.frameNs - sentNs) / 1e3);
+        parse.push_back((s.parsedNs - s.frameNs) / 1e3);
+        write.push_back((s.writtenNs - s.parsedNs) / 1e3);
+        devData.push_back((s.confirmedNs - s.writtenNs) / 1e3);
+        uplink.push_back((double)received[at].us - devDataSentUs[c.devData]);
+        toWrite.push_back((s.writtenNs - sentNs) / 1e3);
+        toConfirm.push_back((double)received[at].us - c.sentUs);
+    }
+
+    printf("commands         %u sent, %zu stamped, %u unconfirmed, %zu lost, %u dropped, %u overwritten\n",
+           opts.commands, done.size(), unconfirmed, inFlight.size(), cmdLatencyDropped(), cmdLatencyOverwritten());
+    printf("link             %u+-%u ms one way, loop() every %u us\n", opts.latencyMs, opts.jitterMs, opts.loopUs);
+    printStage("downlink", downlink);
+    printStage("parse", parse);
+    printStage("write", write);
+    printStage("dev-data", devData);
+    printStage("uplink", uplink);
+    printStage("send to write", toWrite);
+    printStage("send to confirm", toConfirm);
+    return inFlight.empty() && !unconfirmed ? 0 : 1;
+}
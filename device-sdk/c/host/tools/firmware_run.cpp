@@ -0,0 +1,172 @@
+// Runs a firmware project's own setup() and loop() (main.cpp, unmodified)
+// on the host, against SimServer, on the virtual clock. Each loop() call
+// advances the clock by --loop-us; the server pings on its interval and,
+// with --cmd-ms, sends an "output" app-cmd that toggles a field. With
+// --gpio-ms the project's GPIO_INPUT_n pins are toggled in turn.
+//
+// Prints what the device sent and the host CPU time per loop(), which is
+// the figure to profile: perf record ./build/fw_run_output --seconds 3600
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <Arduino.h>
+
+#include "config.h"
+#include "host.h"
+#include "sim_server.h"
+#ifdef FW_DEV_LOG
+#include "dev_log.h"
+#endif
+
+void setup();
+void loop();
+
+struct RunOptions
+{
+    double seconds = 600;
+    uint32_t loopUs = 1000;
+    uint32_t cmdMs = 0;
+    uint32_t gpioMs = 0;
+    uint32_t seed = 1;
+    bool serial = false;
+    SimServerOptions server;
+};
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [--seconds N] [--loop-us N] [--cmd-ms N] [--gpio-ms N] [--auth-code N]\n"
+            "          [--ping-ms N] [--seed N] [--serial]\n",
+            prog);
+}
+
+static bool parseOptions(int argc, char **argv, RunOptions &opts)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "--seconds") == 0 && hasValue)
+            opts.seconds = strtod(argv[++i], nullptr);
+        else if (strcmp(arg, "--loop-us") == 0 && hasValue)
+            opts.loopUs = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--cmd-ms") == 0 && hasValue)
+            opts.cmdMs = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--gpio-ms") == 0 && hasValue)
+            opts.gpioMs = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--auth-code") == 0 && hasValue)
+            opts.server.authCode = atoi(argv[++i]);
+        else if (strcmp(arg, "--ping-ms") == 0 && hasValue)
+            opts.server.pingIntervalMs = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--seed") == 0 && hasValue)
+            opts.seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--serial") == 0)
+            opts.serial = true;
+        else
+        {
+            usage(argv[0]);
+            return false;
+        }
+    }
+    return opts.loopUs > 0;
+}
+
+static const uint8_t INPUT_PINS[] = {
+#ifdef GPIO_INPUT_1
+    GPIO_INPUT_1,
+#endif
+#ifdef GPIO_INPUT_2
+    GPIO_INPUT_2,
+#endif
+#ifdef GPIO_INPUT_3
+    GPIO_INPUT_3,
+#endif
+    0xFF,
+};
+// Divisor-safe for projects without inputs; the loop checks the real count
+static const size_t INPUT_PIN_COUNT = sizeof(INPUT_PINS) - 1;
+static const size_t INPUT_PIN_MOD = INPUT_PIN_COUNT ? INPUT_PIN_COUNT : 1;
+
+int main(int argc, char **argv)
+{
+    RunOptions opts;
+    if (!parseOptions(argc, argv, opts))
+        return 2;
+
+    host::setSerialOutput(opts.serial ? stdout : nullptr);
+    host::seedRandom(opts.seed);
+    SimServer server(opts.server);
+    server.install();
+
+    const uint64_t endUs = (uint64_t)(opts.seconds * 1e6);
+    uint64_t nextCmdUs = (uint64_t)opts.cmdMs * 1000;
+    uint64_t nextGpioUs = (uint64_t)opts.gpioMs * 1000;
+    uint32_t cmds = 0, gpioEdges = 0, restarts = 0;
+    uint64_t loops = 0;
+    bool booted = false;
+
+    const auto start = std::chrono::steady_clock::now();
+    while (host::nowMicros() < endUs)
+    {
+        // ESP.restart() unwinds to here; setup() runs again with the
+        // globals as they were, which a real reboot would reset
+        try
+        {
+            if (!booted)
+            {
+                setup();
+                booted = true;
+            }
+            else
+            {
+                loop();
+                loops++;
+            }
+        }
+        catch (const host::Restart &)
+        {
+            restarts++;
+            booted = false;
+        }
+#ifdef FW_DEV_LOG
+        logDrain();
+#endif
+        host::advanceMicros(opts.loopUs);
+        server.service();
+
+        const uint64_t now = host::nowMicros();
+        if (opts.cmdMs && now >= nextCmdUs)
+        {
+            char op[96];
+            snprintf(op, sizeof(op), "{\"customCmd\":\"output\",\"fieldIndex\":%u,\"fieldValue\":%u}", cmds % 3,
+                     (cmds / 3) % 2 ? 0u : 1u);
+            if (server.sendAppCmd(op))
+                cmds++;
+            nextCmdUs += (uint64_t)opts.cmdMs * 1000;
+        }
+        if (opts.gpioMs && INPUT_PIN_COUNT && now >= nextGpioUs)
+        {
+            const uint8_t pin = INPUT_PINS[gpioEdges % INPUT_PIN_MOD];
+            host::setGpioInput(pin, (gpioEdges / INPUT_PIN_MOD) % 2 ? HIGH : LOW);
+            gpioEdges++;
+            nextGpioUs += (uint64_t)opts.gpioMs * 1000;
+        }
+    }
+    const double hostNs =
+        (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    const SimServer::Stats &st = server.stats();
+    printf("virtual time   %.1f s\n", host::nowMicros() / 1e6);
+    printf("loop() calls   %llu, %.0f ns host time each\n", (unsigned long long)loops, loops ? hostNs / loops : 0.0);
+    printf("restarts       %u\n", restarts);
+    printf("auth requests  %u\n", st.authRequests);
+    printf("connects       %u (sessions %u)\n", st.connects, st.sessions);
+    printf("frames         %u in (%llu bytes), %u out\n", st.framesIn, (unsigned long long)st.bytesIn, st.framesOut);
+    printf("pings          %u, pongs %u\n", st.pings, st.pongs);
+    printf("app-cmds       %u, GPIO edges %u\n", cmds, gpioEdges);
+    for (const auto &event : st.events)
+        printf("  %-14s %u\n", event.first.c_str(), event.second);
+    return 0;
+}
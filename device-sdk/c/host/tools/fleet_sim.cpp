@@ -0,0 +1,377 @@
+// Runs a fleet of FleetDevice state machines against one SimServer on the
+// virtual clock, with a slow or failing server injected, and reports:
+//
+//   - connection storms: how long the fleet takes to come online after
+//     boot and after --drop-at, peak connects per second, refusals
+//   - emit rate: dev-data frames per second at the server
+//   - command round trip: app-cmd sent by the server to the dev-data that
+//     confirms it, p50/p90/p99/max, lost commands
+//
+// Every tick advances the clock by --tick-ms, services the server and
+// calls loop() on each device, so latencies are quantised to the tick.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <WiFi.h>
+
+#include "fleet_device.h"
+#include "host.h"
+#include "sim_server.h"
+
+struct FleetOptions
+{
+    uint32_t devices = 100;
+    double seconds = 300;
+    uint32_t tickMs = 10;
+    uint32_t bootSpreadMs = 0; // devices boot uniformly over this window
+    uint32_t cmdMs = 0;        // per device, staggered across the fleet
+    double stormAt = -1;       // seconds; every online device gets stormCmds at once
+    uint32_t stormCmds = 10;
+    double dropAt = -1; // seconds; the server drops every connection
+    uint32_t outageMs = 0;
+    const char *jsonPath = nullptr;
+    SimServerOptions server;
+};
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [--devices N] [--seconds N] [--tick-ms N] [--boot-spread-ms N]\n"
+            "          [--latency-ms N] [--jitter-ms N] [--auth-ms N] [--auth-workers N] [--auth-queue N]\n"
+            "          [--auth-code N] [--accept-per-sec N] [--ping-ms N]\n"
+            "          [--cmd-ms N] [--storm-at S] [--storm-cmds N] [--drop-at S] [--outage-ms N]\n"
+            "          [--seed N] [--json FILE]\n",
+            prog);
+}
+
+static bool parseOptions(int argc, char **argv, FleetOptions &opts)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            usage(argv[0]);
+            return false;
+        }
+        const char *value = argv[++i];
+        const uint32_t n = (uint32_t)strtoul(value, nullptr, 10);
+        if (strcmp(arg, "--devices") == 0)
+            opts.devices = n;
+        else if (strcmp(arg, "--seconds") == 0)
+            opts.seconds = strtod(value, nullptr);
+        else if (strcmp(arg, "--tick-ms") == 0)
+            opts.tickMs = n;
+        else if (strcmp(arg, "--boot-spread-ms") == 0)
+            opts.bootSpreadMs = n;
+        else if (strcmp(arg, "--latency-ms") == 0)
+            opts.server.linkLatencyMs = n;
+        else if (strcmp(arg, "--jitter-ms") == 0)
+            opts.server.linkJitterMs = n;
+        else if (strcmp(arg, "--auth-ms") == 0)
+            opts.server.authLatencyMs = n;
+        else if (strcmp(arg, "--auth-workers") == 0)
+            opts.server.authWorkers = n;
+        else if (strcmp(arg, "--auth-queue") == 0)
+            opts.server.authQueueMax = n;
+        else if (strcmp(arg, "--auth-code") == 0)
+            opts.server.authCode = atoi(value);
+        else if (strcmp(arg, "--accept-per-sec") == 0)
+            opts.server.acceptPerSec = n;
+        else if (strcmp(arg, "--ping-ms") == 0)
+            opts.server.pingIntervalMs = n;
+        else if (strcmp(arg, "--cmd-ms") == 0)
+            opts.cmdMs = n;
+        else if (strcmp(arg, "--storm-at") == 0)
+            opts.stormAt = strtod(value, nullptr);
+        else if (strcmp(arg, "--storm-cmds") == 0)
+            opts.stormCmds = n;
+        else if (strcmp(arg, "--drop-at") == 0)
+            opts.dropAt = strtod(value, nullptr);
+        else if (strcmp(arg, "--outage-ms") == 0)
+            opts.outageMs = n;
+        else if (strcmp(arg, "--seed") == 0)
+            opts.server.seed = n;
+        else if (strcmp(arg, "--json") == 0)
+            opts.jsonPath = value;
+        else
+        {
+            usage(argv[0]);
+            return false;
+        }
+    }
+    return opts.devices > 0 && opts.tickMs > 0;
+}
+
+static double percentile(std::vector<double> v, double p)
+{
+    if (v.empty())
+        return 0;
+    std::sort(v.begin(), v.end());
+    return v[std::min(v.size() - 1, (size_t)(p * v.size()))];
+}
+
+// Matches each app-cmd with the dev-data that confirms it: a device reports
+// how many commands it had applied when it emitted, and frames keep their
+// order on a connection
+class CommandTracker : public FleetDevice::Listener
+{
+public:
+    explicit CommandTracker(size_t devices) : lanes(devices) {}
+
+    void sent(FleetDevice &device) { lanes[device.index()].pending.push_back(host::nowMicros()); }
+
+    // A dev-data frame reached the server
+    void confirmed(FleetDevice &device)
+    {
+        Lane &lane = lanes[device.index()];
+        if (lane.emits.empty())
+            return;
+        const uint32_t applied = lane.emits.front();
+        lane.emits.pop_front();
+        for (; lane.seen < applied && !lane.pending.empty(); lane.seen++)
+        {
+            rttMs.push_back((host::nowMicros() - lane.pending.front()) / 1000.0);
+            lane.pending.pop_front();
+        }
+    }
+
+    void emitted(FleetDevice &device, uint32_t cmdsApplied) override
+    {
+        lanes[device.index()].emits.push_back(cmdsApplied);
+    }
+
+    // Commands still queued either way were lost with the connection
+    void disconnected(FleetDevice &device) override
+    {
+        Lane &lane = lanes[device.index()];
+        lost += lane.pending.size();
+        lane.pending.clear();
+        lane.emits.clear();
+        lane.seen = device.stats().cmdsApplied;
+    }
+
+    std::vector<double> rttMs;
+    uint64_t lost = 0;
+
+private:
+    struct Lane
+    {
+        std::deque<uint64_t> pending; // send times of unconfirmed commands
+        std::deque<uint32_t> emits;   // cmdsApplied of dev-data in flight
+        uint32_t seen = 0;            // commands confirmed or lost so far
+    };
+    std::vector<Lane> lanes;
+};
+
+// Time from an event until 50/90/100% of the fleet is online
+struct Recovery
+{
+    const char *name;
+    uint64_t startUs;
+    uint64_t doneUs[3] = {0, 0, 0};
+    uint32_t peakConnectsPerSec = 0;
+};
+
+static const double RECOVERY_FRACTIONS[3] = {0.5, 0.9, 1.0};
+
+int main(int argc, char **argv)
+{
+    FleetOptions opts;
+    if (!parseOptions(argc, argv, opts))
+        return 2;
+
+    host::setSerialOutput(nullptr);
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD); // one shim radio for the whole fleet
+    SimServer server(opts.server);
+    server.install();
+    CommandTracker tracker(opts.devices);
+
+    std::vector<std::unique_ptr<FleetDevice>> fleet;
+    std::map<WebSocketsClient *, FleetDevice *> byConn;
+    for (uint32_t i = 0; i < opts.devices; i++)
+    {
+        const uint64_t bootUs = (uint64_t)opts.bootSpreadMs * 1000 * i / opts.devices;
+        fleet.emplace_back(new FleetDevice(server, i, bootUs, &tracker));
+        byConn[fleet.back()->conn()] = fleet.back().get();
+    }
+    server.onFrame([&](WebSocketsClient *conn, const char *text, size_t length)
+                   {
+        if (length > 12 && strncmp(text, "42[\"dev-data\"", 13) == 0)
+            tracker.confirmed(*byConn[conn]); });
+
+    std::vector<uint64_t> nextCmdUs(opts.devices, UINT64_MAX);
+    if (opts.cmdMs)
+        for (uint32_t i = 0; i < opts.devices; i++)
+            nextCmdUs[i] = (uint64_t)opts.cmdMs * 1000 * (opts.devices + i) / opts.devices;
+
+    std::vector<Recovery> recoveries = {{"boot", 0}};
+    const uint64_t tickUs = (uint64_t)opts.tickMs * 1000;
+    const uint64_t endUs = (uint64_t)(opts.seconds * 1e6);
+    uint64_t stormUs = opts.stormAt >= 0 ? (uint64_t)(opts.stormAt * 1e6) : UINT64_MAX;
+    uint64_t dropUs = opts.dropAt >= 0 ? (uint64_t)(opts.dropAt * 1e6) : UINT64_MAX;
+    uint64_t cmds = 0, deviceLoops = 0;
+    uint32_t lastEmits = 0, lastConnects = 0, peakEmitsPerSec = 0;
+    uint64_t secondUs = 1000000;
+
+    const auto start = std::chrono::steady_clock::now();
+    while (host::nowMicros() < endUs)
+    {
+        host::advanceMicros(tickUs);
+        const uint64_t now = host::nowMicros();
+        server.service();
+
+        if (now >= dropUs)
+        {
+            if (opts.outageMs)
+                server.outage(opts.outageMs);
+            else
+                server.dropAll();
+            recoveries.push_back({"drop", now});
+            dropUs = UINT64_MAX;
+        }
+        if (now >= stormUs)
+        {
+            for (auto &device : fleet)
+                for (uint32_t k = 0; k < opts.stormCmds; k++)
+                {
+                    char op[96];
+                    snprintf(op, sizeof(op), "{\"customCmd\":\"output\",\"fieldIndex\":%u,\"fieldValue\":%u}",
+                             k % SENSOR_COUNT, (k / SENSOR_COUNT) % 2 ? 0u : 1u);
+                    if (server.sendAppCmd(device->conn(), op))
+                    {
+                        tracker.sent(*device);
+                        cmds++;
+                    }
+                }
+            stormUs = UINT64_MAX;
+        }
+        for (uint32_t i = 0; i < opts.devices; i++)
+        {
+            if (now < nextCmdUs[i])
+                continue;
+            nextCmdUs[i] += (uint64_t)opts.cmdMs * 1000;
+            char op[96];
+            snprintf(op, sizeof(op), "{\"customCmd\":\"output\",\"fieldIndex\":%u,\"fieldValue\":%u}",
+                     (unsigned)(cmds % SENSOR_COUNT), (unsigned)((cmds / SENSOR_COUNT) % 2));
+            if (server.sendAppCmd(fleet[i]->conn(), op))
+            {
+                tracker.sent(*fleet[i]);
+                cmds++;
+            }
+        }
+
+        uint32_t online = 0;
+        for (auto &device : fleet)
+        {
+            device->loop();
+            online += device->state() == FleetDevice::ONLINE;
+        }
+        deviceLoops += fleet.size();
+
+        Recovery &recovery = recoveries.back();
+        for (int f = 0; f < 3; f++)
+            if (!recovery.doneUs[f] && online >= (uint32_t)(RECOVERY_FRACTIONS[f] * opts.devices + 0.999))
+                recovery.doneUs[f] = now;
+
+        if (now >= secondUs)
+        {
+            const SimServer::Stats &st = server.stats();
+            const uint32_t emits = st.events.count("dev-data") ? st.events.at("dev-data") : 0;
+            peakEmitsPerSec = std::max(peakEmitsPerSec, emits - lastEmits);
+            recovery.peakConnectsPerSec = std::max(recovery.peakConnectsPerSec, st.connects - lastConnects);
+            lastEmits = emits;
+            lastConnects = st.connects;
+            secondUs += 1000000;
+        }
+    }
+    const double hostNs =
+        (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    const SimServer::Stats &st = server.stats();
+    const uint32_t emits = st.events.count("dev-data") ? st.events.at("dev-data") : 0;
+    std::vector<double> authMs(st.authMs.begin(), st.authMs.end());
+    uint32_t online = 0, authFailures = 0, disconnects = 0;
+    for (auto &device : fleet)
+    {
+        online += device->state() == FleetDevice::ONLINE;
+        authFailures += device->stats().authFailures;
+        disconnects += device->stats().disconnects;
+    }
+
+    printf("fleet          %u devices, %u online at the end, %.0f s virtual, %u ms ticks\n", opts.devices, online,
+           host::nowMicros() / 1e6, opts.tickMs);
+    printf("host time      %.2f s, %.0f ns per device loop(), %.0f ns per frame\n", hostNs / 1e9,
+           deviceLoops ? hostNs / deviceLoops : 0.0, hostNs / std::max<uint64_t>(1, st.framesIn + st.framesOut));
+    printf("auth           %u requests, %u rejected, %u device failures, p50 %.0f ms, p99 %.0f ms, max %.0f ms\n",
+           st.authRequests, st.authRejected, authFailures, percentile(authMs, 0.5), percentile(authMs, 0.99),
+           percentile(authMs, 1.0));
+    printf("connections    %u accepted, %u refused, %u dropped, %u ping timeouts, %u device disconnects\n",
+           st.connects, st.refused, st.drops, st.pingTimeouts, disconnects);
+    for (const Recovery &r : recoveries)
+    {
+        printf("  %-6s online", r.name);
+        for (int f = 0; f < 3; f++)
+        {
+            if (r.doneUs[f])
+                printf("  %3.0f%% %7.1f s", RECOVERY_FRACTIONS[f] * 100, (r.doneUs[f] - r.startUs) / 1e6);
+            else
+                printf("  %3.0f%%   never", RECOVERY_FRACTIONS[f] * 100);
+        }
+        printf("  peak %u connects/s\n", r.peakConnectsPerSec);
+    }
+    printf("dev-data       %u, %.1f/s mean, %u/s peak\n", emits, emits / (host::nowMicros() / 1e6), peakEmitsPerSec);
+    printf("app-cmds       %llu sent, %zu confirmed, %llu lost\n", (unsigned long long)cmds, tracker.rttMs.size(),
+           (unsigned long long)tracker.lost);
+    printf("cmd rtt        p50 %.1f ms, p90 %.1f ms, p99 %.1f ms, max %.1f ms\n", percentile(tracker.rttMs, 0.5),
+           percentile(tracker.rttMs, 0.9), percentile(tracker.rttMs, 0.99), percentile(tracker.rttMs, 1.0));
+
+    if (opts.jsonPath)
+    {
+        FILE *out = fopen(opts.jsonPath, "w");
+        if (!out)
+        {
+            perror(opts.jsonPath);
+            return 1;
+        }
+        fprintf(out, "{\"devices\":%u,\"online\":%u,\"seconds\":%.1f,\"tickMs\":%u,\"hostNsPerDeviceLoop\":%.0f,",
+                opts.devices, online, host::nowMicros() / 1e6, opts.tickMs, deviceLoops ? hostNs / deviceLoops : 0.0);
+        fprintf(out,
+                "\"auth\":{\"requests\":%u,\"rejected\":%u,\"failures\":%u,\"p50Ms\":%.0f,\"p99Ms\":%.0f,\"maxMs\":%.0f},",
+                st.authRequests, st.authRejected, authFailures, percentile(authMs, 0.5), percentile(authMs, 0.99),
+                percentile(authMs, 1.0));
+        fprintf(out, "\"connections\":{\"accepted\":%u,\"refused\":%u,\"dropped\":%u,\"pingTimeouts\":%u},",
+                st.connects, st.refused, st.drops, st.pingTimeouts);
+        fprintf(out, "\"recovery\":[");
+        for (size_t i = 0; i < recoveries.size(); i++)
+        {
+            const Recovery &r = recoveries[i];
+            fprintf(out, "%s{\"event\":\"%s\",\"atS\":%.3f", i ? "," : "", r.name, r.startUs / 1e6);
+            for (int f = 0; f < 3; f++)
+            {
+                if (r.doneUs[f])
+                    fprintf(out, ",\"p%.0fS\":%.3f", RECOVERY_FRACTIONS[f] * 100, (r.doneUs[f] - r.startUs) / 1e6);
+                else
+                    fprintf(out, ",\"p%.0fS\":null", RECOVERY_FRACTIONS[f] * 100);
+            }
+            fprintf(out, ",\"peakConnectsPerSec\":%u}", r.peakConnectsPerSec);
+        }
+        fprintf(out, "],\"devData\":{\"count\":%u,\"meanPerSec\":%.1f,\"peakPerSec\":%u},", emits,
+                emits / (host::nowMicros() / 1e6), peakEmitsPerSec);
+        fprintf(out,
+                "\"cmd\":{\"sent\":%llu,\"confirmed\":%zu,\"lost\":%llu,\"p50Ms\":%.1f,\"p90Ms\":%.1f,\"p99Ms\":%.1f,"
+                "\"maxMs\":%.1f}}\n",
+                (unsigned long long)cmds, tracker.rttMs.size(), (unsigned long long)tracker.lost,
+                percentile(tracker.rttMs, 0.5), percentile(tracker.rttMs, 0.9), percentile(tracker.rttMs, 0.99),
+                percentile(tracker.rttMs, 1.0));
+        fclose(out);
+    }
+    return 0;
+}
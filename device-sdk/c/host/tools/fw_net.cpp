@@ -0,0 +1,396 @@
+// Runs a firmware project's own setup() and loop() (main.cpp, unmodified)
+// on the host in real time, against a real server over plain TCP: the
+// HTTPClient shim's requests become HTTP/1.1 requests and each
+// WebSocketsClient shim connection becomes a WebSocket to --server. The
+// host name, port and TLS the firmware asks for are ignored; the path and
+// query are kept.
+//
+// This is how the C++ client takes part in device-sdk/bench/sdk_bench.py
+// next to the Node.js and Python SDKs. The virtual clock follows the wall
+// clock, and loop() runs whenever a frame arrives or 1 ms has passed.
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <Arduino.h>
+
+#include "config.h"
+#include "host.h"
+
+void setup();
+void loop();
+
+struct NetOptions
+{
+    std::string host = "127.0.0.1";
+    std::string port = "8765";
+    double seconds = 0; // 0: until killed
+    bool quiet = false;
+};
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [--server http://HOST:PORT] [--seconds N] [--quiet]\n", prog);
+}
+
+static bool parseOptions(int argc, char **argv, NetOptions &opts)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "--server") == 0 && hasValue)
+        {
+            std::string server = argv[++i];
+            const size_t scheme = server.find("://");
+            if (scheme != std::string::npos)
+                server = server.substr(scheme + 3);
+            server = server.substr(0, server.find('/'));
+            const size_t colon = server.rfind(':');
+            opts.host = server.substr(0, colon);
+            opts.port = colon == std::string::npos ? "80" : server.substr(colon + 1);
+        }
+        else if (strcmp(arg, "--seconds") == 0 && hasValue)
+            opts.seconds = strtod(argv[++i], nullptr);
+        else if (strcmp(arg, "--quiet") == 0)
+            opts.quiet = true;
+        else
+        {
+            usage(argv[0]);
+            return false;
+        }
+    }
+    return !opts.host.empty();
+}
+
+static NetOptions opts;
+
+static int connectTcp()
+{
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *list = nullptr;
+    if (getaddrinfo(opts.host.c_str(), opts.port.c_str(), &hints, &list) != 0)
+        return -1;
+    int fd = -1;
+    for (addrinfo *ai = list; ai && fd < 0; ai = ai->ai_next)
+    {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd >= 0 && connect(fd, ai->ai_addr, ai->ai_addrlen) != 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(list);
+    if (fd >= 0)
+    {
+        const int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    return fd;
+}
+
+static bool sendAll(int fd, const std::string &data)
+{
+    size_t done = 0;
+    while (done < data.size())
+    {
+        const ssize_t n = send(fd, data.data() + done, data.size() - done, MSG_NOSIGNAL);
+        if (n <= 0)
+            return false;
+        done += (size_t)n;
+    }
+    return true;
+}
+
+// Reads up to the end of the response head; the rest stays in buffer
+static bool readHead(int fd, std::string &buffer, std::string &head)
+{
+    char chunk[4096];
+    size_t end;
+    while ((end = buffer.find("\r\n\r\n")) == std::string::npos)
+    {
+        const ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0)
+            return false;
+        buffer.append(chunk, (size_t)n);
+    }
+    head = buffer.substr(0, end + 4);
+    buffer.erase(0, end + 4);
+    return true;
+}
+
+static std::string pathOf(const std::string &url)
+{
+    const size_t scheme = url.find("://");
+    const size_t slash = url.find('/', scheme == std::string::npos ? 0 : scheme + 3);
+    return slash == std::string::npos ? "/" : url.substr(slash);
+}
+
+static host::HttpResponse httpRequest(const host::HttpRequest &request)
+{
+    host::HttpResponse response;
+    const int fd = connectTcp();
+    if (fd < 0)
+        return response;
+    std::string out = request.method + " " + pathOf(request.url) + " HTTP/1.1\r\nHost: " + opts.host + ":" +
+                      opts.port + "\r\nConnection: close\r\nContent-Length: " + std::to_string(request.body.size()) +
+                      "\r\n";
+    for (const auto &header : request.headers)
+        out += header.first + ": " + header.second + "\r\n";
+    out += "\r\n" + request.body;
+    std::string buffer, head;
+    if (sendAll(fd, out) && readHead(fd, buffer, head) && head.compare(0, 5, "HTTP/") == 0)
+    {
+        char chunk[4096];
+        ssize_t n;
+        while ((n = recv(fd, chunk, sizeof(chunk), 0)) > 0)
+            buffer.append(chunk, (size_t)n);
+        response.code = atoi(head.c_str() + head.find(' ') + 1);
+        response.body = buffer;
+    }
+    close(fd);
+    return response;
+}
+
+// Each shim connection as a WebSocket to the server
+class NetBridge : public host::WsPeer
+{
+public:
+    bool accept(WebSocketsClient *conn, const std::string &, uint16_t, const std::string &url) override
+    {
+        const int fd = connectTcp();
+        if (fd < 0)
+            return false;
+        const std::string request = "GET " + url + " HTTP/1.1\r\nHost: " + opts.host + ":" + opts.port +
+                                    "\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                                    "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n";
+        Link link;
+        link.fd = fd;
+        std::string head;
+        if (!sendAll(fd, request) || !readHead(fd, link.rx, head) || head.find(" 101 ") == std::string::npos)
+        {
+            close(fd);
+            return false;
+        }
+        links[conn] = link;
+        return true;
+    }
+
+    // The shim drops frames pushed before this, so the server's first
+    // frames, which may have come with the handshake, wait for it
+    void opened(WebSocketsClient *conn) override
+    {
+        auto it = links.find(conn);
+        if (it == links.end())
+            return;
+        it->second.open = true;
+        if (!parseFrames(conn, it->second))
+            lose(conn);
+    }
+
+    void received(WebSocketsClient *conn, const char *text, size_t length) override
+    {
+        auto it = links.find(conn);
+        if (it != links.end() && !sendFrame(it->second.fd, 0x1, text, length))
+            lose(conn);
+    }
+
+    void closed(WebSocketsClient *conn) override
+    {
+        auto it = links.find(conn);
+        if (it == links.end())
+            return;
+        sendFrame(it->second.fd, 0x8, "", 0);
+        close(it->second.fd);
+        links.erase(it);
+    }
+
+    // Waits up to timeoutMs for server frames and hands them to the shim
+    void poll(int timeoutMs)
+    {
+        std::vector<pollfd> fds;
+        std::vector<WebSocketsClient *> conns;
+        for (const auto &entry : links)
+        {
+            fds.push_back({entry.second.fd, POLLIN, 0});
+            conns.push_back(entry.first);
+        }
+        if (fds.empty())
+        {
+            usleep(timeoutMs * 1000);
+            return;
+        }
+        if (::poll(fds.data(), fds.size(), timeoutMs) <= 0)
+            return;
+        for (size_t i = 0; i < fds.size(); i++)
+        {
+            if (!fds[i].revents)
+                continue;
+            char chunk[16384];
+            const ssize_t n = recv(fds[i].fd, chunk, sizeof(chunk), 0);
+            if (n <= 0)
+            {
+                lose(conns[i]);
+                continue;
+            }
+            Link &link = links[conns[i]];
+            link.rx.append(chunk, (size_t)n);
+            if (link.open && !parseFrames(conns[i], link))
+                lose(conns[i]);
+        }
+    }
+
+private:
+    struct Link
+    {
+        int fd = -1;
+        bool open = false;
+        std::string rx;
+        std::string message; // fragments so far
+    };
+
+    static bool sendFrame(int fd, uint8_t opcode, const char *data, size_t length)
+    {
+        std::string frame;
+        frame += (char)(0x80 | opcode);
+        if (length < 126)
+            frame += (char)(0x80 | length);
+        else if (length < 65536)
+        {
+            frame += (char)(0x80 | 126);
+            frame += (char)(length >> 8);
+            frame += (char)length;
+        }
+        else
+        {
+            frame += (char)(0x80 | 127);
+            for (int shift = 56; shift >= 0; shift -= 8)
+                frame += (char)((uint64_t)length >> shift);
+        }
+        const uint8_t mask[4] = {(uint8_t)rand(), (uint8_t)rand(), (uint8_t)rand(), (uint8_t)rand()};
+        frame.append((const char *)mask, 4);
+        for (size_t i = 0; i < length; i++)
+            frame += (char)(data[i] ^ mask[i & 3]);
+        return sendAll(fd, frame);
+    }
+
+    // False when the server closed the connection
+    bool parseFrames(WebSocketsClient *conn, Link &link)
+    {
+        while (link.rx.size() >= 2)
+        {
+            const uint8_t *p = (const uint8_t *)link.rx.data();
+            const uint8_t opcode = p[0] & 0x0F;
+            const bool fin = p[0] & 0x80;
+            const bool masked = p[1] & 0x80;
+            uint64_t length = p[1] & 0x7F;
+            size_t at = 2;
+            if (length == 126)
+            {
+                if (link.rx.size() < 4)
+                    return true;
+                length = ((uint64_t)p[2] << 8) | p[3];
+                at = 4;
+            }
+            else if (length == 127)
+            {
+                if (link.rx.size() < 10)
+                    return true;
+                length = 0;
+                for (int i = 0; i < 8; i++)
+                    length = (length << 8) | p[2 + i];
+                at = 10;
+            }
+            const size_t maskAt = at;
+            if (masked)
+                at += 4;
+            if (link.rx.size() < at + length)
+                return true;
+            std::string payload = link.rx.substr(at, length);
+            if (masked)
+                for (size_t i = 0; i < payload.size(); i++)
+                    payload[i] ^= p[maskAt + (i & 3)];
+            link.rx.erase(0, at + length);
+
+            if (opcode == 0x8)
+                return false;
+            if (opcode == 0x9)
+                sendFrame(link.fd, 0xA, payload.data(), payload.size());
+            else if (opcode == 0x0 || opcode == 0x1)
+            {
+                link.message += payload;
+                if (fin)
+                {
+                    host::wsPush(conn, link.message);
+                    link.message.clear();
+                }
+            }
+        }
+        return true;
+    }
+
+    void lose(WebSocketsClient *conn)
+    {
+        auto it = links.find(conn);
+        if (it == links.end())
+            return;
+        close(it->second.fd);
+        links.erase(it);
+        host::wsDrop(conn);
+    }
+
+    std::map<WebSocketsClient *, Link> links;
+};
+
+int main(int argc, char **argv)
+{
+    if (!parseOptions(argc, argv, opts))
+        return 2;
+    host::setSerialOutput(opts.quiet ? nullptr : stdout);
+    host::setHttpHandler(httpRequest);
+    NetBridge bridge;
+    host::setWsPeer(&bridge);
+
+    const auto start = std::chrono::steady_clock::now();
+    bool booted = false;
+    while (true)
+    {
+        const uint64_t realUs =
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        if (opts.seconds > 0 && realUs >= opts.seconds * 1e6)
+            break;
+        // delay() in the firmware moves the clock on by itself
+        if (realUs > host::nowMicros())
+            host::setMicros(realUs);
+        try
+        {
+            if (!booted)
+            {
+                setup();
+                booted = true;
+            }
+            else
+                loop();
+        }
+        catch (const host::Restart &)
+        {
+            booted = false;
+        }
+        bridge.poll(1);
+    }
+    return 0;
+}
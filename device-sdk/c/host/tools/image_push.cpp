@@ -0,0 +1,80 @@
+// Converts an image into the app-cmd operations that stream it to an
+// input-device-lcd panel, one JSON object per line, for the server (or a
+// test client) to emit as ["app-cmd",{"operation":<line>}].
+//
+//   image_push logo.png 0 60 > logo.jsonl
+//
+// PNG input must be 8-bit RGB; .qoi files (RGBA included) are sent as is.
+// Sizes go to stderr: QOI, base64 on the wire, and raw RGB565 for scale.
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "image_push.h"
+#include "png_io.h"
+
+// Must match LCD_IMAGE_CHUNK_BYTES in input-device-lcd/include/lcd_app.h
+#define CHUNK_BYTES 2048
+
+static bool readFile(const char *path, std::vector<uint8_t> &out)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return false;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+        out.insert(out.end(), buf, buf + n);
+    fclose(f);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 4)
+    {
+        fprintf(stderr, "usage: %s IMAGE.png|IMAGE.qoi X Y\n", argv[0]);
+        return 2;
+    }
+
+    const std::string path = argv[1];
+    std::vector<uint8_t> qoi;
+    int width = 0, height = 0;
+    if (path.size() > 4 && path.compare(path.size() - 4, 4, ".qoi") == 0)
+    {
+        if (!readFile(argv[1], qoi) || qoi.size() < 14)
+        {
+            fprintf(stderr, "cannot read %s\n", argv[1]);
+            return 1;
+        }
+        width = (int)((uint32_t)qoi[4] << 24 | qoi[5] << 16 | qoi[6] << 8 | qoi[7]);
+        height = (int)((uint32_t)qoi[8] << 24 | qoi[9] << 16 | qoi[10] << 8 | qoi[11]);
+    }
+    else
+    {
+        std::vector<uint8_t> rgb;
+        if (!readRgbPng(path, rgb, width, height))
+        {
+            fprintf(stderr, "cannot read %s (8-bit RGB PNG expected)\n", argv[1]);
+            return 1;
+        }
+        qoi = qoiEncode(rgb.data(), width, height, 3);
+    }
+    if (width > 240)
+    {
+        fprintf(stderr, "%s is %d pixels wide; the panel takes at most 240\n", argv[1], width);
+        return 1;
+    }
+
+    size_t wire = 0;
+    for (const std::string &op : imagePushOperations(qoi, atoi(argv[2]), atoi(argv[3]), CHUNK_BYTES))
+    {
+        printf("%s\n", op.c_str());
+        wire += op.size();
+    }
+    const size_t raw = (size_t)width * height * 2;
+    fprintf(stderr, "%dx%d: %zu B QOI (%.1f%% of %zu B RGB565), %zu B of app-cmd operations\n", width, height,
+            qoi.size(), 100.0 * qoi.size() / raw, raw, wire);
+    return 0;
+}
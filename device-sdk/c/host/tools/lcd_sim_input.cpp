@@ -0,0 +1,551 @@
+// Runs the input-device-lcd dashboard (lcd.cpp + lcd_app.cpp, unmodified)
+// against the simulated ST7789 and reports what every frame costs on the
+// bus. Frames follow a scripted day in the life of the device: boot, idle
+// refreshes, clock ticks, sensor edges and link changes.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "event_log.h"
+#include "hangul.h"
+#include "host.h"
+#include "image_push.h"
+#include "lcd.h"
+#include "lcd_app.h"
+#include "qoi_stream.h"
+#include "qr_code.h"
+#include "sim_report.h"
+#include "sparkline.h"
+#include "wall_clock.h"
+
+static UiSnapshot baseline()
+{
+    UiSnapshot s;
+    s.wifiConnected = true;
+    s.wifiRssi = -58;
+    s.socketConnected = true;
+    for (int i = 0; i < SENSOR_COUNT; i++)
+        s.sensors[i] = false;
+    s.dateText = "2026-02-13";
+    s.timeText = "10:24:30";
+    s.ip = IPAddress(192, 168, 0, 42);
+    return s;
+}
+
+static void renderStep(SimReport &report, const char *name, const UiSnapshot &state)
+{
+    report.begin(name);
+    lcdUiRender(state);
+    LCD::waitIdle();
+
+    const UiFrameStats &fs = lcdUiLastFrameStats();
+    char extra[64];
+    snprintf(extra, sizeof(extra), "widgets=%u area=%lu", fs.widgetsRedrawn, (unsigned long)fs.redrawArea);
+    report.end(extra);
+}
+
+// Draws every printable character in font from y down; returns the y
+// below the last line
+static int drawCharset(const Font &font, int perLine, int y)
+{
+    for (int i = 0; i < FONT_GLYPH_COUNT; i += perLine)
+    {
+        char line[33] = {};
+        for (int k = 0; k < perLine && i + k < FONT_GLYPH_COUNT; ++k)
+            line[k] = (char)(FONT_FIRST_CHAR + i + k);
+        lcdDrawTextFont(font, line, 4, y, 0xFFFF, 0x0000);
+        y += font.height + 2;
+    }
+    return y;
+}
+
+// Every printable character in each font, with its flash footprint and the
+// host CPU time per glyph spent in lcdDrawTextFont() (flush excluded)
+static void fontStep(SimReport &report)
+{
+    const struct
+    {
+        const char *name;
+        const Font &font;
+        int perLine;
+    } fonts[] = {{"FONT_SMALL", FONT_SMALL, 32}, {"FONT_LARGE", FONT_LARGE, 16}, {"FONT_LARGE_AA", FONT_LARGE_AA, 16}};
+
+    char extra[512] = "";
+    for (const auto &f : fonts)
+    {
+        const int runs = 200;
+        double ns = 0;
+        for (int r = 0; r < runs; ++r)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            drawCharset(f.font, f.perLine, 0);
+            ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            LCD::flush();
+        }
+        const size_t len = strlen(extra);
+        snprintf(extra + len, sizeof(extra) - len, "%s%s %u B %.0f ns/glyph", len ? ", " : "", f.name,
+                 (unsigned)f.font.bytes, ns / runs / FONT_GLYPH_COUNT);
+    }
+    LCD::waitIdle();
+
+    report.begin("fonts");
+    lcdUiInit();
+    int y = 4;
+    for (const auto &f : fonts)
+        y = drawCharset(f.font, f.perLine, y) + 6;
+    LCD::flush();
+    LCD::waitIdle();
+    report.end(extra);
+}
+
+// Korean labels as the dashboard would show them, in both large fonts.
+// Timed cold (every syllable rasterized into the cache) and warm (all
+// cache hits), host CPU per glyph, flush excluded.
+static const char *const HANGUL_LABELS[] = {
+    "센서 1 켜짐 / 꺼짐", "온도 23.5도 습도 41%", "와이파이 약함", "서버 연결 끊김",
+    "닭 값 읽기 괜찮아", "뷁 쀍 똠방각하", "ㄱㄴㄷㄹ ㅏㅑㅓㅕ ㅘㅢ",
+};
+
+static int drawHangul(const Font &font, int y)
+{
+    for (const char *label : HANGUL_LABELS)
+    {
+        lcdDrawTextFont(font, label, 4, y, 0xFFFF, 0x0000);
+        y += font.height + 2;
+    }
+    return y;
+}
+
+static int hangulGlyphCount()
+{
+    int n = 0;
+    for (const char *label : HANGUL_LABELS)
+        for (const char *p = label; *p;)
+            n += fontIsHangul(fontNextCodepoint(p)) ? 1 : 0;
+    return n;
+}
+
+static void hangulStep(SimReport &report)
+{
+    // Each label is drawn twice in a row, the way a widget is redrawn on
+    // the next state change: the first draw rasterizes, the second hits.
+    const int glyphs = hangulGlyphCount();
+    const int runs = 200;
+    double coldNs = 0, warmNs = 0;
+    for (int r = 0; r < runs; ++r)
+    {
+        hangulCacheClear();
+        int y = 0;
+        for (const char *label : HANGUL_LABELS)
+        {
+            auto start = std::chrono::steady_clock::now();
+            lcdDrawTextFont(FONT_LARGE_AA, label, 4, y, 0xFFFF, 0x0000);
+            coldNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+            start = std::chrono::steady_clock::now();
+            lcdDrawTextFont(FONT_LARGE_AA, label, 4, y, 0xFFFF, 0x0000);
+            warmNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            y += FONT_LARGE_AA.height + 2;
+        }
+        LCD::flush();
+    }
+    LCD::waitIdle();
+    const HangulCacheStats st = hangulCacheStats(); // last run only
+
+    char extra[256];
+    snprintf(extra, sizeof(extra),
+             "%u B flash, cache %u x %u B, %d glyphs: cold %.0f ns/glyph, warm %.0f ns/glyph, hit rate %.0f%% "
+             "(%u evictions)",
+             (unsigned)hangulFlashBytes(), (unsigned)LCD_HANGUL_CACHE, (unsigned)HANGUL_GLYPH_BYTES, glyphs,
+             coldNs / runs / glyphs, warmNs / runs / glyphs, 100.0 * st.hits / (st.hits + st.misses),
+             (unsigned)st.evictions);
+
+    report.begin("hangul");
+    lcdUiInit();
+    const int y = drawHangul(FONT_LARGE, 4) + 6;
+    drawHangul(FONT_LARGE_AA, y);
+    LCD::flush();
+    LCD::waitIdle();
+    report.end(extra);
+}
+
+// Eight minutes of renders at the firmware's 1 Hz refresh with the clock
+// text held still, so the bus traffic is the sparklines alone: sensor 1
+// toggles every 7 s, sensor 2 blinks on for one render in 13, sensor 3 is
+// on for long stretches. The history wraps the ring, and every tick that
+// closes a column should cost the same.
+static void sparklineStep(SimReport &report, UiSnapshot state)
+{
+    report.begin("sparkline");
+    uint64_t minBytes = UINT64_MAX, maxBytes = 0;
+    int columnTicks = 0;
+    for (int sec = 0; sec < 480; ++sec)
+    {
+        host::advanceMicros(1000000);
+        state.sensors[0] = (sec / 7) % 2 == 1;
+        state.sensors[1] = sec % 13 == 0;
+        state.sensors[2] = (sec / 90) % 2 == 0;
+
+        const uint64_t before = SimPanel::get().stats().bytes;
+        lcdUiRender(state);
+        LCD::waitIdle();
+        const uint64_t bytes = SimPanel::get().stats().bytes - before;
+
+        // Sensor text changes redraw their cards too; only count ticks
+        // where the strips alone moved
+        if (lcdUiLastFrameStats().widgetsRedrawn == SENSOR_COUNT)
+        {
+            minBytes = std::min(minBytes, bytes);
+            maxBytes = std::max(maxBytes, bytes);
+            columnTicks++;
+        }
+    }
+
+    char extra[160];
+    snprintf(extra, sizeof(extra), "%d column ticks, %llu..%llu bytes/tick, %u B history per sensor", columnTicks,
+             (unsigned long long)minBytes, (unsigned long long)maxBytes, (unsigned)sizeof(SparkHistory));
+    report.end(extra);
+}
+
+// The event console: boot history shown when the page opens, then one
+// event per render like a busy site visit. Each new line should cost one
+// line window plus the VSCSAD write, however full the screen is.
+static void consoleStep(SimReport &report)
+{
+    eventLog(EVENT_INFO, "WiFi up 192.168.0.42 -58 dBm");
+    eventLog(EVENT_INFO, "Auth ok");
+    eventLog(EVENT_INFO, "Socket open, sid 3kQ9xv1mZ");
+    eventLog(EVENT_ERROR, "Auth: HTTP 503");
+
+    report.begin("console_open");
+    lcdUiSetPage(UI_PAGE_CONSOLE);
+    LCD::waitIdle();
+    report.end("4 lines of history");
+
+    report.begin("console_lines");
+    uint64_t minBytes = UINT64_MAX, maxBytes = 0;
+    const int events = 45; // wraps the 30-line scroll ring
+    for (int i = 0; i < events; ++i)
+    {
+        host::advanceMicros(700000);
+        if (i % 9 == 4)
+            eventLog(EVENT_WARN, "Socket disconnected");
+        else if (i % 3 == 0)
+            eventLog(EVENT_INFO, "GPIO %d: %d -> %d", 32 + (i / 3) % 3, i % 2, (i + 1) % 2);
+        else
+            eventLog(EVENT_INFO, "Cmd output [%d]=%d", i % 3, i % 2);
+
+        const uint64_t before = SimPanel::get().stats().bytes;
+        lcdUiRender(baseline());
+        LCD::waitIdle();
+        const uint64_t bytes = SimPanel::get().stats().bytes - before;
+        minBytes = std::min(minBytes, bytes);
+        maxBytes = std::max(maxBytes, bytes);
+    }
+    char extra[96];
+    snprintf(extra, sizeof(extra), "%d events, %llu..%llu bytes/line", events, (unsigned long long)minBytes,
+             (unsigned long long)maxBytes);
+    report.end(extra);
+
+    lcdUiSetPage(UI_PAGE_DASHBOARD);
+}
+
+// A site floor plan the way a server would render one: flat fills, walls,
+// and a few markers. Compresses far better than the logo below.
+static std::vector<uint8_t> floorPlan(int w, int h)
+{
+    std::vector<uint8_t> rgb((size_t)w * h * 3);
+    for (int y = 0; y < h; ++y)
+        for (int x = 0; x < w; ++x)
+        {
+            uint8_t *p = &rgb[((size_t)y * w + x) * 3];
+            const bool wall = x < 3 || y < 3 || x >= w - 3 || y >= h - 3 || (x >= 118 && x < 121 && (y < 40 || y > 64)) ||
+                              (y >= 70 && y < 73 && x < 90);
+            const int dx = x - 160, dy = y - 30, ex = x - 50, ey = y - 100;
+            if (wall)
+                p[0] = p[1] = p[2] = 40;
+            else if (dx * dx + dy * dy < 64)
+                p[0] = 220, p[1] = 40, p[2] = 40; // sensor alarm
+            else if (ex * ex + ey * ey < 64)
+                p[0] = 40, p[1] = 200, p[2] = 80;
+            else if (x < 118 && y < 70)
+                p[0] = 235, p[1] = 230, p[2] = 210;
+            else
+                p[0] = p[1] = p[2] = 225;
+        }
+    return rgb;
+}
+
+// RGBA logo: radial gradient disc, transparent outside, antialiased edge
+static std::vector<uint8_t> gradientLogo(int size)
+{
+    std::vector<uint8_t> rgba((size_t)size * size * 4);
+    const double c = (size - 1) / 2.0, r = size / 2.0 - 1;
+    for (int y = 0; y < size; ++y)
+        for (int x = 0; x < size; ++x)
+        {
+            uint8_t *p = &rgba[((size_t)y * size + x) * 4];
+            const double d = std::sqrt((x - c) * (x - c) + (y - c) * (y - c));
+            p[0] = (uint8_t)(255 * x / (size - 1));
+            p[1] = (uint8_t)(80 + 120 * y / (size - 1));
+            p[2] = (uint8_t)(255 - 255 * d / (r + 1));
+            p[3] = (uint8_t)std::lround(255 * std::min(1.0, std::max(0.0, r - d + 0.5)));
+        }
+    return rgba;
+}
+
+// Feeds qoi to the image sink in app-cmd sized chunks; returns host ns
+static double pushImage(const std::vector<uint8_t> &qoi, int x, int y)
+{
+    const auto start = std::chrono::steady_clock::now();
+    lcdImageBegin(x, y);
+    for (size_t off = 0; off < qoi.size(); off += LCD_IMAGE_CHUNK_BYTES)
+        lcdImageWrite(qoi.data() + off, std::min((size_t)LCD_IMAGE_CHUNK_BYTES, qoi.size() - off));
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Decode alone into a scratch band, to separate decoder speed from the
+// panel traffic; returns ns per run
+static double decodeNs(const std::vector<uint8_t> &qoi, int runs)
+{
+    static uint16_t band[LCD::WIDTH * 8];
+    const auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < runs; ++r)
+    {
+        QoiStream qs;
+        qoiStreamBegin(qs, 0x0000);
+        for (size_t off = 0; off < qoi.size(); off += LCD_IMAGE_CHUNK_BYTES)
+        {
+            const uint8_t *p = qoi.data() + off;
+            size_t len = std::min((size_t)LCD_IMAGE_CHUNK_BYTES, qoi.size() - off);
+            while ((len > 0 || qs.run > 0) && qs.status != QOI_DONE)
+                if (qoiStreamDecode(qs, p, len, band, sizeof(band) / sizeof(band[0])) == 0)
+                    break;
+        }
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / runs;
+}
+
+// Two images streamed onto the dashboard through the lcd-image path. Sizes
+// compare the QOI stream, its base64 app-cmd operations, and raw RGB565.
+static void imageStep(SimReport &report)
+{
+    const int planW = 200, planH = 130, logoSize = 64;
+    const std::vector<uint8_t> plan = qoiEncode(floorPlan(planW, planH).data(), planW, planH, 3);
+    const std::vector<uint8_t> logo = qoiEncode(gradientLogo(logoSize).data(), logoSize, logoSize, 4);
+
+    char extra[512];
+    int n = 0;
+    const struct
+    {
+        const char *name;
+        const std::vector<uint8_t> &qoi;
+        int w, h;
+    } images[] = {{"plan", plan, planW, planH}, {"logo", logo, logoSize, logoSize}};
+    for (const auto &im : images)
+    {
+        size_t wire = 0;
+        for (const std::string &op : imagePushOperations(im.qoi, 0, 0, LCD_IMAGE_CHUNK_BYTES))
+            wire += op.size();
+        const size_t raw = (size_t)im.w * im.h * 2;
+        const double ns = decodeNs(im.qoi, 200);
+        n += snprintf(extra + n, sizeof(extra) - n, "%s%s %dx%d: %zu B QOI, %zu B app-cmd, %zu B RGB565 (%.0f%%), %.0f MB/s",
+                      n ? "; " : "", im.name, im.w, im.h, im.qoi.size(), wire, raw, 100.0 * im.qoi.size() / raw,
+                      raw / ns * 1000);
+    }
+    snprintf(extra + n, sizeof(extra) - n, "; %u B RAM", (unsigned)lcdImageRamBytes());
+
+    report.begin("image");
+    lcdUiInit();
+    lcdUiRender(baseline());
+    pushImage(plan, 20, 50);
+    pushImage(logo, 88, 230);
+    LCD::waitIdle();
+    report.end(extra);
+
+    // Chunks that end inside the 14-byte QOI header, or carry nothing,
+    // must draw the same image as the usual split
+    const std::vector<uint16_t> expected(SimPanel::get().framebuffer(),
+                                         SimPanel::get().framebuffer() + SimPanel::WIDTH * SimPanel::HEIGHT);
+    lcdUiRender(baseline());
+    pushImage(plan, 20, 50);
+    lcdImageBegin(88, 230);
+    lcdImageWrite(logo.data(), 0);
+    lcdImageWrite(logo.data(), 5);
+    lcdImageWrite(logo.data() + 5, 0);
+    for (size_t off = 5; off < logo.size(); off += LCD_IMAGE_CHUNK_BYTES)
+        lcdImageWrite(logo.data() + off, std::min((size_t)LCD_IMAGE_CHUNK_BYTES, logo.size() - off));
+    LCD::waitIdle();
+    if (!std::equal(expected.begin(), expected.end(), SimPanel::get().framebuffer()))
+        report.fail("image: a header split across chunks drew a different image");
+}
+
+// The onboarding QR page for DEVICE_SN. The firmware gets that code from
+// flash; the encode time here is what a serial set at run time costs.
+static void qrStep(SimReport &report)
+{
+    const int runs = 200;
+    static volatile const char *serial = DEVICE_SN; // keeps qrEncode() out of constant folding
+    QrCode qr;
+    const auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < runs; ++r)
+        qr = qrEncode((const char *)serial);
+    const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / runs;
+
+    char extra[160];
+    snprintf(extra, sizeof(extra), "%dx%d modules, mask %d, %u B flash, runtime encode %.0f us", qr.size, qr.size,
+             qr.mask, (unsigned)sizeof(QrCode), us);
+
+    report.begin("qr");
+    lcdUiSetPage(UI_PAGE_QR);
+    LCD::waitIdle();
+    report.end(extra);
+
+    lcdUiSetPage(UI_PAGE_DASHBOARD);
+}
+
+// The wall clock behind collectUiState(), on the virtual timeline with
+// SNTP syncs delivered by hand: ten reads per second for ten minutes per
+// phase, checking the texts are formatted once per second and that small
+// corrections slew without the clock ever running backwards.
+static void clockStep(SimReport &report)
+{
+    const int64_t utc = 1770945870LL * 1000000; // 2026-02-13 10:24:30 KST
+    clockBegin("KST-9");
+    const bool blankBeforeSync = strcmp(clockTimeText(), "--:--:--") == 0;
+
+    host::deliverSntp(utc);
+    const uint32_t formatsBefore = clockFormatCount();
+    int64_t last = clockNowUs(), worstRate = 0;
+    bool monotonic = true;
+    int reads = 0;
+    const int64_t corrections[] = {300000, -200000}; // slewed, each one phase
+    for (int phase = 0; phase <= 2; ++phase)
+    {
+        if (phase > 0)
+            host::deliverSntp(clockNowUs() + corrections[phase - 1]);
+        for (int i = 0; i < 6000; ++i)
+        {
+            host::advanceMicros(100000);
+            clockDateText();
+            clockTimeText();
+            reads++;
+            const int64_t now = clockNowUs();
+            monotonic = monotonic && now > last;
+            worstRate = std::max(worstRate, std::abs(now - last - 100000));
+            last = now;
+        }
+    }
+    const uint32_t formats = clockFormatCount() - formatsBefore;
+
+    const int runs = 1000000;
+    const auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < runs; ++r)
+        clockTimeText();
+    const double readNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / runs;
+
+    host::deliverSntp(clockNowUs() - 5000000); // too large to slew
+    const ClockSyncInfo sync = clockSyncInfo();
+
+    char extra[256];
+    snprintf(extra, sizeof(extra),
+             "%s before sync, %d reads -> %u formats, cached read %.0f ns; +300/-200 ms slewed, %s, "
+             "max %lld us/100 ms off; -5 s stepped (%lld ms)",
+             blankBeforeSync ? "blank" : "NOT BLANK", reads, (unsigned)formats, readNs,
+             monotonic ? "monotonic" : "WENT BACKWARDS", (long long)worstRate,
+             (long long)(sync.lastCorrectionUs / 1000));
+
+    report.begin("clock");
+    UiSnapshot state = baseline();
+    state.dateText = clockDateText();
+    state.timeText = clockTimeText();
+    lcdUiRender(state);
+    LCD::waitIdle();
+    report.end(extra);
+}
+
+int main(int argc, char **argv)
+{
+    SimOptions opts;
+    if (!parseSimOptions(argc, argv, opts))
+        return 2;
+
+    host::setSerialOutput(nullptr);
+    host::setPsram(opts.psram);
+    SimPanel::get().reset();
+    SimReport report(opts);
+
+    // Same bring-up as setup() in main.cpp
+    report.begin("boot");
+    LCD::begin();
+    LCD::setBacklight(255);
+    LCD::setRotation(2);
+    LCD::fillScreen(0x0000);
+    LCD::flush();
+    LCD::waitIdle();
+    char clock[48];
+    snprintf(clock, sizeof(clock), "write clock %lu Hz", (unsigned long)LCD::writeClock());
+    report.end(clock);
+
+    UiSnapshot state = baseline();
+    renderStep(report, "first_frame", state);
+    renderStep(report, "idle", state);
+
+    state.timeText = "10:24:31";
+    renderStep(report, "clock_tick", state);
+
+    state.timeText = "10:24:32";
+    state.sensors[0] = true;
+    renderStep(report, "sensor_on", state);
+
+    state.sensors[1] = true;
+    state.sensors[2] = true;
+    renderStep(report, "all_sensors_on", state);
+
+    state.wifiRssi = -82;
+    renderStep(report, "weak_wifi", state);
+
+    state.socketConnected = false;
+    renderStep(report, "socket_lost", state);
+
+    state.wifiConnected = false;
+    state.wifiRssi = 0;
+    state.dateText = "--";
+    state.timeText = "--:--:--";
+    renderStep(report, "wifi_lost", state);
+
+    state = baseline();
+    state.timeText = "10:25:00";
+    renderStep(report, "reconnected", state);
+
+    report.begin("sixty_ticks");
+    static char t[12]; // state keeps pointing at the last time
+    for (int sec = 1; sec <= 60; sec++)
+    {
+        snprintf(t, sizeof(t), "10:%02d:%02d", 25 + sec / 60, sec % 60);
+        state.timeText = t;
+        lcdUiRender(state);
+    }
+    LCD::waitIdle();
+    report.end("60 frames");
+
+    sparklineStep(report, state);
+    consoleStep(report);
+
+    fontStep(report);
+    hangulStep(report);
+    imageStep(report);
+    qrStep(report);
+    clockStep(report);
+
+    if (report.failures())
+    {
+        fprintf(stderr, "%d step(s) did not match the golden images\n", report.failures());
+        return 1;
+    }
+    return 0;
+}
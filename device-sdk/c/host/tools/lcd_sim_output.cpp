@@ -0,0 +1,152 @@
+// Runs the output-device ILI9341 driver (lcd.cpp, unmodified) on top of the
+// ESP-IDF SPI master shim and measures the same operations as the
+// on-device LCD_BENCHMARK, plus the bitmap and pixel-push paths. Then
+// costs the LCD_BENCHMARK operations again on the per-byte driver this one
+// replaced, for a before/after table.
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+#include "host.h"
+#include "lcd.h"
+#include "legacy_ili9341.h"
+#include "sim_report.h"
+
+// Bus time of one call of each LCD_BENCHMARK operation: the old driver at
+// the clock it ran at and at the new driver's clock (to separate the
+// clock from the batching), and the new driver. Both drivers must leave
+// the same pixels.
+static void compareLegacy(SimReport &report, const SimOptions &opts)
+{
+    SimPanel &panel = SimPanel::get();
+    const uint32_t clockHz = panel.effectiveClockHz();
+    const struct
+    {
+        const char *name;
+        int calls;
+        std::function<void()> current, legacy;
+    } ops[] = {
+        {"fill_screen", 1, [] { LCD::fillScreen(0xFFFF); }, [] { legacy_ili9341::fillScreen(0xFFFF); }},
+        {"fill_rect_200x100", 1, [] { LCD::fillRect(20, 20, 200, 100, 0x001F); },
+         [] { legacy_ili9341::fillRect(20, 20, 200, 100, 0x001F); }},
+        {"fill_rect_12x12", 100,
+         []
+         {
+             for (int i = 0; i < 100; i++)
+                 LCD::fillRect(i * 2, 150, 12, 12, 0x07E0);
+         },
+         []
+         {
+             for (int i = 0; i < 100; i++)
+                 legacy_ili9341::fillRect(i * 2, 150, 12, 12, 0x07E0);
+         }},
+        {"draw_rect", 1, [] { LCD::drawRect(10, 10, 220, 100, 0xF800); },
+         [] { legacy_ili9341::drawRect(10, 10, 220, 100, 0xF800); }},
+    };
+
+    printf("\nbefore/after, bus us per call; before = per-byte SPI.transfer() driver\n");
+    printf("%-22s %14s %14s %14s %9s\n", "op", "before", "before", "after", "speedup");
+    printf("%-22s %10.2f MHz %10.2f MHz %10.2f MHz\n", "", legacy_ili9341::DEFAULT_CLOCK_HZ / 1e6, clockHz / 1e6,
+           clockHz / 1e6);
+    for (const auto &op : ops)
+    {
+        panel.reset();
+        op.current();
+        LCD::waitIdle();
+        const double afterUs = panel.busMicros() / op.calls;
+        const std::vector<uint16_t> expected(panel.framebuffer(),
+                                             panel.framebuffer() + SimPanel::WIDTH * SimPanel::HEIGHT);
+
+        panel.reset();
+        panel.setClockOverrideHz(legacy_ili9341::DEFAULT_CLOCK_HZ);
+        op.legacy();
+        const double beforeUs = panel.busMicros() / op.calls;
+        panel.setClockOverrideHz(clockHz);
+        const double beforeSameClockUs = panel.busMicros() / op.calls;
+        if (!std::equal(expected.begin(), expected.end(), panel.framebuffer()))
+        {
+            char what[96];
+            snprintf(what, sizeof(what), "%s: the old and new drivers drew different pixels", op.name);
+            report.fail(what);
+        }
+
+        printf("%-22s %14.1f %14.1f %14.1f %8.0fx\n", op.name, beforeUs, beforeSameClockUs, afterUs,
+               beforeUs / afterUs);
+    }
+    panel.setClockOverrideHz(opts.clockHz);
+    panel.reset();
+}
+
+int main(int argc, char **argv)
+{
+    SimOptions opts;
+    if (!parseSimOptions(argc, argv, opts))
+        return 2;
+
+    host::setSerialOutput(nullptr);
+    SimPanel::get().reset();
+    SimReport report(opts);
+
+    report.begin("init");
+    LCD::begin();
+    LCD::setBacklight(255);
+    LCD::waitIdle();
+    report.end();
+
+    report.begin("fill_screen");
+    LCD::fillScreen(0xFFFF);
+    LCD::waitIdle();
+    report.end();
+
+    report.begin("fill_rect_200x100");
+    LCD::fillRect(20, 20, 200, 100, 0x001F);
+    LCD::waitIdle();
+    report.end();
+
+    report.begin("fill_rect_12x12_x100");
+    for (int i = 0; i < 100; i++)
+        LCD::fillRect(i * 2, 150, 12, 12, 0x07E0);
+    LCD::waitIdle();
+    report.end("100 calls");
+
+    report.begin("draw_rect");
+    LCD::drawRect(10, 10, 220, 100, 0xF800);
+    LCD::waitIdle();
+    report.end();
+
+    // 64x32 checkerboard of 8x8 cells, 1bpp MSB-first
+    std::vector<uint8_t> bitmap(64 / 8 * 32);
+    for (int y = 0; y < 32; y++)
+        for (int x = 0; x < 64; x++)
+            if (((x / 8) + (y / 8)) & 1)
+                bitmap[y * 8 + x / 8] |= (uint8_t)(0x80 >> (x % 8));
+    report.begin("draw_bitmap_64x32");
+    LCD::drawBitmap(88, 180, 64, 32, bitmap.data(), 0x0000, 0xFFE0);
+    LCD::waitIdle();
+    report.end();
+
+    std::vector<uint16_t> gradient(240 * 80);
+    for (int y = 0; y < 80; y++)
+        for (int x = 0; x < 240; x++)
+            gradient[y * 240 + x] = (uint16_t)(((x * 31 / 239) << 11) | ((y * 63 / 79) << 5) | 0x0F);
+    report.begin("push_pixels_240x80");
+    LCD::pushPixels(0, 230, 240, 80, gradient.data());
+    LCD::waitIdle();
+    report.end();
+
+    report.begin("draw_pixel_x100");
+    for (int i = 0; i < 100; i++)
+        LCD::drawPixel(20 + i * 2, 315, 0xFFFF);
+    LCD::waitIdle();
+    report.end("100 calls");
+
+    compareLegacy(report, opts);
+
+    if (report.failures())
+    {
+        fprintf(stderr, "%d step(s) did not match the golden images\n", report.failures());
+        return 1;
+    }
+    return 0;
+}
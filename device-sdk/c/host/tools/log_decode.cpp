@@ -0,0 +1,122 @@
+// Decodes a serial capture of input-device-lcd built with LOG_BINARY 1
+// (dev_log.h) back into text, using the firmware's own log_record.cpp.
+//
+//   log_decode [--trace file] [capture]     reads stdin without a capture
+//
+// --trace writes the traffic trace frames (traffic_trace.h) to file, for
+// trace_replay; they are left out of the text either way.
+// Bytes outside frames (boot ROM output, a capture cut mid-frame) are
+// passed through as they are. Records whose format has not been sent yet,
+// when the capture started late, print the format id and argument count
+// until the format is sent again (at most LOG_FORMAT_RESEND_MS later).
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "log_record.h"
+#include "trace_record.h"
+
+static void printRecord(const std::map<uint32_t, std::string> &formats, const uint8_t *payload, size_t length)
+{
+    uint32_t id;
+    memcpy(&id, payload, 4);
+    LogRecordView record;
+    if (!logParseRecord(payload + 4, length - 4, record))
+    {
+        printf("-- malformed record (format %08x)\n", id);
+        return;
+    }
+    char line[1024];
+    const auto format = formats.find(id);
+    if (format == formats.end())
+        snprintf(line, sizeof(line), "<format %08x, %u args>", id, record.nargs);
+    else
+    {
+        size_t n = logFormat(line, sizeof(line), format->second.c_str(), record);
+        while (n > 0 && line[n - 1] == '\n')
+            line[--n] = '\0';
+    }
+    printf("%lu.%03lu %c %s\n", (unsigned long)(record.timeUs / 1000000), (unsigned long)(record.timeUs / 1000 % 1000),
+           logLevelLetter(record.level), line);
+}
+
+int main(int argc, char **argv)
+{
+    FILE *in = stdin;
+    FILE *trace = nullptr;
+    int arg = 1;
+    if (arg + 1 < argc && strcmp(argv[arg], "--trace") == 0)
+    {
+        if (!(trace = fopen(argv[arg + 1], "wb")))
+        {
+            fprintf(stderr, "cannot create %s\n", argv[arg + 1]);
+            return 1;
+        }
+        arg += 2;
+    }
+    if (arg < argc && !(in = fopen(argv[arg], "rb")))
+    {
+        fprintf(stderr, "cannot open %s\n", argv[arg]);
+        return 1;
+    }
+    std::vector<uint8_t> data;
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0)
+        data.insert(data.end(), chunk, chunk + n);
+    if (in != stdin)
+        fclose(in);
+
+    std::map<uint32_t, std::string> formats;
+    unsigned long records = 0, traceFrames = 0, badFrames = 0;
+    size_t i = 0;
+    while (i < data.size())
+    {
+        // A frame: sync, kind, length, payload, checksum
+        if (data[i] == LOG_FRAME_SYNC && i + 4 < data.size())
+        {
+            const uint8_t kind = data[i + 1];
+            const size_t length = data[i + 2] | (size_t)data[i + 3] << 8;
+            const bool knownKind = kind == LOG_FRAME_FORMAT || kind == LOG_FRAME_RECORD || kind == LOG_FRAME_LOST ||
+                                   kind == LOG_FRAME_TRACE;
+            if (knownKind && length >= 4 && i + 5 + length <= data.size())
+            {
+                const uint8_t *payload = &data[i + 4];
+                uint8_t checksum = 0;
+                for (size_t k = 0; k < length; ++k)
+                    checksum ^= payload[k];
+                if (checksum == data[i + 4 + length])
+                {
+                    uint32_t word;
+                    memcpy(&word, payload, 4);
+                    if (kind == LOG_FRAME_FORMAT)
+                        formats[word].assign((const char *)payload + 4, length - 4);
+                    else if (kind == LOG_FRAME_TRACE)
+                    {
+                        if (trace)
+                            fwrite(&data[i], 1, 5 + length, trace);
+                        traceFrames++;
+                    }
+                    else if (kind == LOG_FRAME_RECORD)
+                    {
+                        printRecord(formats, payload, length);
+                        records++;
+                    }
+                    else
+                        printf("-- %lu records dropped on the device\n", (unsigned long)word);
+                    i += 5 + length;
+                    continue;
+                }
+                badFrames++;
+            }
+        }
+        putchar(data[i++]);
+    }
+    if (trace)
+        fclose(trace);
+    fprintf(stderr, "%lu records, %zu formats, %lu trace frames, %lu bad frames\n", records, formats.size(),
+            traceFrames, badFrames);
+    return 0;
+}
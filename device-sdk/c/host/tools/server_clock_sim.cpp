@@ -0,0 +1,155 @@
+// Runs the input-device-lcd server clock estimator (server_clock.cpp,
+// unmodified) against synthetic round-trip traces and reports how close
+// its offset stays to the truth. Traces vary latency asymmetry, queueing
+// spikes, frequency error and a server clock step. Requests follow the
+// firmware's schedule: a burst after connecting, then one a minute.
+//
+// For every simulated second the estimator's offset is compared with the
+// true one. The uncertainty it reports must cover the error; a trace
+// where it does not (outside the window after a server step) fails the
+// run with exit status 1. Cristian's midpoint of the newest round trip is
+// shown for comparison.
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "server_clock.h"
+
+// Must match the schedule in input-device-lcd/src/main.cpp
+#define BURST_REQUESTS 8
+#define BURST_INTERVAL_US 2000000
+#define REQUEST_INTERVAL_US 60000000
+
+struct Trace
+{
+    const char *name;
+    double upMs, downMs;   // fixed path latency each way
+    double jitterMs;       // mean of the exponential queueing delay, each way
+    double spikeRate;      // share of requests delayed by spikeMs on the way down
+    double spikeMs;
+    double driftPpm;       // server rate minus device rate
+    double stepAtH, stepS; // server clock steps by stepS at hour stepAtH (0: never)
+};
+
+static const Trace TRACES[] = {
+    {"symmetric", 30, 30, 8, 0, 0, 0, 0, 0},
+    {"asymmetric", 10, 90, 8, 0, 0, 0, 0, 0},
+    {"asymmetric_spikes", 10, 90, 8, 0.15, 400, 0, 0, 0},
+    {"cellular_drift", 40, 120, 25, 0.05, 800, 45, 0, 0},
+    {"slow_drift", 60, 20, 10, 0, 0, -30, 0, 0},
+    {"server_step", 10, 90, 8, 0, 0, 20, 3, 2.0},
+};
+
+static const double HOURS = 8;
+
+// Deterministic per trace
+struct Rng
+{
+    uint64_t state;
+    double uniform()
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return ((state >> 11) + 0.5) / 9007199254740992.0;
+    }
+    double exponential(double mean) { return -mean * std::log(uniform()); }
+};
+
+static int64_t trueOffsetUs(const Trace &t, int64_t localUs)
+{
+    const double base = 1.7709e15; // server epoch at local time 0
+    double offset = base + localUs * t.driftPpm * 1e-6;
+    if (t.stepAtH > 0 && localUs >= t.stepAtH * 3600e6)
+        offset += t.stepS * 1e6;
+    return (int64_t)offset;
+}
+
+static double percentile(std::vector<double> v, double p)
+{
+    if (v.empty())
+        return 0;
+    std::sort(v.begin(), v.end());
+    return v[std::min(v.size() - 1, (size_t)(p * v.size()))];
+}
+
+int main()
+{
+    int failures = 0;
+    printf("%-18s %8s %8s %8s %8s %8s %8s %7s %6s\n", "trace", "p50_ms", "p95_ms", "max_ms", "unc_ms", "crist95",
+           "covered", "freq", "steps");
+
+    for (size_t ti = 0; ti < sizeof(TRACES) / sizeof(TRACES[0]); ++ti)
+    {
+        const Trace &t = TRACES[ti];
+        Rng rng = {0x9E3779B97F4A7C15ULL + ti};
+        ServerClock clock;
+        serverClockInit(clock);
+
+        std::vector<double> errors, uncertainties, cristian;
+        uint64_t seconds = 0, covered = 0;
+        double lastCristianUs = 0;
+        bool haveCristian = false;
+
+        int requests = 0;
+        int64_t nextRequest = 1000000;
+        const int64_t end = (int64_t)(HOURS * 3600e6);
+        for (int64_t now = 1000000; now <= end; now += 1000000)
+        {
+            while (nextRequest <= now)
+            {
+                const int64_t sent = nextRequest;
+                const double up = t.upMs + rng.exponential(t.jitterMs);
+                double down = t.downMs + rng.exponential(t.jitterMs);
+                if (rng.uniform() < t.spikeRate)
+                    down += t.spikeMs;
+                const int64_t serverAt = sent + (int64_t)(up * 1000);
+                const int64_t received = serverAt + (int64_t)(down * 1000);
+                // Whole milliseconds, as the server sends them
+                const int64_t serverUs = (serverAt + trueOffsetUs(t, serverAt)) / 1000 * 1000;
+
+                serverClockAddSample(clock, sent, received, serverUs);
+                lastCristianUs = (double)serverUs - (sent + received) / 2.0;
+                haveCristian = true;
+
+                requests++;
+                nextRequest += requests < BURST_REQUESTS ? BURST_INTERVAL_US : REQUEST_INTERVAL_US;
+            }
+            if (!clock.valid)
+                continue;
+
+            const double truth = (double)trueOffsetUs(t, now);
+            const double error = std::fabs(serverClockOffsetUs(clock, now) - truth);
+            const int64_t uncertainty = serverClockUncertaintyUs(clock, now);
+
+            // The minute after a server step cannot be right yet
+            const bool afterStep = t.stepAtH > 0 && now >= t.stepAtH * 3600e6 && now < t.stepAtH * 3600e6 + 61e6;
+            if (afterStep)
+                continue;
+            seconds++;
+            covered += error <= uncertainty;
+            errors.push_back(error / 1000);
+            uncertainties.push_back(uncertainty / 1000.0);
+            if (haveCristian)
+                cristian.push_back(std::fabs(lastCristianUs - truth) / 1000);
+        }
+
+        const double coveredPct = 100.0 * covered / seconds;
+        printf("%-18s %8.1f %8.1f %8.1f %8.1f %8.1f %7.2f%% %+7.1f %6u\n", t.name, percentile(errors, 0.5),
+               percentile(errors, 0.95), percentile(errors, 1.0), percentile(uncertainties, 0.5),
+               percentile(cristian, 0.95), coveredPct, clock.freqPpb / 1000.0, (unsigned)clock.steps);
+        if (covered != seconds)
+            failures++;
+    }
+
+    printf("\np50/p95/max: |offset error| per simulated second over %.0f h; unc: median reported\n"
+           "uncertainty; crist95: p95 error of the newest round trip's midpoint; freq: final\n"
+           "frequency estimate in ppm\n",
+           HOURS);
+    if (failures)
+    {
+        fprintf(stderr, "%d trace(s) had errors outside the reported uncertainty\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,474 @@
+// Replays a traffic trace (trace_record.h) into input-device-lcd's own
+// setup()/loop() on the virtual clock and compares what the firmware sends
+// with what the recorded device sent.
+//
+//   trace_replay [options] trace
+//
+// The trace may be a serial capture as it came off the device: frames are
+// picked out of it and everything else is skipped. Replay starts at the
+// trace's first connect, once the host firmware has connected too. Every
+// recorded frame is pushed to the firmware at its recorded offset, input
+// edges are driven on their pins, and recorded disconnects are replayed as
+// server drops; after a reconnect the schedule moves by however much later
+// the host firmware came back.
+//
+// Reports the host CPU time of the loop() that handled each frame, by
+// frame type, and the difference between the recorded and the replayed
+// packets. Exits 1 if they differ.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+#include "config.h"
+#include "dev_log.h"
+#include "host.h"
+#include "trace_record.h"
+
+void setup();
+void loop();
+
+struct ReplayOptions
+{
+    const char *path = nullptr;
+    double speed = 0; // 0: as fast as possible, 1: real time
+    uint32_t loopUs = 1000;
+    uint32_t tailMs = 2000;
+    uint32_t maxDiffs = 10;
+    std::set<std::string> ignore; // event names not compared
+    bool print = false;
+    bool serial = false;
+};
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [--speed X] [--loop-us N] [--tail-ms N] [--ignore EVENT]... [--max-diffs N]\n"
+            "          [--print] [--serial] trace\n",
+            prog);
+}
+
+static bool parseOptions(int argc, char **argv, ReplayOptions &opts)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "--speed") == 0 && hasValue)
+            opts.speed = strtod(argv[++i], nullptr);
+        else if (strcmp(arg, "--loop-us") == 0 && hasValue)
+            opts.loopUs = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--tail-ms") == 0 && hasValue)
+            opts.tailMs = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--ignore") == 0 && hasValue)
+            opts.ignore.insert(argv[++i]);
+        else if (strcmp(arg, "--max-diffs") == 0 && hasValue)
+            opts.maxDiffs = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--print") == 0)
+            opts.print = true;
+        else if (strcmp(arg, "--serial") == 0)
+            opts.serial = true;
+        else if (arg[0] != '-' && !opts.path)
+            opts.path = arg;
+        else
+        {
+            usage(argv[0]);
+            return false;
+        }
+    }
+    return opts.path && opts.loopUs > 0 && opts.speed >= 0;
+}
+
+// --------------------------------------------------------------------
+
+struct Event
+{
+    int64_t timeUs;
+    uint8_t kind;
+    uint8_t pin;
+    uint8_t level;
+    uint32_t lost;
+    std::string text;
+};
+
+static void collect(const TraceEvent &event, void *ctx)
+{
+    auto &events = *(std::vector<Event> *)ctx;
+    events.push_back({event.timeUs, event.kind, event.pin, event.level, event.lost,
+                      std::string((const char *)event.data, event.length)});
+}
+
+// The LOG_FRAME_TRACE frames of a capture, in order; counts bad ones
+static bool loadTrace(const char *path, std::vector<Event> &events, uint32_t &badFrames)
+{
+    FILE *in = fopen(path, "rb");
+    if (!in)
+    {
+        fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+    std::vector<uint8_t> data;
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0)
+        data.insert(data.end(), chunk, chunk + n);
+    fclose(in);
+
+    badFrames = 0;
+    size_t i = 0;
+    while (i + 4 < data.size())
+    {
+        const size_t length = data[i + 2] | (size_t)data[i + 3] << 8;
+        if (data[i] != LOG_FRAME_SYNC || data[i + 1] != LOG_FRAME_TRACE || i + 5 + length > data.size())
+        {
+            i++;
+            continue;
+        }
+        const uint8_t *payload = &data[i + 4];
+        uint8_t checksum = 0;
+        for (size_t k = 0; k < length; ++k)
+            checksum ^= payload[k];
+        if (checksum != data[i + 4 + length] || !traceParseFrame(payload, length, collect, &events))
+        {
+            badFrames++;
+            i++;
+            continue;
+        }
+        i += 5 + length;
+    }
+    return true;
+}
+
+// "42 app-cmd", "43 ack", "2 ping" ...
+static std::string frameType(const std::string &text)
+{
+    if (text.compare(0, 2, "42") == 0)
+    {
+        const size_t q = text.find('"');
+        const size_t end = q == std::string::npos ? q : text.find('"', q + 1);
+        return end == std::string::npos ? "42" : "42 " + text.substr(q + 1, end - q - 1);
+    }
+    if (text.compare(0, 2, "43") == 0)
+        return "43 ack";
+    static const char *const names[] = {"0 open", "1 close", "2 ping", "3 pong", "4", "5 upgrade", "6 noop"};
+    if (text.compare(0, 2, "40") == 0)
+        return "40 connect";
+    if (text.compare(0, 2, "41") == 0)
+        return "41 disconnect";
+    if (!text.empty() && text[0] >= '0' && text[0] <= '6')
+        return names[text[0] - '0'];
+    return "?";
+}
+
+static double percentile(std::vector<double> v, double p)
+{
+    if (v.empty())
+        return 0;
+    std::sort(v.begin(), v.end());
+    return v[std::min(v.size() - 1, (size_t)(p * v.size()))];
+}
+
+static void printTrace(const std::vector<Event> &events)
+{
+    const int64_t t0 = events.empty() ? 0 : events.front().timeUs;
+    for (const Event &e : events)
+    {
+        printf("%10.3f %c ", (e.timeUs - t0) / 1e3, e.kind);
+        if (e.kind == TRACE_GPIO)
+            printf("pin %u level %u\n", e.pin, e.level);
+        else if (e.kind == TRACE_LOST)
+            printf("%u records lost\n", e.lost);
+        else
+            printf("%s\n", e.text.c_str());
+    }
+}
+
+// --------------------------------------------------------------------
+
+// The server end: records what the firmware sends once replay started
+class ReplayPeer : public host::WsPeer
+{
+public:
+    struct Sent
+    {
+        int64_t us; // since replay start
+        std::string text;
+    };
+
+    bool accept(WebSocketsClient *c, const std::string &, uint16_t, const std::string &) override
+    {
+        conn = c;
+        return true;
+    }
+    void opened(WebSocketsClient *c) override { connected = c == conn; }
+    void closed(WebSocketsClient *c) override
+    {
+        if (c == conn)
+            connected = false;
+    }
+    void received(WebSocketsClient *, const char *text, size_t length) override
+    {
+        if (recording)
+            sent.push_back({(int64_t)host::nowMicros() - startUs, std::string(text, length)});
+    }
+
+    WebSocketsClient *conn = nullptr;
+    bool connected = false;
+    bool recording = false;
+    int64_t startUs = 0;
+    std::vector<Sent> sent;
+};
+
+static ReplayPeer peer;
+static uint32_t restarts = 0;
+
+static void step(uint32_t loopUs)
+{
+    try
+    {
+        loop();
+    }
+    catch (const host::Restart &)
+    {
+        restarts++;
+        setup();
+    }
+    logDrain();
+    host::advanceMicros(loopUs);
+}
+
+static std::string eventName(const std::string &text)
+{
+    const std::string type = frameType(text);
+    return type.compare(0, 3, "42 ") == 0 ? type.substr(3) : "";
+}
+
+struct Packet
+{
+    int64_t us;
+    std::string text;
+};
+
+// Walks both lists in order; a packet that is only in one of them is
+// missing or extra if the other list matches again within a few packets
+static uint32_t diffPackets(const std::vector<Packet> &want, const std::vector<Packet> &got, uint32_t maxDiffs,
+                            std::vector<double> &skewMs)
+{
+    const size_t window = 8;
+    uint32_t matched = 0, changed = 0, missing = 0, extra = 0, shown = 0;
+    auto show = [&](char sign, const Packet &p)
+    {
+        if (shown++ < maxDiffs)
+            printf("  %c %9.3f ms  %.120s\n", sign, p.us / 1e3, p.text.c_str());
+    };
+    size_t i = 0, j = 0;
+    while (i < want.size() || j < got.size())
+    {
+        if (i < want.size() && j < got.size() && want[i].text == got[j].text)
+        {
+            skewMs.push_back((got[j].us - want[i].us) / 1e3);
+            matched++, i++, j++;
+            continue;
+        }
+        size_t ahead = 1;
+        while (ahead <= window && j + ahead < got.size() && !(i < want.size() && got[j + ahead].text == want[i].text))
+            ahead++;
+        size_t behind = 1;
+        while (behind <= window && i + behind < want.size() &&
+               !(j < got.size() && want[i + behind].text == got[j].text))
+            behind++;
+        if (i < want.size() && j + ahead < got.size() && ahead <= window && (ahead <= behind || i + behind >= want.size()))
+        {
+            for (size_t k = 0; k < ahead; k++)
+                show('+', got[j++]), extra++;
+        }
+        else if (j < got.size() && i + behind < want.size() && behind <= window)
+        {
+            for (size_t k = 0; k < behind; k++)
+                show('-', want[i++]), missing++;
+        }
+        else if (i < want.size() && j < got.size())
+        {
+            show('-', want[i++]);
+            show('+', got[j++]);
+            changed++;
+        }
+        else if (i < want.size())
+            show('-', want[i++]), missing++;
+        else
+            show('+', got[j++]), extra++;
+    }
+    printf("packets        %u match, %u differ, %u missing, %u extra\n", matched, changed, missing, extra);
+    return changed + missing + extra;
+}
+
+int main(int argc, char **argv)
+{
+    ReplayOptions opts;
+    if (!parseOptions(argc, argv, opts))
+        return 2;
+
+    std::vector<Event> events;
+    uint32_t badFrames = 0;
+    if (!loadTrace(opts.path, events, badFrames))
+        return 1;
+    if (opts.print)
+    {
+        printTrace(events);
+        return 0;
+    }
+    auto first = std::find_if(events.begin(), events.end(), [](const Event &e)
+                              { return e.kind == TRACE_OPEN; });
+    if (first == events.end())
+    {
+        fprintf(stderr, "%s: no connect in %zu records, nothing to replay from\n", opts.path, events.size());
+        return 1;
+    }
+
+    host::setSerialOutput(opts.serial ? stdout : nullptr);
+    host::setWsPeer(&peer);
+    // The token the recorded device got, so its Socket.IO connect matches
+    static std::string token = "replay-token";
+    for (const Event &e : events)
+    {
+        const char *prefix = "40{\"token\":\"";
+        if (e.kind == TRACE_OUT && e.text.compare(0, strlen(prefix), prefix) == 0)
+        {
+            token = e.text.substr(strlen(prefix), e.text.find('"', strlen(prefix)) - strlen(prefix));
+            break;
+        }
+    }
+    host::setHttpHandler([](const host::HttpRequest &)
+                         {
+        host::HttpResponse response;
+        response.code = 200;
+        response.body = "{\"token\":\"" + token + "\"}";
+        return response; });
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+    setup();
+    while (!peer.connected && host::nowMicros() < 120000000)
+        step(opts.loopUs);
+    if (!peer.connected)
+    {
+        fprintf(stderr, "the firmware never connected\n");
+        return 1;
+    }
+
+    // Virtual time of the recorded first connect; moves with late reconnects
+    int64_t offsetUs = (int64_t)host::nowMicros() - first->timeUs;
+    peer.startUs = (int64_t)host::nowMicros();
+    peer.recording = true;
+
+    std::vector<Packet> want;
+    std::map<std::string, std::vector<double>> handleUs; // host time per frame type
+    std::vector<double> idleUs;
+    uint32_t framesIn = 0, edges = 0, drops = 0, lost = 0, cut = 0;
+    const auto wallStart = std::chrono::steady_clock::now();
+    // Frames the device received in one loop() are handled in one here too
+    std::vector<std::string> pending;
+    auto handlePending = [&]()
+    {
+        if (pending.empty())
+            return;
+        std::string label = pending[0];
+        for (size_t i = 1; i < pending.size(); i++)
+            label += " + " + pending[i];
+        const auto t = std::chrono::steady_clock::now();
+        step(opts.loopUs);
+        handleUs[label].push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t).count());
+        pending.clear();
+    };
+    for (auto e = first; e != events.end(); ++e)
+    {
+        // A GPIO record is when the scan saw the level; the pin changed
+        // somewhere after the previous record, and the replay's scans need
+        // not fall where the device's did. So set it right away.
+        const int64_t dueUs = e->kind == TRACE_GPIO ? 0 : e->timeUs + offsetUs;
+        if ((int64_t)host::nowMicros() < dueUs || e->kind == TRACE_CLOSE || e->kind == TRACE_OPEN ||
+            e->kind == TRACE_GPIO)
+            handlePending();
+        while ((int64_t)host::nowMicros() < dueUs)
+        {
+            const auto t = std::chrono::steady_clock::now();
+            step(opts.loopUs);
+            if (idleUs.size() < 100000)
+                idleUs.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t).count());
+        }
+        if (opts.speed > 0)
+            std::this_thread::sleep_until(wallStart + std::chrono::microseconds((int64_t)((e->timeUs - first->timeUs) /
+                                                                                          opts.speed)));
+        switch (e->kind)
+        {
+        case TRACE_IN:
+            if (e->text.size() >= TRACE_DATA_MAX)
+                cut++;
+            host::wsPush(peer.conn, e->text);
+            pending.push_back(frameType(e->text));
+            framesIn++;
+            break;
+        case TRACE_OUT:
+            if (!opts.ignore.count(eventName(e->text)))
+                want.push_back({dueUs - peer.startUs, e->text});
+            break;
+        case TRACE_GPIO:
+            host::setGpioInput(e->pin, e->level);
+            edges++;
+            break;
+        case TRACE_CLOSE:
+            if (peer.connected)
+                host::wsDrop(peer.conn);
+            drops++;
+            break;
+        case TRACE_OPEN:
+            if (e != first)
+            {
+                while (!peer.connected && (int64_t)host::nowMicros() < dueUs + 60000000)
+                    step(opts.loopUs);
+                offsetUs += std::max<int64_t>(0, (int64_t)host::nowMicros() - dueUs);
+            }
+            break;
+        case TRACE_LOST:
+            lost += e->lost;
+            break;
+        }
+    }
+    handlePending();
+    const uint64_t endUs = host::nowMicros() + (uint64_t)opts.tailMs * 1000;
+    while (host::nowMicros() < endUs)
+        step(opts.loopUs);
+    const double wallS = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    const double spanS = (events.back().timeUs - first->timeUs) / 1e6;
+
+    std::vector<Packet> got;
+    for (const ReplayPeer::Sent &s : peer.sent)
+        if (!opts.ignore.count(eventName(s.text)))
+            got.push_back({s.us, s.text});
+
+    printf("trace          %zu records, %.1f s from the first connect, %u bad frames, %u records lost on the device\n",
+           events.size(), spanS, badFrames, lost);
+    printf("replayed       %u frames in, %u input edges, %u drops, %u restarts in %.2f s (%.0fx)\n", framesIn,
+           edges, drops, restarts, wallS, wallS > 0 ? spanS / wallS : 0.0);
+    if (cut)
+        printf("               %u frames were cut to %u bytes by the recorder\n", cut, TRACE_DATA_MAX);
+    printf("loop() host time per frame handled, us (idle loop p50 %.2f)\n", percentile(idleUs, 0.5));
+    for (const auto &type : handleUs)
+        printf("  %-18s n=%-6zu p50 %8.2f  p99 %8.2f  max %8.2f\n", type.first.c_str(), type.second.size(),
+               percentile(type.second, 0.5), percentile(type.second, 0.99), percentile(type.second, 1.0));
+    std::vector<double> skewMs;
+    const uint32_t diffs = diffPackets(want, got, opts.maxDiffs, skewMs);
+    std::vector<double> absSkew;
+    for (double s : skewMs)
+        absSkew.push_back(s < 0 ? -s : s);
+    printf("send time      replayed - recorded: p50 %.1f ms, max |%.1f| ms\n", percentile(skewMs, 0.5),
+           percentile(absSkew, 1.0));
+    return diffs ? 1 : 0;
+}
@@ -0,0 +1,111 @@
+// A non-blocking TCP connection on a Reactor, in plain text or TLS
+// (OpenSSL), with a receive buffer the listener consumes from and a send
+// buffer that drains as the socket allows. Used for both ends: open()
+// connects, adopt() takes an accepted socket.
+//
+// Idle connections keep little: buffers that grew past a few KB are
+// released once empty, and TLS contexts from tlsClientContext() release
+// OpenSSL's record buffers between records.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <sys/socket.h>
+
+#include <openssl/ssl.h>
+
+#include "reactor.h"
+
+// Where a server is: resolved once and shared by every connection to it
+struct Endpoint
+{
+    sockaddr_storage addr = {};
+    socklen_t length = 0;
+    std::string host;      // name or address, without brackets; TLS server name
+    std::string authority; // Host header: host ([v6] bracketed), :port unless the default
+    uint16_t port = 0;
+    bool secure = false;   // https:// or wss://
+    SSL_CTX *tls = nullptr; // set by the caller when secure
+};
+
+// Resolves http(s)://host[:port] or http(s)://[v6 address][:port] (the
+// path, if any, is ignored); blocks
+bool resolveEndpoint(const std::string &url, Endpoint &out);
+
+class Connection : public Reactor::Handler
+{
+public:
+    class Listener
+    {
+    public:
+        virtual ~Listener() = default;
+        // TCP (and TLS) handshake done; data may be sent
+        virtual void connected(Connection &conn) = 0;
+        // New data in rx; erase what was used, leave a partial message
+        virtual void received(Connection &conn, std::string &rx) = 0;
+        // The peer closed or the connection failed; error is an errno value,
+        // or 0 for an orderly close. Not called after close().
+        virtual void closed(Connection &conn, int error) = 0;
+    };
+
+    Connection(Reactor &reactor, Listener &listener);
+    ~Connection() override;
+    Connection(const Connection &) = delete;
+    Connection &operator=(const Connection &) = delete;
+
+    // Starts connecting to addr; tls is nullptr for plain TCP. serverName
+    // goes out as SNI and is checked against the certificate when the
+    // context verifies; an IP address is checked against its IP SANs
+    // instead, without SNI. False if no socket could be made.
+    bool open(const sockaddr *addr, socklen_t length, SSL_CTX *tls, const char *serverName);
+    bool open(const Endpoint &server)
+    {
+        return open((const sockaddr *)&server.addr, server.length, server.tls, server.host.c_str());
+    }
+    // Takes over an accepted socket; with tls, the TLS handshake follows
+    bool adopt(int fd, SSL_CTX *tls);
+
+    // Queues data; it goes out as the socket allows
+    void send(const char *data, size_t length);
+    void send(const std::string &data) { send(data.data(), data.size()); }
+    // Closes now, dropping anything unsent; no closed() call
+    void close();
+
+    bool isOpen() const { return phase == OPEN; }
+    bool isIdle() const { return phase == IDLE; }
+    size_t unsent() const { return tx.size(); }
+
+    void ready(uint32_t events) override;
+
+private:
+    enum Phase
+    {
+        IDLE,
+        CONNECTING, // TCP
+        HANDSHAKE,  // TLS
+        OPEN,
+    };
+
+    void handshake();
+    void readAll();
+    void flush();
+    void watch();
+    void fail(int error);
+    void trim();
+
+    Reactor &reactor;
+    Listener &listener;
+    int fd = -1;
+    SSL *ssl = nullptr;
+    bool server = false;
+    bool sslWantsWrite = false;
+    uint32_t watching = 0;
+    Phase phase = IDLE;
+    std::string rx;
+    std::string tx;
+};
+
+// A client context: verify against the system store, or caFile if given;
+// verify false accepts any certificate (local stand-ins)
+SSL_CTX *tlsClientContext(bool verify, const char *caFile = nullptr);
@@ -0,0 +1,146 @@
+// One device, DEVICE_SN and all, as a state machine on a Reactor: the auth
+// POST, the Socket.IO session and the app-cmd handling of the firmware's
+// main.cpp, for either kind of device:
+//
+//   OUTPUT  output-device: output, output-all, blinkLed, sync and reboot;
+//           outputs are reported to the Listener to drive real hardware
+//   INPUT   input-device-lcd: inputs come from setInput(); output and
+//           clear-call-bell set them from the app
+//
+// Both send dev-data on every change and every dataIntervalMs, answer
+// pings, and reconnect when no frame has come for heartbeatMs. Settings
+// that are config.h macros in the firmware live in a DeviceProfile shared
+// by every session of a kind, so a session costs its serial, a few timers
+// and its connection.
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "http_client.h"
+#include "socketio_client.h"
+
+struct DeviceProfile
+{
+    enum Kind
+    {
+        INPUT,
+        OUTPUT,
+    };
+
+    Kind kind = OUTPUT;
+    const Endpoint *server = nullptr;
+    std::string apiPath = "/api/dev/io/"; // API_PATH
+    std::string secretKey;                // CLIENT_SECRET_KEY
+    uint32_t baseSensorId = 0x0f1234;     // BASE_SENSOR_ID
+    uint8_t sensorCount = 3;              // SENSOR_COUNT; sessions use at most MAX_SENSORS
+    uint32_t dataIntervalMs = 60000;      // DATA_SEND_INTERVAL / STATUS_REPORT_INTERVAL
+    uint32_t httpTimeoutMs = 30000;       // HTTP_TIMEOUT
+    uint32_t heartbeatMs = 70000;         // the firmware's heartbeat check
+    uint32_t reconnectMs = 5000;          // WebSocketsClient reconnect interval
+    uint32_t authRetryMs = 10000;         // reboot delay after a failed auth
+    uint32_t rebootMs = 1000;             // delay before a commanded reboot
+    uint32_t blinkMs = 500;               // BLINK_INTERVAL
+
+    static const uint8_t MAX_SENSORS = 16;
+};
+
+class DeviceSession : private SocketIOClient::Listener, private HttpClient::Listener
+{
+public:
+    enum State
+    {
+        BOOTING,        // waiting to boot, or to reboot after a failed auth
+        AUTHENTICATING, // auth request in flight
+        CONNECTING,     // WebSocket or Socket.IO handshake not done
+        ONLINE,         // 40 sent, emitting
+    };
+
+    class Listener
+    {
+    public:
+        virtual ~Listener() = default;
+        // OUTPUT: an output was set, by a command or a blink step
+        virtual void output(DeviceSession &session, uint8_t index, bool on)
+        {
+            (void)session, (void)index, (void)on;
+        }
+        virtual void stateChanged(DeviceSession &session, State state)
+        {
+            (void)session, (void)state;
+        }
+    };
+
+    DeviceSession(Reactor &reactor, const DeviceProfile &profile, const std::string &sn,
+                  Listener *listener = nullptr);
+    DeviceSession(const DeviceSession &) = delete;
+    DeviceSession &operator=(const DeviceSession &) = delete;
+
+    // Boots after delayMs
+    void start(uint32_t delayMs = 0);
+    // Goes offline and stays BOOTING until start()
+    void stop();
+
+    // INPUT: an input's level (true: active); a change goes out right away
+    // when online
+    void setInput(uint8_t index, bool active);
+    // The level reported for index: output state or active input
+    bool level(uint8_t index) const { return index < sensors && (levels >> index) & 1; }
+
+    State state() const { return st; }
+    const std::string &sn() const { return serial; }
+    const DeviceProfile &deviceProfile() const { return profile; }
+
+    struct Stats
+    {
+        uint32_t auths = 0;
+        uint32_t authFailures = 0;
+        uint32_t sessions = 0; // times ONLINE was reached
+        uint32_t disconnects = 0;
+        uint32_t heartbeatTimeouts = 0;
+        uint32_t framesIn = 0;
+        uint32_t framesOut = 0;
+        uint32_t emits = 0;       // dev-data sent
+        uint32_t cmdsApplied = 0; // app-cmds acted on
+    };
+    const Stats &stats() const { return counters; }
+
+private:
+    void packet(SocketIOClient &client, const char *payload, size_t length) override;
+    void connected(SocketIOClient &client) override;
+    void disconnected(SocketIOClient &client) override;
+    void httpDone(HttpClient &client, int code, const std::string &body) override;
+
+    void boot();
+    void heartbeat();
+    void periodic();
+    void blink();
+    void enter(State state);
+    void goOffline();
+    void appCmd(const char *data, size_t length);
+    void setLevel(uint8_t index, bool on);
+    void send(const char *packet, size_t length);
+    void emitDevData();
+    void emitDevStatus(const char *status);
+
+    Reactor &reactor;
+    const DeviceProfile &profile;
+    Listener *listener;
+    std::string serial;
+    std::string token;
+    HttpClient http;
+    SocketIOClient socket;
+    MemberTimer<DeviceSession, &DeviceSession::boot> bootTimer;
+    MemberTimer<DeviceSession, &DeviceSession::heartbeat> heartbeatTimer;
+    MemberTimer<DeviceSession, &DeviceSession::periodic> periodicTimer;
+    MemberTimer<DeviceSession, &DeviceSession::blink> blinkTimer;
+    uint64_t lastFrameMs = 0;
+    uint32_t levels = 0; // bit i: output on / input active
+    uint16_t blinkCount[DeviceProfile::MAX_SENSORS] = {};
+    State st = BOOTING;
+    uint8_t sensors; // profile.sensorCount, clamped to MAX_SENSORS
+    bool bootupReady = false;
+    bool levelsChanged = false;
+    bool rebooting = false;
+    Stats counters;
+};
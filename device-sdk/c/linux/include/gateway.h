@@ -0,0 +1,36 @@
+// Many DeviceSessions on one Reactor: the sessions of one DeviceProfile,
+// booted over a ramp so that a gateway coming up does not send every auth
+// request at once.
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "device_session.h"
+
+class Gateway
+{
+public:
+    Gateway(Reactor &reactor, const DeviceProfile &profile);
+
+    DeviceSession &add(const std::string &sn, DeviceSession::Listener *listener = nullptr);
+    // Starts every session, the boots spread evenly over rampMs
+    void start(uint32_t rampMs = 0);
+    void stop();
+
+    size_t size() const { return sessions.size(); }
+    DeviceSession &session(size_t i) { return *sessions[i]; }
+
+    struct Totals
+    {
+        size_t inState[4] = {}; // by DeviceSession::State
+        DeviceSession::Stats sum;
+    };
+    Totals totals() const;
+
+private:
+    Reactor &reactor;
+    const DeviceProfile &profile;
+    std::vector<std::unique_ptr<DeviceSession>> sessions;
+};
@@ -0,0 +1,52 @@
+// One HTTP/1.1 request at a time on the reactor, for the device's auth POST.
+// The request goes out with Connection: close; the response body is read
+// by Content-Length, chunked encoding or up to the close. Failures use
+// HTTPClient's negative codes, so the session treats them as the firmware
+// does.
+#pragma once
+
+#include <string>
+
+#include "connection.h"
+
+class HttpClient : private Connection::Listener
+{
+public:
+    static const int ERROR_CONNECTION_REFUSED = -1;
+    static const int ERROR_CONNECTION_LOST = -5;
+    static const int ERROR_READ_TIMEOUT = -11;
+
+    class Listener
+    {
+    public:
+        virtual ~Listener() = default;
+        // code: HTTP status, or one of the ERROR_ codes
+        virtual void httpDone(HttpClient &client, int code, const std::string &body) = 0;
+    };
+
+    HttpClient(Reactor &reactor, Listener &listener);
+
+    // Starts a POST of a JSON body; httpDone() follows, at the latest after
+    // timeoutMs. False if a request is already in flight.
+    bool post(const Endpoint &server, const std::string &path, const std::string &body, uint32_t timeoutMs);
+    // Drops the request in flight without calling httpDone()
+    void cancel();
+    bool busy() const { return active; }
+
+private:
+    void connected(Connection &conn) override;
+    void received(Connection &conn, std::string &rx) override;
+    void closed(Connection &conn, int error) override;
+    void timeout();
+    void finish(int code, const std::string &body);
+    // True once the response in buffer is complete
+    bool complete(bool closed, int &code, std::string &body);
+
+    Reactor &reactor;
+    Listener &listener;
+    Connection conn;
+    MemberTimer<HttpClient, &HttpClient::timeout> timer;
+    std::string buffer; // the request until connected, then the response
+    bool active = false;
+    bool sent = false;
+};
@@ -0,0 +1,18 @@
+// Just enough JSON for the flat payloads a device sees: the auth response
+// ({"token":".."}), the open packet ({"sid":"..",..}) and app-cmd
+// ({"operation":{"customCmd":"..","fieldIndex":i,"fieldValue":v}}).
+// A key is found wherever it appears, at any depth, so this is not a
+// general parser; it allocates nothing but the string it returns.
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// The string value of the first "key"; escapes other than \uXXXX are undone
+bool jsonString(const char *json, size_t length, const char *key, std::string &out);
+
+// The integer value of the first "key"
+bool jsonInt(const char *json, size_t length, const char *key, long &out);
+
+// Escapes text for use inside a JSON string
+std::string jsonEscape(const std::string &text);
@@ -0,0 +1,87 @@
+// Single-threaded epoll reactor: file descriptors with a handler each, and
+// timers on the monotonic clock. Everything that uses a reactor runs on the
+// thread that calls run(); nothing here locks.
+//
+// Timers live in an index heap, so schedule() and cancel() are O(log n) and
+// a cancelled timer leaves nothing behind; a Timer may be destroyed once it
+// is cancelled or has fired.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Reactor
+{
+public:
+    class Handler
+    {
+    public:
+        virtual ~Handler() = default;
+        // events: EPOLLIN, EPOLLOUT, EPOLLERR, EPOLLHUP as reported
+        virtual void ready(uint32_t events) = 0;
+    };
+
+    class Timer
+    {
+    public:
+        virtual ~Timer() = default;
+        virtual void fire() = 0;
+        bool scheduled() const { return heapIndex != NONE; }
+        uint64_t dueMs() const { return due; }
+
+    private:
+        friend class Reactor;
+        static const size_t NONE = (size_t)-1;
+        size_t heapIndex = NONE;
+        uint64_t due = 0;
+    };
+
+    Reactor();
+    ~Reactor();
+    Reactor(const Reactor &) = delete;
+    Reactor &operator=(const Reactor &) = delete;
+
+    // events as for epoll_ctl; false if epoll_ctl failed
+    bool add(int fd, uint32_t events, Handler *handler);
+    bool modify(int fd, uint32_t events, Handler *handler);
+    void remove(int fd);
+
+    // (Re)arms timer to fire at nowMs() + ms
+    void schedule(Timer *timer, uint64_t ms);
+    void cancel(Timer *timer);
+
+    // Waits for events or the next timer, at most maxWaitMs, and handles
+    // them; returns the number of fd events handled
+    int runOnce(int maxWaitMs = 1000);
+    // runOnce() until stop()
+    void run();
+    void stop() { running = false; }
+
+    // Milliseconds on CLOCK_MONOTONIC
+    static uint64_t nowMs();
+
+    size_t timerCount() const { return heap.size(); }
+
+private:
+    void siftUp(size_t i);
+    void siftDown(size_t i);
+    void place(size_t i, Timer *timer);
+
+    int epfd;
+    bool running = false;
+    std::vector<Timer *> heap;
+};
+
+// A timer that calls a member function, so that an object can own several
+// without a std::function each
+template <class T, void (T::*Method)()>
+class MemberTimer : public Reactor::Timer
+{
+public:
+    explicit MemberTimer(T &owner) : owner(owner) {}
+    void fire() override { (owner.*Method)(); }
+
+private:
+    T &owner;
+};
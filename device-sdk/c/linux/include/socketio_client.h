@@ -0,0 +1,86 @@
+// The firmware's SocketIOClient (platformio/input-device-lcd) on POSIX: a
+// WebSocket carrying Engine.IO/Socket.IO text packets, reconnecting after
+// the reconnect interval whenever the link drops, as WebSocketsClient does.
+//
+// Where the firmware has one client, static callbacks and loop(), here any
+// number share one Reactor and report to a Listener; nothing polls. As in
+// the firmware, the client only frames and delivers packets: answering
+// pings and the 40 handshake are up to the listener.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "connection.h"
+
+class SocketIOClient : private Connection::Listener
+{
+public:
+    // Longest message accepted, the Engine.IO default maxPayload; a server
+    // that sends more loses the connection
+    static const size_t MAX_MESSAGE = 1000000;
+
+    class Listener
+    {
+    public:
+        virtual ~Listener() = default;
+        // A whole text message: one Engine.IO packet
+        virtual void packet(SocketIOClient &client, const char *payload, size_t length) = 0;
+        // WebSocket handshake done (WStype_CONNECTED)
+        virtual void connected(SocketIOClient &client) = 0;
+        // Link lost or refused (WStype_DISCONNECTED); a reconnect follows
+        virtual void disconnected(SocketIOClient &client) = 0;
+    };
+
+    SocketIOClient(Reactor &reactor, Listener &listener);
+
+    // Connects to path on server (see socketPath()); server must outlive
+    // the client
+    void begin(const Endpoint &server, const std::string &path);
+    // Disconnects without a disconnected() call and stops reconnecting
+    void end();
+    // Drops the link and connects again right away, as connectSocketIO()
+    // after a heartbeat timeout
+    void reconnect();
+
+    // Send a text packet (Socket.IO encoded string)
+    void sendPacket(const char *type, const std::string &data = "");
+    void sendText(const char *text, size_t length);
+
+    void setReconnectInterval(uint32_t ms) { reconnectInterval = ms; }
+    bool isConnected() const { return phase == OPEN; }
+
+private:
+    enum Phase
+    {
+        IDLE,      // not begun, or ended
+        WAITING,   // for the reconnect interval
+        UPGRADING, // TCP/TLS up to the 101 response
+        OPEN,
+    };
+
+    void connected(Connection &conn) override;
+    void received(Connection &conn, std::string &rx) override;
+    void closed(Connection &conn, int error) override;
+    void retry();
+    void connect();
+    void lost();
+    void sendFrame(uint8_t opcode, const char *data, size_t length);
+    // Bytes used from rx, or 0 while the 101 response is incomplete
+    size_t upgrade(const std::string &rx);
+
+    Reactor &reactor;
+    Listener &listener;
+    Connection conn;
+    MemberTimer<SocketIOClient, &SocketIOClient::retry> retryTimer;
+    const Endpoint *server = nullptr;
+    std::string path;
+    std::string pending; // UPGRADING: the Sec-WebSocket-Key; OPEN: fragments so far
+    Phase phase = IDLE;
+    uint32_t reconnectInterval = 5000;
+};
+
+// The firmware's socket path:
+// apiPath?sn=..&clientType=device&clientVersion=V4&sensorIds=[..]&EIO=4&transport=websocket
+std::string socketPath(const std::string &apiPath, const std::string &sn, uint32_t baseSensorId, size_t sensorCount);
@@ -0,0 +1,387 @@
+#include "connection.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <openssl/err.h>
+#include <openssl/x509v3.h>
+
+#include <cstdlib>
+#include <cstring>
+
+// Buffers above this are released once empty
+static const size_t KEEP_BUFFER = 4096;
+
+Connection::Connection(Reactor &r, Listener &l) : reactor(r), listener(l)
+{
+}
+
+Connection::~Connection()
+{
+    close();
+}
+
+static void tune(int fd)
+{
+    const int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+bool Connection::open(const sockaddr *addr, socklen_t length, SSL_CTX *tls, const char *serverName)
+{
+    close();
+    trim();
+    fd = socket(addr->sa_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return false;
+    tune(fd);
+    server = false;
+    if (tls)
+    {
+        ssl = SSL_new(tls);
+        SSL_set_fd(ssl, fd);
+        if (serverName)
+        {
+            // An address is matched against the certificate's IP SANs,
+            // which SSL_set1_host() never looks at, and goes out without SNI
+            in6_addr ip;
+            if (inet_pton(AF_INET, serverName, &ip) == 1 || inet_pton(AF_INET6, serverName, &ip) == 1)
+                X509_VERIFY_PARAM_set1_ip_asc(SSL_get0_param(ssl), serverName);
+            else
+            {
+                SSL_set_tlsext_host_name(ssl, serverName);
+                SSL_set1_host(ssl, serverName);
+            }
+        }
+    }
+    phase = CONNECTING;
+    if (::connect(fd, addr, length) != 0 && errno != EINPROGRESS)
+    {
+        const int error = errno;
+        close();
+        errno = error;
+        return false;
+    }
+    watching = EPOLLIN | EPOLLOUT;
+    reactor.add(fd, watching, this);
+    return true;
+}
+
+bool Connection::adopt(int acceptedFd, SSL_CTX *tls)
+{
+    close();
+    trim();
+    fd = acceptedFd;
+    tune(fd);
+    server = true;
+    watching = EPOLLIN;
+    reactor.add(fd, watching, this);
+    if (tls)
+    {
+        ssl = SSL_new(tls);
+        SSL_set_fd(ssl, fd);
+        phase = HANDSHAKE;
+        handshake();
+    }
+    else
+    {
+        phase = OPEN;
+        listener.connected(*this);
+    }
+    return true;
+}
+
+void Connection::close()
+{
+    if (fd < 0)
+        return;
+    if (ssl)
+    {
+        if (phase == OPEN)
+            SSL_shutdown(ssl);
+        SSL_free(ssl);
+        ssl = nullptr;
+    }
+    reactor.remove(fd);
+    ::close(fd);
+    fd = -1;
+    phase = IDLE;
+    sslWantsWrite = false;
+    // Not released here: close() may run inside received(), with the
+    // listener still reading rx
+    rx.clear();
+    tx.clear();
+}
+
+void Connection::fail(int error)
+{
+    close();
+    listener.closed(*this, error);
+}
+
+void Connection::trim()
+{
+    if (rx.empty() && rx.capacity() > KEEP_BUFFER)
+        std::string().swap(rx);
+    if (tx.empty() && tx.capacity() > KEEP_BUFFER)
+        std::string().swap(tx);
+}
+
+void Connection::watch()
+{
+    if (fd < 0)
+        return;
+    uint32_t want = EPOLLIN;
+    if (phase == CONNECTING || sslWantsWrite || (phase == OPEN && !tx.empty()))
+        want |= EPOLLOUT;
+    if (want != watching)
+    {
+        watching = want;
+        reactor.modify(fd, watching, this);
+    }
+}
+
+void Connection::send(const char *data, size_t length)
+{
+    if (phase == IDLE)
+        return;
+    tx.append(data, length);
+    if (phase == OPEN)
+        flush();
+}
+
+void Connection::handshake()
+{
+    ERR_clear_error();
+    const int r = server ? SSL_accept(ssl) : SSL_connect(ssl);
+    if (r == 1)
+    {
+        phase = OPEN;
+        sslWantsWrite = false;
+        watch();
+        listener.connected(*this);
+        if (phase == OPEN)
+            flush();
+        return;
+    }
+    const int error = SSL_get_error(ssl, r);
+    if (error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE)
+    {
+        sslWantsWrite = error == SSL_ERROR_WANT_WRITE;
+        watch();
+        return;
+    }
+    fail(EPROTO);
+}
+
+void Connection::flush()
+{
+    while (!tx.empty() && fd >= 0)
+    {
+        ssize_t n;
+        if (ssl)
+        {
+            ERR_clear_error();
+            n = SSL_write(ssl, tx.data(), (int)tx.size());
+            if (n <= 0)
+            {
+                const int error = SSL_get_error(ssl, (int)n);
+                if (error == SSL_ERROR_WANT_WRITE || error == SSL_ERROR_WANT_READ)
+                    break;
+                fail(EPIPE);
+                return;
+            }
+        }
+        else
+        {
+            n = ::send(fd, tx.data(), tx.size(), MSG_NOSIGNAL);
+            if (n < 0)
+            {
+                if (errno == EAGAIN || errno == EINTR)
+                    break;
+                fail(errno);
+                return;
+            }
+        }
+        tx.erase(0, (size_t)n);
+    }
+    trim();
+    watch();
+}
+
+void Connection::readAll()
+{
+    char chunk[16384];
+    while (fd >= 0)
+    {
+        ssize_t n;
+        if (ssl)
+        {
+            ERR_clear_error();
+            n = SSL_read(ssl, chunk, sizeof(chunk));
+            if (n <= 0)
+            {
+                const int error = SSL_get_error(ssl, (int)n);
+                if (error == SSL_ERROR_WANT_READ)
+                    break;
+                if (error == SSL_ERROR_WANT_WRITE)
+                {
+                    sslWantsWrite = true;
+                    watch();
+                    break;
+                }
+                fail(error == SSL_ERROR_ZERO_RETURN ? 0 : ECONNRESET);
+                return;
+            }
+        }
+        else
+        {
+            n = ::recv(fd, chunk, sizeof(chunk), 0);
+            if (n < 0)
+            {
+                if (errno == EAGAIN || errno == EINTR)
+                    break;
+                fail(errno);
+                return;
+            }
+            if (n == 0)
+            {
+                fail(0);
+                return;
+            }
+        }
+        rx.append(chunk, (size_t)n);
+        if ((size_t)n < sizeof(chunk) && !(ssl && SSL_pending(ssl)))
+            break;
+    }
+    if (!rx.empty())
+    {
+        listener.received(*this, rx);
+        trim();
+    }
+}
+
+void Connection::ready(uint32_t events)
+{
+    if (fd < 0)
+        return;
+    switch (phase)
+    {
+    case CONNECTING:
+    {
+        int error = 0;
+        socklen_t length = sizeof(error);
+        getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length);
+        if (error || (events & (EPOLLERR | EPOLLHUP)))
+        {
+            fail(error ? error : ECONNREFUSED);
+            return;
+        }
+        if (!(events & EPOLLOUT))
+            return;
+        if (ssl)
+        {
+            phase = HANDSHAKE;
+            handshake();
+        }
+        else
+        {
+            phase = OPEN;
+            watch();
+            listener.connected(*this);
+            if (phase == OPEN)
+                flush();
+        }
+        return;
+    }
+    case HANDSHAKE:
+        handshake();
+        return;
+    case OPEN:
+        if (events & (EPOLLIN | EPOLLERR | EPOLLHUP))
+            readAll();
+        if (phase == OPEN && (events & EPOLLOUT))
+        {
+            sslWantsWrite = false;
+            flush();
+        }
+        return;
+    case IDLE:
+        return;
+    }
+}
+
+SSL_CTX *tlsClientContext(bool verify, const char *caFile)
+{
+    SSL_CTX *ctx = SSL_CTX_new(TLS_client_method());
+    if (!ctx)
+        return nullptr;
+    SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+    SSL_CTX_set_mode(ctx, SSL_MODE_RELEASE_BUFFERS | SSL_MODE_ENABLE_PARTIAL_WRITE |
+                              SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+    if (verify)
+    {
+        SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER, nullptr);
+        if (caFile)
+            SSL_CTX_load_verify_locations(ctx, caFile, nullptr);
+        else
+            SSL_CTX_set_default_verify_paths(ctx);
+    }
+    else
+        SSL_CTX_set_verify(ctx, SSL_VERIFY_NONE, nullptr);
+    return ctx;
+}
+
+bool resolveEndpoint(const std::string &url, Endpoint &out)
+{
+    std::string rest = url;
+    out.secure = false;
+    const size_t scheme = rest.find("://");
+    if (scheme != std::string::npos)
+    {
+        const std::string name = rest.substr(0, scheme);
+        out.secure = name == "https" || name == "wss";
+        rest = rest.substr(scheme + 3);
+    }
+    rest = rest.substr(0, rest.find('/'));
+    size_t colon;
+    if (!rest.empty() && rest[0] == '[')
+    {
+        // [IPv6 address], whose colons are not the port's
+        const size_t close = rest.find(']');
+        if (close == std::string::npos || (close + 1 < rest.size() && rest[close + 1] != ':'))
+            return false;
+        out.host = rest.substr(1, close - 1);
+        colon = close + 1 < rest.size() ? close + 1 : std::string::npos;
+    }
+    else
+    {
+        colon = rest.rfind(':');
+        out.host = rest.substr(0, colon);
+    }
+    const uint16_t defaultPort = out.secure ? 443 : 80;
+    out.port = colon == std::string::npos ? defaultPort : (uint16_t)atoi(rest.c_str() + colon + 1);
+    if (out.host.empty() || out.port == 0)
+        return false;
+    out.authority = out.host.find(':') == std::string::npos ? out.host : "[" + out.host + "]";
+    if (out.port != defaultPort)
+        out.authority += ":" + std::to_string(out.port);
+
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *list = nullptr;
+    if (getaddrinfo(out.host.c_str(), std::to_string(out.port).c_str(), &hints, &list) != 0 || !list)
+        return false;
+    memcpy(&out.addr, list->ai_addr, list->ai_addrlen);
+    out.length = list->ai_addrlen;
+    freeaddrinfo(list);
+    return true;
+}
@@ -0,0 +1,327 @@
+#include "device_session.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include "json_scan.h"
+
+DeviceSession::DeviceSession(Reactor &r, const DeviceProfile &p, const std::string &sn, Listener *l)
+    : reactor(r), profile(p), listener(l), serial(sn), http(r, *this), socket(r, *this), bootTimer(*this),
+      heartbeatTimer(*this), periodicTimer(*this), blinkTimer(*this)
+{
+    sensors = profile.sensorCount < DeviceProfile::MAX_SENSORS ? profile.sensorCount : DeviceProfile::MAX_SENSORS;
+}
+
+void DeviceSession::enter(State state)
+{
+    if (st == state)
+        return;
+    st = state;
+    if (listener)
+        listener->stateChanged(*this, state);
+}
+
+void DeviceSession::start(uint32_t delayMs)
+{
+    stop();
+    reactor.schedule(&bootTimer, delayMs);
+}
+
+void DeviceSession::stop()
+{
+    goOffline();
+    reactor.cancel(&bootTimer);
+    reactor.cancel(&blinkTimer);
+    http.cancel();
+    socket.end();
+    std::string().swap(token);
+    enter(BOOTING);
+}
+
+// setup(): a fresh boot, then authenticateDevice()
+void DeviceSession::boot()
+{
+    bootupReady = false;
+    rebooting = false;
+    if (profile.kind == DeviceProfile::OUTPUT)
+    {
+        levels = 0;
+        memset(blinkCount, 0, sizeof(blinkCount));
+        reactor.cancel(&blinkTimer);
+    }
+
+    std::string body = "{\"sn\":\"" + jsonEscape(serial) + "\",\"client_secret_key\":\"" +
+                       jsonEscape(profile.secretKey) + "\",\"sensorIds\":[";
+    for (uint8_t i = 0; i < sensors; i++)
+    {
+        body += std::to_string(profile.baseSensorId + i);
+        if (i + 1 < sensors)
+            body += ",";
+    }
+    body += "]}";
+    counters.auths++;
+    enter(AUTHENTICATING);
+    http.post(*profile.server, "/api/v3/devices/auth", body, profile.httpTimeoutMs);
+}
+
+void DeviceSession::httpDone(HttpClient &, int code, const std::string &body)
+{
+    if (code == 200 && jsonString(body.data(), body.size(), "token", token))
+    {
+        socket.setReconnectInterval(profile.reconnectMs);
+        enter(CONNECTING);
+        socket.begin(*profile.server,
+                     socketPath(profile.apiPath, serial, profile.baseSensorId, sensors));
+        return;
+    }
+    // "Authentication failed! Rebooting in 10 seconds..."
+    counters.authFailures++;
+    enter(BOOTING);
+    reactor.schedule(&bootTimer, profile.authRetryMs);
+}
+
+void DeviceSession::connected(SocketIOClient &)
+{
+}
+
+void DeviceSession::disconnected(SocketIOClient &)
+{
+    if (st == ONLINE)
+        counters.disconnects++;
+    goOffline();
+}
+
+void DeviceSession::goOffline()
+{
+    if (st != ONLINE)
+        return;
+    reactor.cancel(&heartbeatTimer);
+    reactor.cancel(&periodicTimer);
+    enter(CONNECTING);
+}
+
+// The firmware's heartbeat check: no frame, not even a ping, for
+// heartbeatMs means the link is dead even if TCP has not noticed
+void DeviceSession::heartbeat()
+{
+    if (st != ONLINE)
+        return;
+    const uint64_t elapsed = Reactor::nowMs() - lastFrameMs;
+    if (elapsed <= profile.heartbeatMs)
+    {
+        reactor.schedule(&heartbeatTimer, profile.heartbeatMs - elapsed + 1);
+        return;
+    }
+    counters.heartbeatTimeouts++;
+    counters.disconnects++;
+    goOffline();
+    socket.reconnect();
+}
+
+void DeviceSession::periodic()
+{
+    if (st != ONLINE)
+        return;
+    emitDevData();
+    levelsChanged = false;
+    reactor.schedule(&periodicTimer, profile.dataIntervalMs);
+}
+
+void DeviceSession::send(const char *packet, size_t length)
+{
+    if (!socket.isConnected())
+        return;
+    socket.sendText(packet, length);
+    counters.framesOut++;
+}
+
+// handleSocketIOPacket()
+void DeviceSession::packet(SocketIOClient &, const char *payload, size_t length)
+{
+    counters.framesIn++;
+    lastFrameMs = Reactor::nowMs();
+    if (length == 0)
+        return;
+
+    switch (payload[0])
+    {
+    case '0': // open
+    {
+        if (length < 2 || payload[1] != '{')
+            return;
+        const std::string connect = "40{\"token\":\"" + jsonEscape(token) + "\"}";
+        send(connect.data(), connect.size());
+        enter(ONLINE);
+        counters.sessions++;
+        reactor.schedule(&heartbeatTimer, profile.heartbeatMs + 1);
+        reactor.schedule(&periodicTimer, profile.dataIntervalMs);
+        if (!bootupReady)
+        {
+            bootupReady = true;
+            emitDevStatus("Bootup & Ready");
+        }
+        else if (profile.kind == DeviceProfile::OUTPUT)
+            emitDevStatus("Reconnected");
+        break;
+    }
+    case '2': // ping
+        send("3", 1);
+        break;
+    case '4':
+    {
+        // 42["app-cmd",{...}]
+        static const char APP_CMD[] = "42[\"app-cmd\",";
+        static const char APPCMD[] = "42[\"appcmd\",";
+        if (length > sizeof(APP_CMD) - 1 && memcmp(payload, APP_CMD, sizeof(APP_CMD) - 1) == 0)
+            appCmd(payload + sizeof(APP_CMD) - 1, length - (sizeof(APP_CMD) - 1));
+        else if (profile.kind == DeviceProfile::OUTPUT && length > sizeof(APPCMD) - 1 &&
+                 memcmp(payload, APPCMD, sizeof(APPCMD) - 1) == 0)
+            appCmd(payload + sizeof(APPCMD) - 1, length - (sizeof(APPCMD) - 1));
+        break;
+    }
+    default:
+        break;
+    }
+
+    // The firmware's loop() sends what a packet changed right after it
+    if (levelsChanged && st == ONLINE)
+    {
+        emitDevData();
+        levelsChanged = false;
+    }
+}
+
+// processAppCmd() of output-device, or the app-cmd branch of
+// input-device-lcd
+void DeviceSession::appCmd(const char *data, size_t length)
+{
+    std::string cmd;
+    long index = -1;
+    long value = -1;
+    jsonString(data, length, "customCmd", cmd);
+    jsonInt(data, length, "fieldIndex", index);
+    jsonInt(data, length, "fieldValue", value);
+    const bool indexValid = index >= 0 && index < sensors;
+
+    if (profile.kind == DeviceProfile::INPUT)
+    {
+        if (cmd == "clear-call-bell" || cmd == "output")
+        {
+            if (index < 0)
+                index = 0;
+            if (index < sensors)
+                setLevel((uint8_t)index, value == 1);
+            counters.cmdsApplied++;
+            levelsChanged = true;
+        }
+        return;
+    }
+
+    if (cmd.empty() || cmd == "output")
+    {
+        if (indexValid && value >= 0)
+            setLevel((uint8_t)index, value > 0);
+    }
+    else if (cmd == "output-all")
+    {
+        if (value >= 0)
+            for (uint8_t i = 0; i < sensors; i++)
+                setLevel(i, value > 0);
+    }
+    else if (cmd == "blinkLed")
+    {
+        if (!indexValid)
+            return;
+        blinkCount[index] = (uint16_t)((value > 0 ? value : 5) * 2); // on+off per blink
+        if (!blinkTimer.scheduled())
+            reactor.schedule(&blinkTimer, profile.blinkMs);
+    }
+    else if (cmd == "sync")
+        levelsChanged = true;
+    else if (cmd == "reboot")
+    {
+        emitDevStatus("Rebooting");
+        counters.cmdsApplied++;
+        goOffline();
+        socket.end();
+        rebooting = true;
+        enter(BOOTING);
+        reactor.schedule(&bootTimer, profile.rebootMs);
+        return;
+    }
+    else
+        return;
+    counters.cmdsApplied++;
+}
+
+void DeviceSession::setLevel(uint8_t index, bool on)
+{
+    if (index >= sensors)
+        return;
+    if (on)
+        levels |= 1u << index;
+    else
+        levels &= ~(1u << index);
+    levelsChanged = true;
+    if (profile.kind == DeviceProfile::OUTPUT && listener)
+        listener->output(*this, index, on);
+}
+
+void DeviceSession::setInput(uint8_t index, bool active)
+{
+    if (index >= sensors || level(index) == active)
+        return;
+    setLevel(index, active);
+    if (st == ONLINE)
+    {
+        emitDevData();
+        levelsChanged = false;
+    }
+}
+
+// handleBlinkLogic()
+void DeviceSession::blink()
+{
+    bool more = false;
+    for (uint8_t i = 0; i < sensors; i++)
+    {
+        if (blinkCount[i] == 0)
+            continue;
+        setLevel(i, !level(i));
+        if (--blinkCount[i] == 0)
+            setLevel(i, false); // off when done
+        else
+            more = true;
+    }
+    if (more)
+        reactor.schedule(&blinkTimer, profile.blinkMs);
+    if (levelsChanged && st == ONLINE)
+    {
+        emitDevData();
+        levelsChanged = false;
+    }
+}
+
+void DeviceSession::emitDevData()
+{
+    char packet[32 + 2 * DeviceProfile::MAX_SENSORS];
+    size_t n = (size_t)snprintf(packet, sizeof(packet), "42[\"dev-data\",{\"content\":[");
+    for (uint8_t i = 0; i < sensors; i++)
+    {
+        packet[n++] = level(i) ? '1' : '0';
+        packet[n++] = i + 1 < sensors ? ',' : ']';
+    }
+    if (sensors == 0)
+        packet[n++] = ']';
+    packet[n++] = '}';
+    packet[n++] = ']';
+    counters.emits++;
+    send(packet, n);
+}
+
+void DeviceSession::emitDevStatus(const char *status)
+{
+    char packet[96];
+    const int n = snprintf(packet, sizeof(packet), "42[\"dev-status\",\"%s\"]", status);
+    send(packet, (size_t)n);
+}
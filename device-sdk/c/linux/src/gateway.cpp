@@ -0,0 +1,44 @@
+#include "gateway.h"
+
+Gateway::Gateway(Reactor &r, const DeviceProfile &p) : reactor(r), profile(p)
+{
+}
+
+DeviceSession &Gateway::add(const std::string &sn, DeviceSession::Listener *listener)
+{
+    sessions.emplace_back(new DeviceSession(reactor, profile, sn, listener));
+    return *sessions.back();
+}
+
+void Gateway::start(uint32_t rampMs)
+{
+    const size_t n = sessions.size();
+    for (size_t i = 0; i < n; i++)
+        sessions[i]->start((uint32_t)((uint64_t)rampMs * i / (n ? n : 1)));
+}
+
+void Gateway::stop()
+{
+    for (auto &session : sessions)
+        session->stop();
+}
+
+Gateway::Totals Gateway::totals() const
+{
+    Totals t;
+    for (const auto &session : sessions)
+    {
+        t.inState[session->state()]++;
+        const DeviceSession::Stats &s = session->stats();
+        t.sum.auths += s.auths;
+        t.sum.authFailures += s.authFailures;
+        t.sum.sessions += s.sessions;
+        t.sum.disconnects += s.disconnects;
+        t.sum.heartbeatTimeouts += s.heartbeatTimeouts;
+        t.sum.framesIn += s.framesIn;
+        t.sum.framesOut += s.framesOut;
+        t.sum.emits += s.emits;
+        t.sum.cmdsApplied += s.cmdsApplied;
+    }
+    return t;
+}
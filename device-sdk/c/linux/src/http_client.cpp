@@ -0,0 +1,145 @@
+#include "http_client.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+
+// Longest response accepted; the auth response is a token
+static const size_t MAX_RESPONSE = 65536;
+
+HttpClient::HttpClient(Reactor &r, Listener &l) : reactor(r), listener(l), conn(r, *this), timer(*this)
+{
+}
+
+bool HttpClient::post(const Endpoint &server, const std::string &path, const std::string &body, uint32_t timeoutMs)
+{
+    if (active)
+        return false;
+    buffer = "POST " + path + " HTTP/1.1\r\nHost: " + server.authority + "\r\nConnection: close\r\n"
+             "Content-Type: application/json\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+    active = true;
+    sent = false;
+    reactor.schedule(&timer, timeoutMs);
+    if (!conn.open(server))
+    {
+        // Reported from the timer, never from inside post()
+        reactor.schedule(&timer, 0);
+    }
+    return true;
+}
+
+void HttpClient::cancel()
+{
+    if (!active)
+        return;
+    active = false;
+    conn.close();
+    reactor.cancel(&timer);
+    std::string().swap(buffer);
+}
+
+void HttpClient::finish(int code, const std::string &body)
+{
+    cancel();
+    listener.httpDone(*this, code, body);
+}
+
+void HttpClient::timeout()
+{
+    finish(sent ? ERROR_READ_TIMEOUT : ERROR_CONNECTION_REFUSED, std::string());
+}
+
+void HttpClient::connected(Connection &)
+{
+    conn.send(buffer);
+    buffer.clear();
+    sent = true;
+}
+
+void HttpClient::received(Connection &, std::string &rx)
+{
+    buffer += rx;
+    rx.clear();
+    if (buffer.size() > MAX_RESPONSE)
+    {
+        finish(ERROR_CONNECTION_LOST, std::string());
+        return;
+    }
+    int code;
+    std::string body;
+    if (complete(false, code, body))
+        finish(code, body);
+}
+
+void HttpClient::closed(Connection &, int)
+{
+    int code;
+    std::string body;
+    if (complete(true, code, body))
+        finish(code, body);
+    else
+        finish(sent ? ERROR_CONNECTION_LOST : ERROR_CONNECTION_REFUSED, std::string());
+}
+
+// The value of a response header, or nullptr; head ends with the blank line
+static const char *header(const std::string &head, const char *name)
+{
+    const size_t nameLength = strlen(name);
+    size_t line = head.find("\r\n");
+    while (line != std::string::npos && line + 2 < head.size())
+    {
+        const char *p = head.c_str() + line + 2;
+        if (strncasecmp(p, name, nameLength) == 0 && p[nameLength] == ':')
+        {
+            p += nameLength + 1;
+            while (*p == ' ')
+                p++;
+            return p;
+        }
+        line = head.find("\r\n", line + 2);
+    }
+    return nullptr;
+}
+
+bool HttpClient::complete(bool closed, int &code, std::string &body)
+{
+    const size_t headEnd = buffer.find("\r\n\r\n");
+    if (headEnd == std::string::npos || buffer.compare(0, 5, "HTTP/") != 0)
+        return false;
+    const std::string head = buffer.substr(0, headEnd + 4);
+    code = atoi(head.c_str() + head.find(' ') + 1);
+    const size_t bodyAt = headEnd + 4;
+
+    const char *encoding = header(head, "Transfer-Encoding");
+    if (encoding && strncasecmp(encoding, "chunked", 7) == 0)
+    {
+        body.clear();
+        size_t at = bodyAt;
+        while (true)
+        {
+            const size_t lineEnd = buffer.find("\r\n", at);
+            if (lineEnd == std::string::npos)
+                return false;
+            const size_t size = strtoul(buffer.c_str() + at, nullptr, 16);
+            if (size == 0)
+                return true;
+            if (buffer.size() < lineEnd + 2 + size + 2)
+                return false;
+            body.append(buffer, lineEnd + 2, size);
+            at = lineEnd + 2 + size + 2;
+        }
+    }
+    const char *length = header(head, "Content-Length");
+    if (length)
+    {
+        const size_t size = strtoul(length, nullptr, 10);
+        if (buffer.size() < bodyAt + size)
+            return false;
+        body = buffer.substr(bodyAt, size);
+        return true;
+    }
+    if (!closed)
+        return false;
+    body = buffer.substr(bodyAt);
+    return true;
+}
@@ -0,0 +1,101 @@
+#include "json_scan.h"
+
+#include <cstdlib>
+#include <cstring>
+
+// Where the value of "key" starts, or nullptr
+static const char *valueOf(const char *json, size_t length, const char *key)
+{
+    const size_t keyLength = strlen(key);
+    const char *end = json + length;
+    for (const char *p = json; p + keyLength + 2 <= end; p++)
+    {
+        if (*p != '"' || p[keyLength + 1] != '"' || memcmp(p + 1, key, keyLength) != 0)
+            continue;
+        const char *q = p + keyLength + 2;
+        while (q < end && (*q == ' ' || *q == '\t' || *q == '\r' || *q == '\n'))
+            q++;
+        if (q >= end || *q != ':')
+            continue;
+        q++;
+        while (q < end && (*q == ' ' || *q == '\t' || *q == '\r' || *q == '\n'))
+            q++;
+        if (q < end)
+            return q;
+    }
+    return nullptr;
+}
+
+bool jsonString(const char *json, size_t length, const char *key, std::string &out)
+{
+    const char *p = valueOf(json, length, key);
+    const char *end = json + length;
+    if (!p || *p != '"')
+        return false;
+    out.clear();
+    for (p++; p < end; p++)
+    {
+        if (*p == '"')
+            return true;
+        if (*p != '\\')
+        {
+            out += *p;
+            continue;
+        }
+        if (++p >= end)
+            break;
+        switch (*p)
+        {
+        case 'n':
+            out += '\n';
+            break;
+        case 't':
+            out += '\t';
+            break;
+        case 'r':
+            out += '\r';
+            break;
+        case 'b':
+            out += '\b';
+            break;
+        case 'f':
+            out += '\f';
+            break;
+        default: // " \ / and the u of \uXXXX, kept as is
+            out += *p;
+            break;
+        }
+    }
+    return false;
+}
+
+bool jsonInt(const char *json, size_t length, const char *key, long &out)
+{
+    const char *p = valueOf(json, length, key);
+    const char *end = json + length;
+    if (!p || !(*p == '-' || (*p >= '0' && *p <= '9')))
+        return false;
+    // json need not be terminated
+    char digits[24];
+    size_t n = 0;
+    while (p < end && n + 1 < sizeof(digits) && (*p == '-' || (*p >= '0' && *p <= '9')))
+        digits[n++] = *p++;
+    digits[n] = '\0';
+    out = strtol(digits, nullptr, 10);
+    return true;
+}
+
+std::string jsonEscape(const std::string &text)
+{
+    std::string out;
+    out.reserve(text.size());
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        if ((unsigned char)c < 0x20)
+            continue;
+        out += c;
+    }
+    return out;
+}
@@ -0,0 +1,146 @@
+#include "reactor.h"
+
+#include <sys/epoll.h>
+#include <time.h>
+#include <unistd.h>
+
+Reactor::Reactor() : epfd(epoll_create1(EPOLL_CLOEXEC))
+{
+}
+
+Reactor::~Reactor()
+{
+    close(epfd);
+}
+
+bool Reactor::add(int fd, uint32_t events, Handler *handler)
+{
+    epoll_event ev = {};
+    ev.events = events;
+    ev.data.ptr = handler;
+    return epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+bool Reactor::modify(int fd, uint32_t events, Handler *handler)
+{
+    epoll_event ev = {};
+    ev.events = events;
+    ev.data.ptr = handler;
+    return epoll_ctl(epfd, EPOLL_CTL_MOD, fd, &ev) == 0;
+}
+
+void Reactor::remove(int fd)
+{
+    epoll_ctl(epfd, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+uint64_t Reactor::nowMs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+void Reactor::place(size_t i, Timer *timer)
+{
+    heap[i] = timer;
+    timer->heapIndex = i;
+}
+
+void Reactor::siftUp(size_t i)
+{
+    Timer *timer = heap[i];
+    while (i > 0)
+    {
+        const size_t parent = (i - 1) / 2;
+        if (heap[parent]->due <= timer->due)
+            break;
+        place(i, heap[parent]);
+        i = parent;
+    }
+    place(i, timer);
+}
+
+void Reactor::siftDown(size_t i)
+{
+    Timer *timer = heap[i];
+    const size_t n = heap.size();
+    while (true)
+    {
+        size_t child = 2 * i + 1;
+        if (child >= n)
+            break;
+        if (child + 1 < n && heap[child + 1]->due < heap[child]->due)
+            child++;
+        if (timer->due <= heap[child]->due)
+            break;
+        place(i, heap[child]);
+        i = child;
+    }
+    place(i, timer);
+}
+
+void Reactor::schedule(Timer *timer, uint64_t ms)
+{
+    timer->due = nowMs() + ms;
+    if (timer->scheduled())
+    {
+        siftUp(timer->heapIndex);
+        siftDown(timer->heapIndex);
+        return;
+    }
+    heap.push_back(timer);
+    siftUp(heap.size() - 1);
+}
+
+void Reactor::cancel(Timer *timer)
+{
+    if (!timer->scheduled())
+        return;
+    const size_t i = timer->heapIndex;
+    timer->heapIndex = Timer::NONE;
+    Timer *last = heap.back();
+    heap.pop_back();
+    if (last == timer)
+        return;
+    place(i, last);
+    siftUp(i);
+    siftDown(last->heapIndex);
+}
+
+int Reactor::runOnce(int maxWaitMs)
+{
+    int waitMs = maxWaitMs;
+    if (!heap.empty())
+    {
+        const uint64_t now = nowMs();
+        const uint64_t due = heap[0]->due;
+        if (due <= now)
+            waitMs = 0;
+        else if (due - now < (uint64_t)waitMs)
+            waitMs = (int)(due - now);
+    }
+
+    epoll_event events[256];
+    const int n = epoll_wait(epfd, events, 256, waitMs);
+    for (int i = 0; i < n; i++)
+        static_cast<Handler *>(events[i].data.ptr)->ready(events[i].events);
+
+    // Timers due now; one that reschedules itself for now runs next round
+    const uint64_t now = nowMs();
+    size_t budget = heap.size();
+    while (!heap.empty() && heap[0]->due <= now && budget--)
+    {
+        Timer *timer = heap[0];
+        cancel(timer);
+        timer->fire();
+    }
+    return n > 0 ? n : 0;
+}
+
+void Reactor::run()
+{
+    running = true;
+    while (running)
+        runOnce();
+}
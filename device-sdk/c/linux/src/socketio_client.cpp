@@ -0,0 +1,278 @@
+#include "socketio_client.h"
+
+#include <cstring>
+
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <openssl/sha.h>
+
+// Frame masks need not be unpredictable to anyone but a proxy cache, so a
+// xorshift seeded once is enough and keeps RAND_bytes off the send path
+static uint32_t nextMask()
+{
+    thread_local uint64_t state = 0;
+    if (state == 0)
+    {
+        RAND_bytes((unsigned char *)&state, sizeof(state));
+        state |= 1;
+    }
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return (uint32_t)state;
+}
+
+// Longest 101 response head accepted
+static const size_t MAX_HEAD = 8192;
+
+SocketIOClient::SocketIOClient(Reactor &r, Listener &l) : reactor(r), listener(l), conn(r, *this), retryTimer(*this)
+{
+}
+
+void SocketIOClient::begin(const Endpoint &s, const std::string &p)
+{
+    server = &s;
+    path = p;
+    connect();
+}
+
+void SocketIOClient::end()
+{
+    reactor.cancel(&retryTimer);
+    conn.close();
+    phase = IDLE;
+    std::string().swap(pending);
+}
+
+void SocketIOClient::reconnect()
+{
+    if (phase == IDLE)
+        return;
+    reactor.cancel(&retryTimer);
+    conn.close();
+    connect();
+}
+
+void SocketIOClient::connect()
+{
+    phase = UPGRADING;
+    pending.clear();
+    if (!conn.open(*server))
+    {
+        phase = WAITING;
+        reactor.schedule(&retryTimer, reconnectInterval);
+    }
+}
+
+void SocketIOClient::retry()
+{
+    if (phase == WAITING)
+        connect();
+}
+
+// The link is gone; try again after the interval and tell the listener
+void SocketIOClient::lost()
+{
+    conn.close();
+    phase = WAITING;
+    std::string().swap(pending);
+    reactor.schedule(&retryTimer, reconnectInterval);
+    listener.disconnected(*this);
+}
+
+void SocketIOClient::connected(Connection &)
+{
+    unsigned char nonce[16];
+    RAND_bytes(nonce, sizeof(nonce));
+    char key[32];
+    EVP_EncodeBlock((unsigned char *)key, nonce, sizeof(nonce));
+    pending = key;
+
+    std::string request = "GET " + path + " HTTP/1.1\r\nHost: " + server->authority +
+                          "\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Key: " + pending +
+                          "\r\nSec-WebSocket-Version: 13\r\n\r\n";
+    conn.send(request);
+}
+
+size_t SocketIOClient::upgrade(const std::string &rx)
+{
+    const size_t end = rx.find("\r\n\r\n");
+    if (end == std::string::npos)
+        return 0;
+    // The accept value is base64(SHA-1(key + the RFC 6455 GUID))
+    const std::string keyed = pending + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    unsigned char digest[SHA_DIGEST_LENGTH];
+    SHA1((const unsigned char *)keyed.data(), keyed.size(), digest);
+    char accept[32];
+    EVP_EncodeBlock((unsigned char *)accept, digest, sizeof(digest));
+
+    const std::string head = rx.substr(0, end + 2);
+    if (head.compare(0, 12, "HTTP/1.1 101") != 0 || head.find(accept) == std::string::npos)
+        return std::string::npos;
+    return end + 4;
+}
+
+void SocketIOClient::received(Connection &, std::string &rx)
+{
+    size_t at = 0;
+    if (phase == UPGRADING)
+    {
+        at = upgrade(rx);
+        if (at == 0)
+        {
+            if (rx.size() > MAX_HEAD)
+                lost();
+            return;
+        }
+        if (at == std::string::npos)
+        {
+            lost();
+            return;
+        }
+        phase = OPEN;
+        pending.clear();
+        listener.connected(*this);
+        if (!conn.isOpen())
+            return;
+    }
+
+    // Server frames are not masked. Whole unfragmented messages go to the
+    // listener straight from rx; anything it does that drops the link also
+    // empties rx, so each callback is followed by a check.
+    while (rx.size() - at >= 2)
+    {
+        const uint8_t *p = (const uint8_t *)rx.data() + at;
+        const size_t available = rx.size() - at;
+        const uint8_t opcode = p[0] & 0x0F;
+        const bool fin = p[0] & 0x80;
+        uint64_t length = p[1] & 0x7F;
+        size_t head = 2;
+        if (length == 126)
+        {
+            if (available < 4)
+                break;
+            length = ((uint64_t)p[2] << 8) | p[3];
+            head = 4;
+        }
+        else if (length == 127)
+        {
+            if (available < 10)
+                break;
+            length = 0;
+            for (int i = 0; i < 8; i++)
+                length = (length << 8) | p[2 + i];
+            head = 10;
+        }
+        if (p[1] & 0x80)
+            head += 4; // a masked server frame is a protocol error; skip the key
+        // Checked before the sum below, which a length near 2^64 would wrap
+        if (length > MAX_MESSAGE || ((opcode == 0x0 || opcode == 0x1) && pending.size() + length > MAX_MESSAGE))
+        {
+            lost();
+            return;
+        }
+        if (available < head + length)
+            break;
+        const char *payload = (const char *)p + head;
+        at += head + length;
+
+        switch (opcode)
+        {
+        case 0x8: // close
+            lost();
+            return;
+        case 0x9: // ping
+            sendFrame(0xA, payload, length);
+            break;
+        case 0x0:
+        case 0x1:
+            if (fin && opcode == 0x1 && pending.empty())
+                listener.packet(*this, payload, length);
+            else
+            {
+                pending.append(payload, length);
+                if (fin)
+                {
+                    std::string message;
+                    message.swap(pending);
+                    listener.packet(*this, message.data(), message.size());
+                }
+            }
+            break;
+        default:
+            break;
+        }
+        if (!conn.isOpen())
+            return;
+    }
+    rx.erase(0, at);
+}
+
+void SocketIOClient::closed(Connection &, int)
+{
+    lost();
+}
+
+void SocketIOClient::sendPacket(const char *type, const std::string &data)
+{
+    const size_t typeLength = strlen(type);
+    if (data.empty())
+    {
+        sendText(type, typeLength);
+        return;
+    }
+    thread_local std::string packet;
+    packet.assign(type, typeLength);
+    packet += data;
+    sendText(packet.data(), packet.size());
+}
+
+void SocketIOClient::sendText(const char *text, size_t length)
+{
+    if (phase == OPEN)
+        sendFrame(0x1, text, length);
+}
+
+void SocketIOClient::sendFrame(uint8_t opcode, const char *data, size_t length)
+{
+    // One scratch buffer per thread: no allocation per frame once warm
+    thread_local std::string frame;
+    frame.clear();
+    frame += (char)(0x80 | opcode);
+    if (length < 126)
+        frame += (char)(0x80 | length);
+    else if (length < 65536)
+    {
+        frame += (char)(0x80 | 126);
+        frame += (char)(length >> 8);
+        frame += (char)length;
+    }
+    else
+    {
+        frame += (char)(0x80 | 127);
+        for (int shift = 56; shift >= 0; shift -= 8)
+            frame += (char)((uint64_t)length >> shift);
+    }
+    const uint32_t mask = nextMask();
+    const uint8_t *key = (const uint8_t *)&mask;
+    frame.append((const char *)key, 4);
+    const size_t at = frame.size();
+    frame.append(data, length);
+    for (size_t i = 0; i < length; i++)
+        frame[at + i] ^= key[i & 3];
+    conn.send(frame);
+}
+
+std::string socketPath(const std::string &apiPath, const std::string &sn, uint32_t baseSensorId, size_t sensorCount)
+{
+    std::string sensorIds = "[";
+    for (size_t i = 0; i < sensorCount; i++)
+    {
+        sensorIds += std::to_string(baseSensorId + i);
+        if (i + 1 < sensorCount)
+            sensorIds += ",";
+    }
+    sensorIds += "]";
+    return apiPath + "?sn=" + sn + "&clientType=device" + "&clientVersion=V4" + "&sensorIds=" + sensorIds +
+           "&EIO=4&transport=websocket";
+}
@@ -0,0 +1,234 @@
+// Hosts many devices in one process: one DeviceSession per serial, all on
+// one epoll reactor, against the real server or the stand-in.
+//
+//   device_gateway --server https://atcloud365.com --secret KEY --sn-file sns.txt
+//   device_gateway --server http://127.0.0.1:8765 --count 1000 --kind input
+//
+// Serials come from --sn-file (one per line, # comments) or are generated
+// as <prefix><n>. https:// verifies the certificate against the system
+// store, or --ca; --insecure skips that (the stand-in's is self-signed).
+// A status line goes to stdout every --status-ms.
+#include <sys/resource.h>
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "gateway.h"
+
+struct GatewayOptions
+{
+    std::string server;
+    std::string secret;
+    std::string snFile;
+    std::string snPrefix = "LNX";
+    std::string caFile;
+    uint32_t count = 0;
+    uint32_t rampMs = 0;
+    uint32_t statusMs = 5000;
+    double seconds = 0; // 0: until killed
+    bool insecure = false;
+    bool log = false;
+    DeviceProfile profile;
+};
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s --server URL (--sn-file FILE | --count N [--sn-prefix P])\n"
+            "          [--secret KEY] [--kind input|output] [--sensors N] [--base-sensor-id N]\n"
+            "          [--api-path P] [--data-interval-ms N] [--ramp-ms N] [--insecure] [--ca FILE]\n"
+            "          [--seconds N] [--status-ms N] [--log]\n",
+            prog);
+}
+
+static bool parseOptions(int argc, char **argv, GatewayOptions &opts)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "--insecure") == 0)
+            opts.insecure = true;
+        else if (strcmp(arg, "--log") == 0)
+            opts.log = true;
+        else if (!hasValue)
+        {
+            usage(argv[0]);
+            return false;
+        }
+        else if (strcmp(arg, "--server") == 0)
+            opts.server = argv[++i];
+        else if (strcmp(arg, "--secret") == 0)
+            opts.secret = argv[++i];
+        else if (strcmp(arg, "--sn-file") == 0)
+            opts.snFile = argv[++i];
+        else if (strcmp(arg, "--sn-prefix") == 0)
+            opts.snPrefix = argv[++i];
+        else if (strcmp(arg, "--count") == 0)
+            opts.count = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(arg, "--ca") == 0)
+            opts.caFile = argv[++i];
+        else if (strcmp(arg, "--kind") == 0)
+        {
+            const char *kind = argv[++i];
+            opts.profile.kind = strcmp(kind, "input") == 0 ? DeviceProfile::INPUT : DeviceProfile::OUTPUT;
+        }
+        else if (strcmp(arg, "--sensors") == 0)
+            opts.profile.sensorCount = (uint8_t)atoi(argv[++i]);
+        else if (strcmp(arg, "--base-sensor-id") == 0)
+            opts.profile.baseSensorId = (uint32_t)strtoul(argv[++i], nullptr, 0);
+        else if (strcmp(arg, "--api-path") == 0)
+            opts.profile.apiPath = argv[++i];
+        else if (strcmp(arg, "--data-interval-ms") == 0)
+            opts.profile.dataIntervalMs = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(arg, "--ramp-ms") == 0)
+            opts.rampMs = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(arg, "--status-ms") == 0)
+            opts.statusMs = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(arg, "--seconds") == 0)
+            opts.seconds = strtod(argv[++i], nullptr);
+        else
+        {
+            usage(argv[0]);
+            return false;
+        }
+    }
+    if (opts.server.empty() || (opts.snFile.empty() && opts.count == 0) || opts.profile.sensorCount == 0 ||
+        opts.profile.sensorCount > DeviceProfile::MAX_SENSORS)
+    {
+        usage(argv[0]);
+        return false;
+    }
+    if (opts.secret.empty() && getenv("ATCLOUD_SECRET_KEY"))
+        opts.secret = getenv("ATCLOUD_SECRET_KEY");
+    return true;
+}
+
+static bool loadSerials(const GatewayOptions &opts, std::vector<std::string> &sns)
+{
+    if (opts.snFile.empty())
+    {
+        char sn[64];
+        for (uint32_t i = 0; i < opts.count; i++)
+        {
+            snprintf(sn, sizeof(sn), "%s%08u", opts.snPrefix.c_str(), i);
+            sns.push_back(sn);
+        }
+        return true;
+    }
+    std::ifstream in(opts.snFile);
+    if (!in)
+        return false;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        line = line.substr(0, line.find('#'));
+        const size_t begin = line.find_first_not_of(" \t\r");
+        if (begin == std::string::npos)
+            continue;
+        sns.push_back(line.substr(begin, line.find_last_not_of(" \t\r") - begin + 1));
+    }
+    return true;
+}
+
+static const char *const STATE_NAMES[] = {"booting", "authenticating", "connecting", "online"};
+
+class Log : public DeviceSession::Listener
+{
+public:
+    void output(DeviceSession &session, uint8_t index, bool on) override
+    {
+        printf("[%s] output %u %s\n", session.sn().c_str(), index, on ? "ON" : "OFF");
+    }
+    void stateChanged(DeviceSession &session, DeviceSession::State state) override
+    {
+        printf("[%s] %s\n", session.sn().c_str(), STATE_NAMES[state]);
+    }
+};
+
+class StatusLine : public Reactor::Timer
+{
+public:
+    StatusLine(Reactor &r, Gateway &g, uint32_t ms) : reactor(r), gateway(g), intervalMs(ms) {}
+    void fire() override
+    {
+        const Gateway::Totals t = gateway.totals();
+        printf("online %zu/%zu  connecting %zu  authenticating %zu  booting %zu  auth failures %u  "
+               "disconnects %u  cmds %u  dev-data %u\n",
+               t.inState[DeviceSession::ONLINE], gateway.size(), t.inState[DeviceSession::CONNECTING],
+               t.inState[DeviceSession::AUTHENTICATING], t.inState[DeviceSession::BOOTING], t.sum.authFailures,
+               t.sum.disconnects, t.sum.cmdsApplied, t.sum.emits);
+        fflush(stdout);
+        reactor.schedule(this, intervalMs);
+    }
+
+private:
+    Reactor &reactor;
+    Gateway &gateway;
+    uint32_t intervalMs;
+};
+
+class Stopper : public Reactor::Timer
+{
+public:
+    explicit Stopper(Reactor &r) : reactor(r) {}
+    void fire() override { reactor.stop(); }
+
+private:
+    Reactor &reactor;
+};
+
+int main(int argc, char **argv)
+{
+    GatewayOptions opts;
+    if (!parseOptions(argc, argv, opts))
+        return 2;
+    signal(SIGPIPE, SIG_IGN);
+
+    std::vector<std::string> sns;
+    if (!loadSerials(opts, sns) || sns.empty())
+    {
+        fprintf(stderr, "no serials\n");
+        return 2;
+    }
+    // One socket per device, and the auth request's while it lasts
+    rlimit files;
+    getrlimit(RLIMIT_NOFILE, &files);
+    files.rlim_cur = files.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &files);
+    if (sns.size() + 16 > files.rlim_cur)
+        fprintf(stderr, "warning: %zu devices, file limit %llu\n", sns.size(), (unsigned long long)files.rlim_cur);
+
+    Endpoint server;
+    if (!resolveEndpoint(opts.server, server))
+    {
+        fprintf(stderr, "cannot resolve %s\n", opts.server.c_str());
+        return 1;
+    }
+    if (server.secure)
+        server.tls = tlsClientContext(!opts.insecure, opts.caFile.empty() ? nullptr : opts.caFile.c_str());
+    opts.profile.server = &server;
+    opts.profile.secretKey = opts.secret;
+
+    Reactor reactor;
+    Gateway gateway(reactor, opts.profile);
+    Log log;
+    for (const std::string &sn : sns)
+        gateway.add(sn, opts.log ? &log : nullptr);
+    gateway.start(opts.rampMs);
+
+    StatusLine status(reactor, gateway, opts.statusMs);
+    reactor.schedule(&status, opts.statusMs);
+    Stopper stopper(reactor);
+    if (opts.seconds > 0)
+        reactor.schedule(&stopper, (uint64_t)(opts.seconds * 1000));
+    reactor.run();
+    gateway.stop();
+    status.fire();
+    return 0;
+}
@@ -0,0 +1,385 @@
+// What a device session costs in a gateway: N DeviceSessions against the
+// stand-in server, which runs in a forked child so that this process's
+// memory and CPU are the client's alone. Reports:
+//
+//   - memory per session: RSS and malloc'd bytes once every session is
+//     online, over the baseline taken before the sessions were made
+//     (socket buffers in the kernel are not in either)
+//   - connect: time and CPU to bring every session online
+//   - idle: CPU while sessions sit online
+//   - command storm: --cmds rounds of an output app-cmd to every session;
+//     CPU per message (each frame in or out) and per command, throughput
+//
+//   gateway_bench --sessions 5000 [--tls] [--cmds 10] [--json FILE]
+#include <malloc.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "gateway.h"
+#include "standin_server.h"
+
+struct BenchOptions
+{
+    uint32_t sessions = 1000;
+    uint32_t cmds = 10;
+    uint32_t rampMs = 0; // 0: sessions / 5 ms
+    double idleSeconds = 3;
+    bool tls = false;
+    const char *jsonPath = nullptr;
+    DeviceProfile profile;
+};
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [--sessions N] [--tls] [--cmds N] [--kind input|output] [--sensors N]\n"
+            "          [--ramp-ms N] [--idle-s S] [--json FILE]\n",
+            prog);
+}
+
+static bool parseOptions(int argc, char **argv, BenchOptions &opts)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "--tls") == 0)
+            opts.tls = true;
+        else if (strcmp(arg, "--sessions") == 0 && hasValue)
+            opts.sessions = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(arg, "--cmds") == 0 && hasValue)
+            opts.cmds = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(arg, "--kind") == 0 && hasValue)
+            opts.profile.kind = strcmp(argv[++i], "input") == 0 ? DeviceProfile::INPUT : DeviceProfile::OUTPUT;
+        else if (strcmp(arg, "--sensors") == 0 && hasValue)
+            opts.profile.sensorCount = (uint8_t)atoi(argv[++i]);
+        else if (strcmp(arg, "--ramp-ms") == 0 && hasValue)
+            opts.rampMs = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(arg, "--idle-s") == 0 && hasValue)
+            opts.idleSeconds = strtod(argv[++i], nullptr);
+        else if (strcmp(arg, "--json") == 0 && hasValue)
+            opts.jsonPath = argv[++i];
+        else
+        {
+            usage(argv[0]);
+            return false;
+        }
+    }
+    if (opts.sessions == 0 || opts.profile.sensorCount == 0 ||
+        opts.profile.sensorCount > DeviceProfile::MAX_SENSORS)
+    {
+        usage(argv[0]);
+        return false;
+    }
+    if (opts.rampMs == 0)
+        opts.rampMs = opts.sessions / 5;
+    return true;
+}
+
+// --------------------------------------------------------------------
+// The stand-in, in the child: lines on the control pipe are
+//   cmd <operation json>   broadcast an app-cmd, no reply
+//   stats                  reply with one line of counters
+// --------------------------------------------------------------------
+class Control : public Reactor::Handler
+{
+public:
+    Control(Reactor &r, StandIn &s, int in, int out) : reactor(r), server(s), inFd(in), outFd(out) {}
+
+    void ready(uint32_t) override
+    {
+        char chunk[4096];
+        const ssize_t n = read(inFd, chunk, sizeof(chunk));
+        if (n <= 0)
+        {
+            reactor.stop();
+            return;
+        }
+        buffer.append(chunk, (size_t)n);
+        size_t end;
+        while ((end = buffer.find('\n')) != std::string::npos)
+        {
+            const std::string line = buffer.substr(0, end);
+            buffer.erase(0, end + 1);
+            if (line.compare(0, 4, "cmd ") == 0)
+                server.broadcast(line.substr(4));
+            else if (line == "stats")
+            {
+                const StandIn::Stats &s = server.stats();
+                char reply[256];
+                const int length = snprintf(reply, sizeof(reply), "%zu %llu %llu %llu %llu\n", s.online,
+                                            (unsigned long long)s.auths, (unsigned long long)s.handshakes,
+                                            (unsigned long long)s.devData, (unsigned long long)s.framesOut);
+                if (write(outFd, reply, (size_t)length) != length)
+                    reactor.stop();
+            }
+        }
+    }
+
+private:
+    Reactor &reactor;
+    StandIn &server;
+    int inFd;
+    int outFd;
+    std::string buffer;
+};
+
+static int runStandIn(bool tls, int inFd, int outFd)
+{
+    Reactor reactor;
+    StandIn server(reactor, tls ? standInTlsContext() : nullptr);
+    const uint16_t port = server.listen(0);
+    char line[32];
+    const int length = snprintf(line, sizeof(line), "%u\n", port);
+    if (!port || write(outFd, line, (size_t)length) != length)
+        return 1;
+    Control control(reactor, server, inFd, outFd);
+    reactor.add(inFd, EPOLLIN, &control);
+    server.setPingInterval(25000);
+    reactor.run();
+    return 0;
+}
+
+// --------------------------------------------------------------------
+// The client side, in the parent
+// --------------------------------------------------------------------
+static double cpuSeconds()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+static size_t rssBytes()
+{
+    long pages = 0, resident = 0;
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (f)
+    {
+        if (fscanf(f, "%ld %ld", &pages, &resident) != 2)
+            resident = 0;
+        fclose(f);
+    }
+    return (size_t)resident * (size_t)sysconf(_SC_PAGESIZE);
+}
+
+static size_t heapBytes()
+{
+    return mallinfo2().uordblks;
+}
+
+static bool readLine(int fd, std::string &line)
+{
+    line.clear();
+    char c;
+    while (read(fd, &c, 1) == 1)
+    {
+        if (c == '\n')
+            return true;
+        line += c;
+    }
+    return false;
+}
+
+// Runs the reactor until done() or timeoutMs; false on timeout
+template <class Done>
+static bool runUntil(Reactor &reactor, uint64_t timeoutMs, Done done)
+{
+    const uint64_t until = Reactor::nowMs() + timeoutMs;
+    while (!done())
+    {
+        if (Reactor::nowMs() >= until)
+            return false;
+        reactor.runOnce(10);
+    }
+    return true;
+}
+
+// Runs the reactor for ms without waking it more than it needs
+static void runFor(Reactor &reactor, uint64_t ms)
+{
+    const uint64_t until = Reactor::nowMs() + ms;
+    uint64_t now;
+    while ((now = Reactor::nowMs()) < until)
+        reactor.runOnce((int)(until - now));
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions opts;
+    if (!parseOptions(argc, argv, opts))
+        return 2;
+    signal(SIGPIPE, SIG_IGN);
+    rlimit files;
+    getrlimit(RLIMIT_NOFILE, &files);
+    files.rlim_cur = files.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &files);
+    if (opts.sessions + 64 > files.rlim_cur)
+    {
+        fprintf(stderr, "%u sessions need more than the file limit, %llu\n", opts.sessions,
+                (unsigned long long)files.rlim_cur);
+        return 2;
+    }
+
+    int toChild[2], fromChild[2];
+    if (pipe(toChild) != 0 || pipe(fromChild) != 0)
+    {
+        perror("pipe");
+        return 1;
+    }
+    const pid_t child = fork();
+    if (child == 0)
+    {
+        close(toChild[1]);
+        close(fromChild[0]);
+        _exit(runStandIn(opts.tls, toChild[0], fromChild[1]));
+    }
+    close(toChild[0]);
+    close(fromChild[1]);
+    std::string line;
+    if (child < 0 || !readLine(fromChild[0], line))
+    {
+        fprintf(stderr, "stand-in did not start\n");
+        return 1;
+    }
+    const std::string url = std::string(opts.tls ? "https" : "http") + "://127.0.0.1:" + line;
+
+    Endpoint server;
+    if (!resolveEndpoint(url, server))
+    {
+        fprintf(stderr, "cannot resolve %s\n", url.c_str());
+        return 1;
+    }
+    if (server.secure)
+        server.tls = tlsClientContext(false);
+    opts.profile.server = &server;
+    opts.profile.secretKey = "bench-secret";
+    Reactor reactor;
+
+    // Baseline: everything but the sessions
+    const size_t rss0 = rssBytes();
+    const size_t heap0 = heapBytes();
+    const double cpu0 = cpuSeconds();
+    const uint64_t t0 = Reactor::nowMs();
+
+    Gateway gateway(reactor, opts.profile);
+    char sn[32];
+    for (uint32_t i = 0; i < opts.sessions; i++)
+    {
+        snprintf(sn, sizeof(sn), "03EB0BENCH%012u", i);
+        gateway.add(sn);
+    }
+    gateway.start(opts.rampMs);
+    auto online = [&] { return gateway.totals().inState[DeviceSession::ONLINE]; };
+    // Totals walk every session; checking every few ms is plenty
+    uint64_t lastCheck = 0;
+    auto allOnline = [&]
+    {
+        if (Reactor::nowMs() - lastCheck < 20)
+            return false;
+        lastCheck = Reactor::nowMs();
+        return online() == opts.sessions;
+    };
+    const bool connected = runUntil(reactor, 60000 + opts.rampMs, allOnline);
+    const uint64_t connectMs = Reactor::nowMs() - t0;
+    const double connectCpu = cpuSeconds() - cpu0;
+    // Let the last handshakes' frames drain, then weigh the sessions
+    runFor(reactor, 300);
+    const size_t rss1 = rssBytes();
+    const size_t heap1 = heapBytes();
+
+    const double idleCpu0 = cpuSeconds();
+    runFor(reactor, (uint64_t)(opts.idleSeconds * 1000));
+    const double idleCpu = cpuSeconds() - idleCpu0;
+
+    // Command storm: every round reaches every session at once
+    const Gateway::Totals before = gateway.totals();
+    const double stormCpu0 = cpuSeconds();
+    const uint64_t stormT0 = Reactor::nowMs();
+    const uint32_t sensors = opts.profile.sensorCount;
+    for (uint32_t r = 0; r < opts.cmds; r++)
+    {
+        char cmd[128];
+        const int length =
+            snprintf(cmd, sizeof(cmd), "cmd {\"customCmd\":\"output\",\"fieldIndex\":%u,\"fieldValue\":%u}\n",
+                     r % sensors, ((r / sensors) & 1) ^ 1);
+        if (write(toChild[1], cmd, (size_t)length) != length)
+        {
+            fprintf(stderr, "stand-in went away\n");
+            return 1;
+        }
+    }
+    const uint64_t target = before.sum.cmdsApplied + (uint64_t)online() * opts.cmds;
+    lastCheck = 0;
+    const bool stormDone = runUntil(reactor, 60000,
+                                    [&]
+                                    {
+                                        if (Reactor::nowMs() - lastCheck < 5)
+                                            return false;
+                                        lastCheck = Reactor::nowMs();
+                                        return gateway.totals().sum.cmdsApplied >= target;
+                                    });
+    const uint64_t stormMs = Reactor::nowMs() - stormT0;
+    const double stormCpu = cpuSeconds() - stormCpu0;
+    const Gateway::Totals after = gateway.totals();
+    const uint64_t cmds = after.sum.cmdsApplied - before.sum.cmdsApplied;
+    const uint64_t frames =
+        (after.sum.framesIn - before.sum.framesIn) + (after.sum.framesOut - before.sum.framesOut);
+
+    // What the server saw, once the last dev-data has reached it
+    runFor(reactor, 500);
+    unsigned long long serverDevData = 0, serverAuths = 0, serverOnline = 0, handshakes = 0, serverFramesOut = 0;
+    if (write(toChild[1], "stats\n", 6) == 6 && readLine(fromChild[0], line))
+        sscanf(line.c_str(), "%llu %llu %llu %llu %llu", &serverOnline, &serverAuths, &handshakes, &serverDevData,
+               &serverFramesOut);
+
+    gateway.stop();
+    close(toChild[1]);
+    int status;
+    waitpid(child, &status, 0);
+
+    const size_t n = opts.sessions;
+    const double rssPer = ((double)rss1 - (double)rss0) / n;
+    const double heapPer = ((double)heap1 - (double)heap0) / n;
+    printf("sessions       %zu %s %s, %zu sensors, %s\n", n,
+           opts.profile.kind == DeviceProfile::OUTPUT ? "output" : "input", opts.tls ? "TLS" : "plain TCP",
+           (size_t)sensors, connected ? "all online" : "NOT all online");
+    printf("memory         %.0f B RSS per session, %.0f B heap per session (%.1f MB RSS total)\n", rssPer,
+           heapPer, rss1 / 1048576.0);
+    printf("connect        %.2f s with a %.2f s ramp, %.0f us CPU per session (auth + upgrade + handshake)\n",
+           connectMs / 1e3, opts.rampMs / 1e3, connectCpu * 1e6 / n);
+    printf("idle           %.2f%% CPU over %.1f s\n", idleCpu * 100 / opts.idleSeconds, opts.idleSeconds);
+    printf("command storm  %llu cmds in %.2f s (%.0f/s), %s\n", (unsigned long long)cmds, stormMs / 1e3,
+           cmds * 1e3 / (stormMs ? stormMs : 1), stormDone ? "all applied" : "NOT all applied");
+    printf("cpu            %.2f us per message (%llu frames in+out), %.2f us per command\n",
+           frames ? stormCpu * 1e6 / frames : 0.0, (unsigned long long)frames, cmds ? stormCpu * 1e6 / cmds : 0.0);
+    printf("server         %llu online, %llu auths, %llu handshakes, %llu dev-data\n", serverOnline, serverAuths,
+           handshakes, serverDevData);
+
+    if (opts.jsonPath)
+    {
+        FILE *out = fopen(opts.jsonPath, "w");
+        if (out)
+        {
+            fprintf(out,
+                    "{\"sessions\":%zu,\"tls\":%s,\"allOnline\":%s,\"rssBytesPerSession\":%.0f,"
+                    "\"heapBytesPerSession\":%.0f,\"connectSeconds\":%.3f,\"connectCpuUsPerSession\":%.1f,"
+                    "\"idleCpuPercent\":%.3f,\"cmds\":%llu,\"cmdsPerSec\":%.0f,\"cpuUsPerMessage\":%.3f,"
+                    "\"cpuUsPerCmd\":%.3f}\n",
+                    n, opts.tls ? "true" : "false", connected ? "true" : "false", rssPer, heapPer, connectMs / 1e3,
+                    connectCpu * 1e6 / n, idleCpu * 100 / opts.idleSeconds, (unsigned long long)cmds,
+                    cmds * 1e3 / (stormMs ? stormMs : 1), frames ? stormCpu * 1e6 / frames : 0.0,
+                    cmds ? stormCpu * 1e6 / cmds : 0.0);
+            fclose(out);
+        }
+    }
+    return connected && stormDone ? 0 : 1;
+}
@@ -0,0 +1,118 @@
+// The stand-in server on its own, for running device_gateway (or any other
+// client) against it:
+//
+//   standin --port 8765 [--tls] [--ping-ms 25000] [--cmd-ms 1000]
+//
+// --cmd-ms sends every online device an output app-cmd at that interval,
+// cycling through the outputs. A status line goes to stdout every second.
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "standin_server.h"
+
+struct StandInOptions
+{
+    uint16_t port = 8765;
+    bool tls = false;
+    uint32_t pingMs = 25000;
+    uint32_t cmdMs = 0;
+    uint32_t sensors = 3;
+};
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [--port N] [--tls] [--ping-ms N] [--cmd-ms N] [--sensors N]\n", prog);
+}
+
+static bool parseOptions(int argc, char **argv, StandInOptions &opts)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "--tls") == 0)
+            opts.tls = true;
+        else if (strcmp(arg, "--port") == 0 && hasValue)
+            opts.port = (uint16_t)atoi(argv[++i]);
+        else if (strcmp(arg, "--ping-ms") == 0 && hasValue)
+            opts.pingMs = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(arg, "--cmd-ms") == 0 && hasValue)
+            opts.cmdMs = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(arg, "--sensors") == 0 && hasValue)
+            opts.sensors = (uint32_t)atoi(argv[++i]);
+        else
+        {
+            usage(argv[0]);
+            return false;
+        }
+    }
+    return opts.sensors > 0;
+}
+
+class Commander : public Reactor::Timer
+{
+public:
+    Commander(Reactor &r, StandIn &s, const StandInOptions &o) : reactor(r), server(s), opts(o) {}
+    void fire() override
+    {
+        char op[96];
+        snprintf(op, sizeof(op), "{\"customCmd\":\"output\",\"fieldIndex\":%u,\"fieldValue\":%u}",
+                 (unsigned)(round % opts.sensors), (unsigned)((round / opts.sensors) & 1) ^ 1);
+        server.broadcast(op);
+        round++;
+        reactor.schedule(this, opts.cmdMs);
+    }
+
+private:
+    Reactor &reactor;
+    StandIn &server;
+    const StandInOptions &opts;
+    uint32_t round = 0;
+};
+
+class StatusLine : public Reactor::Timer
+{
+public:
+    StatusLine(Reactor &r, StandIn &s) : reactor(r), server(s) {}
+    void fire() override
+    {
+        const StandIn::Stats &s = server.stats();
+        printf("online %zu  accepted %llu  auths %llu  dev-data %llu  dev-status %llu  pongs %llu\n", s.online,
+               (unsigned long long)s.accepted, (unsigned long long)s.auths, (unsigned long long)s.devData,
+               (unsigned long long)s.devStatus, (unsigned long long)s.pongs);
+        fflush(stdout);
+        reactor.schedule(this, 1000);
+    }
+
+private:
+    Reactor &reactor;
+    StandIn &server;
+};
+
+int main(int argc, char **argv)
+{
+    StandInOptions opts;
+    if (!parseOptions(argc, argv, opts))
+        return 2;
+    signal(SIGPIPE, SIG_IGN);
+
+    Reactor reactor;
+    StandIn server(reactor, opts.tls ? standInTlsContext() : nullptr);
+    const uint16_t port = server.listen(opts.port);
+    if (!port)
+    {
+        perror("listen");
+        return 1;
+    }
+    printf("listening on %s://127.0.0.1:%u\n", opts.tls ? "https" : "http", port);
+    server.setPingInterval(opts.pingMs);
+    Commander commander(reactor, server, opts);
+    if (opts.cmdMs)
+        reactor.schedule(&commander, opts.cmdMs);
+    StatusLine status(reactor, server);
+    reactor.schedule(&status, 1000);
+    reactor.run();
+    return 0;
+}
@@ -0,0 +1,340 @@
+#include "standin_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#include <openssl/evp.h>
+#include <openssl/sha.h>
+#include <openssl/x509.h>
+
+#include "json_scan.h"
+#include "socketio_client.h"
+
+// Server frames are not masked
+static std::string frameOf(const char *text, size_t length)
+{
+    std::string frame;
+    frame.reserve(length + 10);
+    frame += (char)0x81;
+    if (length < 126)
+        frame += (char)length;
+    else if (length < 65536)
+    {
+        frame += (char)126;
+        frame += (char)(length >> 8);
+        frame += (char)length;
+    }
+    else
+    {
+        frame += (char)127;
+        for (int shift = 56; shift >= 0; shift -= 8)
+            frame += (char)((uint64_t)length >> shift);
+    }
+    frame.append(text, length);
+    return frame;
+}
+
+class StandIn::Client : public Connection::Listener
+{
+public:
+    Client(StandIn &s, size_t index) : server(s), conn(s.reactor, *this), slot(index) {}
+
+    void connected(Connection &) override {}
+    void closed(Connection &, int) override { server.drop(this); }
+
+    void received(Connection &, std::string &rx) override
+    {
+        if (!upgraded)
+        {
+            request(rx);
+            return;
+        }
+        size_t at = 0;
+        while (rx.size() - at >= 6)
+        {
+            uint8_t *p = (uint8_t *)&rx[at];
+            const size_t available = rx.size() - at;
+            const uint8_t opcode = p[0] & 0x0F;
+            uint64_t length = p[1] & 0x7F;
+            size_t head = 2;
+            if (length == 126)
+            {
+                length = ((uint64_t)p[2] << 8) | p[3];
+                head = 4;
+            }
+            else if (length == 127)
+            {
+                if (available < 14)
+                    break;
+                length = 0;
+                for (int i = 0; i < 8; i++)
+                    length = (length << 8) | p[2 + i];
+                head = 10;
+            }
+            const uint8_t *key = p + head;
+            head += 4;
+            if (length > SocketIOClient::MAX_MESSAGE)
+            {
+                conn.close();
+                server.drop(this);
+                return;
+            }
+            if (available < head + length)
+                break;
+            char *payload = (char *)p + head;
+            for (size_t i = 0; i < length; i++)
+                payload[i] ^= key[i & 3];
+            at += head + length;
+
+            if (opcode == 0x8)
+            {
+                conn.close();
+                server.drop(this);
+                return;
+            }
+            if (opcode == 0x1)
+                message(payload, length);
+            if (!conn.isOpen())
+                return;
+        }
+        rx.erase(0, at);
+    }
+
+    void send(const char *text, size_t length)
+    {
+        conn.send(frameOf(text, length));
+        server.counters.framesOut++;
+    }
+
+    StandIn &server;
+    Connection conn;
+    size_t slot;
+    size_t onlineSlot = (size_t)-1;
+    bool upgraded = false;
+    std::string sid;
+
+private:
+    void message(const char *text, size_t length)
+    {
+        server.counters.framesIn++;
+        if (length >= 2 && text[0] == '4' && text[1] == '0')
+        {
+            server.counters.handshakes++;
+            const std::string ack = "40{\"sid\":\"" + sid + "\"}";
+            send(ack.data(), ack.size());
+            server.setOnline(this, true);
+        }
+        else if (length == 1 && text[0] == '3')
+            server.counters.pongs++;
+        else if (length > 13 && memcmp(text, "42[\"dev-data\"", 13) == 0)
+            server.counters.devData++;
+        else if (length > 15 && memcmp(text, "42[\"dev-status\"", 15) == 0)
+            server.counters.devStatus++;
+    }
+
+    void respond(const char *status, const std::string &body)
+    {
+        conn.send(std::string("HTTP/1.1 ") + status + "\r\nContent-Type: application/json\r\nContent-Length: " +
+                  std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body);
+    }
+
+    void request(std::string &rx)
+    {
+        const size_t end = rx.find("\r\n\r\n");
+        if (end == std::string::npos)
+            return;
+        const std::string head = rx.substr(0, end + 4);
+        if (head.compare(0, 5, "POST ") == 0)
+        {
+            const size_t lengthAt = head.find("Content-Length:");
+            const size_t length = lengthAt == std::string::npos ? 0 : strtoul(head.c_str() + lengthAt + 15, nullptr, 10);
+            if (rx.size() < end + 4 + length)
+                return;
+            const std::string body = rx.substr(end + 4, length);
+            rx.clear();
+            std::string sn;
+            if (head.compare(0, 26, "POST /api/v3/devices/auth ") != 0 ||
+                !jsonString(body.data(), body.size(), "sn", sn))
+            {
+                respond("404 Not Found", "{}");
+                return;
+            }
+            server.counters.auths++;
+            respond("200 OK", "{\"token\":\"tok-" + jsonEscape(sn) + "\"}");
+            return;
+        }
+
+        const size_t keyAt = head.find("Sec-WebSocket-Key: ");
+        if (head.compare(0, 4, "GET ") != 0 || keyAt == std::string::npos)
+        {
+            respond("404 Not Found", "{}");
+            return;
+        }
+        const std::string keyed =
+            head.substr(keyAt + 19, head.find("\r\n", keyAt) - keyAt - 19) + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+        unsigned char digest[SHA_DIGEST_LENGTH];
+        SHA1((const unsigned char *)keyed.data(), keyed.size(), digest);
+        char accept[32];
+        EVP_EncodeBlock((unsigned char *)accept, digest, sizeof(digest));
+        rx.erase(0, end + 4);
+        upgraded = true;
+        sid = std::to_string(server.nextSid++);
+        conn.send(std::string("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                              "Sec-WebSocket-Accept: ") +
+                  accept + "\r\n\r\n");
+        const std::string open = "0{\"sid\":\"" + sid +
+                                 "\",\"upgrades\":[],\"pingInterval\":25000,\"pingTimeout\":20000,\"maxPayload\":1000000}";
+        send(open.data(), open.size());
+    }
+};
+
+StandIn::StandIn(Reactor &r, SSL_CTX *t) : reactor(r), tls(t), pingTimer(*this), reapTimer(*this)
+{
+}
+
+StandIn::~StandIn()
+{
+    reactor.cancel(&pingTimer);
+    reactor.cancel(&reapTimer);
+    if (listenFd >= 0)
+    {
+        reactor.remove(listenFd);
+        close(listenFd);
+    }
+}
+
+uint16_t StandIn::listen(uint16_t port)
+{
+    listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    const int one = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(addr);
+    if (bind(listenFd, (sockaddr *)&addr, sizeof(addr)) != 0 || ::listen(listenFd, 4096) != 0 ||
+        getsockname(listenFd, (sockaddr *)&addr, &length) != 0)
+        return 0;
+    reactor.add(listenFd, EPOLLIN, this);
+    return ntohs(addr.sin_port);
+}
+
+void StandIn::ready(uint32_t)
+{
+    while (true)
+    {
+        const int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+            return;
+        counters.accepted++;
+        clients.emplace_back(new Client(*this, clients.size()));
+        clients.back()->conn.adopt(fd, tls);
+    }
+}
+
+void StandIn::setOnline(Client *client, bool on)
+{
+    if (on && client->onlineSlot == (size_t)-1)
+    {
+        client->onlineSlot = online.size();
+        online.push_back(client);
+    }
+    else if (!on && client->onlineSlot != (size_t)-1)
+    {
+        Client *last = online.back();
+        online[client->onlineSlot] = last;
+        last->onlineSlot = client->onlineSlot;
+        online.pop_back();
+        client->onlineSlot = (size_t)-1;
+    }
+    counters.online = online.size();
+}
+
+// The connection is closed; the Client goes once the reactor is out of it
+void StandIn::drop(Client *client)
+{
+    setOnline(client, false);
+    const size_t slot = client->slot;
+    if (slot >= clients.size() || clients[slot].get() != client)
+        return;
+    dead.push_back(std::move(clients[slot]));
+    if (slot + 1 < clients.size())
+    {
+        clients[slot] = std::move(clients.back());
+        clients[slot]->slot = slot;
+    }
+    clients.pop_back();
+    if (!reapTimer.scheduled())
+        reactor.schedule(&reapTimer, 0);
+}
+
+void StandIn::reap()
+{
+    dead.clear();
+}
+
+void StandIn::sendAll(const std::string &frame)
+{
+    // Indexing: a failed send drops the client and reorders online
+    for (size_t i = 0; i < online.size(); i++)
+    {
+        Client *client = online[i];
+        client->conn.send(frame);
+        counters.framesOut++;
+        if (i < online.size() && online[i] != client)
+            i--;
+    }
+}
+
+size_t StandIn::broadcast(const std::string &operation)
+{
+    const std::string packet = "42[\"app-cmd\",{\"operation\":" + operation + "}]";
+    const size_t n = online.size();
+    sendAll(frameOf(packet.data(), packet.size()));
+    return n;
+}
+
+void StandIn::setPingInterval(uint32_t ms)
+{
+    pingMs = ms;
+    if (ms)
+        reactor.schedule(&pingTimer, ms);
+    else
+        reactor.cancel(&pingTimer);
+}
+
+void StandIn::ping()
+{
+    sendAll(frameOf("2", 1));
+    reactor.schedule(&pingTimer, pingMs);
+}
+
+SSL_CTX *standInTlsContext()
+{
+    EVP_PKEY *key = EVP_EC_gen("P-256");
+    X509 *cert = X509_new();
+    if (!key || !cert)
+        return nullptr;
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), -3600);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 7 * 24 * 3600);
+    X509_set_pubkey(cert, key);
+    X509_NAME *name = X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char *)"localhost", -1, -1, 0);
+    X509_set_issuer_name(cert, name);
+    X509_sign(cert, key, EVP_sha256());
+
+    SSL_CTX *ctx = SSL_CTX_new(TLS_server_method());
+    SSL_CTX_set_mode(ctx, SSL_MODE_RELEASE_BUFFERS | SSL_MODE_ENABLE_PARTIAL_WRITE |
+                              SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+    SSL_CTX_use_certificate(ctx, cert);
+    SSL_CTX_use_PrivateKey(ctx, key);
+    X509_free(cert);
+    EVP_PKEY_free(key);
+    return ctx;
+}
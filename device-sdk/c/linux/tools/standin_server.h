@@ -0,0 +1,68 @@
+// A local stand-in for the atCloud365 server, on a Reactor: the auth
+// endpoint, the WebSocket upgrade and the Engine.IO/Socket.IO handshake,
+// Engine.IO pings, and app-cmds on demand; it counts what devices send.
+// Plain TCP, or TLS with a certificate made at startup. Used by
+// gateway_bench and by the standin tool.
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "connection.h"
+
+class StandIn : private Reactor::Handler
+{
+public:
+    StandIn(Reactor &reactor, SSL_CTX *tls = nullptr);
+    ~StandIn() override;
+
+    // Listens on 127.0.0.1; port 0 picks one. Returns the port, 0 on failure
+    uint16_t listen(uint16_t port);
+
+    // Sends 42["app-cmd",{"operation":operation}] to every online device;
+    // returns how many got it
+    size_t broadcast(const std::string &operation);
+    // Sends an Engine.IO ping to every online device every ms (0: never)
+    void setPingInterval(uint32_t ms);
+
+    struct Stats
+    {
+        uint64_t accepted = 0;
+        uint64_t auths = 0;
+        uint64_t handshakes = 0; // 40 received
+        uint64_t devData = 0;
+        uint64_t devStatus = 0;
+        uint64_t pongs = 0;
+        uint64_t framesIn = 0;
+        uint64_t framesOut = 0;
+        size_t online = 0;
+    };
+    const Stats &stats() const { return counters; }
+
+private:
+    class Client;
+
+    void ready(uint32_t events) override;
+    void ping();
+    void reap();
+    void sendAll(const std::string &frame);
+    void setOnline(Client *client, bool online);
+    void drop(Client *client);
+
+    Reactor &reactor;
+    SSL_CTX *tls;
+    int listenFd = -1;
+    std::vector<std::unique_ptr<Client>> clients; // by Client::slot
+    std::vector<Client *> online;                 // by Client::onlineSlot
+    std::vector<std::unique_ptr<Client>> dead;    // freed outside callbacks
+    MemberTimer<StandIn, &StandIn::ping> pingTimer;
+    MemberTimer<StandIn, &StandIn::reap> reapTimer;
+    uint32_t pingMs = 0;
+    uint64_t nextSid = 1;
+    Stats counters;
+};
+
+// A server context with a self-signed P-256 certificate for localhost
+SSL_CTX *standInTlsContext();
@@ -0,0 +1,118 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+// ==================================================
+// WiFi Configuration
+// ==================================================
+#define WIFI_SSID "YOUR_WIFI_SSID_HERE"
+#define WIFI_PASSWORD "YOUR_WIFI_PASSWORD_HERE"
+
+// ==================================================
+// atCloud365 Authentication
+// NOTE: This is for testing purpose only
+// For production, use credentials from atCloud365 platform
+// ==================================================
+#define DEVICE_SN "03EB023C002601000000FC"
+#define CLIENT_SECRET_KEY "$2b$10$MTQ9AXjbWxckfbCPzVDpkOtpRrSP2z.KyRhtPvhVuaAcmyBiPZXne"
+
+// ==================================================
+// atCloud365 Server Configuration
+// ==================================================
+#define SERVER_URL "https://atcloud365.com"
+#define SERVER_PORT 443
+#define API_PATH "/api/dev/io/"
+
+// ==================================================
+// Sensor Configuration
+// ==================================================
+// Base sensor ID and sensor count used in the authentication payload.
+// Modify these values to match your hardware configuration.
+#define BASE_SENSOR_ID 0x0f1234
+#define SENSOR_COUNT 3
+
+// ==================================================
+// Timeout Settings
+// ==================================================
+#define HTTP_TIMEOUT 30000     // 30 seconds
+#define SOCKETIO_TIMEOUT 60000 // 60 seconds
+
+// ==================================================
+// GPIO Pin Configuration (ESP32)
+// ==================================================
+// Input pins for sensors (pulled up internally)
+#define GPIO_INPUT_1 32
+#define GPIO_INPUT_2 33
+#define GPIO_INPUT_3 25
+
+// Uncomment to drive the inputs with random values (no wiring needed)
+// #define USE_SIMULATED_GPIO_VALUES
+
+// ==================================================
+// LCD Configuration (ST7789P3 240x320, ESP32-32E module)
+// ==================================================
+#define HAS_LCD_240x320
+
+#ifdef HAS_LCD_240x320
+// SPI pins (module default, see README)
+#define LCD_SCK_PIN 14
+#define LCD_MOSI_PIN 13
+#define LCD_MISO_PIN 12
+#define LCD_CS_PIN 15
+#define LCD_DC_PIN 2
+#define LCD_RST_PIN 22
+#define LCD_BL_PIN 21
+
+// Height of each DMA strip in full-width rows (used when no PSRAM)
+#define LCD_BAND_ROWS 20
+
+// SPI write clock. With LCD_SPI_CALIBRATE the first boot steps it up,
+// verifying each step by reading test patterns back over MISO, and stores
+// the highest stable clock minus LCD_SPI_CAL_MARGIN steps in NVS.
+#define LCD_SPI_FREQ 10000000
+#define LCD_SPI_CALIBRATE
+#define LCD_SPI_CAL_MARGIN 1
+// #define LCD_SPI_RECALIBRATE // ignore the stored clock and calibrate again
+
+// Anti-aliased (2 bits per pixel) large font for text drawn at scale 2
+// #define LCD_FONT_AA
+// Composed Hangul glyphs kept in RAM, 64 bytes each (default 24)
+// #define LCD_HANGUL_CACHE 24
+// Sensor sparklines: one 2-bit column per period (default 2000 ms)
+// #define LCD_SPARK_PERIOD_MS 2000
+// Print font flash footprint and draw time per glyph at boot
+// #define LCD_BENCHMARK
+#endif
+
+// ==================================================
+// Clock (SNTP)
+// ==================================================
+// POSIX TZ string for the displayed time, e.g. "CET-1CEST,M3.5.0,M10.5.0/3"
+#define CLOCK_TZ "KST-9"
+// #define CLOCK_NTP_SERVER_1 "pool.ntp.org"
+// #define CLOCK_NTP_SERVER_2 "time.nist.gov"
+
+// ==================================================
+// Timing Configuration
+// ==================================================
+#define GPIO_SCAN_INTERVAL 100   // Scan GPIO every 100ms
+#define DATA_SEND_INTERVAL 60000 // Send periodic update every 60s
+
+// ==================================================
+// Logging (see dev_log.h)
+// ==================================================
+// LOG_LEVEL_NONE, _ERROR, _WARN, _INFO or _DEBUG; calls above it are
+// compiled out. DEBUG logs every packet with its payload.
+#define LOG_LEVEL LOG_LEVEL_INFO
+// 1: binary records on Serial, decoded by host/tools/log_decode
+#define LOG_BINARY 0
+
+// Uncomment to time loop() stages and packet handling with the CPU cycle
+// counter (see profiler.h): 'p' on Serial or the app-cmd
+// {"customCmd":"dev-profile"} reports them
+// #define LOOP_PROFILER
+
+// Uncomment to record Socket.IO traffic and input edges for replay on the
+// host (see traffic_trace.h); the trace goes out with the log
+// #define TRAFFIC_TRACE
+
+#endif // CONFIG_H
@@ -0,0 +1,198 @@
+// Deferred logging that is cheap enough to leave on in the field.
+//
+// LOG_ERROR() .. LOG_DEBUG() do not format or touch Serial. They copy a
+// binary record (log_record.h: the format string's address, a timestamp
+// and the raw arguments) into a lock-free ring and return; a task on core 0
+// drains the ring to Serial. Levels above LOG_LEVEL are compiled out,
+// arguments included. Writers reserve space with one compare-and-swap and
+// never wait: when the ring is full the record is dropped and counted.
+//
+// With LOG_BINARY 0 the drain task prints text lines ("12.345 I [AUTH]
+// ..."). With LOG_BINARY 1 it sends the records as binary frames, each
+// format string once (and again every LOG_FORMAT_RESEND_MS, for captures
+// started late); host/tools/log_decode turns a capture back into text.
+//
+// The format must be a string literal: only its address is stored. String
+// arguments are copied, cut to LOG_STR_MAX bytes. The format is checked
+// against the arguments as for printf().
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+#include "config.h"
+#include "log_record.h"
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+#ifndef LOG_BINARY
+#define LOG_BINARY 0
+#endif
+
+#define LOG_RING_BYTES 8192 // a power of two
+#define LOG_RECORD_MAX 256  // bytes per record, longer arguments are cut
+#define LOG_FORMAT_RESEND_MS 60000
+#define LOG_TASK_STACK 4096
+// loop() runs at priority 1 on core 1 and never blocks, so the drainer
+// takes the same priority on the other core; with a single core it is
+// time-sliced with loop() instead of starving at idle priority
+#define LOG_TASK_PRIORITY 1
+#define LOG_TASK_CORE 0
+#define LOG_DRAIN_INTERVAL_MS 20
+
+// Starts the drain task. Records logged before it runs wait in the ring.
+void logBegin();
+
+// Sends every complete record to Serial now; returns how many. The drain
+// task calls this; call it before a restart so nothing is lost.
+size_t logDrain();
+
+// Records dropped because the ring was full, since boot
+uint32_t logDropped();
+// Ring bytes written but not drained yet
+uint32_t logPendingBytes();
+
+// Writes one frame of log_record.h (payload a then b) to Serial; only the
+// drainer may call it, so frames never interleave
+void logSendFrame(uint8_t kind, const void *a, size_t aLength, const void *b, size_t bLength);
+
+// Copies a finished record (the payload of log_record.h without the id)
+// into the ring
+void logCommit(const char *fmt, const uint8_t *payload, size_t length);
+
+// Argument encoding, see log_record.h
+template <typename T>
+constexpr uint8_t logArgType()
+{
+    using U = std::decay_t<T>;
+    if constexpr (std::is_same_v<U, const char *> || std::is_same_v<U, char *>)
+        return LOG_ARG_STR;
+    else if constexpr (std::is_pointer_v<U>)
+        return LOG_ARG_PTR;
+    else if constexpr (std::is_floating_point_v<U>)
+        return LOG_ARG_F64;
+    else if constexpr (std::is_enum_v<U>)
+        return logArgType<std::underlying_type_t<U>>();
+    else
+    {
+        static_assert(std::is_integral_v<U>, "log arguments are integers, floats, strings or pointers");
+        if constexpr (sizeof(U) <= 4)
+            return std::is_signed_v<U> ? LOG_ARG_I32 : LOG_ARG_U32;
+        else
+            return std::is_signed_v<U> ? LOG_ARG_I64 : LOG_ARG_U64;
+    }
+}
+
+// Encoded size without the text of strings
+template <typename T>
+constexpr size_t logArgSize()
+{
+    constexpr uint8_t type = logArgType<T>();
+    return type == LOG_ARG_STR ? 1 : type == LOG_ARG_I32 || type == LOG_ARG_U32 ? 4 : 8;
+}
+
+// Strings take their text out of budget, the record space the fixed-size
+// arguments leave. Arrays are not read past their size.
+inline uint8_t *logPackString(uint8_t *p, size_t &budget, const char *s, size_t size = LOG_STR_MAX)
+{
+    if (!s)
+        s = "(null)";
+    if (size > budget)
+        size = budget;
+    const size_t length = strnlen(s, size < LOG_STR_MAX ? size : LOG_STR_MAX);
+    budget -= length;
+    *p++ = (uint8_t)length;
+    memcpy(p, s, length);
+    return p + length;
+}
+
+template <typename T>
+inline uint8_t *logPack(uint8_t *p, size_t &budget, const T &value)
+{
+    constexpr uint8_t type = logArgType<T>();
+    if constexpr (type == LOG_ARG_STR && std::is_array_v<T>)
+        return logPackString(p, budget, value, sizeof(T));
+    else if constexpr (type == LOG_ARG_STR)
+        return logPackString(p, budget, value);
+    else if constexpr (type == LOG_ARG_PTR)
+    {
+        const uint64_t v = (uint64_t)(uintptr_t)value;
+        memcpy(p, &v, 8);
+        return p + 8;
+    }
+    else if constexpr (type == LOG_ARG_F64)
+    {
+        const double v = value;
+        memcpy(p, &v, 8);
+        return p + 8;
+    }
+    else if constexpr (type == LOG_ARG_I32 || type == LOG_ARG_U32)
+    {
+        const uint32_t v = (uint32_t)value;
+        memcpy(p, &v, 4);
+        return p + 4;
+    }
+    else
+    {
+        const uint64_t v = (uint64_t)value;
+        memcpy(p, &v, 8);
+        return p + 8;
+    }
+}
+
+int64_t logTimeUs();
+
+template <typename... Args>
+void logWrite(uint8_t level, const char *fmt, const Args &...args)
+{
+    constexpr size_t fixed = 10 + sizeof...(Args) + (logArgSize<Args>() + ... + 0);
+    static_assert(fixed <= LOG_RECORD_MAX, "too many log arguments");
+    uint8_t record[LOG_RECORD_MAX];
+    const int64_t now = logTimeUs();
+    memcpy(record, &now, 8);
+    record[8] = level;
+    record[9] = (uint8_t)sizeof...(Args);
+    uint8_t *p = record + 10;
+    ((*p++ = logArgType<Args>()), ...);
+    size_t budget = LOG_RECORD_MAX - fixed;
+    ((p = logPack(p, budget, args)), ...);
+    (void)budget;
+    logCommit(fmt, record, (size_t)(p - record));
+}
+
+// Never called: lets the compiler check the format against the arguments
+inline void logCheckFormat(const char *, ...) __attribute__((format(printf, 1, 2)));
+inline void logCheckFormat(const char *, ...)
+{
+}
+
+#define LOG_AT(level, ...)               \
+    do                                   \
+    {                                    \
+        if (false)                       \
+            logCheckFormat(__VA_ARGS__); \
+        logWrite(level, __VA_ARGS__);    \
+    } while (0)
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) do {} while (0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(...) LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) do {} while (0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...) LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) do {} while (0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) do {} while (0)
+#endif
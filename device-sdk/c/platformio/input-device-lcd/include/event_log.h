@@ -0,0 +1,47 @@
+// Recent device events (connects, commands, edges, errors) for the LCD
+// console page.
+//
+// A fixed ring of EVENT_LOG_SIZE slots that never blocks: writers claim a
+// ticket with one atomic increment and overwrite the oldest slot, and each
+// slot carries a sequence number (odd while being written) that the reader
+// checks before and after copying, seqlock style. A reader that falls
+// behind loses the oldest events and is told how many. eventLog() may be
+// called from any task, not from ISRs (it formats with vsnprintf).
+#pragma once
+
+#include <stdint.h>
+
+#define EVENT_LOG_SIZE 32 // slots, a power of two
+#define EVENT_TEXT_LEN 48 // including the terminator; longer text is cut
+
+enum EventLevel : uint8_t
+{
+    EVENT_INFO,
+    EVENT_WARN,
+    EVENT_ERROR,
+};
+
+struct EventEntry
+{
+    uint32_t seq;    // ticket, counting from 0 since boot
+    uint32_t timeMs; // millis() when logged
+    EventLevel level;
+    char text[EVENT_TEXT_LEN];
+};
+
+// Read position of one consumer
+struct EventCursor
+{
+    uint32_t next; // ticket to read next
+    uint32_t lost; // events overwritten before this cursor reached them
+};
+
+void eventLog(EventLevel level, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+// Tickets issued so far (the next event's seq)
+uint32_t eventLogHead();
+
+// Copies the event at cursor.next into out and advances. Returns false
+// when it is not complete yet; skips (and counts in cursor.lost) events
+// that were overwritten.
+bool eventLogRead(EventCursor &cursor, EventEntry &out);
@@ -0,0 +1,294 @@
+// Packed bitmap fonts for the LCD UI, built at compile time.
+//
+// font_5x9.h holds the source art. The constexpr pipeline below turns it
+// into atlases that live in flash: every glyph is trimmed to its inked
+// columns (digits keep the full cell so numbers do not jitter), optionally
+// upscaled 2x with Scale2x edge smoothing instead of pixel doubling, and
+// packed row-major at 1 or 2 bits per pixel. The 2-bit atlas is
+// anti-aliased: Scale2x is applied twice and the 4x result box-filtered
+// back down to 2x.
+//
+// Text is UTF-8. fontTextWidth() is constexpr as well, so widget layout
+// can be computed from string literals at compile time.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "font_5x9.h"
+
+#define FONT_FIRST_CHAR 32
+#define FONT_GLYPH_COUNT 95
+
+struct FontGlyph
+{
+    uint16_t offset; // bit offset of the glyph's first row in Font::bits
+    uint8_t width;   // columns; rows are Font::height
+};
+
+struct Font
+{
+    uint8_t height;  // rows per glyph, descenders included
+    uint8_t bpp;     // 1, or 2 for anti-aliased coverage (0..3)
+    uint8_t spacing; // blank columns between glyphs
+    const FontGlyph *glyphs;
+    const uint8_t *bits;
+    uint32_t bytes; // flash used by the glyph table and bits together
+};
+
+// Glyph for c; characters outside 32-126 draw as '?'
+constexpr const FontGlyph &fontGlyph(const Font &font, char c)
+{
+    return font.glyphs[((uint8_t)c >= FONT_FIRST_CHAR && (uint8_t)c < FONT_FIRST_CHAR + FONT_GLYPH_COUNT)
+                           ? (uint8_t)c - FONT_FIRST_CHAR
+                           : '?' - FONT_FIRST_CHAR];
+}
+
+// Hangul syllables and compatibility jamo (hangul.h) are drawn at this
+// size in fonts at least this tall; smaller fonts show them as '?'.
+#define FONT_HANGUL_SIZE 16
+
+constexpr bool fontIsHangul(uint32_t cp)
+{
+    return (cp >= 0xAC00 && cp <= 0xD7A3) || (cp >= 0x3131 && cp <= 0x3163);
+}
+
+// Next code point of UTF-8 text, advancing p past it. Malformed or
+// truncated sequences decode as '?' one byte at a time.
+constexpr uint32_t fontNextCodepoint(const char *&p)
+{
+    const uint8_t b0 = (uint8_t)*p++;
+    if (b0 < 0x80)
+        return b0;
+
+    int extra = 0;
+    uint32_t cp = 0;
+    if ((b0 & 0xE0) == 0xC0)
+    {
+        extra = 1;
+        cp = b0 & 0x1F;
+    }
+    else if ((b0 & 0xF0) == 0xE0)
+    {
+        extra = 2;
+        cp = b0 & 0x0F;
+    }
+    else if ((b0 & 0xF8) == 0xF0)
+    {
+        extra = 3;
+        cp = b0 & 0x07;
+    }
+    else
+        return '?';
+
+    for (int i = 0; i < extra; ++i)
+    {
+        if (((uint8_t)p[i] & 0xC0) != 0x80)
+            return '?';
+        cp = (cp << 6) | ((uint8_t)p[i] & 0x3F);
+    }
+    p += extra;
+    return cp;
+}
+
+constexpr int fontCharWidth(const Font &font, uint32_t cp)
+{
+    if (fontIsHangul(cp) && font.height >= FONT_HANGUL_SIZE)
+        return FONT_HANGUL_SIZE;
+    return fontGlyph(font, cp < 0x80 ? (char)cp : '?').width;
+}
+
+// Pixel width of UTF-8 text drawn in font (no trailing spacing)
+constexpr int fontTextWidth(const Font &font, const char *text)
+{
+    int w = 0;
+    for (const char *p = text; *p;)
+    {
+        w += fontCharWidth(font, fontNextCodepoint(p));
+        if (*p)
+            w += font.spacing;
+    }
+    return w;
+}
+
+// Coverage of one glyph pixel: 0/1, or 0..3 for 2 bpp fonts
+constexpr uint8_t fontPixel(const Font &font, const FontGlyph &glyph, int x, int y)
+{
+    const uint32_t bit = glyph.offset + (uint32_t)(y * glyph.width + x) * font.bpp;
+    const uint8_t byte = font.bits[bit >> 3];
+    return (uint8_t)((byte >> (8 - font.bpp - (bit & 7))) & ((1 << font.bpp) - 1));
+}
+
+namespace fontgen
+{
+    constexpr int SRC_W = 5;
+    constexpr int SRC_H = 9;
+    constexpr int SPACE_WIDTH = 3;
+    constexpr int MAX_SCALE = 4; // largest intermediate raster (AA path)
+
+    enum Style : uint8_t
+    {
+        STYLE_1X,    // source pixels, 1 bpp
+        STYLE_2X,    // Scale2x, 1 bpp
+        STYLE_2X_AA, // Scale2x twice, 2x2 box filter, 2 bpp
+    };
+
+    struct Raster
+    {
+        int w = 0;
+        int h = 0;
+        uint8_t px[SRC_W * MAX_SCALE * SRC_H * MAX_SCALE] = {};
+
+        constexpr uint8_t at(int x, int y) const
+        {
+            return (x < 0 || y < 0 || x >= w || y >= h) ? 0 : px[y * w + x];
+        }
+        constexpr void set(int x, int y, uint8_t v) { px[y * w + x] = v; }
+    };
+
+    constexpr Raster source(const char *const (&art)[SRC_H], int index)
+    {
+        const char c = (char)(FONT_FIRST_CHAR + index);
+        int first = SRC_W, last = -1;
+        for (int y = 0; y < SRC_H; ++y)
+            for (int x = 0; x < SRC_W; ++x)
+                if (art[y][x] == '#')
+                {
+                    first = x < first ? x : first;
+                    last = x > last ? x : last;
+                }
+
+        if (c >= '0' && c <= '9')
+        {
+            first = 0;
+            last = SRC_W - 1;
+        }
+        else if (last < 0)
+        {
+            first = 0;
+            last = SPACE_WIDTH - 1;
+        }
+
+        Raster r;
+        r.w = last - first + 1;
+        r.h = SRC_H;
+        for (int y = 0; y < r.h; ++y)
+            for (int x = 0; x < r.w; ++x)
+                r.set(x, y, art[y][first + x] == '#' ? 1 : 0);
+        return r;
+    }
+
+    // Scale2x (EPX): each pixel becomes 2x2, with corners taken from the
+    // neighbours where two of them agree, which rounds off diagonals.
+    constexpr Raster scale2x(const Raster &in)
+    {
+        Raster out;
+        out.w = in.w * 2;
+        out.h = in.h * 2;
+        for (int y = 0; y < in.h; ++y)
+            for (int x = 0; x < in.w; ++x)
+            {
+                const uint8_t p = in.at(x, y);
+                const uint8_t a = in.at(x, y - 1), b = in.at(x + 1, y);
+                const uint8_t c = in.at(x - 1, y), d = in.at(x, y + 1);
+                out.set(2 * x, 2 * y, (c == a && c != d && a != b) ? a : p);
+                out.set(2 * x + 1, 2 * y, (a == b && a != c && b != d) ? b : p);
+                out.set(2 * x, 2 * y + 1, (d == c && d != b && c != a) ? c : p);
+                out.set(2 * x + 1, 2 * y + 1, (b == d && b != a && d != c) ? d : p);
+            }
+        return out;
+    }
+
+    // 2x2 box filter of a 1 bpp raster into 2-bit coverage
+    constexpr Raster downsample2(const Raster &in)
+    {
+        Raster out;
+        out.w = in.w / 2;
+        out.h = in.h / 2;
+        for (int y = 0; y < out.h; ++y)
+            for (int x = 0; x < out.w; ++x)
+            {
+                const int ink = in.at(2 * x, 2 * y) + in.at(2 * x + 1, 2 * y) + in.at(2 * x, 2 * y + 1) +
+                                in.at(2 * x + 1, 2 * y + 1);
+                out.set(x, y, (uint8_t)(ink > 3 ? 3 : ink));
+            }
+        return out;
+    }
+
+    constexpr Raster render(const char *const (&art)[FONT_GLYPH_COUNT][SRC_H], int index, Style style)
+    {
+        const Raster src = source(art[index], index);
+        if (style == STYLE_1X)
+            return src;
+        if (style == STYLE_2X)
+            return scale2x(src);
+        return downsample2(scale2x(scale2x(src)));
+    }
+
+    constexpr int bppOf(Style style) { return style == STYLE_2X_AA ? 2 : 1; }
+    constexpr int heightOf(Style style) { return style == STYLE_1X ? SRC_H : SRC_H * 2; }
+    constexpr int spacingOf(Style style) { return style == STYLE_1X ? 1 : 2; }
+
+    constexpr uint32_t atlasBytes(const char *const (&art)[FONT_GLYPH_COUNT][SRC_H], Style style)
+    {
+        uint32_t bits = 0;
+        for (int i = 0; i < FONT_GLYPH_COUNT; ++i)
+        {
+            const Raster r = render(art, i, style);
+            bits += (uint32_t)(r.w * r.h * bppOf(style));
+        }
+        return (bits + 7) / 8;
+    }
+
+    template <uint32_t Bytes>
+    struct Atlas
+    {
+        FontGlyph glyphs[FONT_GLYPH_COUNT] = {};
+        uint8_t bits[Bytes] = {};
+    };
+
+    // Glyph rows are packed back to back, MSB first, with no padding
+    template <uint32_t Bytes>
+    constexpr Atlas<Bytes> buildAtlas(const char *const (&art)[FONT_GLYPH_COUNT][SRC_H], Style style)
+    {
+        static_assert(Bytes * 8 <= 0x10000, "glyph offsets are 16-bit");
+        Atlas<Bytes> atlas;
+        const int bpp = bppOf(style);
+        uint32_t bit = 0;
+        for (int i = 0; i < FONT_GLYPH_COUNT; ++i)
+        {
+            const Raster r = render(art, i, style);
+            atlas.glyphs[i].offset = (uint16_t)bit;
+            atlas.glyphs[i].width = (uint8_t)r.w;
+            for (int y = 0; y < r.h; ++y)
+                for (int x = 0; x < r.w; ++x)
+                {
+                    const uint8_t v = r.at(x, y);
+                    atlas.bits[bit >> 3] |= (uint8_t)(v << (8 - bpp - (bit & 7)));
+                    bit += bpp;
+                }
+        }
+        return atlas;
+    }
+
+    template <uint32_t Bytes>
+    constexpr Font makeFont(const Atlas<Bytes> &atlas, Style style)
+    {
+        return {(uint8_t)heightOf(style), (uint8_t)bppOf(style), (uint8_t)spacingOf(style),
+                atlas.glyphs, atlas.bits, (uint32_t)sizeof(Atlas<Bytes>)};
+    }
+}
+
+#define FONT_ATLAS(name, style)                                                                 \
+    inline constexpr auto name##_ATLAS =                                                        \
+        fontgen::buildAtlas<fontgen::atlasBytes(FONT_5X9_ART, style)>(FONT_5X9_ART, style);     \
+    inline constexpr Font name = fontgen::makeFont(name##_ATLAS, style)
+
+// 5x9 cell, 1 bpp
+FONT_ATLAS(FONT_SMALL, fontgen::STYLE_1X);
+// 10x18 cell, 1 bpp, smoothed diagonals
+FONT_ATLAS(FONT_LARGE, fontgen::STYLE_2X);
+// 10x18 cell, 2 bpp anti-aliased
+FONT_ATLAS(FONT_LARGE_AA, fontgen::STYLE_2X_AA);
+
+#undef FONT_ATLAS
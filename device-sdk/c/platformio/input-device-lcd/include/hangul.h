@@ -0,0 +1,45 @@
+// Hangul glyphs composed from jamo.
+//
+// Flash holds only stroke outlines of 14 base consonants and 14 base
+// vowels (2 bytes per stroke). A syllable is decomposed into initial,
+// medial and final jamo, doubled and compound jamo are split into two
+// base shapes, and the strokes are rasterized into a layout chosen by the
+// vowel's orientation and whether there is a final. Every modern syllable
+// (U+AC00-U+D7A3) and compatibility jamo (U+3131-U+3163) is covered.
+//
+// Rasterized glyphs are kept in a small LRU cache in RAM, so repeated
+// labels cost a lookup instead of a rasterization.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config.h"
+#include "font.h"
+
+// Glyphs kept rasterized (64 bytes each). Must cover one screen-wide line
+// of Hangul, since a draw call holds all of its glyphs at once.
+#ifndef LCD_HANGUL_CACHE
+#define LCD_HANGUL_CACHE 24
+#endif
+
+#define HANGUL_GLYPH_BYTES (FONT_HANGUL_SIZE * FONT_HANGUL_SIZE * 2 / 8)
+
+struct HangulCacheStats
+{
+    uint32_t hits;
+    uint32_t misses; // each one a rasterization
+    uint32_t evictions;
+};
+
+// FONT_HANGUL_SIZE square glyph for cp as 2-bit coverage (0..3), rows
+// packed MSB first, or nullptr when cp is not Hangul. Without antialias
+// the coverage is 0 or 3. The pointer stays valid until
+// LCD_HANGUL_CACHE other glyphs have been requested.
+const uint8_t *hangulGlyph(uint32_t cp, bool antialias);
+
+const HangulCacheStats &hangulCacheStats();
+void hangulCacheClear(); // drops every glyph and zeroes the stats
+
+// Flash used by the stroke and jamo tables
+size_t hangulFlashBytes();
@@ -0,0 +1,40 @@
+// Bounded snprintf writer for JSON reports built without ArduinoJson
+// (dev-metrics, dev-profile).
+#pragma once
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// snprintf that tracks the running length and turns overflow into a
+// sticky failure
+struct JsonOut
+{
+    char *out;
+    size_t size;
+    size_t length;
+    bool full;
+
+    void put(const char *fmt, ...) __attribute__((format(printf, 2, 3)))
+    {
+        if (full)
+            return;
+        va_list args;
+        va_start(args, fmt);
+        const int n = vsnprintf(out + length, size - length, fmt, args);
+        va_end(args);
+        if (n < 0 || (size_t)n >= size - length)
+            full = true;
+        else
+            length += n;
+    }
+
+    // Length written, or 0 with out emptied if it did not fit
+    size_t finish()
+    {
+        if (!full)
+            return length;
+        out[0] = '\0';
+        return 0;
+    }
+};
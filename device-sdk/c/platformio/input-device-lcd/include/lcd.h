@@ -6,9 +6,17 @@
 
 #ifdef HAS_LCD_240x320
 
+// Drawing calls are composed off-screen and only reach the panel on
+// flush(): into a full-frame sprite in PSRAM when the module has it,
+// otherwise recorded and replayed into two banded strips in internal RAM.
+// Either way the panel only ever receives finished pixels, pushed with DMA
+// while the caller goes on composing the next frame.
 class LCD
 {
 public:
+    static const int16_t WIDTH = 240;
+    static const int16_t HEIGHT = 320;
+
     static void begin();
     static void setBacklight(uint8_t level); // 0..255
     static void fillScreen(uint16_t color);
@@ -17,6 +25,34 @@ public:
     static void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
     static void setRotation(uint8_t rot); // 0-3
 
+    // Push a w*h block of RGB565 pixels (native byte order, row-major).
+    static void pushPixels(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t *pixels);
+
+    // Streamed variant of pushPixels: open one address window, feed it in
+    // chunks of row-major pixels, then close it.
+    static void beginPixels(int16_t x, int16_t y, int16_t w, int16_t h);
+    static void writePixels(const uint16_t *pixels, uint32_t count);
+    static void endPixels();
+
+    // Send everything drawn since the last flush. Returns once the last
+    // strip is queued for DMA; the transfer finishes in the background.
+    static void flush();
+
+    // Block until the last DMA transfer has completed.
+    static void waitIdle();
+
+    // Hardware vertical scrolling (ST7789 VSCRDEF/VSCSAD). Rows [top,
+    // top + height) become a ring: screen row top + i shows framebuffer
+    // row top + (i + offset) % height. Drawing coordinates stay framebuffer
+    // rows. Sent right away (after any DMA in flight), so flush() what
+    // should be visible first. setScrollArea(0, HEIGHT) restores the
+    // normal display. Rotation 0 or 2 only, like the compositor.
+    static void setScrollArea(int16_t top, int16_t height);
+    static void setScrollOffset(int16_t offset);
+
+    // SPI write clock in use (calibrated or stored when LCD_SPI_CALIBRATE is set)
+    static uint32_t writeClock();
+
 private:
     static void writeCommand(uint8_t cmd);
     static void writeData(uint8_t data);
@@ -4,6 +4,7 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include "config.h"
+#include "font.h"
 
 #ifdef HAS_LCD_240x320
 
@@ -13,15 +14,88 @@ struct UiSnapshot
     int wifiRssi; // dBm, valid only when wifiConnected is true
     bool socketConnected;
     bool sensors[SENSOR_COUNT]; // true = ON/active
-    String dateText;            // e.g., "2026-02-13"
-    String timeText;            // e.g., "10:24:30"
+    const char *dateText;       // e.g., "2026-02-13"
+    const char *timeText;       // e.g., "10:24:30"
     IPAddress ip;
 };
 
-// Initialize the LCD surface and paint the static chrome.
+struct UiRect
+{
+    int16_t x;
+    int16_t y;
+    int16_t w;
+    int16_t h;
+};
+
+// Cost of the most recent lcdUiRender() call.
+struct UiFrameStats
+{
+    uint16_t widgetsRedrawn; // up to UI_WIDGET_COUNT, over 255 with large SENSOR_COUNT
+    uint32_t redrawArea; // pixels covered by the union of redrawn widget bounds (console: new lines)
+};
+
+enum UiPage : uint8_t
+{
+    UI_PAGE_DASHBOARD,
+    UI_PAGE_CONSOLE, // recent events from event_log.h, newest at the bottom
+    UI_PAGE_QR,      // the serial as a QR code, for registering the device
+};
+
+// Switch pages; the console and QR pages are drawn right away, the
+// dashboard on the next render.
+void lcdUiSetPage(UiPage page);
+UiPage lcdUiPage();
+
+// Serial shown on the QR page: DEVICE_SN (encoded at compile time) unless
+// set here, e.g. to a serial provisioned into NVS, which is encoded on the
+// spot.
+void lcdUiSetSerial(const char *serial);
+
+// True while the console is shown and events are waiting to be drawn, so
+// the loop can render without waiting for the next refresh tick.
+bool lcdUiConsolePending();
+
+// Clear the LCD surface and mark every widget for redraw on the next render.
 void lcdUiInit();
 
-// Render / refresh the LCD UI with the provided snapshot.
+// Render / refresh the LCD UI with the provided snapshot. Only widgets
+// whose displayed state changed since the last call are redrawn; on the
+// console page only new event lines are.
 void lcdUiRender(const UiSnapshot &state);
 
+const UiFrameStats &lcdUiLastFrameStats();
+
+// Draw text in font at (x, y) as one window at least boxW pixels wide;
+// everything in it that is not ink is painted bg. Size boxes for the
+// widest value with fontTextWidth(), which works at compile time.
+void lcdDrawTextFont(const Font &font, const char *text, int x, int y, uint16_t color, uint16_t bg, int boxW = 0);
+
+// Largest decoded chunk of a streamed image one app-cmd may carry
+#define LCD_IMAGE_CHUNK_BYTES 2048
+
+struct LcdImageStats
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t encodedBytes; // QOI bytes received so far
+    uint32_t micros;       // decoding and drawing, flush included
+    bool done;
+};
+
+// Streams a QOI image (qoi_stream.h) onto the current page with its top
+// left at (x, y), drawing rows as their chunks arrive. Images are at most
+// LCD::WIDTH wide; the page's next full redraw paints over them.
+void lcdImageBegin(int x, int y);
+// Feeds the next encoded bytes. Returns false once the stream is invalid
+// or no image was begun; true otherwise, including after the last pixel.
+bool lcdImageWrite(const uint8_t *data, size_t len);
+const LcdImageStats &lcdImageStats();
+// Static RAM the image path uses (band buffer and decoder state)
+size_t lcdImageRamBytes();
+
+#ifdef LCD_BENCHMARK
+// Print each font's flash footprint and draw time per glyph to Serial
+void lcdFontReport();
+#endif
+
 #endif // HAS_LCD_240x320
\ No newline at end of file
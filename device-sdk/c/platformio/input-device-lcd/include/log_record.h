@@ -0,0 +1,72 @@
+// Binary log records and the frames they travel in, shared by the device
+// logger (dev_log.h) and the host decoder (host/tools/log_decode.cpp).
+//
+// A record is the format string's id plus the raw arguments; the text is
+// only produced where it is read. Payload layout:
+//
+//   int64  timeUs     esp_timer time when logged
+//   uint8  level      LOG_LEVEL_*
+//   uint8  nargs
+//   uint8  types[nargs]
+//   args              4 bytes for 32-bit integers, 8 for 64-bit integers,
+//                     doubles and pointers, strings as a length byte and
+//                     the bytes without terminator
+//
+// All little-endian. On the serial line each piece is a frame:
+//
+//   0xA5, kind, uint16 length, payload[length], checksum (xor of payload)
+//
+// LOG_FRAME_FORMAT  uint32 id, format text     sent before first use
+// LOG_FRAME_RECORD  uint32 id, record payload
+// LOG_FRAME_LOST    uint32 records dropped because the ring was full
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+#define LOG_FRAME_SYNC 0xA5
+#define LOG_FRAME_FORMAT 'F'
+#define LOG_FRAME_RECORD 'R'
+#define LOG_FRAME_LOST 'L'
+
+#define LOG_STR_MAX 160 // string arguments are cut to this many bytes
+
+enum LogArgType : uint8_t
+{
+    LOG_ARG_I32,
+    LOG_ARG_U32,
+    LOG_ARG_I64,
+    LOG_ARG_U64,
+    LOG_ARG_F64,
+    LOG_ARG_STR,
+    LOG_ARG_PTR,
+};
+
+// A parsed record payload; points into the buffer it was parsed from
+struct LogRecordView
+{
+    int64_t timeUs;
+    uint8_t level;
+    uint8_t nargs;
+    const uint8_t *types;
+    const uint8_t *args;
+    size_t argsLength;
+};
+
+// False if the payload is truncated or malformed
+bool logParseRecord(const uint8_t *payload, size_t length, LogRecordView &out);
+
+// printf() of fmt with the record's arguments into out (always
+// terminated). Length modifiers in fmt are ignored: each conversion takes
+// the next argument at the size it was recorded with. A missing or
+// mismatched argument prints as "<?>". Returns the length written.
+size_t logFormat(char *out, size_t size, const char *fmt, const LogRecordView &record);
+
+// 'E', 'W', 'I', 'D', or '?'
+char logLevelLetter(uint8_t level);
@@ -32,9 +32,25 @@ void handleSocketIOPacket(const char *packet, size_t length);
 void sendPacket(const char *type, const String &data = "");
 void emitDevData();
 void emitDevStatus(const String &status);
+void setupMetrics();
+void serviceMetrics();
+// Periodic reports start a new histogram interval, on-demand ones do not
+void emitDevMetrics(bool onDemand);
+#ifdef LOOP_PROFILER
+void emitDevProfile(bool reset);
+#endif
 bool scanGpioInputs();
+void serverClockConnected();
+void serviceServerClock();
+void handleServerTimeAck(uint32_t id, int64_t serverMs);
+// Server time now and a bound on its error, false until the first sample
+bool serverTimeMs(int64_t &nowMs, uint32_t &uncertaintyMs);
+#ifdef HAS_LCD_240x320
+void handleImageChunk(int32_t seq, int x, int y, const char *data);
+#endif
 
-// LCD helper (prototype)
-void lcdDrawText(const char *text, int x, int y, uint16_t color, uint8_t scale = 2);
+// LCD helper: draws text with its background in one windowed write.
+// scale 1 uses the 5x9 font, 2 and up the 10x18 one (see font.h).
+void lcdDrawText(const char *text, int x, int y, uint16_t color, uint16_t bg, uint8_t scale = 2);
 
 #endif // MAIN_H
\ No newline at end of file
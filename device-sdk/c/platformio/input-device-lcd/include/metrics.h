@@ -0,0 +1,64 @@
+// Device health metrics: counters, gauges and fixed-bucket histograms,
+// reported as the dev-metrics Socket.IO event.
+//
+// Metrics are registered once during setup() into a fixed table of
+// METRICS_MAX entries; registration is not thread-safe, updates are. An
+// update is one or a few relaxed atomic operations on 32-bit words (the
+// ESP32 has no lock-free 64-bit atomics) and never blocks, so it may be
+// called from any task. Histograms count values into buckets by ascending
+// upper bounds, plus one bucket above the last bound, and keep the count,
+// sum and maximum of the current report interval.
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+#define METRICS_MAX 16
+#define METRIC_BOUNDS_MAX 12
+
+enum MetricType : uint8_t
+{
+    METRIC_COUNTER,   // total since boot
+    METRIC_GAUGE,     // last value set
+    METRIC_HISTOGRAM, // distribution since the last report
+};
+
+struct Metric
+{
+    const char *name;
+    MetricType type;
+    uint8_t boundCount;
+    const uint32_t *bounds; // histograms: ascending inclusive upper bounds
+    std::atomic<int32_t> value;
+    std::atomic<uint32_t> count;
+    std::atomic<uint32_t> sum;
+    std::atomic<uint32_t> max;
+    std::atomic<uint32_t> buckets[METRIC_BOUNDS_MAX + 1];
+};
+
+// Register a metric. name and bounds must stay valid (literals, static
+// arrays). With the table full, updates go to a shared metric that is
+// never reported.
+Metric *metricCounter(const char *name);
+Metric *metricGauge(const char *name);
+Metric *metricHistogram(const char *name, const uint32_t *bounds, uint8_t boundCount);
+
+inline void metricAdd(Metric *m, int32_t n = 1)
+{
+    m->value.fetch_add(n, std::memory_order_relaxed);
+}
+
+inline void metricSet(Metric *m, int32_t value)
+{
+    m->value.store(value, std::memory_order_relaxed);
+}
+
+void metricObserve(Metric *m, uint32_t value);
+
+// Writes all metrics as one JSON object into out (always terminated):
+// counters and gauges as numbers, histograms as
+// {"n":count,"sum":sum,"max":max,"b":[bucket counts]}, plus "le":[bounds]
+// when withBounds is set. resetHistograms starts a new interval. Returns
+// the length, or 0 if out was too small.
+size_t metricsJson(char *out, size_t size, bool withBounds, bool resetHistograms);
@@ -0,0 +1,107 @@
+// Cycle-counting profiler for named stages of loop() and the packet
+// handlers.
+//
+// PROFILE_SCOPE("name") times the rest of the enclosing block with the CPU
+// cycle counter (CCOUNT on the ESP32) and folds the result into the
+// stage's row of a fixed table: count, min, max, sum and a log-linear
+// histogram (four buckets per power of two, so percentiles are within
+// 19%). Stages register on first use, in that order. Scopes may nest;
+// each stage counts its inclusive time.
+//
+// Only the loop task may run profiled code: rows are plain integers. A
+// stage longer than the 32-bit cycle counter's period (17.9 s at 240 MHz)
+// is misreported.
+//
+// Without LOOP_PROFILER in config.h, PROFILE_SCOPE compiles to nothing and
+// the table does not exist. On the host, "cycles" are nanoseconds.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config.h"
+
+#ifdef LOOP_PROFILER
+
+#if defined(ESP_PLATFORM) && !defined(__XTENSA__)
+#include <Esp.h>
+#elif !defined(ESP_PLATFORM)
+#include <time.h>
+#endif
+
+#define PROFILE_STAGES_MAX 12
+#define PROFILE_MIN_CYCLES_LOG2 6 // samples below 64 cycles share bucket 0
+#define PROFILE_BUCKETS (1 + (32 - PROFILE_MIN_CYCLES_LOG2) * 4)
+#define PROFILE_REPORT_MAX 1024
+
+static inline uint32_t profileCycles()
+{
+#if defined(__XTENSA__)
+    uint32_t ccount;
+    __asm__ __volatile__("rsr %0, ccount" : "=a"(ccount));
+    return ccount;
+#elif defined(ESP_PLATFORM)
+    return ESP.getCycleCount();
+#else
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec);
+#endif
+}
+
+struct ProfileStats
+{
+    const char *name;
+    uint32_t count;
+    uint32_t min; // cycles
+    uint32_t avg;
+    uint32_t max;
+    uint32_t p99; // upper bound of the bucket holding the 99th percentile, at most max
+};
+
+// Index of a stage, registered on the first call with a new name. Past
+// PROFILE_STAGES_MAX, samples go to a row that is never reported.
+uint8_t profileStage(const char *name);
+void profileRecord(uint8_t stage, uint32_t cycles);
+
+// Stage count and per-stage figures since boot or the last reset
+uint8_t profileStageCount();
+bool profileStats(uint8_t stage, ProfileStats &out);
+void profileReset();
+// CPU cycles per microsecond (the clock may be changed at run time)
+uint32_t profileCyclesPerUs();
+
+// Writes {"mhz":m,"s":{"<stage>":{"n":..,"min":..,"avg":..,"max":..,"p99":..}}}
+// in cycles into out (always terminated). Returns the length, or 0 if out
+// was too small.
+size_t profileJson(char *out, size_t size);
+// One LOG_INFO line per stage, in microseconds
+void profileLog();
+// Reports with profileLog() when 'p' arrives on Serial, resets on 'r';
+// call from loop()
+void profileService();
+
+class ProfileScope
+{
+public:
+    explicit ProfileScope(uint8_t stage) : stage(stage), start(profileCycles()) {}
+    ~ProfileScope() { profileRecord(stage, profileCycles() - start); }
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+
+private:
+    uint8_t stage;
+    uint32_t start;
+};
+
+#define PROFILE_CAT2(a, b) a##b
+#define PROFILE_CAT(a, b) PROFILE_CAT2(a, b)
+#define PROFILE_SCOPE(name)                                                        \
+    static const uint8_t PROFILE_CAT(profileStage_, __LINE__) = profileStage(name); \
+    ProfileScope PROFILE_CAT(profileScope_, __LINE__)(PROFILE_CAT(profileStage_, __LINE__))
+
+#else
+
+#define PROFILE_SCOPE(name) ((void)0)
+
+#endif // LOOP_PROFILER
@@ -0,0 +1,43 @@
+// Streaming QOI decoder (https://qoiformat.org) for images pushed to the LCD.
+//
+// Encoded bytes can arrive in chunks of any size: an op split across two
+// chunks is held in the state until the rest arrives. Pixels come out as
+// native RGB565, alpha blended over a fixed background, into whatever
+// buffer the caller provides, so an image never needs more RAM than the
+// caller's line buffer plus this state (about 300 bytes).
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define QOI_HEADER_BYTES 14
+
+enum QoiStatus : uint8_t
+{
+    QOI_HEADER,  // waiting for the rest of the header
+    QOI_PIXELS,  // header parsed, pixels pending
+    QOI_DONE,    // every pixel decoded (the end marker is not required)
+    QOI_INVALID, // bad magic or size; the stream is ignored from here on
+};
+
+struct QoiStream
+{
+    QoiStatus status;
+    uint32_t width;
+    uint32_t height;
+    uint32_t pixelsLeft;
+    uint16_t background; // RGB565 that transparent pixels blend over
+
+    uint8_t px[4];         // previous pixel, RGBA
+    uint8_t index[64][4];  // recently seen pixels
+    uint8_t pending[QOI_HEADER_BYTES]; // header or op split across chunks
+    uint8_t pendingLen;
+    uint8_t run; // repeats of px still to emit
+};
+
+void qoiStreamBegin(QoiStream &s, uint16_t background);
+
+// Decodes from data (advancing it and shrinking len) into out, up to
+// maxPixels. Returns the pixels written; 0 with len > 0 left means the
+// stream is done or invalid.
+size_t qoiStreamDecode(QoiStream &s, const uint8_t *&data, size_t &len, uint16_t *out, size_t maxPixels);
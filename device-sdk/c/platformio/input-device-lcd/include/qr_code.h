@@ -0,0 +1,389 @@
+// QR codes (ISO/IEC 18004) for the device serial, built at compile time.
+//
+// qrEncode() is constexpr from segment encoding through Reed-Solomon and
+// mask selection, so the code for DEVICE_SN is a packed bitmap in flash
+// and costs nothing at boot. The same function runs on the device for a
+// serial that is only known at run time (e.g. provisioned into NVS).
+//
+// Versions 1-6 at error correction level M: up to 154 alphanumeric
+// characters (0-9, A-Z, space, $%*+-./:) or 106 bytes of anything else,
+// plenty for a serial. Alphanumeric mode is used when the text allows it,
+// so a 22-character hex serial fits version 2 (25x25 modules).
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define QR_MAX_VERSION 6
+#define QR_MAX_SIZE (17 + 4 * QR_MAX_VERSION)
+#define QR_ROW_BYTES ((QR_MAX_SIZE + 7) / 8)
+#define QR_QUIET_ZONE 4 // light modules required around the symbol
+
+struct QrCode
+{
+    uint8_t size = 0; // modules per side; 0 when the text does not fit
+    uint8_t mask = 0;
+    uint8_t rows[QR_MAX_SIZE][QR_ROW_BYTES] = {}; // MSB first, 1 = dark
+
+    constexpr bool dark(int x, int y) const
+    {
+        return (rows[y][x >> 3] >> (7 - (x & 7))) & 1;
+    }
+};
+
+namespace qrgen
+{
+    constexpr int MAX_DATA_BYTES = 108;  // version 6-M
+    constexpr int MAX_BLOCK_BYTES = 72; // longest block, data and ECC (version 3-M)
+
+    // Level M: ECC codewords per block and block count for versions 1-6
+    constexpr uint8_t ECC_PER_BLOCK[QR_MAX_VERSION + 1] = {0, 10, 16, 26, 18, 24, 16};
+    constexpr uint8_t BLOCKS[QR_MAX_VERSION + 1] = {0, 1, 1, 1, 2, 2, 4};
+    constexpr uint8_t FORMAT_LEVEL_M = 0; // ECC level as coded in the format bits
+
+    // Codewords that fit the data area (no version information below 7)
+    constexpr int rawCodewords(int version)
+    {
+        const int size = 17 + 4 * version;
+        int modules = size * size - 3 * 64 - 2 * (size - 16); // finders, separators, format, timing
+        if (version >= 2)
+            modules -= 25; // one alignment pattern
+        return (modules - 31) / 8; // 31 = format bits and the dark module
+    }
+
+    constexpr int dataCodewords(int version)
+    {
+        return rawCodewords(version) - ECC_PER_BLOCK[version] * BLOCKS[version];
+    }
+
+    constexpr int alnumValue(char c)
+    {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'A' && c <= 'Z')
+            return c - 'A' + 10;
+        const char symbols[] = " $%*+-./:";
+        for (int i = 0; symbols[i]; ++i)
+            if (symbols[i] == c)
+                return 36 + i;
+        return -1;
+    }
+
+    struct BitWriter
+    {
+        uint8_t bytes[MAX_DATA_BYTES] = {};
+        int bits = 0;
+
+        constexpr void put(uint32_t value, int count)
+        {
+            for (int i = count - 1; i >= 0; --i, ++bits)
+                bytes[bits >> 3] |= (uint8_t)(((value >> i) & 1) << (7 - (bits & 7)));
+        }
+    };
+
+    // GF(2^8) with the QR polynomial x^8 + x^4 + x^3 + x^2 + 1
+    constexpr uint8_t gfMultiply(uint8_t x, uint8_t y)
+    {
+        int z = 0;
+        for (int i = 7; i >= 0; --i)
+        {
+            z = (z << 1) ^ ((z >> 7) * 0x11D);
+            z ^= ((y >> i) & 1) * x;
+        }
+        return (uint8_t)z;
+    }
+
+    // ECC of data: remainder of data(x) * x^degree over the generator
+    // polynomial (x - 2^0)(x - 2^1)...(x - 2^(degree-1))
+    constexpr void reedSolomon(const uint8_t *data, int len, int degree, uint8_t *ecc)
+    {
+        uint8_t generator[32] = {};
+        generator[degree - 1] = 1;
+        uint8_t root = 1;
+        for (int i = 0; i < degree; ++i)
+        {
+            for (int j = 0; j < degree; ++j)
+            {
+                generator[j] = gfMultiply(generator[j], root);
+                if (j + 1 < degree)
+                    generator[j] ^= generator[j + 1];
+            }
+            root = gfMultiply(root, 0x02);
+        }
+
+        for (int i = 0; i < degree; ++i)
+            ecc[i] = 0;
+        for (int i = 0; i < len; ++i)
+        {
+            const uint8_t factor = data[i] ^ ecc[0];
+            for (int j = 0; j + 1 < degree; ++j)
+                ecc[j] = ecc[j + 1];
+            ecc[degree - 1] = 0;
+            for (int j = 0; j < degree; ++j)
+                ecc[j] ^= gfMultiply(generator[j], factor);
+        }
+    }
+
+    struct Builder
+    {
+        QrCode qr;
+        QrCode reserved; // function patterns, never masked
+
+        constexpr void set(QrCode &m, int x, int y, bool dark)
+        {
+            const uint8_t bit = (uint8_t)(0x80 >> (x & 7));
+            m.rows[y][x >> 3] = dark ? (uint8_t)(m.rows[y][x >> 3] | bit) : (uint8_t)(m.rows[y][x >> 3] & ~bit);
+        }
+
+        constexpr void setFunction(int x, int y, bool dark)
+        {
+            set(qr, x, y, dark);
+            set(reserved, x, y, true);
+        }
+
+        constexpr void finder(int cx, int cy)
+        {
+            for (int dy = -4; dy <= 4; ++dy)
+                for (int dx = -4; dx <= 4; ++dx)
+                {
+                    const int x = cx + dx, y = cy + dy;
+                    const int adx = dx < 0 ? -dx : dx, ady = dy < 0 ? -dy : dy;
+                    const int dist = adx > ady ? adx : ady;
+                    if (x >= 0 && y >= 0 && x < qr.size && y < qr.size)
+                        setFunction(x, y, dist != 2 && dist != 4);
+                }
+        }
+
+        constexpr void formatBits(int mask)
+        {
+            const int data = FORMAT_LEVEL_M << 3 | mask;
+            int rem = data;
+            for (int i = 0; i < 10; ++i)
+                rem = (rem << 1) ^ ((rem >> 9) * 0x537);
+            const int bits = (data << 10 | rem) ^ 0x5412;
+            const int n = qr.size;
+
+            for (int i = 0; i <= 5; ++i)
+                setFunction(8, i, (bits >> i) & 1);
+            setFunction(8, 7, (bits >> 6) & 1);
+            setFunction(8, 8, (bits >> 7) & 1);
+            setFunction(7, 8, (bits >> 8) & 1);
+            for (int i = 9; i < 15; ++i)
+                setFunction(14 - i, 8, (bits >> i) & 1);
+
+            for (int i = 0; i < 8; ++i)
+                setFunction(n - 1 - i, 8, (bits >> i) & 1);
+            for (int i = 8; i < 15; ++i)
+                setFunction(8, n - 15 + i, (bits >> i) & 1);
+            setFunction(8, n - 8, true); // dark module
+        }
+
+        constexpr void functionPatterns(int version)
+        {
+            const int n = qr.size;
+            for (int i = 0; i < n; ++i)
+            {
+                setFunction(6, i, i % 2 == 0);
+                setFunction(i, 6, i % 2 == 0);
+            }
+            finder(3, 3);
+            finder(n - 4, 3);
+            finder(3, n - 4);
+            if (version >= 2)
+            {
+                const int c = n - 7;
+                for (int dy = -2; dy <= 2; ++dy)
+                    for (int dx = -2; dx <= 2; ++dx)
+                    {
+                        const int adx = dx < 0 ? -dx : dx, ady = dy < 0 ? -dy : dy;
+                        setFunction(c + dx, c + dy, (adx > ady ? adx : ady) != 1);
+                    }
+            }
+            formatBits(0); // reserves the area; rewritten once the mask is chosen
+        }
+
+        // Codewords in the two-column zigzag from the bottom right corner
+        constexpr void place(const uint8_t *codewords, int count)
+        {
+            const int n = qr.size;
+            int i = 0;
+            for (int right = n - 1; right >= 1; right -= 2)
+            {
+                if (right == 6)
+                    right = 5; // skip the vertical timing pattern
+                for (int vert = 0; vert < n; ++vert)
+                    for (int j = 0; j < 2; ++j)
+                    {
+                        const int x = right - j;
+                        const bool upward = ((right + 1) & 2) == 0;
+                        const int y = upward ? n - 1 - vert : vert;
+                        if (!reserved.dark(x, y) && i < count * 8)
+                        {
+                            set(qr, x, y, (codewords[i >> 3] >> (7 - (i & 7))) & 1);
+                            ++i;
+                        }
+                    }
+            }
+        }
+
+        constexpr void applyMask(int mask)
+        {
+            for (int y = 0; y < qr.size; ++y)
+                for (int x = 0; x < qr.size; ++x)
+                {
+                    bool invert = false;
+                    switch (mask)
+                    {
+                    case 0: invert = (x + y) % 2 == 0; break;
+                    case 1: invert = y % 2 == 0; break;
+                    case 2: invert = x % 3 == 0; break;
+                    case 3: invert = (x + y) % 3 == 0; break;
+                    case 4: invert = (x / 3 + y / 2) % 2 == 0; break;
+                    case 5: invert = x * y % 2 + x * y % 3 == 0; break;
+                    case 6: invert = (x * y % 2 + x * y % 3) % 2 == 0; break;
+                    default: invert = ((x + y) % 2 + x * y % 3) % 2 == 0; break;
+                    }
+                    if (invert && !reserved.dark(x, y))
+                        set(qr, x, y, !qr.dark(x, y));
+                }
+        }
+
+        // The four penalty rules of ISO/IEC 18004 section 7.8.3
+        constexpr int penalty() const
+        {
+            const int n = qr.size;
+            int score = 0, darkCount = 0;
+            for (int pass = 0; pass < 2; ++pass) // rows, then columns
+                for (int a = 0; a < n; ++a)
+                {
+                    int run = 0;
+                    bool runDark = false;
+                    uint32_t window = 0; // last 11 modules, to spot finder-like patterns
+                    for (int b = 0; b < n; ++b)
+                    {
+                        const bool d = pass == 0 ? qr.dark(b, a) : qr.dark(a, b);
+                        if (b > 0 && d == runDark)
+                        {
+                            if (++run == 5)
+                                score += 3;
+                            else if (run > 5)
+                                score += 1;
+                        }
+                        else
+                        {
+                            run = 1;
+                            runDark = d;
+                        }
+                        window = ((window << 1) | d) & 0x7FF;
+                        if (b >= 10 && (window == 0x05D || window == 0x5D0))
+                            score += 40;
+                    }
+                }
+            for (int y = 0; y < n; ++y)
+                for (int x = 0; x < n; ++x)
+                {
+                    darkCount += qr.dark(x, y);
+                    if (x + 1 < n && y + 1 < n)
+                    {
+                        const bool d = qr.dark(x, y);
+                        if (qr.dark(x + 1, y) == d && qr.dark(x, y + 1) == d && qr.dark(x + 1, y + 1) == d)
+                            score += 3;
+                    }
+                }
+            const int total = n * n;
+            const int deviation = darkCount * 20 - total * 10;
+            score += ((deviation < 0 ? -deviation : deviation) + total - 1) / total * 10 - 10;
+            return score;
+        }
+    };
+}
+
+constexpr QrCode qrEncode(const char *text)
+{
+    using namespace qrgen;
+
+    int len = 0;
+    bool alnum = true;
+    for (; text[len]; ++len)
+        alnum = alnum && alnumValue(text[len]) >= 0;
+
+    // Versions 1-9 share the character count width
+    const int dataBits = 4 + (alnum ? 9 + len / 2 * 11 + len % 2 * 6 : 8 + len * 8);
+    int version = 1;
+    while (version <= QR_MAX_VERSION && dataBits > dataCodewords(version) * 8)
+        ++version;
+    if (version > QR_MAX_VERSION)
+        return QrCode();
+
+    // Segment, terminator, byte padding, then alternating pad codewords
+    const int capacity = dataCodewords(version);
+    BitWriter data;
+    if (alnum)
+    {
+        data.put(0x2, 4);
+        data.put((uint32_t)len, 9);
+        for (int i = 0; i + 1 < len; i += 2)
+            data.put((uint32_t)(alnumValue(text[i]) * 45 + alnumValue(text[i + 1])), 11);
+        if (len % 2)
+            data.put((uint32_t)alnumValue(text[len - 1]), 6);
+    }
+    else
+    {
+        data.put(0x4, 4);
+        data.put((uint32_t)len, 8);
+        for (int i = 0; i < len; ++i)
+            data.put((uint8_t)text[i], 8);
+    }
+    const int terminator = capacity * 8 - data.bits;
+    data.put(0, terminator < 4 ? terminator : 4);
+    data.put(0, (8 - data.bits % 8) % 8);
+    for (uint8_t pad = 0xEC; data.bits < capacity * 8; pad ^= 0xEC ^ 0x11)
+        data.put(pad, 8);
+
+    // Split into blocks (short ones first, one data byte less), add ECC
+    // and interleave column by column
+    const int raw = rawCodewords(version);
+    const int blocks = BLOCKS[version];
+    const int eccLen = ECC_PER_BLOCK[version];
+    const int shortBlocks = blocks - raw % blocks;
+    const int shortLen = raw / blocks; // codewords in a short block
+    uint8_t block[4][MAX_BLOCK_BYTES] = {};
+    for (int b = 0, k = 0; b < blocks; ++b)
+    {
+        const int dataLen = shortLen - eccLen + (b < shortBlocks ? 0 : 1);
+        for (int i = 0; i < dataLen; ++i)
+            block[b][i] = data.bytes[k + i];
+        k += dataLen;
+        // Short blocks keep a dummy byte before their ECC so columns line up
+        reedSolomon(block[b], dataLen, eccLen, block[b] + shortLen - eccLen + 1);
+    }
+    uint8_t codewords[QR_MAX_SIZE * QR_MAX_SIZE / 8] = {};
+    int count = 0;
+    for (int i = 0; i <= shortLen; ++i)
+        for (int b = 0; b < blocks; ++b)
+            if (i != shortLen - eccLen || b >= shortBlocks)
+                codewords[count++] = block[b][i];
+
+    Builder builder;
+    builder.qr.size = (uint8_t)(17 + 4 * version);
+    builder.functionPatterns(version);
+    builder.place(codewords, count);
+
+    int best = 0, bestPenalty = 0;
+    for (int mask = 0; mask < 8; ++mask)
+    {
+        builder.applyMask(mask);
+        builder.formatBits(mask);
+        const int p = builder.penalty();
+        if (mask == 0 || p < bestPenalty)
+        {
+            best = mask;
+            bestPenalty = p;
+        }
+        builder.applyMask(mask); // XOR again to undo
+    }
+    builder.applyMask(best);
+    builder.formatBits(best);
+    builder.qr.mask = (uint8_t)best;
+    return builder.qr;
+}
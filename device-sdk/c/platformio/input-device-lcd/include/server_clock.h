@@ -0,0 +1,77 @@
+// Server clock offset estimated from Socket.IO round trips, for sites
+// where NTP is blocked.
+//
+// Each sample is one request: sent at local time t0, answered with the
+// server's time S, received at t1. Whatever the latency split, the offset
+// (server minus local) was between S - t1 and S - t0, an interval as wide
+// as the round trip. The estimate is the intersection of the recent
+// intervals, carried to a common time with the estimated frequency error
+// and widened for drift: short round trips dominate by being narrow, and
+// asymmetric paths cannot push the truth outside the bound the way they
+// bias Cristian's midpoint. Samples that no longer intersect (server clock
+// stepped, frequency changed) are dropped oldest first.
+//
+// The offset returned is disciplined: the frequency error is estimated
+// over long baselines and applied between samples, and a new estimate
+// that agrees with the current one within its uncertainty is slewed in
+// rather than stepped. All times are microseconds; local times come from a
+// monotonic clock (esp_timer).
+#pragma once
+
+#include <stdint.h>
+
+#define SERVER_CLOCK_SAMPLES 8
+#define SERVER_CLOCK_MAX_RTT_US 3000000     // slower answers are ignored
+#define SERVER_CLOCK_STAMP_US 1000          // server timestamps are whole ms
+#define SERVER_CLOCK_DRIFT_PPM 100          // assumed frequency error until measured
+#define SERVER_CLOCK_LOCKED_PPM 20          // residual once measured
+#define SERVER_CLOCK_BASELINE_US 1800000000 // 30 min between frequency measurements
+#define SERVER_CLOCK_SLEW_PPM 1000
+
+struct ServerClockSample
+{
+    int64_t sentUs;     // local
+    int64_t receivedUs; // local
+    int64_t serverUs;   // server's clock when it answered
+};
+
+struct ServerClock
+{
+    ServerClockSample samples[SERVER_CLOCK_SAMPLES]; // newest first
+    uint8_t count;
+    bool valid;
+    bool freqLocked;
+    int32_t freqPpb; // server rate minus local rate
+
+    // Intersection of the samples at the newest one
+    int64_t refUs;
+    int64_t estimateUs;
+    int64_t halfWidthUs;
+
+    // Estimate the frequency is next measured against
+    int64_t anchorUs;
+    int64_t anchorEstimateUs;
+
+    // Offset handed out at refUs, slewing from slewFromUs to estimateUs
+    // between refUs and slewEndUs
+    int64_t slewFromUs;
+    int64_t slewEndUs;
+
+    uint32_t accepted;
+    uint32_t rejected;
+    uint32_t steps; // estimates too far off to slew
+};
+
+void serverClockInit(ServerClock &c);
+
+// Adds one round trip. Returns false if it was rejected (negative or
+// overlong round trip).
+bool serverClockAddSample(ServerClock &c, int64_t sentUs, int64_t receivedUs, int64_t serverUs);
+
+// Server time minus local time at localUs; valid once a sample arrived
+int64_t serverClockOffsetUs(const ServerClock &c, int64_t localUs);
+
+// Bound on the error of serverClockOffsetUs() at localUs: the
+// intersection's half width, any slew still pending, and drift since the
+// last sample. INT64_MAX before the first sample.
+int64_t serverClockUncertaintyUs(const ServerClock &c, int64_t localUs);
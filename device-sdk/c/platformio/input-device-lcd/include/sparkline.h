@@ -0,0 +1,48 @@
+// Per-sensor activity history for the dashboard sparklines.
+//
+// Time is cut into columns of LCD_SPARK_PERIOD_MS. Every sample taken
+// during a column folds into its min and max, so a sensor that blinked on
+// and off between two renders still shows up, and the column is stored as
+// 2 bits in a ring of SPARK_COLUMNS. Periods with no sample repeat the
+// last value.
+//
+// Memory per sensor is fixed no matter how long the device runs:
+// SPARK_COLUMNS * 2 bits plus the state below, 72 bytes in all for 210
+// columns.
+#pragma once
+
+#include <stdint.h>
+
+#include "config.h"
+
+// One column per period; 210 columns of 2 s show the last 7 minutes
+#ifndef LCD_SPARK_PERIOD_MS
+#define LCD_SPARK_PERIOD_MS 2000
+#endif
+
+#define SPARK_COLUMNS 210
+
+// Column codes: (min << 1) | max
+#define SPARK_OFF 0   // off for the whole period
+#define SPARK_MIXED 1 // changed during the period
+#define SPARK_ON 3    // on for the whole period
+
+struct SparkHistory
+{
+    uint8_t bits[(SPARK_COLUMNS * 2 + 7) / 8];
+    uint32_t columns;     // columns committed since boot; the newest is columns - 1
+    uint32_t periodStart; // millis() at which the open column began
+    uint8_t openMin;      // min/max of the samples in the open column
+    uint8_t openMax;
+    bool hasSample; // the open column has seen a sample
+    bool started;
+    bool last; // most recent sample, repeated across periods with none
+};
+
+// Adds a sample at nowMs, first closing every column whose period has
+// ended. Returns the number of columns committed (0 most of the time).
+uint32_t sparkSample(SparkHistory &h, bool value, uint32_t nowMs);
+
+// Code of absolute column c; only the last SPARK_COLUMNS are kept, so c
+// must be in [columns - SPARK_COLUMNS, columns).
+uint8_t sparkColumn(const SparkHistory &h, uint32_t c);
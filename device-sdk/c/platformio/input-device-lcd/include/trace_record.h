@@ -0,0 +1,59 @@
+// Traffic trace records and the frames they travel in, shared by the
+// device recorder (traffic_trace.h) and the host replay driver
+// (host/tools/trace_replay.cpp).
+//
+// A trace leaves the device as LOG_FRAME_TRACE frames in the serial
+// framing of log_record.h, next to the log. Payload layout:
+//
+//   int64   baseUs     esp_timer time of the frame's first record
+//   records, each:
+//     uint8   kind       TRACE_*
+//     varint  deltaUs    since the previous record (the first: since baseUs)
+//     TRACE_IN, TRACE_OUT  varint length, the frame text
+//     TRACE_GPIO           uint8 pin, uint8 level
+//     TRACE_LOST           varint records dropped since the last TRACE_LOST
+//
+// Varints are LEB128, 7 bits per byte, low bits first; everything else is
+// little-endian. A trace file is the frames back to back, as
+// log_decode --trace extracts them from a capture.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "log_record.h"
+
+#define LOG_FRAME_TRACE 'T'
+
+#define TRACE_DATA_MAX 1024 // longer frames are cut; replay reports them
+
+enum TraceKind : uint8_t
+{
+    TRACE_IN = 'I',    // text frame received
+    TRACE_OUT = 'O',   // packet sent
+    TRACE_OPEN = 'C',  // WebSocket connected
+    TRACE_CLOSE = 'D', // WebSocket disconnected
+    TRACE_GPIO = 'G',  // input level read by the scan changed
+    TRACE_LOST = 'L',  // records dropped because the ring was full
+};
+
+// A parsed record; data points into the payload it was parsed from
+struct TraceEvent
+{
+    int64_t timeUs;
+    uint8_t kind;
+    uint8_t pin;
+    uint8_t level;
+    uint32_t lost;
+    const uint8_t *data;
+    size_t length;
+};
+
+// Writes v to out (at most 5 bytes); returns the bytes written
+size_t traceVarint(uint8_t *out, uint32_t v);
+
+// Calls onEvent for every record of a LOG_FRAME_TRACE payload, in order.
+// False if the payload is malformed; the records before the fault were
+// delivered.
+bool traceParseFrame(const uint8_t *payload, size_t length, void (*onEvent)(const TraceEvent &event, void *ctx),
+                     void *ctx);
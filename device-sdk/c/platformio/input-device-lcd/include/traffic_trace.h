@@ -0,0 +1,46 @@
+// Recorder for the device's Socket.IO traffic, to replay it on the host
+// (host/tools/trace_replay.cpp): every frame received, every packet sent,
+// connects, disconnects and the input levels the GPIO scan reads (when
+// they change), with esp_timer time.
+//
+// TRACE_RECORD() copies the record into a ring of TRAFFIC_TRACE_BYTES and
+// returns; the dev_log drain task sends the ring as LOG_FRAME_TRACE frames
+// (trace_record.h) between log records, so a serial capture holds both.
+// Only the loop task may record. When the ring is full the record is
+// dropped, and the next one that fits says how many were.
+//
+// Without TRAFFIC_TRACE in config.h the macros compile to nothing and the
+// ring does not exist.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config.h"
+
+#ifdef TRAFFIC_TRACE
+
+#include "trace_record.h"
+
+#ifndef TRAFFIC_TRACE_BYTES
+#define TRAFFIC_TRACE_BYTES 16384 // a power of two
+#endif
+
+void traceRecord(uint8_t kind, const void *data, size_t length);
+// Records the level only if it differs from the last one recorded for pin
+void traceGpio(uint8_t pin, uint8_t level);
+
+// Sends every finished record; logDrain() calls this
+void traceDrain();
+// Records dropped because the ring was full, since boot
+uint32_t traceDropped();
+
+#define TRACE_RECORD(kind, data, length) traceRecord(kind, data, length)
+#define TRACE_GPIO(pin, level) traceGpio(pin, level)
+
+#else
+
+#define TRACE_RECORD(kind, data, length) ((void)0)
+#define TRACE_GPIO(pin, level) ((void)0)
+
+#endif // TRAFFIC_TRACE
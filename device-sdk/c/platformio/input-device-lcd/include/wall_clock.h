@@ -0,0 +1,61 @@
+// Wall-clock time for the UI without blocking the loop.
+//
+// SNTP runs in the background (lwIP task). Each sync only records the
+// offset between UTC and esp_timer, the monotonic microsecond counter
+// since boot, so clockNowUs() is an addition and never waits. Small
+// corrections are slewed in over time instead of stepped, which keeps the
+// clock from running backwards; the first sync and large errors step.
+//
+// Where NTP is blocked, another source (the server clock estimated over
+// Socket.IO, server_clock.h) can feed syncs with clockSyncFrom() until
+// SNTP gets through.
+//
+// Local time follows a POSIX TZ string ("KST-9", "CET-1CEST,M3.5.0,M10.5.0/3").
+// The date and time texts are formatted only when the displayed second
+// changes and are returned from a static buffer.
+#pragma once
+
+#include <stdint.h>
+
+#include "config.h"
+
+#ifndef CLOCK_TZ
+#define CLOCK_TZ "KST-9"
+#endif
+#ifndef CLOCK_NTP_SERVER_1
+#define CLOCK_NTP_SERVER_1 "pool.ntp.org"
+#endif
+#ifndef CLOCK_NTP_SERVER_2
+#define CLOCK_NTP_SERVER_2 "time.nist.gov"
+#endif
+
+// Corrections up to this size are slewed at CLOCK_SLEW_PPM
+#define CLOCK_SLEW_LIMIT_US 500000
+#define CLOCK_SLEW_PPM 500
+
+struct ClockSyncInfo
+{
+    uint32_t syncs;           // syncs since clockBegin(), from either source
+    bool sntp;                // SNTP has synced (other sources are ignored from then on)
+    int64_t lastCorrectionUs; // how far off the clock was at the last sync
+    int64_t lastSyncUs;       // esp_timer time of the last sync
+};
+
+// Sets the time zone and starts SNTP; call once WiFi is up
+void clockBegin(const char *tz = CLOCK_TZ);
+void clockSetTimeZone(const char *tz);
+
+// A sync from a source other than SNTP: UTC microseconds now
+void clockSyncFrom(int64_t utcUs);
+
+bool clockSynced();
+// UTC microseconds since 1970, or 0 before the first sync
+int64_t clockNowUs();
+ClockSyncInfo clockSyncInfo();
+
+// "2026-02-13" and "10:24:30" in local time, "--" and "--:--:--" before
+// the first sync. The pointers stay valid; the text changes in place.
+const char *clockDateText();
+const char *clockTimeText();
+// Times the texts were re-formatted (at most once per second)
+uint32_t clockFormatCount();
@@ -0,0 +1,230 @@
+#include "dev_log.h"
+#include "traffic_trace.h"
+
+#include <Arduino.h>
+#include <atomic>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+static_assert((LOG_RING_BYTES & (LOG_RING_BYTES - 1)) == 0, "LOG_RING_BYTES must be a power of two");
+
+#define LOG_LINE_MAX 320
+#define LOG_FORMAT_SLOTS 128 // format ids sent since the last resend, a power of two
+
+// Entries start on 4-byte positions: a tag word (position + 1 once the
+// entry is complete), the payload length, the format pointer and the
+// payload. Only the tag is accessed atomically; everything after it may
+// wrap around the end of the ring. Drained space is zeroed before tail
+// moves past it, so a tag can only match once its writer stored it.
+static uint8_t ring[LOG_RING_BYTES] __attribute__((aligned(4)));
+static std::atomic<uint32_t> head(0); // next position to reserve
+static std::atomic<uint32_t> tail(0); // first position not drained
+static std::atomic<uint32_t> dropped(0);
+static std::atomic_flag draining = ATOMIC_FLAG_INIT;
+
+static uint32_t droppedReported = 0;
+#if LOG_BINARY
+static uint32_t sentFormats[LOG_FORMAT_SLOTS];
+static uint32_t sentFormatCount = 0;
+static unsigned long lastFormatReset = 0;
+#endif
+
+static uint32_t *tagAt(uint32_t pos)
+{
+    return (uint32_t *)&ring[pos & (LOG_RING_BYTES - 1)];
+}
+
+static void copyIn(uint32_t pos, const void *data, size_t length)
+{
+    const size_t at = pos & (LOG_RING_BYTES - 1);
+    const size_t first = length < LOG_RING_BYTES - at ? length : LOG_RING_BYTES - at;
+    memcpy(&ring[at], data, first);
+    memcpy(ring, (const uint8_t *)data + first, length - first);
+}
+
+static void copyOut(uint32_t pos, void *data, size_t length)
+{
+    const size_t at = pos & (LOG_RING_BYTES - 1);
+    const size_t first = length < LOG_RING_BYTES - at ? length : LOG_RING_BYTES - at;
+    memcpy(data, &ring[at], first);
+    memcpy((uint8_t *)data + first, ring, length - first);
+}
+
+static void zero(uint32_t pos, size_t length)
+{
+    const size_t at = pos & (LOG_RING_BYTES - 1);
+    const size_t first = length < LOG_RING_BYTES - at ? length : LOG_RING_BYTES - at;
+    memset(&ring[at], 0, first);
+    memset(ring, 0, length - first);
+}
+
+static uint32_t entrySize(uint32_t length)
+{
+    return (uint32_t)((8 + sizeof(const char *) + length + 3) & ~(size_t)3);
+}
+
+int64_t logTimeUs()
+{
+    return esp_timer_get_time();
+}
+
+void logCommit(const char *fmt, const uint8_t *payload, size_t length)
+{
+    const uint32_t size = entrySize((uint32_t)length);
+    uint32_t pos = head.load(std::memory_order_relaxed);
+    do
+    {
+        if (pos + size - tail.load(std::memory_order_acquire) > LOG_RING_BYTES)
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    } while (!head.compare_exchange_weak(pos, pos + size, std::memory_order_relaxed));
+
+    const uint32_t length32 = (uint32_t)length;
+    copyIn(pos + 4, &length32, 4);
+    copyIn(pos + 8, &fmt, sizeof(fmt));
+    copyIn(pos + 8 + sizeof(fmt), payload, length);
+    __atomic_store_n(tagAt(pos), pos + 1, __ATOMIC_RELEASE);
+}
+
+uint32_t logDropped()
+{
+    return dropped.load(std::memory_order_relaxed);
+}
+
+uint32_t logPendingBytes()
+{
+    return head.load(std::memory_order_relaxed) - tail.load(std::memory_order_relaxed);
+}
+
+void logSendFrame(uint8_t kind, const void *a, size_t aLength, const void *b, size_t bLength)
+{
+    const size_t length = aLength + bLength;
+    const uint8_t header[4] = {LOG_FRAME_SYNC, kind, (uint8_t)length, (uint8_t)(length >> 8)};
+    uint8_t checksum = 0;
+    for (size_t i = 0; i < aLength; ++i)
+        checksum ^= ((const uint8_t *)a)[i];
+    for (size_t i = 0; i < bLength; ++i)
+        checksum ^= ((const uint8_t *)b)[i];
+    Serial.write(header, sizeof(header));
+    Serial.write((const uint8_t *)a, aLength);
+    if (bLength)
+        Serial.write((const uint8_t *)b, bLength);
+    Serial.write(&checksum, 1);
+}
+
+#if LOG_BINARY
+// Sends the format text unless it went out since the last reset
+static void defineFormat(uint32_t id, const char *fmt)
+{
+    if (millis() - lastFormatReset >= LOG_FORMAT_RESEND_MS || sentFormatCount >= LOG_FORMAT_SLOTS / 2)
+    {
+        memset(sentFormats, 0, sizeof(sentFormats));
+        sentFormatCount = 0;
+        lastFormatReset = millis();
+    }
+    // Open addressing on the id; 0 marks a free slot (ids are addresses)
+    for (uint32_t i = (id >> 2) * 2654435761u;; ++i)
+    {
+        uint32_t &slot = sentFormats[i & (LOG_FORMAT_SLOTS - 1)];
+        if (slot == id)
+            return;
+        if (slot == 0)
+        {
+            slot = id;
+            sentFormatCount++;
+            break;
+        }
+    }
+    logSendFrame(LOG_FRAME_FORMAT, &id, 4, fmt, strlen(fmt));
+}
+
+static void emit(const char *fmt, const uint8_t *payload, size_t length)
+{
+    const uint32_t id = (uint32_t)(uintptr_t)fmt;
+    defineFormat(id, fmt);
+    logSendFrame(LOG_FRAME_RECORD, &id, 4, payload, length);
+}
+
+static void emitLost(uint32_t count)
+{
+    logSendFrame(LOG_FRAME_LOST, &count, 4, nullptr, 0);
+}
+#else
+static void emit(const char *fmt, const uint8_t *payload, size_t length)
+{
+    LogRecordView record;
+    if (!logParseRecord(payload, length, record))
+        return;
+    char line[LOG_LINE_MAX];
+    size_t n = logFormat(line, sizeof(line), fmt, record);
+    // Lines are terminated here
+    while (n > 0 && line[n - 1] == '\n')
+        line[--n] = '\0';
+    Serial.printf("%lu.%03lu %c %s\n", (unsigned long)(record.timeUs / 1000000),
+                  (unsigned long)(record.timeUs / 1000 % 1000), logLevelLetter(record.level), line);
+}
+
+static void emitLost(uint32_t count)
+{
+    Serial.printf("[LOG] %lu records dropped\n", (unsigned long)count);
+}
+#endif
+
+size_t logDrain()
+{
+    if (draining.test_and_set(std::memory_order_acquire))
+        return 0; // the other drainer gets them
+
+    size_t count = 0;
+    uint32_t pos = tail.load(std::memory_order_relaxed);
+    while (__atomic_load_n(tagAt(pos), __ATOMIC_ACQUIRE) == pos + 1)
+    {
+        uint32_t length;
+        const char *fmt;
+        uint8_t payload[LOG_RECORD_MAX];
+        copyOut(pos + 4, &length, 4);
+        copyOut(pos + 8, &fmt, sizeof(fmt));
+        if (length > sizeof(payload))
+            length = 0; // cannot happen; keeps a corrupt entry from overrunning
+        copyOut(pos + 8 + sizeof(fmt), payload, length);
+
+        const uint32_t size = entrySize(length);
+        zero(pos, size);
+        pos += size;
+        tail.store(pos, std::memory_order_release);
+
+        emit(fmt, payload, length);
+        count++;
+    }
+
+    const uint32_t lost = dropped.load(std::memory_order_relaxed);
+    if (lost != droppedReported)
+    {
+        emitLost(lost - droppedReported);
+        droppedReported = lost;
+    }
+#ifdef TRAFFIC_TRACE
+    traceDrain();
+#endif
+    draining.clear(std::memory_order_release);
+    return count;
+}
+
+static void logTask(void *)
+{
+    while (true)
+    {
+        logDrain();
+        vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_INTERVAL_MS));
+    }
+}
+
+void logBegin()
+{
+    if (xTaskCreatePinnedToCore(logTask, "log", LOG_TASK_STACK, nullptr, LOG_TASK_PRIORITY, nullptr,
+                                LOG_TASK_CORE) != pdPASS)
+        Serial.println("[LOG] Drain task not started, call logDrain()");
+}
@@ -0,0 +1,74 @@
+#include "event_log.h"
+
+#include <Arduino.h>
+#include <atomic>
+#include <stdarg.h>
+#include <string.h>
+
+static_assert((EVENT_LOG_SIZE & (EVENT_LOG_SIZE - 1)) == 0, "EVENT_LOG_SIZE must be a power of two");
+
+struct EventSlot
+{
+    std::atomic<uint32_t> state; // 2 * seq + 1 while writing, 2 * seq + 2 when complete
+    EventEntry entry;
+};
+
+static EventSlot slots[EVENT_LOG_SIZE];
+static std::atomic<uint32_t> head(0);
+
+void eventLog(EventLevel level, const char *fmt, ...)
+{
+    const uint32_t seq = head.fetch_add(1, std::memory_order_relaxed);
+    EventSlot &slot = slots[seq & (EVENT_LOG_SIZE - 1)];
+
+    slot.state.store(2 * seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.entry.seq = seq;
+    slot.entry.timeMs = millis();
+    slot.entry.level = level;
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(slot.entry.text, sizeof(slot.entry.text), fmt, args);
+    va_end(args);
+
+    slot.state.store(2 * seq + 2, std::memory_order_release);
+}
+
+uint32_t eventLogHead()
+{
+    return head.load(std::memory_order_acquire);
+}
+
+bool eventLogRead(EventCursor &cursor, EventEntry &out)
+{
+    while (true)
+    {
+        const uint32_t seq = cursor.next;
+        if ((int32_t)(eventLogHead() - seq) <= 0)
+            return false;
+
+        const EventSlot &slot = slots[seq & (EVENT_LOG_SIZE - 1)];
+        const uint32_t before = slot.state.load(std::memory_order_acquire);
+        const int32_t age = (int32_t)(before - (2 * seq + 2));
+        if (age < 0)
+            return false; // still being written
+
+        if (age == 0)
+        {
+            memcpy(&out, &slot.entry, sizeof(out));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.state.load(std::memory_order_relaxed) == before)
+            {
+                cursor.next = seq + 1;
+                return true;
+            }
+        }
+
+        // Overwritten: resume at the oldest event still in the ring
+        const uint32_t oldest = eventLogHead() - EVENT_LOG_SIZE;
+        const uint32_t resume = (int32_t)(oldest - seq) > 0 ? oldest : seq + 1;
+        cursor.lost += resume - seq;
+        cursor.next = resume;
+    }
+}
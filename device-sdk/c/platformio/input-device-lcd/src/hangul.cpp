@@ -0,0 +1,307 @@
+#include "hangul.h"
+
+#include <math.h>
+#include <string.h>
+
+// --------------------------------------------------------------
+// Jamo outlines
+// --------------------------------------------------------------
+// Strokes live on a 0..8 grid spanning the box the layout gives the jamo.
+// A stroke is 4 nibbles: a line x0,y0 -> x1,y1, or, with x1 == 0xF, an
+// ellipse centred on x0,y0 with radius y1.
+#define LN(x0, y0, x1, y1) (uint16_t)(((x0) << 12) | ((y0) << 8) | ((x1) << 4) | (y1))
+#define RING(cx, cy, r) (uint16_t)(((cx) << 12) | ((cy) << 8) | 0xF0 | (r))
+
+static const uint16_t STROKES[] = {
+    // consonants
+    LN(0, 0, 8, 0), LN(8, 0, 8, 8),                                                 // ㄱ
+    LN(0, 0, 0, 8), LN(0, 8, 8, 8),                                                 // ㄴ
+    LN(0, 0, 8, 0), LN(0, 0, 0, 8), LN(0, 8, 8, 8),                                 // ㄷ
+    LN(0, 0, 8, 0), LN(8, 0, 8, 4), LN(0, 4, 8, 4), LN(0, 4, 0, 8), LN(0, 8, 8, 8), // ㄹ
+    LN(0, 0, 8, 0), LN(0, 0, 0, 8), LN(8, 0, 8, 8), LN(0, 8, 8, 8),                 // ㅁ
+    LN(0, 0, 0, 8), LN(8, 0, 8, 8), LN(0, 4, 8, 4), LN(0, 8, 8, 8),                 // ㅂ
+    LN(4, 0, 0, 8), LN(4, 2, 8, 8),                                                 // ㅅ
+    RING(4, 4, 4),                                                                  // ㅇ
+    LN(0, 0, 8, 0), LN(4, 0, 0, 8), LN(4, 2, 8, 8),                                 // ㅈ
+    LN(2, 0, 6, 0), LN(0, 2, 8, 2), LN(4, 2, 0, 8), LN(4, 4, 8, 8),                 // ㅊ
+    LN(0, 0, 8, 0), LN(8, 0, 8, 8), LN(0, 4, 8, 4),                                 // ㅋ
+    LN(0, 0, 8, 0), LN(0, 0, 0, 8), LN(0, 4, 8, 4), LN(0, 8, 8, 8),                 // ㅌ
+    LN(0, 0, 8, 0), LN(2, 0, 2, 8), LN(6, 0, 6, 8), LN(0, 8, 8, 8),                 // ㅍ
+    LN(2, 0, 6, 0), LN(0, 2, 8, 2), RING(4, 6, 2),                                  // ㅎ
+    // vertical vowels
+    LN(3, 0, 3, 8), LN(3, 4, 7, 4),                                 // ㅏ
+    LN(2, 0, 2, 8), LN(2, 4, 5, 4), LN(6, 0, 6, 8),                 // ㅐ
+    LN(3, 0, 3, 8), LN(3, 3, 7, 3), LN(3, 5, 7, 5),                 // ㅑ
+    LN(2, 0, 2, 8), LN(2, 3, 5, 3), LN(2, 5, 5, 5), LN(6, 0, 6, 8), // ㅒ
+    LN(5, 0, 5, 8), LN(1, 4, 5, 4),                                 // ㅓ
+    LN(0, 4, 3, 4), LN(3, 0, 3, 8), LN(6, 0, 6, 8),                 // ㅔ
+    LN(5, 0, 5, 8), LN(1, 3, 5, 3), LN(1, 5, 5, 5),                 // ㅕ
+    LN(0, 3, 3, 3), LN(0, 5, 3, 5), LN(3, 0, 3, 8), LN(6, 0, 6, 8), // ㅖ
+    LN(4, 0, 4, 8),                                                 // ㅣ
+    // horizontal vowels
+    LN(4, 2, 4, 6), LN(0, 6, 8, 6),                 // ㅗ
+    LN(3, 2, 3, 6), LN(5, 2, 5, 6), LN(0, 6, 8, 6), // ㅛ
+    LN(0, 2, 8, 2), LN(4, 2, 4, 7),                 // ㅜ
+    LN(0, 2, 8, 2), LN(3, 2, 3, 7), LN(5, 2, 5, 7), // ㅠ
+    LN(0, 4, 8, 4),                                 // ㅡ
+};
+
+// First stroke and stroke count of each base shape
+struct Shape
+{
+    uint8_t first;
+    uint8_t count;
+};
+
+enum : uint8_t
+{
+    // consonants
+    C_G, C_N, C_D, C_R, C_M, C_B, C_S, C_NG, C_J, C_CH, C_K, C_T, C_P, C_H,
+    // vertical vowels
+    V_A, V_AE, V_YA, V_YAE, V_EO, V_E, V_YEO, V_YE, V_I,
+    // horizontal vowels
+    V_O, V_YO, V_U, V_YU, V_EU,
+    SHAPE_COUNT,
+    NONE = 0xFF,
+};
+
+static const Shape SHAPES[SHAPE_COUNT] = {
+    {0, 2}, {2, 2}, {4, 3}, {7, 5}, {12, 4}, {16, 4}, {20, 2}, {22, 1}, {23, 3}, {26, 4}, {30, 3}, {33, 4}, {37, 4}, {41, 3},
+    {44, 2}, {46, 3}, {49, 3}, {52, 4}, {56, 2}, {58, 3}, {61, 3}, {64, 4}, {68, 1},
+    {69, 2}, {71, 3}, {74, 2}, {76, 3}, {79, 1},
+};
+
+// Jamo as up to two base shapes: side by side for consonants (ㄲ, ㄳ),
+// horizontal part + vertical part for vowels (ㅘ = ㅗ + ㅏ).
+struct Jamo
+{
+    uint8_t a;
+    uint8_t b;
+};
+
+static const Jamo INITIALS[19] = {
+    {C_G, NONE}, {C_G, C_G}, {C_N, NONE}, {C_D, NONE}, {C_D, C_D}, {C_R, NONE}, {C_M, NONE},
+    {C_B, NONE}, {C_B, C_B}, {C_S, NONE}, {C_S, C_S}, {C_NG, NONE}, {C_J, NONE}, {C_J, C_J},
+    {C_CH, NONE}, {C_K, NONE}, {C_T, NONE}, {C_P, NONE}, {C_H, NONE},
+};
+
+// {horizontal part, vertical part}
+static const Jamo MEDIALS[21] = {
+    {NONE, V_A}, {NONE, V_AE}, {NONE, V_YA}, {NONE, V_YAE}, {NONE, V_EO}, {NONE, V_E}, {NONE, V_YEO},
+    {NONE, V_YE}, {V_O, NONE}, {V_O, V_A}, {V_O, V_AE}, {V_O, V_I}, {V_YO, NONE}, {V_U, NONE},
+    {V_U, V_EO}, {V_U, V_E}, {V_U, V_I}, {V_YU, NONE}, {V_EU, NONE}, {V_EU, V_I}, {NONE, V_I},
+};
+
+// Index 0 is "no final"
+static const Jamo FINALS[28] = {
+    {NONE, NONE}, {C_G, NONE}, {C_G, C_G}, {C_G, C_S}, {C_N, NONE}, {C_N, C_J}, {C_N, C_H},
+    {C_D, NONE}, {C_R, NONE}, {C_R, C_G}, {C_R, C_M}, {C_R, C_B}, {C_R, C_S}, {C_R, C_T},
+    {C_R, C_P}, {C_R, C_H}, {C_M, NONE}, {C_B, NONE}, {C_B, C_S}, {C_S, NONE}, {C_S, C_S},
+    {C_NG, NONE}, {C_J, NONE}, {C_CH, NONE}, {C_K, NONE}, {C_T, NONE}, {C_P, NONE}, {C_H, NONE},
+};
+
+// Compatibility consonants U+3131-U+314E, in code point order
+static const Jamo COMPAT_CONSONANTS[30] = {
+    {C_G, NONE}, {C_G, C_G}, {C_G, C_S}, {C_N, NONE}, {C_N, C_J}, {C_N, C_H}, {C_D, NONE}, {C_D, C_D},
+    {C_R, NONE}, {C_R, C_G}, {C_R, C_M}, {C_R, C_B}, {C_R, C_S}, {C_R, C_T}, {C_R, C_P}, {C_R, C_H},
+    {C_M, NONE}, {C_B, NONE}, {C_B, C_B}, {C_B, C_S}, {C_S, NONE}, {C_S, C_S}, {C_NG, NONE}, {C_J, NONE},
+    {C_J, C_J}, {C_CH, NONE}, {C_K, NONE}, {C_T, NONE}, {C_P, NONE}, {C_H, NONE},
+};
+
+// --------------------------------------------------------------
+// Rasterizer
+// --------------------------------------------------------------
+// Jamo are drawn at 2x with a 3px brush, then box-filtered to 2-bit
+// coverage, which gives strokes about the weight of FONT_LARGE's.
+#define RASTER_SCALE 2
+#define RASTER_SIZE (FONT_HANGUL_SIZE * RASTER_SCALE)
+#define BRUSH 3
+
+struct Box
+{
+    int8_t x, y, w, h; // 1x pixels inside the glyph square
+};
+
+static uint8_t raster[RASTER_SIZE * RASTER_SIZE];
+
+static void plot(int x, int y)
+{
+    for (int dy = 0; dy < BRUSH; ++dy)
+        for (int dx = 0; dx < BRUSH; ++dx)
+        {
+            const int px = x + dx, py = y + dy;
+            if (px >= 0 && py >= 0 && px < RASTER_SIZE && py < RASTER_SIZE)
+                raster[py * RASTER_SIZE + px] = 1;
+        }
+}
+
+// Grid coordinate (0..8) to raster pixel, keeping the brush inside the box
+static float mapX(const Box &box, float g) { return box.x * RASTER_SCALE + g * (box.w * RASTER_SCALE - BRUSH) / 8.0f; }
+static float mapY(const Box &box, float g) { return box.y * RASTER_SCALE + g * (box.h * RASTER_SCALE - BRUSH) / 8.0f; }
+
+static void drawShape(uint8_t shape, const Box &box)
+{
+    const Shape &s = SHAPES[shape];
+    for (uint8_t i = 0; i < s.count; ++i)
+    {
+        const uint16_t st = STROKES[s.first + i];
+        const int x0 = st >> 12, y0 = (st >> 8) & 0xF, x1 = (st >> 4) & 0xF, y1 = st & 0xF;
+        if (x1 == 0xF)
+        {
+            const float cx = mapX(box, x0), cy = mapY(box, y0);
+            const float rx = mapX(box, x0 + y1) - cx, ry = mapY(box, y0 + y1) - cy;
+            const int steps = 48;
+            for (int k = 0; k < steps; ++k)
+            {
+                const float a = k * 6.2831853f / steps;
+                plot((int)lroundf(cx + rx * cosf(a)), (int)lroundf(cy + ry * sinf(a)));
+            }
+            continue;
+        }
+
+        const float ax = mapX(box, x0), ay = mapY(box, y0);
+        const float bx = mapX(box, x1), by = mapY(box, y1);
+        const int steps = (int)fmaxf(fabsf(bx - ax), fabsf(by - ay)) + 1;
+        for (int k = 0; k <= steps; ++k)
+            plot((int)lroundf(ax + (bx - ax) * k / steps), (int)lroundf(ay + (by - ay) * k / steps));
+    }
+}
+
+// Two shapes side by side share the box with a 1px gap
+static void drawJamo(const Jamo &j, const Box &box)
+{
+    if (j.b == NONE)
+    {
+        drawShape(j.a, box);
+        return;
+    }
+    const int8_t half = (int8_t)((box.w - 1) / 2);
+    drawShape(j.a, {box.x, box.y, half, box.h});
+    drawShape(j.b, {(int8_t)(box.x + box.w - half), box.y, half, box.h});
+}
+
+static void composeSyllable(uint32_t index)
+{
+    const Jamo &initial = INITIALS[index / 588];
+    const Jamo &medial = MEDIALS[(index % 588) / 28];
+    const Jamo &final = FINALS[index % 28];
+    const bool horizontal = medial.a != NONE;
+    const bool vertical = medial.b != NONE;
+    const bool hasFinal = final.a != NONE;
+
+    // Layouts by vowel orientation, squeezed upward when there is a final
+    if (vertical && !horizontal)
+    {
+        drawJamo(initial, hasFinal ? Box{0, 0, 9, 9} : Box{0, 1, 9, 14});
+        drawShape(medial.b, hasFinal ? Box{9, 0, 7, 10} : Box{9, 0, 7, 16});
+    }
+    else if (horizontal && !vertical)
+    {
+        drawJamo(initial, hasFinal ? Box{2, 0, 12, 5} : Box{2, 0, 12, 8});
+        drawShape(medial.a, hasFinal ? Box{0, 4, 16, 6} : Box{0, 7, 16, 9});
+    }
+    else
+    {
+        drawJamo(initial, hasFinal ? Box{0, 0, 10, 5} : Box{0, 0, 10, 7});
+        drawShape(medial.a, hasFinal ? Box{0, 4, 11, 6} : Box{0, 6, 11, 9});
+        drawShape(medial.b, hasFinal ? Box{10, 0, 6, 10} : Box{10, 0, 6, 16});
+    }
+    if (hasFinal)
+        drawJamo(final, {2, 10, 12, 6});
+}
+
+static bool rasterize(uint32_t cp)
+{
+    memset(raster, 0, sizeof(raster));
+    if (cp >= 0xAC00 && cp <= 0xD7A3)
+        composeSyllable(cp - 0xAC00);
+    else if (cp >= 0x3131 && cp <= 0x314E)
+        drawJamo(COMPAT_CONSONANTS[cp - 0x3131], {2, 1, 12, 14});
+    else if (cp >= 0x314F && cp <= 0x3163)
+    {
+        const Jamo &m = MEDIALS[cp - 0x314F];
+        if (m.a != NONE)
+            drawShape(m.a, m.b != NONE ? Box{0, 6, 11, 9} : Box{0, 4, 16, 9});
+        if (m.b != NONE)
+            drawShape(m.b, m.a != NONE ? Box{10, 0, 6, 16} : Box{4, 0, 8, 16});
+    }
+    else
+        return false;
+    return true;
+}
+
+// 2x2 box filter into 2-bit coverage; without antialias, half covered is ink
+static void downsample(uint8_t *out, bool antialias)
+{
+    memset(out, 0, HANGUL_GLYPH_BYTES);
+    for (int y = 0; y < FONT_HANGUL_SIZE; ++y)
+        for (int x = 0; x < FONT_HANGUL_SIZE; ++x)
+        {
+            const uint8_t *r = raster + (y * RASTER_SCALE) * RASTER_SIZE + x * RASTER_SCALE;
+            const int ink = r[0] + r[1] + r[RASTER_SIZE] + r[RASTER_SIZE + 1];
+            const uint8_t level = antialias ? (uint8_t)(ink > 3 ? 3 : ink) : (ink >= 2 ? 3 : 0);
+            const int bit = (y * FONT_HANGUL_SIZE + x) * 2;
+            out[bit >> 3] |= (uint8_t)(level << (6 - (bit & 7)));
+        }
+}
+
+// --------------------------------------------------------------
+// LRU cache
+// --------------------------------------------------------------
+struct CacheEntry
+{
+    uint32_t key; // code point << 1 | antialias, 0 when empty
+    uint32_t lastUse;
+    uint8_t bits[HANGUL_GLYPH_BYTES];
+};
+
+static CacheEntry cache[LCD_HANGUL_CACHE];
+static uint32_t useClock = 0;
+static HangulCacheStats stats = {};
+
+const uint8_t *hangulGlyph(uint32_t cp, bool antialias)
+{
+    if (!fontIsHangul(cp))
+        return nullptr;
+
+    const uint32_t key = (cp << 1) | (antialias ? 1 : 0);
+    CacheEntry *victim = &cache[0];
+    for (CacheEntry &e : cache)
+    {
+        if (e.key == key)
+        {
+            e.lastUse = ++useClock;
+            stats.hits++;
+            return e.bits;
+        }
+        if (e.lastUse < victim->lastUse)
+            victim = &e;
+    }
+
+    stats.misses++;
+    if (victim->key != 0)
+        stats.evictions++;
+    rasterize(cp);
+    downsample(victim->bits, antialias);
+    victim->key = key;
+    victim->lastUse = ++useClock;
+    return victim->bits;
+}
+
+const HangulCacheStats &hangulCacheStats()
+{
+    return stats;
+}
+
+void hangulCacheClear()
+{
+    memset(cache, 0, sizeof(cache));
+    useClock = 0;
+    stats = {};
+}
+
+size_t hangulFlashBytes()
+{
+    return sizeof(STROKES) + sizeof(SHAPES) + sizeof(INITIALS) + sizeof(MEDIALS) + sizeof(FINALS) +
+           sizeof(COMPAT_CONSONANTS);
+}
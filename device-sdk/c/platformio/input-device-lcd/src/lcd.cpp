@@ -2,8 +2,15 @@
 
 #ifdef HAS_LCD_240x320
 
+#include "dev_log.h"
 #include "lcd.h"
 #include <LovyanGFX.hpp>
+#include <Preferences.h>
+
+// Write clock used when calibration is off, or cannot verify anything
+#ifndef LCD_SPI_FREQ
+#define LCD_SPI_FREQ 10000000
+#endif
 
 // LovyanGFX-based implementation that preserves the existing LCD:: API.
 // This acts as a thin wrapper so existing code doesn't need to change.
@@ -16,9 +23,12 @@ public:
     {
         // SPI bus configuration
         auto bus_cfg = _bus_spi.config();
-        bus_cfg.spi_host = VSPI_HOST;  // use VSPI or HSPI as desired
-        bus_cfg.freq_write = 10000000; // 10MHz (safer for some modules)
+        // The module's pins (14/13/12/15) are the HSPI IO_MUX pins; on HSPI
+        // the bus bypasses the GPIO matrix, which caps it at 40MHz.
+        bus_cfg.spi_host = HSPI_HOST;
+        bus_cfg.freq_write = LCD_SPI_FREQ;
         bus_cfg.freq_read = 4000000;
+        bus_cfg.dma_channel = SPI_DMA_CH_AUTO; // required for pushImageDMA
         bus_cfg.pin_sclk = LCD_SCK_PIN;
         bus_cfg.pin_mosi = LCD_MOSI_PIN;
         bus_cfg.pin_miso = LCD_MISO_PIN;
@@ -45,6 +55,16 @@ public:
         setPanel(&_panel_st7789);
     }
 
+    // Only between transactions; takes effect on the next one
+    void setWriteClock(uint32_t hz)
+    {
+        auto bus_cfg = _bus_spi.config();
+        bus_cfg.freq_write = hz;
+        _bus_spi.config(bus_cfg);
+    }
+
+    uint32_t writeClock() const { return _bus_spi.config().freq_write; }
+
 private:
     lgfx::Bus_SPI _bus_spi;
     lgfx::Panel_ST7789P3 _panel_st7789;
@@ -52,6 +72,503 @@ private:
 
 static LGFX_Config display;
 
+// --------------------------------------------------------------
+// Write clock calibration
+// --------------------------------------------------------------
+// Steps the write clock up through what the ESP32 SPI divider can produce
+// from its 80MHz source, verifying each step by writing test patterns and
+// reading them back over MISO at the fixed (slow) read clock. The winner,
+// minus LCD_SPI_CAL_MARGIN steps, is kept in NVS and reused on later boots.
+#ifdef LCD_SPI_CALIBRATE
+
+#ifndef LCD_SPI_CAL_MARGIN
+#define LCD_SPI_CAL_MARGIN 1
+#endif
+
+#define CAL_ROWS 8
+#define CAL_PIXELS ((int32_t)LCD::WIDTH * CAL_ROWS)
+#define CAL_ROUNDS 4
+
+static const char *CAL_NVS_NAMESPACE = "lcd";
+static const char *CAL_NVS_KEY = "spi_wr_hz";
+
+static const uint32_t CAL_STEPS[] = {10000000, 16000000, 20000000, 26666667, 40000000, 80000000};
+static const uint8_t CAL_STEP_COUNT = sizeof(CAL_STEPS) / sizeof(CAL_STEPS[0]);
+
+static uint32_t crc32Update(uint32_t crc, const uint16_t *pixels, int32_t count)
+{
+    for (int32_t i = 0; i < count; ++i)
+    {
+        crc ^= pixels[i];
+        for (uint8_t b = 0; b < 16; ++b)
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+    }
+    return crc;
+}
+
+// Round 0 toggles every data line each clock, round 1 swings whole pixels
+// between all-zero and all-one, the rest are pseudo-random.
+static void fillCalPattern(uint16_t *pattern, uint8_t round)
+{
+    uint32_t seed = 0x9E3779B9u * (round + 1);
+    for (int32_t i = 0; i < CAL_PIXELS; ++i)
+    {
+        if (round == 0)
+            pattern[i] = (i & 1) ? 0x5555 : 0xAAAA;
+        else if (round == 1)
+            pattern[i] = (i & 1) ? 0x0000 : 0xFFFF;
+        else
+        {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            pattern[i] = (uint16_t)seed;
+        }
+    }
+}
+
+static bool verifyWriteClock(uint32_t hz, uint16_t *pattern, uint16_t *row)
+{
+    display.setWriteClock(hz);
+    for (uint8_t round = 0; round < CAL_ROUNDS; ++round)
+    {
+        fillCalPattern(pattern, round);
+        const uint32_t expected = crc32Update(0xFFFFFFFFu, pattern, CAL_PIXELS);
+        display.pushImage(0, 0, LCD::WIDTH, CAL_ROWS, (const lgfx::rgb565_t *)pattern);
+
+        uint32_t crc = 0xFFFFFFFFu;
+        for (int16_t y = 0; y < CAL_ROWS; ++y)
+        {
+            display.readRect(0, y, LCD::WIDTH, 1, (lgfx::rgb565_t *)row);
+            crc = crc32Update(crc, row, LCD::WIDTH);
+        }
+        if (crc != expected)
+            return false;
+    }
+    return true;
+}
+
+// Highest verified step minus the margin, or 0 when readback does not
+// even work at LCD_SPI_FREQ (MISO not connected, panel not readable).
+static uint32_t runCalibration()
+{
+    uint16_t *pattern = (uint16_t *)malloc(CAL_PIXELS * sizeof(uint16_t));
+    uint16_t *row = (uint16_t *)malloc(LCD::WIDTH * sizeof(uint16_t));
+    uint32_t result = 0;
+
+    if (pattern && row && verifyWriteClock(LCD_SPI_FREQ, pattern, row))
+    {
+        int8_t best = -1;
+        for (uint8_t i = 0; i < CAL_STEP_COUNT; ++i)
+        {
+            if (CAL_STEPS[i] <= LCD_SPI_FREQ)
+                continue;
+            const bool ok = verifyWriteClock(CAL_STEPS[i], pattern, row);
+            LOG_INFO("[LCD] Calibration %lu Hz: %s", (unsigned long)CAL_STEPS[i], ok ? "ok" : "FAIL");
+            if (!ok)
+                break;
+            best = i;
+        }
+
+        result = LCD_SPI_FREQ;
+        const int8_t pick = best - LCD_SPI_CAL_MARGIN;
+        if (pick >= 0 && CAL_STEPS[pick] > LCD_SPI_FREQ)
+            result = CAL_STEPS[pick];
+    }
+
+    display.setWriteClock(LCD_SPI_FREQ);
+    display.fillRect(0, 0, LCD::WIDTH, CAL_ROWS, 0x0000);
+    free(pattern);
+    free(row);
+    return result;
+}
+
+static void selectWriteClock()
+{
+    Preferences prefs;
+    prefs.begin(CAL_NVS_NAMESPACE, false);
+
+#ifndef LCD_SPI_RECALIBRATE
+    const uint32_t stored = prefs.getUInt(CAL_NVS_KEY, 0);
+    if (stored >= LCD_SPI_FREQ && stored <= CAL_STEPS[CAL_STEP_COUNT - 1])
+    {
+        display.setWriteClock(stored);
+        prefs.end();
+        LOG_INFO("[LCD] SPI write clock %lu Hz (stored)", (unsigned long)stored);
+        return;
+    }
+#endif
+
+    if (LCD_MISO_PIN < 0)
+    {
+        prefs.end();
+        LOG_WARN("[LCD] No MISO pin, SPI clock calibration skipped");
+        return;
+    }
+
+    const uint32_t hz = runCalibration();
+    if (hz == 0)
+    {
+        // Nothing stored, so the next boot tries again
+        prefs.end();
+        LOG_WARN("[LCD] Panel readback failed, SPI clock calibration skipped");
+        return;
+    }
+
+    display.setWriteClock(hz);
+    prefs.putUInt(CAL_NVS_KEY, hz);
+    prefs.end();
+    LOG_INFO("[LCD] SPI write clock %lu Hz (calibrated)", (unsigned long)hz);
+}
+
+#endif // LCD_SPI_CALIBRATE
+
+// --------------------------------------------------------------
+// Off-screen compositor
+// --------------------------------------------------------------
+// Height of each DMA strip in full-width rows (2 strips, 9.6KB each at 20).
+#ifndef LCD_BAND_ROWS
+#define LCD_BAND_ROWS 20
+#endif
+
+// Banded mode only: pixel payload (text tiles, images) recorded per frame,
+// and the number of draw operations recorded per frame. When either runs
+// out the frame so far is flushed early, which keeps painter's order.
+#ifndef LCD_ARENA_PIXELS
+#define LCD_ARENA_PIXELS 8192
+#endif
+#ifndef LCD_MAX_OPS
+#define LCD_MAX_OPS 128
+#endif
+
+// Frame mode only: dirty rectangles kept separately before collapsing
+// into one bounding box.
+#define LCD_MAX_DIRTY 12
+
+#define BAND_PIXELS ((int32_t)LCD::WIDTH * LCD_BAND_ROWS)
+
+struct LcdRect
+{
+    int16_t x;
+    int16_t y;
+    int16_t w;
+    int16_t h;
+};
+
+enum CompositorMode : uint8_t
+{
+    MODE_DIRECT, // no off-screen memory: draw straight to the panel
+    MODE_FRAME,  // full-frame sprite in PSRAM
+    MODE_BANDED, // display list replayed into strips at flush time
+};
+
+struct DrawOp
+{
+    LcdRect r;      // unclipped
+    uint16_t color; // fill color (native RGB565) when pixels < 0
+    int32_t pixels; // arena offset of r.w*r.h native RGB565 pixels, or -1
+};
+
+static CompositorMode mode = MODE_DIRECT;
+
+// Strips are DMA-capable internal RAM. The panel reads one while the other
+// is composed: pushImageDMA() waits for the previous transfer before
+// starting, so the strip not currently on the bus is always free.
+static LGFX_Sprite band0(&display);
+static LGFX_Sprite band1(&display);
+static LGFX_Sprite *bands[2] = {&band0, &band1};
+static uint8_t nextBand = 0;
+
+static LGFX_Sprite frame(&display);
+static LcdRect dirty[LCD_MAX_DIRTY];
+static uint8_t dirtyCount = 0;
+
+static DrawOp ops[LCD_MAX_OPS];
+static uint16_t opCount = 0;
+static uint16_t arena[LCD_ARENA_PIXELS];
+static int32_t arenaUsed = 0;
+
+// Open beginPixels() window
+static LcdRect streamRect;
+static int32_t streamPos = 0;
+static int32_t streamOffset = -1; // arena offset in banded mode
+static bool streamDirect = false; // window too large for the arena
+
+static inline uint16_t toPanelOrder(uint16_t color)
+{
+    // Strips and the frame sprite hold pixels in wire (big-endian) order
+    return (uint16_t)((color >> 8) | (color << 8));
+}
+
+static inline int16_t imin(int a, int b) { return (int16_t)(a < b ? a : b); }
+static inline int16_t imax(int a, int b) { return (int16_t)(a > b ? a : b); }
+
+static bool clipRect(LcdRect &r)
+{
+    if (r.x < 0)
+    {
+        r.w += r.x;
+        r.x = 0;
+    }
+    if (r.y < 0)
+    {
+        r.h += r.y;
+        r.y = 0;
+    }
+    if (r.x + r.w > LCD::WIDTH)
+        r.w = LCD::WIDTH - r.x;
+    if (r.y + r.h > LCD::HEIGHT)
+        r.h = LCD::HEIGHT - r.y;
+    return r.w > 0 && r.h > 0;
+}
+
+static bool intersect(const LcdRect &a, const LcdRect &b, LcdRect &out)
+{
+    const int16_t x0 = imax(a.x, b.x);
+    const int16_t y0 = imax(a.y, b.y);
+    const int16_t x1 = imin(a.x + a.w, b.x + b.w);
+    const int16_t y1 = imin(a.y + a.h, b.y + b.h);
+    if (x1 <= x0 || y1 <= y0)
+        return false;
+    out = {x0, y0, (int16_t)(x1 - x0), (int16_t)(y1 - y0)};
+    return true;
+}
+
+static bool contains(const LcdRect &outer, const LcdRect &inner)
+{
+    return inner.x >= outer.x && inner.y >= outer.y &&
+           inner.x + inner.w <= outer.x + outer.w && inner.y + inner.h <= outer.y + outer.h;
+}
+
+static LcdRect boundingBox(const LcdRect &a, const LcdRect &b)
+{
+    const int16_t x0 = imin(a.x, b.x);
+    const int16_t y0 = imin(a.y, b.y);
+    const int16_t x1 = imax(a.x + a.w, b.x + b.w);
+    const int16_t y1 = imax(a.y + a.h, b.y + b.h);
+    return {x0, y0, (int16_t)(x1 - x0), (int16_t)(y1 - y0)};
+}
+
+static void initCompositor()
+{
+    band0.setColorDepth(16);
+    band1.setColorDepth(16);
+    band0.setPsram(false);
+    band1.setPsram(false);
+    if (!band0.createSprite(LCD::WIDTH, LCD_BAND_ROWS) || !band1.createSprite(LCD::WIDTH, LCD_BAND_ROWS))
+    {
+        band0.deleteSprite();
+        band1.deleteSprite();
+        LOG_WARN("[LCD] No RAM for DMA strips, drawing directly");
+        mode = MODE_DIRECT;
+        return;
+    }
+
+    if (psramFound())
+    {
+        frame.setColorDepth(16);
+        frame.setPsram(true);
+        if (frame.createSprite(LCD::WIDTH, LCD::HEIGHT))
+        {
+            mode = MODE_FRAME;
+            LOG_INFO("[LCD] Compositor: full frame in PSRAM");
+            return;
+        }
+    }
+
+    mode = MODE_BANDED;
+    LOG_INFO("[LCD] Compositor: %d-row strips in internal RAM", LCD_BAND_ROWS);
+}
+
+// ---- frame mode ----------------------------------------------
+
+static void markDirty(LcdRect r)
+{
+    // Overlapping rects merge into their bounding box (the frame holds
+    // every pixel, so pushing a slightly larger area is always correct).
+    for (uint8_t i = 0; i < dirtyCount;)
+    {
+        LcdRect overlap;
+        if (intersect(dirty[i], r, overlap))
+        {
+            r = boundingBox(dirty[i], r);
+            dirty[i] = dirty[--dirtyCount];
+            i = 0;
+            continue;
+        }
+        ++i;
+    }
+
+    if (dirtyCount == LCD_MAX_DIRTY)
+    {
+        for (uint8_t i = 0; i < dirtyCount; ++i)
+            r = boundingBox(dirty[i], r);
+        dirtyCount = 0;
+    }
+    dirty[dirtyCount++] = r;
+}
+
+static void frameFill(const LcdRect &r, uint16_t color)
+{
+    uint16_t *fb = (uint16_t *)frame.getBuffer();
+    const uint16_t wire = toPanelOrder(color);
+    for (int16_t row = 0; row < r.h; ++row)
+    {
+        uint16_t *dst = fb + (int32_t)(r.y + row) * LCD::WIDTH + r.x;
+        for (int16_t col = 0; col < r.w; ++col)
+            dst[col] = wire;
+    }
+    markDirty(r);
+}
+
+static void flushFrame()
+{
+    const uint16_t *fb = (const uint16_t *)frame.getBuffer();
+    for (uint8_t i = 0; i < dirtyCount; ++i)
+    {
+        const LcdRect &r = dirty[i];
+        const int16_t rowsPerBand = BAND_PIXELS / r.w;
+        for (int16_t y = r.y; y < r.y + r.h; y += rowsPerBand)
+        {
+            const int16_t rows = imin(rowsPerBand, r.y + r.h - y);
+            // PSRAM is not DMA-capable on ESP32, so rows are staged in a strip
+            uint16_t *buf = (uint16_t *)bands[nextBand]->getBuffer();
+            for (int16_t row = 0; row < rows; ++row)
+                memcpy(buf + (int32_t)row * r.w, fb + (int32_t)(y + row) * LCD::WIDTH + r.x, r.w * sizeof(uint16_t));
+            display.pushImageDMA(r.x, y, r.w, rows, (const lgfx::swap565_t *)buf);
+            nextBand ^= 1;
+        }
+    }
+    dirtyCount = 0;
+}
+
+// ---- banded mode ---------------------------------------------
+
+static void flushBanded();
+
+static void recordOp(const LcdRect &r, uint16_t color, int32_t pixels)
+{
+    LcdRect clipped = r;
+    if (!clipRect(clipped))
+        return;
+    if (opCount == LCD_MAX_OPS)
+        flushBanded();
+    ops[opCount++] = {r, color, pixels};
+}
+
+// Paint every recorded op that touches band into buf (stride band.w)
+static void composeBand(const LcdRect &band, uint16_t *buf)
+{
+    for (uint16_t i = 0; i < opCount; ++i)
+    {
+        const DrawOp &op = ops[i];
+        LcdRect area;
+        if (!intersect(op.r, band, area))
+            continue;
+
+        for (int16_t y = area.y; y < area.y + area.h; ++y)
+        {
+            uint16_t *dst = buf + (int32_t)(y - band.y) * band.w + (area.x - band.x);
+            if (op.pixels < 0)
+            {
+                const uint16_t wire = toPanelOrder(op.color);
+                for (int16_t x = 0; x < area.w; ++x)
+                    dst[x] = wire;
+            }
+            else
+            {
+                const uint16_t *src = arena + op.pixels + (int32_t)(y - op.r.y) * op.r.w + (area.x - op.r.x);
+                for (int16_t x = 0; x < area.w; ++x)
+                    dst[x] = toPanelOrder(src[x]);
+            }
+        }
+    }
+}
+
+// Regions pushed for a banded frame. Every op fully paints its own rect,
+// so op rects (never their bounding boxes) are the only safe regions.
+// Rects inside another region are dropped and rects that join into an
+// exact rectangle are merged.
+static uint16_t buildRegions(LcdRect *regions)
+{
+    uint16_t n = 0;
+    for (uint16_t i = 0; i < opCount; ++i)
+    {
+        LcdRect r = ops[i].r;
+        if (clipRect(r))
+            regions[n++] = r;
+    }
+
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (uint16_t i = 0; i < n && !changed; ++i)
+        {
+            for (uint16_t j = 0; j < n; ++j)
+            {
+                if (i == j)
+                    continue;
+                const LcdRect &a = regions[i];
+                const LcdRect &b = regions[j];
+                const bool joinX = a.y == b.y && a.h == b.h && a.x + a.w == b.x;
+                const bool joinY = a.x == b.x && a.w == b.w && a.y + a.h == b.y;
+                if (contains(a, b) || joinX || joinY)
+                {
+                    regions[i] = boundingBox(a, b);
+                    regions[j] = regions[--n];
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+    return n;
+}
+
+static void flushBanded()
+{
+    static LcdRect regions[LCD_MAX_OPS];
+    const uint16_t n = buildRegions(regions);
+
+    for (uint16_t i = 0; i < n; ++i)
+    {
+        const LcdRect &r = regions[i];
+        const int16_t rowsPerBand = BAND_PIXELS / r.w;
+        for (int16_t y = r.y; y < r.y + r.h; y += rowsPerBand)
+        {
+            const LcdRect band = {r.x, y, r.w, imin(rowsPerBand, r.y + r.h - y)};
+            uint16_t *buf = (uint16_t *)bands[nextBand]->getBuffer();
+            composeBand(band, buf);
+            display.pushImageDMA(band.x, band.y, band.w, band.h, (const lgfx::swap565_t *)buf);
+            nextBand ^= 1;
+        }
+    }
+
+    // Strips hold their own copy, so the display list can be reused now
+    opCount = 0;
+    arenaUsed = 0;
+}
+
+// ---- shared entry points -------------------------------------
+
+static void compositeFill(LcdRect r, uint16_t color)
+{
+    switch (mode)
+    {
+    case MODE_FRAME:
+        if (clipRect(r))
+            frameFill(r, color);
+        break;
+    case MODE_BANDED:
+        recordOp(r, color, -1);
+        break;
+    default:
+        display.fillRect(r.x, r.y, r.w, r.h, color);
+        break;
+    }
+}
+
 void LCD::begin()
 {
     // If available, perform a manual hardware reset sequence first (some modules need it)
@@ -62,20 +579,21 @@ void LCD::begin()
         delay(20);
         digitalWrite(LCD_RST_PIN, HIGH);
         delay(20);
-#if DEBUG_ENABLED
-        Serial.println("[LCD] Manual RST toggle done");
-#endif
+        LOG_DEBUG("[LCD] Manual RST toggle done");
     }
 
-#if DEBUG_ENABLED
-    Serial.println("[LCD] Initializing LovyanGFX panel (freq_write=20MHz)");
-#endif
+    LOG_DEBUG("[LCD] Initializing LovyanGFX panel (freq_write=%luHz)", (unsigned long)display.writeClock());
     // Initialize panel
     display.init();
 
     // Leave byte order as-is; swapping plus BGR was causing blue-only output
     display.setSwapBytes(false);
 
+#ifdef LCD_SPI_CALIBRATE
+    // Before the backlight comes on, so the test patterns are not visible
+    selectWriteClock();
+#endif
+
     // ensure backlight PWM initialized
     pinMode(LCD_BL_PIN, OUTPUT);
     ledcSetup(0, 5000, 8);
@@ -90,10 +608,15 @@ void LCD::begin()
         pinMode(LCD_BL_PIN, INPUT_PULLUP);
         int bl = digitalRead(LCD_BL_PIN);
         pinMode(LCD_BL_PIN, OUTPUT);
-#if DEBUG_ENABLED
-        Serial.printf("[LCD-DIAG] BL pin read back = %d\n", bl);
-#endif
+        LOG_DEBUG("[LCD-DIAG] BL pin read back = %d", bl);
+        (void)bl;
     }
+
+    initCompositor();
+
+    // Keep the bus transaction open so DMA pushes started by flush() run
+    // asynchronously instead of being waited on by endWrite().
+    display.startWrite();
 }
 
 void LCD::setBacklight(uint8_t level)
@@ -104,29 +627,214 @@ void LCD::setBacklight(uint8_t level)
 
 void LCD::setRotation(uint8_t rot)
 {
-    // LovyanGFX uses 0-3 for rotation
+    // LovyanGFX uses 0-3 for rotation. The compositor assumes a portrait
+    // (240x320) logical surface, i.e. rotation 0 or 2.
     display.setRotation(rot & 3);
 }
 
 void LCD::drawPixel(int16_t x, int16_t y, uint16_t color)
 {
-    // LovyanGFX expects 16-bit RGB565 color; pass through
-    display.drawPixel(x, y, color);
+    compositeFill({x, y, 1, 1}, color);
 }
 
 void LCD::fillScreen(uint16_t color)
 {
-    display.fillScreen(color);
+    compositeFill({0, 0, WIDTH, HEIGHT}, color);
 }
 
 void LCD::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
 {
-    display.fillRect(x, y, w, h, color);
+    if (w > 0 && h > 0)
+        compositeFill({x, y, w, h}, color);
 }
 
 void LCD::drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
 {
-    display.drawRect(x, y, w, h, color);
+    if (w <= 0 || h <= 0)
+        return;
+
+    // Four edges, so each recorded op still paints its whole rect
+    fillRect(x, y, w, 1, color);
+    fillRect(x, y + h - 1, w, 1, color);
+    fillRect(x, y + 1, 1, h - 2, color);
+    fillRect(x + w - 1, y + 1, 1, h - 2, color);
+}
+
+void LCD::pushPixels(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t *pixels)
+{
+    if (!pixels || w <= 0 || h <= 0)
+        return;
+
+    beginPixels(x, y, w, h);
+    writePixels(pixels, (uint32_t)w * h);
+    endPixels();
+}
+
+void LCD::beginPixels(int16_t x, int16_t y, int16_t w, int16_t h)
+{
+    streamRect = {x, y, w, h};
+    streamPos = 0;
+    streamOffset = -1;
+    streamDirect = false;
+    const int32_t count = (int32_t)w * h;
+
+    if (mode == MODE_BANDED && count <= LCD_ARENA_PIXELS)
+    {
+        if (opCount == LCD_MAX_OPS || arenaUsed + count > LCD_ARENA_PIXELS)
+            flushBanded();
+        streamOffset = arenaUsed;
+        arenaUsed += count;
+        recordOp(streamRect, 0, streamOffset);
+        return;
+    }
+
+    if (mode == MODE_BANDED || mode == MODE_DIRECT)
+    {
+        // Too large to record: settle what is queued, then stream straight
+        // into a panel window.
+        if (mode == MODE_BANDED)
+            flushBanded();
+        streamDirect = true;
+        display.waitDMA();
+        display.setAddrWindow(x, y, w, h);
+    }
+}
+
+void LCD::writePixels(const uint16_t *pixels, uint32_t count)
+{
+    if (streamDirect)
+    {
+        // rgb565_t tells LovyanGFX the data is native-endian, independent of setSwapBytes()
+        display.writePixels((const lgfx::rgb565_t *)pixels, (int32_t)count);
+        streamPos += count;
+        return;
+    }
+
+    const int32_t total = (int32_t)streamRect.w * streamRect.h;
+    if (streamPos + (int32_t)count > total)
+        count = total - streamPos;
+
+    if (mode == MODE_BANDED)
+    {
+        if (streamOffset >= 0)
+            memcpy(arena + streamOffset + streamPos, pixels, count * sizeof(uint16_t));
+        streamPos += count;
+        return;
+    }
+
+    // MODE_FRAME: copy into the frame one (partial) window row at a time,
+    // dropping anything outside the screen
+    uint16_t *fb = (uint16_t *)frame.getBuffer();
+    while (count > 0)
+    {
+        const int16_t col = streamPos % streamRect.w;
+        const int16_t py = streamRect.y + streamPos / streamRect.w;
+        const int16_t run = imin(streamRect.w - col, (int)count);
+        if (py >= 0 && py < HEIGHT)
+        {
+            for (int16_t i = 0; i < run; ++i)
+            {
+                const int16_t px = streamRect.x + col + i;
+                if (px >= 0 && px < WIDTH)
+                    fb[(int32_t)py * WIDTH + px] = toPanelOrder(pixels[i]);
+            }
+        }
+        pixels += run;
+        streamPos += run;
+        count -= run;
+    }
+}
+
+void LCD::endPixels()
+{
+    if (mode == MODE_FRAME)
+    {
+        LcdRect r = streamRect;
+        if (clipRect(r))
+            markDirty(r);
+    }
+    streamDirect = false;
+}
+
+void LCD::flush()
+{
+    if (mode == MODE_FRAME)
+        flushFrame();
+    else if (mode == MODE_BANDED)
+        flushBanded();
+}
+
+void LCD::waitIdle()
+{
+    display.waitDMA();
+}
+
+// --------------------------------------------------------------
+// Vertical scrolling
+// --------------------------------------------------------------
+#define ST7789_VSCRDEF 0x33 // top fixed, scroll area, bottom fixed rows
+#define ST7789_VSCSAD 0x37  // panel row shown first in the scroll area
+
+static int16_t scrollTop = 0;
+static int16_t scrollHeight = LCD::HEIGHT;
+
+// Rotation 2 addresses panel rows from the other edge, and the panel then
+// walks the scroll ring backwards as seen from the drawing side
+static bool rowsMirrored()
+{
+    return display.getRotation() == 2;
+}
+
+static uint16_t scrollFixedTop()
+{
+    return rowsMirrored() ? LCD::HEIGHT - scrollTop - scrollHeight : scrollTop;
+}
+
+void LCD::writeCommand(uint8_t cmd)
+{
+    display.writeCommand(cmd);
+}
+
+void LCD::writeData(uint8_t data)
+{
+    display.writeData(data);
+}
+
+void LCD::setScrollArea(int16_t top, int16_t height)
+{
+    if (top < 0 || height <= 0 || top + height > HEIGHT)
+        return;
+    scrollTop = top;
+    scrollHeight = height;
+
+    const uint16_t tfa = scrollFixedTop();
+    const uint16_t bfa = HEIGHT - tfa - height;
+    display.waitDMA();
+    writeCommand(ST7789_VSCRDEF);
+    writeData(tfa >> 8);
+    writeData(tfa & 0xFF);
+    writeData(height >> 8);
+    writeData(height & 0xFF);
+    writeData(bfa >> 8);
+    writeData(bfa & 0xFF);
+    setScrollOffset(0);
+}
+
+void LCD::setScrollOffset(int16_t offset)
+{
+    offset %= scrollHeight;
+    if (offset < 0)
+        offset += scrollHeight;
+    const uint16_t vsp = scrollFixedTop() + (rowsMirrored() ? (scrollHeight - offset) % scrollHeight : offset);
+    display.waitDMA();
+    writeCommand(ST7789_VSCSAD);
+    writeData(vsp >> 8);
+    writeData(vsp & 0xFF);
+}
+
+uint32_t LCD::writeClock()
+{
+    return display.writeClock();
 }
 
 #endif // HAS_LCD_240x320
@@ -1,140 +1,46 @@
 #include <Arduino.h>
+#include <algorithm>
+#include "dev_log.h"
+#include "event_log.h"
+#include "hangul.h"
 #include "lcd_app.h"
 #include "lcd.h"
 #include "main.h"
+#include "profiler.h"
+#include "qoi_stream.h"
+#include "qr_code.h"
+#include "sparkline.h"
 
 #ifdef HAS_LCD_240x320
 
-// ------------------------------------------------------------
-// Small 5x7 bitmap font for uppercase letters, digits, and a
-// handful of punctuation. Stored column-wise.
-// ------------------------------------------------------------
-static const uint8_t FONT_5X7[][5] = {
-    // 32 ' '
-    {0x00, 0x00, 0x00, 0x00, 0x00},
-    // 33 '!'
-    {0x00, 0x00, 0x5f, 0x00, 0x00},
-    // 34 '"'
-    {0x00, 0x07, 0x00, 0x07, 0x00},
-    // 35 '#'
-    {0x14, 0x7f, 0x14, 0x7f, 0x14},
-    // 36 '$'
-    {0x24, 0x2a, 0x7f, 0x2a, 0x12},
-    // 37 '%'
-    {0x23, 0x13, 0x08, 0x64, 0x62},
-    // 38 '&'
-    {0x36, 0x49, 0x55, 0x22, 0x50},
-    // 39 '\''
-    {0x00, 0x05, 0x03, 0x00, 0x00},
-    // 40 '('
-    {0x00, 0x1c, 0x22, 0x41, 0x00},
-    // 41 ')'
-    {0x00, 0x41, 0x22, 0x1c, 0x00},
-    // 42 '*'
-    {0x14, 0x08, 0x3e, 0x08, 0x14},
-    // 43 '+'
-    {0x08, 0x08, 0x3e, 0x08, 0x08},
-    // 44 ','
-    {0x00, 0x50, 0x30, 0x00, 0x00},
-    // 45 '-'
-    {0x08, 0x08, 0x08, 0x08, 0x08},
-    // 46 '.'
-    {0x00, 0x60, 0x60, 0x00, 0x00},
-    // 47 '/'
-    {0x20, 0x10, 0x08, 0x04, 0x02},
-    // 48 '0'
-    {0x3e, 0x45, 0x49, 0x51, 0x3e},
-    // 49 '1'
-    {0x00, 0x21, 0x7f, 0x01, 0x00},
-    // 50 '2'
-    {0x21, 0x43, 0x45, 0x49, 0x31},
-    // 51 '3'
-    {0x42, 0x41, 0x51, 0x69, 0x46},
-    // 52 '4'
-    {0x0c, 0x14, 0x24, 0x7f, 0x04},
-    // 53 '5'
-    {0x72, 0x51, 0x51, 0x51, 0x4e},
-    // 54 '6'
-    {0x1e, 0x29, 0x49, 0x49, 0x06},
-    // 55 '7'
-    {0x40, 0x47, 0x48, 0x50, 0x60},
-    // 56 '8'
-    {0x36, 0x49, 0x49, 0x49, 0x36},
-    // 57 '9'
-    {0x30, 0x49, 0x49, 0x4a, 0x3c},
-    // 58 ':'
-    {0x00, 0x36, 0x36, 0x00, 0x00},
-    // 59 ';'
-    {0x00, 0x56, 0x36, 0x00, 0x00},
-    // 60 '<'
-    {0x08, 0x14, 0x22, 0x41, 0x00},
-    // 61 '='
-    {0x14, 0x14, 0x14, 0x14, 0x14},
-    // 62 '>'
-    {0x00, 0x41, 0x22, 0x14, 0x08},
-    // 63 '?'
-    {0x20, 0x40, 0x45, 0x48, 0x30},
-    // 64 '@'
-    {0x32, 0x49, 0x79, 0x41, 0x3e},
-    // 65 'A'
-    {0x3f, 0x48, 0x48, 0x48, 0x3f},
-    // 66 'B'
-    {0x7f, 0x49, 0x49, 0x49, 0x36},
-    // 67 'C'
-    {0x3e, 0x41, 0x41, 0x41, 0x22},
-    // 68 'D'
-    {0x7f, 0x41, 0x41, 0x22, 0x1c},
-    // 69 'E'
-    {0x7f, 0x49, 0x49, 0x49, 0x41},
-    // 70 'F'
-    {0x7f, 0x48, 0x48, 0x48, 0x40},
-    // 71 'G'
-    {0x3e, 0x41, 0x49, 0x49, 0x2e},
-    // 72 'H'
-    {0x7f, 0x08, 0x08, 0x08, 0x7f},
-    // 73 'I'
-    {0x00, 0x41, 0x7f, 0x41, 0x00},
-    // 74 'J'
-    {0x02, 0x01, 0x01, 0x01, 0x7e},
-    // 75 'K'
-    {0x7f, 0x08, 0x14, 0x22, 0x41},
-    // 76 'L'
-    {0x7f, 0x01, 0x01, 0x01, 0x01},
-    // 77 'M'
-    {0x7f, 0x20, 0x18, 0x20, 0x7f},
-    // 78 'N'
-    {0x7f, 0x10, 0x08, 0x04, 0x7f},
-    // 79 'O'
-    {0x3e, 0x41, 0x41, 0x41, 0x3e},
-    // 80 'P'
-    {0x7f, 0x48, 0x48, 0x48, 0x30},
-    // 81 'Q'
-    {0x3e, 0x41, 0x45, 0x42, 0x3d},
-    // 82 'R'
-    {0x7f, 0x48, 0x4c, 0x4a, 0x31},
-    // 83 'S'
-    {0x31, 0x49, 0x49, 0x49, 0x46},
-    // 84 'T'
-    {0x40, 0x40, 0x7f, 0x40, 0x40},
-    // 85 'U'
-    {0x7e, 0x01, 0x01, 0x01, 0x7e},
-    // 86 'V'
-    {0x7c, 0x02, 0x01, 0x02, 0x7c},
-    // 87 'W'
-    {0x7f, 0x02, 0x0c, 0x02, 0x7f},
-    // 88 'X'
-    {0x63, 0x14, 0x08, 0x14, 0x63},
-    // 89 'Y'
-    {0x70, 0x08, 0x07, 0x08, 0x70},
-    // 90 'Z'
-    {0x43, 0x45, 0x49, 0x51, 0x61},
-};
-
-static inline uint16_t rgb565(uint8_t r, uint8_t g, uint8_t b)
+static constexpr uint16_t rgb565(uint8_t r, uint8_t g, uint8_t b)
 {
     return (uint16_t)((((uint16_t)(r & 0xF8) << 8)) | (((uint16_t)(g & 0xFC) << 3)) | ((b & 0xF8) >> 3));
 }
 
+/*
+    x- y coordinates are top-left of the LCD area
+    320|
+        |
+        |
+        |
+        |
+        +----------------240
+
+*/
+#define LCD_WIDTH 240
+#define LCD_HEIGHT 320
+
+// Large UI text; both variants have the same metrics
+#ifdef LCD_FONT_AA
+static constexpr const Font &FONT_UI_LARGE = FONT_LARGE_AA;
+#else
+static constexpr const Font &FONT_UI_LARGE = FONT_LARGE;
+#endif
+
+// Screen background; also used behind text so glyph cells clear themselves.
+static constexpr uint16_t COLOR_SCREEN_BG = rgb565(10, 12, 18);
+
 // Simple Bresenham line drawer (used for tiny icons)
 static void drawLine(int x0, int y0, int x1, int y1, uint16_t color)
 {
@@ -166,54 +72,115 @@ static void drawLine(int x0, int y0, int x1, int y1, uint16_t color)
 // -------------------------------------------------------------------
 // Font rendering
 // -------------------------------------------------------------------
-static const uint8_t *lookupGlyph(char c)
+// Scratch tile the text is rasterized into before it goes to the panel:
+// one full-width row of large glyphs (8.6KB). Anything taller streams
+// through it band by band inside the same address window.
+#define TEXT_TILE_PIXELS (LCD_WIDTH * 18)
+static uint16_t textTile[TEXT_TILE_PIXELS];
+
+static uint16_t blend565(uint16_t fg, uint16_t bg, uint8_t level)
+{
+    // level 0..3 of fg over bg, per channel
+    const uint16_t r = (((fg >> 11) & 0x1F) * level + ((bg >> 11) & 0x1F) * (3 - level)) / 3;
+    const uint16_t g = (((fg >> 5) & 0x3F) * level + ((bg >> 5) & 0x3F) * (3 - level)) / 3;
+    const uint16_t b = ((fg & 0x1F) * level + (bg & 0x1F) * (3 - level)) / 3;
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+// One decoded character of a draw call: an atlas glyph, or a Hangul
+// bitmap from the cache (hangul.h) sitting `top` rows down in the cell.
+struct TextGlyph
 {
-    // Normalize lowercase to uppercase to save table space
-    if (c >= 'a' && c <= 'z')
-        c = char(c - 'a' + 'A');
+    const FontGlyph *glyph;
+    const uint8_t *hangul;
+};
 
-    if (c < 32 || c > 90)
-        return FONT_5X7[0]; // space
+#define TEXT_MAX_GLYPHS (LCD_WIDTH / 2) // narrowest glyph plus spacing is 2px
+static TextGlyph textGlyphs[TEXT_MAX_GLYPHS];
 
-    return FONT_5X7[c - 32];
-}
+static_assert(LCD_HANGUL_CACHE >= LCD_WIDTH / (FONT_HANGUL_SIZE + 2) + 1,
+              "Hangul cache must hold a full line, the draw keeps every glyph pointer");
 
-void lcdDrawText(const char *text, int x, int y, uint16_t color, uint8_t scale)
+void lcdDrawTextFont(const Font &font, const char *text, int x, int y, uint16_t color, uint16_t bg, int boxW)
 {
-    int cursorX = x;
-    const int glyphW = 5 * scale;
-    const int spacing = 1 * scale;
+    if (!text || x < 0 || x >= LCD_WIDTH || y < 0 || y >= LCD_HEIGHT)
+        return;
+
+    const int textW = fontTextWidth(font, text);
+    int w = textW > boxW ? textW : boxW;
+    if (w > LCD_WIDTH - x)
+        w = LCD_WIDTH - x;
+    if (w <= 0)
+        return;
+
+    // Decode the UTF-8 once, keeping only what fits the window
+    int count = 0;
+    const bool hangulFits = font.height >= FONT_HANGUL_SIZE;
+    for (int cx = 0; *text && cx < w && count < TEXT_MAX_GLYPHS; ++count)
+    {
+        const uint32_t cp = fontNextCodepoint(text);
+        TextGlyph &g = textGlyphs[count];
+        g.hangul = hangulFits ? hangulGlyph(cp, font.bpp == 2) : nullptr;
+        g.glyph = g.hangul ? nullptr : &fontGlyph(font, cp < 0x80 ? (char)cp : '?');
+        cx += (g.hangul ? FONT_HANGUL_SIZE : g.glyph->width) + font.spacing;
+    }
+
+    const int hangulTop = (font.height - FONT_HANGUL_SIZE) / 2;
+    // Rows past the bottom edge are cut, as columns past the right edge are
+    const int h = font.height < LCD_HEIGHT - y ? font.height : LCD_HEIGHT - y;
+    const int bandRows = TEXT_TILE_PIXELS / w;
+    uint16_t palette[4] = {bg, color, color, color};
+    if (font.bpp == 2)
+    {
+        palette[1] = blend565(color, bg, 1);
+        palette[2] = blend565(color, bg, 2);
+    }
 
-    for (const char *p = text; *p; ++p)
+    // Whole string plus box padding (background included) goes out in one
+    // windowed write.
+    LCD::beginPixels(x, y, w, h);
+    for (int bandY = 0; bandY < h; bandY += bandRows)
     {
-        const uint8_t *glyph = lookupGlyph(*p);
-        for (int col = 0; col < 5; ++col)
+        const int rows = (h - bandY) < bandRows ? (h - bandY) : bandRows;
+        uint16_t *dst = textTile;
+        for (int py = bandY; py < bandY + rows; ++py)
         {
-            uint8_t bits = glyph[col];
-            for (int row = 0; row < 7; ++row)
+            uint16_t *rowEnd = dst + w;
+            for (int i = 0; i < count && dst < rowEnd; ++i)
             {
-                if (bits & (1 << row))
+                const TextGlyph &g = textGlyphs[i];
+                if (g.hangul)
+                {
+                    const int gy = py - hangulTop;
+                    const bool inside = gy >= 0 && gy < FONT_HANGUL_SIZE;
+                    for (int gx = 0; gx < FONT_HANGUL_SIZE && dst < rowEnd; ++gx)
+                    {
+                        const int bit = (gy * FONT_HANGUL_SIZE + gx) * 2;
+                        *dst++ = inside ? palette[(g.hangul[bit >> 3] >> (6 - (bit & 7))) & 3] : bg;
+                    }
+                }
+                else
                 {
-                    LCD::fillRect(cursorX + col * scale, y + row * scale, scale, scale, color);
+                    for (int gx = 0; gx < g.glyph->width && dst < rowEnd; ++gx)
+                        *dst++ = palette[fontPixel(font, *g.glyph, gx, py)];
                 }
+                for (int s = 0; s < font.spacing && i + 1 < count && dst < rowEnd; ++s)
+                    *dst++ = bg;
             }
+            while (dst < rowEnd)
+                *dst++ = bg;
         }
-        cursorX += glyphW + spacing;
+        LCD::writePixels(textTile, (uint32_t)rows * w);
     }
+    LCD::endPixels();
 }
 
-/*
-    x- y coordinates are top-left of the LCD area
-    320|
-        |
-        |
-        |
-        |
-        +----------------240
+void lcdDrawText(const char *text, int x, int y, uint16_t color, uint16_t bg, uint8_t scale)
+{
+    if (scale > 0)
+        lcdDrawTextFont(scale >= 2 ? FONT_UI_LARGE : FONT_SMALL, text, x, y, color, bg);
+}
 
-*/
-#define LCD_WIDTH 240
-#define LCD_HEIGHT 320
 // -------------------------------------------------------------------
 // Basic shapes and UI primitives
 // -------------------------------------------------------------------
@@ -222,21 +189,22 @@ static void drawBadge(int x, int y, int w, int h, uint16_t bg)
     LCD::fillRect(x, y, w, h, bg);
 }
 
-static void drawWifiIcon(int x, int y, bool connected, int rssi)
+static int wifiBars(bool connected, int rssi)
+{
+    if (!connected)
+        return 0;
+    if (rssi > -50)
+        return 4;
+    if (rssi > -60)
+        return 3;
+    if (rssi > -70)
+        return 2;
+    return 1;
+}
+
+static void drawWifiIcon(int x, int y, bool connected, int bars)
 {
     uint16_t color = connected ? rgb565(80, 200, 120) : rgb565(200, 80, 80);
-    int bars = 0;
-    if (connected)
-    {
-        if (rssi > -50)
-            bars = 4;
-        else if (rssi > -60)
-            bars = 3;
-        else if (rssi > -70)
-            bars = 2;
-        else
-            bars = 1;
-    }
 
     const int barW = 6;
     const int barSpacing = 4;
@@ -289,27 +257,586 @@ static void drawSensorCard(int idx, bool on)
     const int cardX = 5;
     const int cardY = LCD_HEIGHT - 70 - (idx * 40);
 
-    uint16_t bg = on ? rgb565(40, 90, 50) : rgb565(40, 44, 54);
-
     char label[24];
     snprintf(label, sizeof(label), "SENSOR %d:", idx + 1);
-    lcdDrawText(label, cardX + 10, cardY + 10, rgb565(210, 220, 235), 2);
+    lcdDrawTextFont(FONT_UI_LARGE, label, cardX + 10, cardY + 10, rgb565(210, 220, 235), COLOR_SCREEN_BG);
 
+    // The box is as wide as the wider state, so "ON" fully covers a previous "OFF"
+    constexpr int stateBoxW = std::max(fontTextWidth(FONT_UI_LARGE, "ON"), fontTextWidth(FONT_UI_LARGE, "OFF"));
     const char *stateText = on ? "ON" : "OFF";
     uint16_t stateColor = on ? rgb565(200, 255, 200) : rgb565(220, 180, 160);
-    // Clear previous state text area to avoid ghosting when toggling
-    // LCD::fillRect(cardX + 140, cardY + 6, 90, 20, bg);
-    drawBadge(cardX + 140, cardY + 6, 90, 20, rgb565(10, 12, 18));
-    lcdDrawText(stateText, cardX + 150, cardY + 10, stateColor, 2);
+    lcdDrawTextFont(FONT_UI_LARGE, stateText, cardX + 150, cardY + 10, stateColor, COLOR_SCREEN_BG, stateBoxW);
 }
 
 static void drawHeader()
 {
     const uint16_t headerBg = rgb565(18, 26, 36);
     // LCD::fillRect(0, 0, 240, 56, headerBg);
-    drawBadge(5, 10, 230, 36, rgb565(10, 12, 18));
-    // lcdDrawText("https://atcloud365.com", 10, 10, rgb565(210, 230, 255), 2);
-    lcdDrawText("atcloud365.com", 10, 10, rgb565(210, 230, 255), 2);
+    drawBadge(5, 10, 230, 36, COLOR_SCREEN_BG);
+    // lcdDrawText("https://atcloud365.com", 10, 10, rgb565(210, 230, 255), COLOR_SCREEN_BG, 2);
+    lcdDrawTextFont(FONT_UI_LARGE, "atcloud365.com", 10, 10, rgb565(210, 230, 255), COLOR_SCREEN_BG);
+}
+
+static void drawClock(const UiSnapshot &state)
+{
+    // Text boxes are sized at compile time for the widest value, and text
+    // cells carry the screen background, so nothing is cleared first.
+    constexpr int dateBoxW = fontTextWidth(FONT_SMALL, "0000-00-00");
+    constexpr int timeBoxW = fontTextWidth(FONT_UI_LARGE, "00:00:00");
+    const int badgeY = LCD_HEIGHT - 38;
+    lcdDrawTextFont(FONT_SMALL, state.dateText, 10, badgeY + 10, rgb565(150, 190, 230), COLOR_SCREEN_BG,
+                    dateBoxW);
+    lcdDrawTextFont(FONT_UI_LARGE, state.timeText, 10, badgeY + 20, rgb565(220, 240, 255), COLOR_SCREEN_BG,
+                    timeBoxW);
+}
+
+// -------------------------------------------------------------------
+// Sensor sparklines
+// -------------------------------------------------------------------
+// A strip above each sensor row, one screen column per history column.
+// Column x always shows ring slot x, so the trace sweeps left to right
+// like an oscilloscope instead of scrolling: a tick paints only the new
+// columns plus the blank gap ahead of them, and costs the same however
+// long the history is. The oldest data sits just right of the gap.
+// Strips are the one widget that does not repaint its whole rectangle on
+// every draw, which is safe because nothing overlaps them.
+#define SPARK_X 15
+#define SPARK_HEIGHT 7
+#define SPARK_GAP 3
+
+static constexpr int sparkY(int idx) { return LCD_HEIGHT - 70 - (idx * 40) + 1; }
+
+static SparkHistory sparkHistory[SENSOR_COUNT];
+static uint32_t sparkDrawn[SENSOR_COUNT]; // history columns already on screen
+static bool sparkStale[SENSOR_COUNT];     // strip must be repainted whole
+
+// What screen column x of the strip shows now, as a SPARK_* code or -1
+// for blank (the sweep gap, or no history yet)
+static int sparkCodeAt(const SparkHistory &h, int x)
+{
+    const int head = (int)(h.columns % SPARK_COLUMNS);
+    const uint32_t age = (uint32_t)((head - 1 - x + SPARK_COLUMNS) % SPARK_COLUMNS); // 0 = newest
+    if (age >= SPARK_COLUMNS - SPARK_GAP || age >= h.columns)
+        return -1;
+    return sparkColumn(h, h.columns - 1 - age);
+}
+
+// Screen columns x0 .. x0 + w - 1 of the strip as one window
+static void drawSparkSpan(int idx, int x0, int w)
+{
+    const uint16_t colorOn = rgb565(200, 255, 200);
+    const uint16_t colorMixed = rgb565(110, 160, 120);
+    const uint16_t colorOff = rgb565(60, 60, 70);
+
+    uint16_t *px = textTile;
+    for (int row = 0; row < SPARK_HEIGHT; ++row)
+        for (int x = x0; x < x0 + w; ++x)
+        {
+            const int code = sparkCodeAt(sparkHistory[idx], x);
+            uint16_t c = COLOR_SCREEN_BG;
+            if (code == SPARK_ON)
+                c = colorOn;
+            else if (code == SPARK_MIXED)
+                c = colorMixed;
+            else if (code == SPARK_OFF && row == SPARK_HEIGHT - 1)
+                c = colorOff; // baseline
+            *px++ = c;
+        }
+
+    LCD::beginPixels(SPARK_X + x0, sparkY(idx), w, SPARK_HEIGHT);
+    LCD::writePixels(textTile, (uint32_t)w * SPARK_HEIGHT);
+    LCD::endPixels();
+}
+
+static void drawSparkline(int idx)
+{
+    static_assert(SPARK_COLUMNS * SPARK_HEIGHT <= TEXT_TILE_PIXELS, "strip is composed in textTile");
+
+    const SparkHistory &h = sparkHistory[idx];
+    const uint32_t fresh = h.columns - sparkDrawn[idx];
+    if (sparkStale[idx] || fresh > SPARK_COLUMNS - SPARK_GAP)
+    {
+        drawSparkSpan(idx, 0, SPARK_COLUMNS);
+    }
+    else
+    {
+        // New columns and the gap ahead of them, split where the ring wraps
+        const int start = (int)(sparkDrawn[idx] % SPARK_COLUMNS);
+        const int len = (int)fresh + SPARK_GAP;
+        const int first = std::min(len, SPARK_COLUMNS - start);
+        drawSparkSpan(idx, start, first);
+        if (len > first)
+            drawSparkSpan(idx, 0, len - first);
+    }
+    sparkDrawn[idx] = h.columns;
+    sparkStale[idx] = false;
+}
+
+// -------------------------------------------------------------------
+// Retained widget table
+// -------------------------------------------------------------------
+// Each widget owns a screen rectangle and reduces the part of the
+// snapshot it displays to a hash. A frame only redraws widgets whose hash
+// changed (plus any widget overlapping one that is redrawn), so a frame
+// with no visible change sends nothing to the panel. Draw functions must
+// repaint every pixel they may have painted before.
+struct UiWidget
+{
+    UiRect bounds;
+    uint32_t (*hash)(const UiSnapshot &state, int arg);
+    void (*draw)(const UiSnapshot &state, int arg);
+    int arg;
+    uint32_t lastHash;
+    bool valid; // false until drawn once (or after lcdUiInit)
+};
+
+static uint32_t hashMix(uint32_t h, uint32_t v)
+{
+    // FNV-1a over the 4 bytes of v
+    for (int i = 0; i < 4; ++i)
+    {
+        h ^= (v >> (i * 8)) & 0xFF;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static uint32_t hashString(uint32_t h, const char *s)
+{
+    for (; *s; ++s)
+    {
+        h ^= (uint8_t)*s;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static const uint32_t HASH_SEED = 2166136261u;
+
+static uint32_t headerHash(const UiSnapshot &, int) { return HASH_SEED; }
+static void headerDraw(const UiSnapshot &, int) { drawHeader(); }
+
+static uint32_t clockHash(const UiSnapshot &state, int)
+{
+    return hashString(hashString(HASH_SEED, state.dateText), state.timeText);
+}
+static void clockDraw(const UiSnapshot &state, int) { drawClock(state); }
+
+// RSSI is hashed as displayed bars, so signal jitter inside a band is free.
+static uint32_t wifiHash(const UiSnapshot &state, int)
+{
+    return hashMix(hashMix(HASH_SEED, state.wifiConnected), wifiBars(state.wifiConnected, state.wifiRssi));
+}
+static void wifiDraw(const UiSnapshot &state, int)
+{
+    drawWifiIcon(160, LCD_HEIGHT - 25, state.wifiConnected, wifiBars(state.wifiConnected, state.wifiRssi));
+}
+
+static uint32_t socketHash(const UiSnapshot &state, int) { return hashMix(HASH_SEED, state.socketConnected); }
+static void socketDraw(const UiSnapshot &state, int) { drawSocketConnectIcon(215, LCD_HEIGHT - 17, state.socketConnected); }
+
+static uint32_t sensorHash(const UiSnapshot &state, int idx) { return hashMix(HASH_SEED, state.sensors[idx]); }
+static void sensorDraw(const UiSnapshot &state, int idx) { drawSensorCard(idx, state.sensors[idx]); }
+
+// Changes once per committed history column
+static uint32_t sparkHash(const UiSnapshot &, int idx) { return hashMix(HASH_SEED, sparkHistory[idx].columns); }
+static void sparkDraw(const UiSnapshot &, int idx) { drawSparkline(idx); }
+
+#define UI_FIXED_WIDGETS 4
+#define UI_WIDGET_COUNT (UI_FIXED_WIDGETS + 2 * SENSOR_COUNT)
+
+static UiWidget widgets[UI_WIDGET_COUNT] = {
+    {{5, 10, 230, 36}, headerHash, headerDraw, 0, 0, false},
+    {{5, LCD_HEIGHT - 38, 100, 38}, clockHash, clockDraw, 0, 0, false},
+    {{158, LCD_HEIGHT - 25, 38, 25}, wifiHash, wifiDraw, 0, 0, false},
+    {{214, LCD_HEIGHT - 16, 20, 16}, socketHash, socketDraw, 0, 0, false},
+};
+
+static bool widgetsLaidOut = false;
+static bool screenCleared = false; // lcdUiInit() ran since the last render
+static UiFrameStats lastFrameStats = {};
+
+static void layoutSensorWidgets()
+{
+    for (int i = 0; i < SENSOR_COUNT; ++i)
+    {
+        const int16_t cardY = LCD_HEIGHT - 70 - (i * 40);
+        const UiRect bounds = {5, (int16_t)(cardY + 10), 230, FONT_UI_LARGE.height};
+        widgets[UI_FIXED_WIDGETS + i] = {bounds, sensorHash, sensorDraw, i, 0, false};
+
+        const UiRect sparkBounds = {SPARK_X, (int16_t)sparkY(i), SPARK_COLUMNS, SPARK_HEIGHT};
+        widgets[UI_FIXED_WIDGETS + SENSOR_COUNT + i] = {sparkBounds, sparkHash, sparkDraw, i, 0, false};
+    }
+    widgetsLaidOut = true;
+}
+
+static bool rectsOverlap(const UiRect &a, const UiRect &b)
+{
+    return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+}
+
+// Exact area of the union of rects (n is small, so a simple slab sweep
+// over the distinct x edges is enough).
+static uint32_t unionArea(const UiRect *rects, int n)
+{
+    int16_t xs[2 * UI_WIDGET_COUNT];
+    int nx = 0;
+    for (int i = 0; i < n; ++i)
+    {
+        xs[nx++] = rects[i].x;
+        xs[nx++] = rects[i].x + rects[i].w;
+    }
+    std::sort(xs, xs + nx);
+
+    uint32_t area = 0;
+    for (int k = 0; k + 1 < nx; ++k)
+    {
+        const int16_t x0 = xs[k];
+        const int16_t x1 = xs[k + 1];
+        if (x0 == x1)
+            continue;
+
+        // y-intervals of rects spanning this slab, merged after sorting
+        int16_t y0s[UI_WIDGET_COUNT];
+        int16_t y1s[UI_WIDGET_COUNT];
+        int ny = 0;
+        for (int i = 0; i < n; ++i)
+        {
+            if (rects[i].x <= x0 && rects[i].x + rects[i].w >= x1)
+            {
+                int j = ny++;
+                while (j > 0 && y0s[j - 1] > rects[i].y)
+                {
+                    y0s[j] = y0s[j - 1];
+                    y1s[j] = y1s[j - 1];
+                    --j;
+                }
+                y0s[j] = rects[i].y;
+                y1s[j] = rects[i].y + rects[i].h;
+            }
+        }
+
+        uint32_t covered = 0;
+        int16_t runStart = 0;
+        int16_t runEnd = 0;
+        for (int j = 0; j < ny; ++j)
+        {
+            if (j == 0 || y0s[j] > runEnd)
+            {
+                covered += runEnd - runStart;
+                runStart = y0s[j];
+                runEnd = y1s[j];
+            }
+            else if (y1s[j] > runEnd)
+            {
+                runEnd = y1s[j];
+            }
+        }
+        covered += runEnd - runStart;
+        area += covered * (uint32_t)(x1 - x0);
+    }
+    return area;
+}
+
+#ifdef LCD_BENCHMARK
+void lcdFontReport()
+{
+    // Every printable character once, as one string
+    char all[FONT_GLYPH_COUNT + 1];
+    for (int i = 0; i < FONT_GLYPH_COUNT; ++i)
+        all[i] = (char)(FONT_FIRST_CHAR + i);
+    all[FONT_GLYPH_COUNT] = '\0';
+
+    const struct
+    {
+        const char *name;
+        const Font &font;
+    } fonts[] = {{"small 5x9", FONT_SMALL}, {"large 10x18", FONT_LARGE}, {"large 10x18 AA", FONT_LARGE_AA}};
+
+    uint32_t total = 0;
+    for (const auto &f : fonts)
+    {
+        // Rasterize in chunks that fit the screen width; flush() is timed
+        // too, since that is where the pixels reach the panel.
+        const int runs = 10;
+        const unsigned long start = micros();
+        for (int r = 0; r < runs; ++r)
+        {
+            for (int i = 0; i < FONT_GLYPH_COUNT; i += 16)
+            {
+                char chunk[17];
+                strncpy(chunk, all + i, 16);
+                chunk[16] = '\0';
+                lcdDrawTextFont(f.font, chunk, 0, (i / 16) * f.font.height, 0xFFFF, 0x0000);
+            }
+            LCD::flush();
+        }
+        LCD::waitIdle();
+        const unsigned long elapsed = micros() - start;
+        total += f.font.bytes;
+        LOG_INFO("[LCD-BENCH] font %-15s %5lu bytes flash, %lu.%02lu us/glyph", f.name, (unsigned long)f.font.bytes,
+                 elapsed / (runs * FONT_GLYPH_COUNT), (elapsed * 100 / (runs * FONT_GLYPH_COUNT)) % 100);
+    }
+    LOG_INFO("[LCD-BENCH] fonts total %lu bytes flash (unused atlases are dropped by the linker)",
+             (unsigned long)total);
+    lcdUiInit();
+}
+#endif
+
+// -------------------------------------------------------------------
+// Event console page
+// -------------------------------------------------------------------
+// Lines of the event log below a fixed title. The line area is a hardware
+// scroll ring (LCD::setScrollArea): line n always lives in slot
+// n % CONSOLE_LINES, and the scroll offset puts the newest slot at the
+// bottom. A new event costs one line window and a VSCSAD write, never a
+// repaint of the lines already on screen.
+#define CONSOLE_TOP 20
+#define CONSOLE_LINE_H 10 // FONT_SMALL plus one row of leading
+#define CONSOLE_LINES ((LCD_HEIGHT - CONSOLE_TOP) / CONSOLE_LINE_H)
+
+static UiPage currentPage = UI_PAGE_DASHBOARD;
+static EventCursor consoleCursor = {};
+static uint32_t consoleShownLost = 0; // cursor.lost already reported on screen
+static uint32_t consoleLine = 0;      // lines written since the page was opened
+
+static void consoleWrite(const char *text, uint16_t color)
+{
+    const int slot = (int)(consoleLine++ % CONSOLE_LINES);
+    lcdDrawTextFont(FONT_SMALL, text, 0, CONSOLE_TOP + slot * CONSOLE_LINE_H, color, COLOR_SCREEN_BG, LCD_WIDTH);
+}
+
+// Draws every complete event not shown yet; returns the lines written
+static uint32_t consoleDrain()
+{
+    static const uint16_t levelColors[] = {rgb565(190, 200, 215), rgb565(240, 200, 90), rgb565(240, 110, 100)};
+
+    // Lines that would scroll away in the same batch are not worth drawing
+    const uint32_t head = eventLogHead();
+    if (head - consoleCursor.next > CONSOLE_LINES)
+        consoleCursor.next = head - CONSOLE_LINES;
+
+    const uint32_t start = consoleLine;
+    EventEntry e;
+    while (eventLogRead(consoleCursor, e))
+    {
+        if (consoleCursor.lost != consoleShownLost)
+        {
+            char note[40];
+            snprintf(note, sizeof(note), "-- %lu events lost --", (unsigned long)(consoleCursor.lost - consoleShownLost));
+            consoleWrite(note, levelColors[EVENT_WARN]);
+            consoleShownLost = consoleCursor.lost;
+        }
+
+        char line[EVENT_TEXT_LEN + 16];
+        snprintf(line, sizeof(line), "%5lu.%lu %s", (unsigned long)(e.timeMs / 1000),
+                 (unsigned long)(e.timeMs / 100 % 10), e.text);
+        consoleWrite(line, levelColors[e.level <= EVENT_ERROR ? e.level : EVENT_ERROR]);
+    }
+    return consoleLine - start;
+}
+
+// Lines are pushed before the scroll moves, so the panel never shows a
+// slot that is still waiting for its text
+static void consoleScroll()
+{
+    LCD::flush();
+    LCD::setScrollOffset((int16_t)((consoleLine % CONSOLE_LINES) * CONSOLE_LINE_H));
+}
+
+static void consoleOpen()
+{
+    LCD::fillScreen(COLOR_SCREEN_BG);
+    lcdDrawTextFont(FONT_UI_LARGE, "Event log", 4, 1, rgb565(210, 230, 255), COLOR_SCREEN_BG);
+
+    // Start with the most recent page of history still in the ring
+    const uint32_t head = eventLogHead();
+    consoleCursor.next = head > CONSOLE_LINES ? head - CONSOLE_LINES : 0;
+    consoleShownLost = consoleCursor.lost;
+    consoleLine = 0;
+    consoleDrain();
+
+    LCD::flush();
+    LCD::setScrollArea(CONSOLE_TOP, CONSOLE_LINES * CONSOLE_LINE_H);
+    consoleScroll();
+}
+
+// -------------------------------------------------------------------
+// QR page
+// -------------------------------------------------------------------
+// The serial as a QR code for onboarding from the app, in place of a
+// printed label. DEVICE_SN's code is a constant in flash; a serial set at
+// run time is encoded once into RAM.
+#define QR_TOP 26
+#define QR_SERIAL_MAX 64
+
+static constexpr QrCode DEVICE_QR = qrEncode(DEVICE_SN);
+static_assert(DEVICE_QR.size != 0, "DEVICE_SN is too long for a QR code");
+
+static char qrSerial[QR_SERIAL_MAX] = DEVICE_SN;
+static QrCode qrRuntime;
+static const QrCode *qrShown = &DEVICE_QR;
+
+// The symbol and its quiet zone as one window, a module row at a time
+static void drawQr(const QrCode &qr, int x, int y, int scale)
+{
+    static constexpr uint16_t DARK = 0x0000, LIGHT = 0xFFFF;
+    const int modules = qr.size + 2 * QR_QUIET_ZONE;
+    const int side = modules * scale;
+    uint16_t *row = textTile;
+
+    LCD::beginPixels(x, y, side, side);
+    for (int my = -QR_QUIET_ZONE; my < qr.size + QR_QUIET_ZONE; ++my)
+    {
+        for (int mx = -QR_QUIET_ZONE; mx < qr.size + QR_QUIET_ZONE; ++mx)
+        {
+            const bool dark = mx >= 0 && my >= 0 && mx < qr.size && my < qr.size && qr.dark(mx, my);
+            std::fill_n(row + (mx + QR_QUIET_ZONE) * scale, scale, dark ? DARK : LIGHT);
+        }
+        for (int i = 0; i < scale; ++i)
+            LCD::writePixels(row, side);
+    }
+    LCD::endPixels();
+}
+
+static void qrOpen()
+{
+    LCD::fillScreen(COLOR_SCREEN_BG);
+    lcdDrawTextFont(FONT_UI_LARGE, "Register device", 4, 1, rgb565(210, 230, 255), COLOR_SCREEN_BG);
+
+    const QrCode &qr = *qrShown;
+    if (qr.size == 0)
+    {
+        lcdDrawTextFont(FONT_SMALL, "Serial too long for a QR code", 4, QR_TOP, rgb565(240, 110, 100), COLOR_SCREEN_BG);
+    }
+    else
+    {
+        const int modules = qr.size + 2 * QR_QUIET_ZONE;
+        const int scale = (LCD_WIDTH - 16) / modules;
+        const int side = modules * scale;
+        drawQr(qr, (LCD_WIDTH - side) / 2, QR_TOP, scale);
+
+        const int textW = fontTextWidth(FONT_SMALL, qrSerial);
+        lcdDrawTextFont(FONT_SMALL, qrSerial, std::max(0, (LCD_WIDTH - textW) / 2), QR_TOP + side + 8,
+                        rgb565(230, 235, 240), COLOR_SCREEN_BG);
+    }
+    static constexpr const char HINT[] = "Scan in the atCloud365 app";
+    lcdDrawTextFont(FONT_SMALL, HINT, (LCD_WIDTH - fontTextWidth(FONT_SMALL, HINT)) / 2, LCD_HEIGHT - 20,
+                    rgb565(150, 160, 175), COLOR_SCREEN_BG);
+    LCD::flush();
+}
+
+void lcdUiSetSerial(const char *serial)
+{
+    snprintf(qrSerial, sizeof(qrSerial), "%s", serial);
+    if (strcmp(qrSerial, DEVICE_SN) == 0)
+    {
+        qrShown = &DEVICE_QR;
+    }
+    else
+    {
+        qrRuntime = qrEncode(qrSerial);
+        qrShown = &qrRuntime;
+    }
+    if (currentPage == UI_PAGE_QR)
+        qrOpen();
+}
+
+// -------------------------------------------------------------------
+// Streamed images
+// -------------------------------------------------------------------
+// QOI decoded straight into a band of full image rows, pushed through the
+// compositor every IMAGE_BAND_ROWS rows and at the end of each chunk, so
+// RAM use is the band plus the decoder state whatever the image size.
+#define IMAGE_BAND_ROWS 8
+
+static QoiStream imageStream;
+static uint16_t imageBand[LCD_WIDTH * IMAGE_BAND_ROWS];
+static int imageX = 0;
+static int imageY = 0;
+static uint32_t imageBandFill = 0; // pixels in imageBand
+static uint32_t imageRowsDone = 0; // rows already pushed
+static bool imageActive = false;
+static LcdImageStats imageStats = {};
+
+static void imagePushBand()
+{
+    // No header yet: the width is unknown and nothing has been decoded
+    if (imageStream.width == 0)
+        return;
+    const uint32_t rows = imageBandFill / imageStream.width;
+    if (rows == 0)
+        return;
+    LCD::pushPixels(imageX, imageY + imageRowsDone, imageStream.width, rows, imageBand);
+    imageRowsDone += rows;
+
+    // A partial row stays for the next chunk
+    const uint32_t rest = imageBandFill - rows * imageStream.width;
+    memmove(imageBand, imageBand + rows * imageStream.width, rest * sizeof(uint16_t));
+    imageBandFill = rest;
+}
+
+void lcdImageBegin(int x, int y)
+{
+    qoiStreamBegin(imageStream, COLOR_SCREEN_BG);
+    imageX = x;
+    imageY = y;
+    imageBandFill = 0;
+    imageRowsDone = 0;
+    imageActive = true;
+    imageStats = {};
+}
+
+bool lcdImageWrite(const uint8_t *data, size_t len)
+{
+    if (!imageActive)
+        return false;
+
+    const unsigned long start = micros();
+    imageStats.encodedBytes += len;
+    if (imageStream.status == QOI_HEADER)
+        qoiStreamDecode(imageStream, data, len, nullptr, 0);
+    if (imageStream.status == QOI_INVALID || (imageStream.status == QOI_PIXELS && imageStream.width > LCD_WIDTH))
+    {
+        imageActive = false;
+        return false;
+    }
+
+    // Whole rows per band, more of them for narrow images
+    const uint32_t rowsPerBand = imageStream.width ? (LCD_WIDTH * IMAGE_BAND_ROWS) / imageStream.width : 0;
+    const uint32_t capacity = rowsPerBand * imageStream.width;
+    // A run can outlast the chunk that started it, so keep going until it
+    // has been drained as well
+    while ((len > 0 || imageStream.run > 0) && imageStream.status == QOI_PIXELS)
+    {
+        const size_t n = qoiStreamDecode(imageStream, data, len, imageBand + imageBandFill, capacity - imageBandFill);
+        imageBandFill += n;
+        if (imageBandFill == capacity)
+            imagePushBand();
+        if (n == 0)
+            break; // chunk used up in the middle of an op
+    }
+    if (imageStream.status == QOI_DONE)
+        imageActive = false;
+    if (imageStream.status == QOI_PIXELS || imageStream.status == QOI_DONE)
+        imagePushBand();
+    LCD::flush();
+
+    imageStats.width = imageStream.width;
+    imageStats.height = imageStream.height;
+    imageStats.done = imageStream.status == QOI_DONE;
+    imageStats.micros += micros() - start;
+    return true;
+}
+
+const LcdImageStats &lcdImageStats()
+{
+    return imageStats;
+}
+
+size_t lcdImageRamBytes()
+{
+    return sizeof(imageStream) + sizeof(imageBand);
 }
 
 // -------------------------------------------------------------------
@@ -317,19 +844,49 @@ static void drawHeader()
 // -------------------------------------------------------------------
 void lcdUiInit()
 {
-    LCD::fillScreen(rgb565(10, 12, 18));
-    drawHeader();
+    if (!widgetsLaidOut)
+        layoutSensorWidgets();
+
+    LCD::fillScreen(COLOR_SCREEN_BG);
+    screenCleared = true;
 
-    // Prepaint sensor slots so only state changes redraw later.
+    // Everything is redrawn on the next render
+    for (int i = 0; i < UI_WIDGET_COUNT; ++i)
+        widgets[i].valid = false;
     for (int i = 0; i < SENSOR_COUNT; ++i)
+        sparkStale[i] = true;
+}
+
+void lcdUiSetPage(UiPage page)
+{
+    if (page == currentPage)
+        return;
+    currentPage = page;
+    if (page == UI_PAGE_CONSOLE)
     {
-        drawSensorCard(i, false);
+        consoleOpen();
+        return;
     }
+    LCD::setScrollArea(0, LCD_HEIGHT);
+    if (page == UI_PAGE_QR)
+        qrOpen();
+    else
+        lcdUiInit();
+}
+
+UiPage lcdUiPage()
+{
+    return currentPage;
+}
+
+bool lcdUiConsolePending()
+{
+    return currentPage == UI_PAGE_CONSOLE && eventLogHead() != consoleCursor.next;
 }
 
 void lcdUiRender(const UiSnapshot &state)
 {
-    static UiSnapshot prev = {};
+    PROFILE_SCOPE("ui_render");
     static bool first = true;
 
     if (first)
@@ -338,34 +895,78 @@ void lcdUiRender(const UiSnapshot &state)
         first = false;
     }
 
-    // Header status row : date/time block (kept inside 240x320 with margin)
-    const int badgeY = LCD_HEIGHT - 38; // 44px height + 10px bottom margin
-    // Use the same color as the screen background to blend the badge
-    drawBadge(5, badgeY, 100, 38, rgb565(10, 12, 18));
-    lcdDrawText(state.dateText.c_str(), 10, badgeY + 10, rgb565(150, 190, 230), 1);
-    lcdDrawText(state.timeText.c_str(), 10, badgeY + 22, rgb565(220, 240, 255), 2);
-
-    drawWifiIcon(160, LCD_HEIGHT - 25, state.wifiConnected, state.wifiRssi);
-    drawSocketConnectIcon(215, LCD_HEIGHT - 17, state.socketConnected);
-#if 1
-    // Sensors
+    const uint32_t now = millis();
     for (int i = 0; i < SENSOR_COUNT; ++i)
+        sparkSample(sparkHistory[i], state.sensors[i], now);
+
+    if (currentPage == UI_PAGE_QR)
+    {
+        lastFrameStats = {};
+        return;
+    }
+    if (currentPage == UI_PAGE_CONSOLE)
+    {
+        const uint32_t lines = consoleDrain();
+        if (lines)
+            consoleScroll();
+        lastFrameStats.widgetsRedrawn = 0;
+        lastFrameStats.redrawArea = lines * (uint32_t)LCD_WIDTH * FONT_SMALL.height;
+        return;
+    }
+
+    bool dirty[UI_WIDGET_COUNT];
+    uint32_t hashes[UI_WIDGET_COUNT];
+    for (int i = 0; i < UI_WIDGET_COUNT; ++i)
     {
-        if (first || state.sensors[i] != prev.sensors[i])
+        hashes[i] = widgets[i].hash(state, widgets[i].arg);
+        dirty[i] = !widgets[i].valid || hashes[i] != widgets[i].lastHash;
+    }
+
+    // A redraw may paint over neighbours, so dirtiness spreads to every
+    // widget overlapping a dirty one until nothing changes.
+    bool spread = true;
+    while (spread)
+    {
+        spread = false;
+        for (int i = 0; i < UI_WIDGET_COUNT; ++i)
         {
-            //   Serial.printf("index %d state changed: %s\n", i + 1, state.sensors[i] ? "ON" : "OFF");
-            drawSensorCard(i, state.sensors[i]);
+            if (!dirty[i])
+                continue;
+            for (int j = 0; j < UI_WIDGET_COUNT; ++j)
+            {
+                if (!dirty[j] && rectsOverlap(widgets[i].bounds, widgets[j].bounds))
+                {
+                    dirty[j] = true;
+                    spread = true;
+                }
+            }
         }
+    }
 
-        prev.sensors[i] = state.sensors[i];
+    UiRect dirtyRects[UI_WIDGET_COUNT];
+    int dirtyCount = 0;
+    for (int i = 0; i < UI_WIDGET_COUNT; ++i)
+    {
+        if (!dirty[i])
+            continue;
+        widgets[i].draw(state, widgets[i].arg);
+        widgets[i].lastHash = hashes[i];
+        widgets[i].valid = true;
+        dirtyRects[dirtyCount++] = widgets[i].bounds;
     }
-#endif
-    prev.wifiConnected = state.wifiConnected;
-    prev.wifiRssi = state.wifiRssi;
-    prev.socketConnected = state.socketConnected;
-    prev.dateText = state.dateText;
-    prev.timeText = state.timeText;
-    prev.ip = state.ip;
+
+    // Push the composed frame; the DMA transfer overlaps the next loop()
+    LCD::flush();
+
+    lastFrameStats.widgetsRedrawn = (uint16_t)dirtyCount;
+    lastFrameStats.redrawArea = screenCleared ? (uint32_t)LCD_WIDTH * LCD_HEIGHT
+                                              : unionArea(dirtyRects, dirtyCount);
+    screenCleared = false;
+}
+
+const UiFrameStats &lcdUiLastFrameStats()
+{
+    return lastFrameStats;
 }
 
 #endif // HAS_LCD_240x320
@@ -0,0 +1,270 @@
+#include "log_record.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static size_t argSize(uint8_t type, const uint8_t *arg, size_t available)
+{
+    switch (type)
+    {
+    case LOG_ARG_I32:
+    case LOG_ARG_U32:
+        return 4;
+    case LOG_ARG_I64:
+    case LOG_ARG_U64:
+    case LOG_ARG_F64:
+    case LOG_ARG_PTR:
+        return 8;
+    case LOG_ARG_STR:
+        return available ? 1 + arg[0] : 1;
+    default:
+        return SIZE_MAX;
+    }
+}
+
+bool logParseRecord(const uint8_t *payload, size_t length, LogRecordView &out)
+{
+    if (length < 10)
+        return false;
+    memcpy(&out.timeUs, payload, 8);
+    out.level = payload[8];
+    out.nargs = payload[9];
+    if (length < 10u + out.nargs)
+        return false;
+    out.types = payload + 10;
+    out.args = out.types + out.nargs;
+    out.argsLength = length - 10 - out.nargs;
+
+    size_t offset = 0;
+    for (uint8_t i = 0; i < out.nargs; ++i)
+    {
+        const size_t size = argSize(out.types[i], out.args + offset, out.argsLength - offset);
+        if (size > out.argsLength - offset)
+            return false;
+        offset += size;
+    }
+    return offset == out.argsLength;
+}
+
+// Walks the arguments of a record in order
+struct ArgReader
+{
+    const LogRecordView &record;
+    uint8_t index;
+    size_t offset;
+
+    bool next(uint8_t &type, const uint8_t *&data)
+    {
+        if (index >= record.nargs)
+            return false;
+        type = record.types[index++];
+        data = record.args + offset;
+        offset += argSize(type, data, record.argsLength - offset);
+        return true;
+    }
+
+    // 32-bit arguments come back sign- or zero-extended, with narrow set
+    bool nextInteger(bool &isSigned, uint64_t &value, bool &narrow)
+    {
+        uint8_t type;
+        const uint8_t *data;
+        if (!next(type, data))
+            return false;
+        switch (type)
+        {
+        case LOG_ARG_I32:
+        {
+            int32_t v;
+            memcpy(&v, data, 4);
+            value = (uint64_t)(int64_t)v;
+            isSigned = true;
+            narrow = true;
+            return true;
+        }
+        case LOG_ARG_U32:
+        {
+            uint32_t v;
+            memcpy(&v, data, 4);
+            value = v;
+            isSigned = false;
+            narrow = true;
+            return true;
+        }
+        case LOG_ARG_I64:
+        case LOG_ARG_U64:
+        case LOG_ARG_PTR:
+            memcpy(&value, data, 8);
+            isSigned = type == LOG_ARG_I64;
+            narrow = false;
+            return true;
+        default:
+            return false;
+        }
+    }
+};
+
+size_t logFormat(char *out, size_t size, const char *fmt, const LogRecordView &record)
+{
+    if (size == 0)
+        return 0;
+    size_t n = 0;
+    auto append = [&](const char *text, size_t length)
+    {
+        const size_t room = size - 1 - n;
+        if (length > room)
+            length = room;
+        memcpy(out + n, text, length);
+        n += length;
+    };
+
+    ArgReader args = {record, 0, 0};
+    char piece[LOG_STR_MAX + 64];
+    while (*fmt)
+    {
+        if (*fmt != '%')
+        {
+            const char *end = strchr(fmt, '%');
+            const size_t length = end ? (size_t)(end - fmt) : strlen(fmt);
+            append(fmt, length);
+            fmt += length;
+            continue;
+        }
+        if (fmt[1] == '%')
+        {
+            append("%", 1);
+            fmt += 2;
+            continue;
+        }
+
+        // Flags, width and precision are kept; '*' takes an argument
+        char spec[32] = "%";
+        size_t specLength = 1;
+        int star = -1;
+        const char *p = fmt + 1;
+        while (*p && strchr("-+ #0123456789.*", *p) && specLength < sizeof(spec) - 6)
+        {
+            if (*p == '*')
+            {
+                bool isSigned, narrow;
+                uint64_t value;
+                if (star >= 0 || !args.nextInteger(isSigned, value, narrow))
+                    break;
+                star = (int)(int64_t)value;
+            }
+            spec[specLength++] = *p++;
+        }
+        while (*p && strchr("hlLqjzt", *p))
+            p++;
+        const char conversion = *p ? *p++ : '\0';
+        fmt = p;
+
+        bool ok = true;
+        int written = 0;
+        bool isSigned, narrow;
+        uint64_t value;
+        uint8_t type;
+        const uint8_t *data;
+        switch (conversion)
+        {
+        case 'd':
+        case 'i':
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            ok = args.nextInteger(isSigned, value, narrow);
+            if (ok)
+            {
+                const bool signedConversion = conversion == 'd' || conversion == 'i';
+                // A signed 32-bit argument printed unsigned wraps at 32 bits, as printf would
+                if (!signedConversion && isSigned && narrow)
+                    value &= 0xFFFFFFFFu;
+                spec[specLength++] = 'l';
+                spec[specLength++] = 'l';
+                spec[specLength++] = conversion;
+                spec[specLength] = '\0';
+                written = star >= 0 ? (signedConversion ? snprintf(piece, sizeof(piece), spec, star, (long long)value)
+                                                        : snprintf(piece, sizeof(piece), spec, star,
+                                                                   (unsigned long long)value))
+                                    : (signedConversion ? snprintf(piece, sizeof(piece), spec, (long long)value)
+                                                        : snprintf(piece, sizeof(piece), spec,
+                                                                   (unsigned long long)value));
+            }
+            break;
+        case 'c':
+            ok = args.nextInteger(isSigned, value, narrow);
+            if (ok)
+            {
+                spec[specLength++] = 'c';
+                spec[specLength] = '\0';
+                written = star >= 0 ? snprintf(piece, sizeof(piece), spec, star, (int)value)
+                                    : snprintf(piece, sizeof(piece), spec, (int)value);
+            }
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            ok = args.next(type, data) && type == LOG_ARG_F64;
+            if (ok)
+            {
+                double v;
+                memcpy(&v, data, 8);
+                spec[specLength++] = conversion;
+                spec[specLength] = '\0';
+                written = star >= 0 ? snprintf(piece, sizeof(piece), spec, star, v)
+                                    : snprintf(piece, sizeof(piece), spec, v);
+            }
+            break;
+        case 's':
+            ok = args.next(type, data) && type == LOG_ARG_STR;
+            if (ok)
+            {
+                char text[256];
+                memcpy(text, data + 1, data[0]);
+                text[data[0]] = '\0';
+                spec[specLength++] = 's';
+                spec[specLength] = '\0';
+                written = star >= 0 ? snprintf(piece, sizeof(piece), spec, star, text)
+                                    : snprintf(piece, sizeof(piece), spec, text);
+            }
+            break;
+        case 'p':
+            ok = args.nextInteger(isSigned, value, narrow);
+            if (ok)
+                written = snprintf(piece, sizeof(piece), "0x%llx", (unsigned long long)value);
+            break;
+        default:
+            ok = false;
+            break;
+        }
+
+        if (!ok)
+            append("<?>", 3);
+        else if (written > 0)
+            append(piece, (size_t)written < sizeof(piece) ? (size_t)written : sizeof(piece) - 1);
+    }
+    out[n] = '\0';
+    return n;
+}
+
+char logLevelLetter(uint8_t level)
+{
+    switch (level)
+    {
+    case LOG_LEVEL_ERROR:
+        return 'E';
+    case LOG_LEVEL_WARN:
+        return 'W';
+    case LOG_LEVEL_INFO:
+        return 'I';
+    case LOG_LEVEL_DEBUG:
+        return 'D';
+    default:
+        return '?';
+    }
+}
@@ -17,19 +17,32 @@
 #include <WiFi.h>
 #include <HTTPClient.h>
 #include <ArduinoJson.h>
-#include <time.h>
+#include <mbedtls/base64.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
 #include "config.h"
 #include "main.h"
+#include "dev_log.h"
+#include "event_log.h"
+#include "metrics.h"
+#include "profiler.h"
+#include "server_clock.h"
+#include "traffic_trace.h"
+#include "wall_clock.h"
 #ifdef HAS_LCD_240x320
 #include "lcd.h"
 #include "lcd_app.h"
 #endif
 
 SocketIOClient socketIo;
+static ServerClock serverClock;
+static Metric *loopMetric, *emitMetric, *cmdMetric, *rxMetric, *txMetric, *reconnectMetric;
+static Metric *heapFreeMetric, *heapBlockMetric, *rssiMetric, *logQueueMetric, *logDroppedMetric;
 
 #ifdef HAS_LCD_240x320
 static void collectUiState(UiSnapshot &ui)
 {
+    PROFILE_SCOPE("ui_state");
     ui.wifiConnected = WiFi.status() == WL_CONNECTED;
     ui.wifiRssi = ui.wifiConnected ? WiFi.RSSI() : 0;
     ui.socketConnected = socketConnected;
@@ -37,29 +50,19 @@ static void collectUiState(UiSnapshot &ui)
     for (int i = 0; i < SENSOR_COUNT; i++)
         ui.sensors[i] = (gpioInputs[i].state == LOW);
 
-    static bool ntpInit = false;
-    if (!ntpInit)
-    {
-        const long gmtOffset = 9 * 3600; // KST (UTC+9)
-        const int daylightOffset = 0;
-        configTime(gmtOffset, daylightOffset, "pool.ntp.org", "time.nist.gov");
-        ntpInit = true;
-    }
+    // Cached texts, re-formatted only when the second changes
+    ui.dateText = clockDateText();
+    ui.timeText = clockTimeText();
 
-    struct tm timeinfo;
-    if (getLocalTime(&timeinfo, 100))
+    static uint32_t syncsSeen = 0;
+    const ClockSyncInfo sync = clockSyncInfo();
+    if (sync.syncs != syncsSeen)
     {
-        char dateBuf[16];
-        char timeBuf[12];
-        strftime(dateBuf, sizeof(dateBuf), "%Y-%m-%d", &timeinfo);
-        strftime(timeBuf, sizeof(timeBuf), "%H:%M:%S", &timeinfo);
-        ui.dateText = String(dateBuf);
-        ui.timeText = String(timeBuf);
-    }
-    else
-    {
-        ui.dateText = "--";
-        ui.timeText = "--:--:--";
+        syncsSeen = sync.syncs;
+        if (sync.syncs == 1)
+            eventLog(EVENT_INFO, "Clock synced (%s)", sync.sntp ? "NTP" : "server");
+        else if (sync.lastCorrectionUs > CLOCK_SLEW_LIMIT_US || sync.lastCorrectionUs < -CLOCK_SLEW_LIMIT_US)
+            eventLog(EVENT_WARN, "Clock stepped by %ld ms", (long)(sync.lastCorrectionUs / 1000));
     }
     ui.ip = WiFi.localIP();
 }
@@ -72,43 +75,48 @@ void setup()
 {
     Serial.begin(115200);
     delay(100);
+    logBegin();
+    setupMetrics();
 
-    DEBUG_PRINTLN("\n\n========================================");
-    DEBUG_PRINTLN("atCloud365 Input Device Example");
-    DEBUG_PRINTLN("========================================\n");
+    LOG_INFO("atCloud365 Input Device Example");
 
     // Initialize GPIO pins as inputs with pullup
-    DEBUG_PRINTLN("[GPIO] Initializing input pins...");
+    LOG_INFO("[GPIO] Initializing input pins...");
     for (int i = 0; i < SENSOR_COUNT; i++)
     {
         pinMode(gpioInputs[i].pin, INPUT_PULLUP);
         gpioInputs[i].state = digitalRead(gpioInputs[i].pin);
         gpioInputs[i].previousState = gpioInputs[i].state;
-        DEBUG_PRINTF("  GPIO %d: %d\n", gpioInputs[i].pin, gpioInputs[i].state);
+        LOG_INFO("  GPIO %d: %d", gpioInputs[i].pin, gpioInputs[i].state);
     }
     setupWiFi();
+    clockBegin(); // SNTP in the background; the UI shows "--" until it syncs
 
     // GET Authentication Token
     if (authenticateDevice())
     {
-        DEBUG_PRINTLN("[AUTH] Authentication successful!");
+        LOG_INFO("[AUTH] Authentication successful!");
 
         // Connect to Socket.IO (use SocketIOClient)
         socketIo.setPacketCallback(handleSocketIOPacket);
         socketIo.setConnectCallback([]()
-                                    { DEBUG_PRINTLN("[SOCKET] SocketIO connected (callback)"); });
+                                    { LOG_INFO("[SOCKET] SocketIO connected (callback)"); });
         socketIo.setDisconnectCallback([]()
                                        {
-            DEBUG_PRINTLN("[SOCKET] SocketIO disconnected (callback)");
+            LOG_WARN("[SOCKET] SocketIO disconnected (callback)");
+            eventLog(EVENT_WARN, "Socket disconnected");
             socketConnected = false; });
         socketIo.begin(authToken);
 
 #ifdef HAS_LCD_240x320
-        DEBUG_PRINTLN("[LCD] Initializing and running visual test...");
+        LOG_INFO("[LCD] Initializing and running visual test...");
         LCD::begin();
         LCD::setBacklight(255);
         LCD::setRotation(2); // 180-degree rotation to match panel mounting
         LCD::fillScreen(0x0000);
+#ifdef LCD_BENCHMARK
+        lcdFontReport();
+#endif
 
         // Draw the operational dashboard (WiFi, Socket, Sensors, Clock)
         UiSnapshot uiState;
@@ -118,8 +126,16 @@ void setup()
     }
     else
     {
-        DEBUG_PRINTLN("[AUTH] Authentication failed! Rebooting in 10 seconds...");
+        LOG_ERROR("[AUTH] Authentication failed! Rebooting in 10 seconds...");
+#ifdef HAS_LCD_240x320
+        // Most often a device not registered yet: show its QR code meanwhile
+        LCD::begin();
+        LCD::setBacklight(255);
+        LCD::setRotation(2);
+        lcdUiSetPage(UI_PAGE_QR);
+#endif
         delay(10000);
+        logDrain();
         ESP.restart();
     }
 }
@@ -129,7 +145,17 @@ void setup()
 // ==================================================
 void loop()
 {
+    PROFILE_SCOPE("loop");
+    static int64_t lastLoopUs = 0;
+    const int64_t loopUs = esp_timer_get_time();
+    if (lastLoopUs)
+        metricObserve(loopMetric, (uint32_t)(loopUs - lastLoopUs));
+    lastLoopUs = loopUs;
+
     socketIo.loop();
+#ifdef LOOP_PROFILER
+    profileService();
+#endif
 
     // Scan GPIO inputs periodically
     if (millis() - lastGpioScan >= GPIO_SCAN_INTERVAL)
@@ -139,6 +165,9 @@ void loop()
     }
     if (socketConnected)
     {
+        serviceServerClock();
+        serviceMetrics();
+
         // Send periodic update even if no change
         if ((millis() - lastDataSend >= DATA_SEND_INTERVAL))
             dataUpdateRequired = true;
@@ -158,7 +187,7 @@ void loop()
 #ifdef HAS_LCD_240x320
     static unsigned long lastUiRefresh = 0;
 
-    if ((millis() - lastUiRefresh > 1000) || dataUpdateRequired)
+    if ((millis() - lastUiRefresh > 1000) || dataUpdateRequired || lcdUiConsolePending())
     {
         UiSnapshot uiState;
         collectUiState(uiState);
@@ -173,8 +202,7 @@ void loop()
 // ==================================================
 void setupWiFi()
 {
-    DEBUG_PRINT("[WiFi] Connecting to ");
-    DEBUG_PRINTLN(WIFI_SSID);
+    LOG_INFO("[WiFi] Connecting to %s", WIFI_SSID);
 
     WiFi.mode(WIFI_STA);
     WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
@@ -183,23 +211,21 @@ void setupWiFi()
     while (WiFi.status() != WL_CONNECTED && attempts < 30)
     {
         delay(500);
-        DEBUG_PRINT(".");
         attempts++;
     }
 
     if (WiFi.status() == WL_CONNECTED)
     {
-        DEBUG_PRINTLN("\n[WiFi] Connected!");
-        DEBUG_PRINT("[WiFi] IP Address: ");
-        DEBUG_PRINTLN(WiFi.localIP());
-        DEBUG_PRINT("[WiFi] RSSI: ");
-        DEBUG_PRINT(WiFi.RSSI());
-        DEBUG_PRINTLN(" dBm");
+        LOG_INFO("[WiFi] Connected after %d attempts, IP %s, RSSI %d dBm", attempts,
+                 WiFi.localIP().toString().c_str(), (int)WiFi.RSSI());
+        eventLog(EVENT_INFO, "WiFi up %s %d dBm", WiFi.localIP().toString().c_str(), (int)WiFi.RSSI());
     }
     else
     {
-        DEBUG_PRINTLN("\n[WiFi] Connection failed! Rebooting...");
+        LOG_ERROR("[WiFi] Connection failed! Rebooting...");
+        eventLog(EVENT_ERROR, "WiFi failed, rebooting");
         delay(5000);
+        logDrain();
         ESP.restart();
     }
 }
@@ -209,8 +235,8 @@ void setupWiFi()
 // ==================================================
 bool authenticateDevice()
 {
-    DEBUG_PRINTLN("\n[AUTH] Authenticating with atCloud365...");
-    DEBUG_PRINTF("[AUTH] Device SN: %s\n", DEVICE_SN);
+    LOG_INFO("[AUTH] Authenticating with atCloud365...");
+    LOG_INFO("[AUTH] Device SN: %s", DEVICE_SN);
 
     HTTPClient https;
     https.setTimeout(HTTP_TIMEOUT);
@@ -231,8 +257,8 @@ bool authenticateDevice()
     String postPayload;
     serializeJson(doc, postPayload);
 
-    DEBUG_PRINTF("[AUTH] URL: %s\n", authUrl.c_str());
-    DEBUG_PRINTF("[AUTH] Payload: %s\n", postPayload.c_str());
+    LOG_DEBUG("[AUTH] URL: %s", authUrl.c_str());
+    LOG_DEBUG("[AUTH] Payload: %s", postPayload.c_str());
 
     https.begin(authUrl);
     https.addHeader("Content-Type", "application/json");
@@ -242,7 +268,7 @@ bool authenticateDevice()
     if (httpCode == HTTP_CODE_OK)
     {
         String payload = https.getString();
-        DEBUG_PRINTF("[AUTH] Response: %s\n", payload.c_str());
+        LOG_DEBUG("[AUTH] Response: %s", payload.c_str());
 
         // Parse JSON response
         JsonDocument doc;
@@ -251,18 +277,21 @@ bool authenticateDevice()
         if (!error && doc["token"].is<const char *>())
         {
             authToken = doc["token"].as<String>();
-            DEBUG_PRINTLN("[AUTH] Token received successfully");
+            LOG_INFO("[AUTH] Token received successfully");
+            eventLog(EVENT_INFO, "Auth ok");
             https.end();
             return true;
         }
         else
         {
-            DEBUG_PRINTLN("[AUTH] Invalid response format");
+            LOG_ERROR("[AUTH] Invalid response format");
+            eventLog(EVENT_ERROR, "Auth: invalid response");
         }
     }
     else
     {
-        DEBUG_PRINTF("[AUTH] HTTP Error: %d\n", httpCode);
+        LOG_ERROR("[AUTH] HTTP Error: %d", httpCode);
+        eventLog(EVENT_ERROR, "Auth: HTTP %d", httpCode);
     }
 
     https.end();
@@ -277,7 +306,7 @@ void connectSocketIO()
     // connect using the SocketIOClient wrapper (authToken must be set)
     socketIo.begin(authToken);
     socketIo.setReconnectInterval(5000);
-    DEBUG_PRINTLN("[SOCKET] Connection initiated via SocketIOClient");
+    LOG_INFO("[SOCKET] Connection initiated via SocketIOClient");
 }
 
 // ==================================================
@@ -292,6 +321,9 @@ void handleSocketIOPacket(const char *packet, size_t length)
 {
     if (length == 0)
         return;
+    PROFILE_SCOPE("packet");
+    const int64_t receivedUs = esp_timer_get_time();
+    metricAdd(rxMetric);
 
     char packetType = packet[0];
 
@@ -299,7 +331,7 @@ void handleSocketIOPacket(const char *packet, size_t length)
     {
     case '0': // Connection info (open)
     {
-        DEBUG_PRINTLN("[SOCKET] Connection info received");
+        LOG_DEBUG("[SOCKET] Connection info received");
         const char *jsonStr = packet + 1;
         JsonDocument doc;
         DeserializationError error = deserializeJson(doc, jsonStr);
@@ -309,13 +341,15 @@ void handleSocketIOPacket(const char *packet, size_t length)
             if (doc["sid"].is<const char *>())
             {
                 socketSid = doc["sid"].as<String>();
-                DEBUG_PRINTF("[SOCKET] SID: %s\n", socketSid.c_str());
+                LOG_DEBUG("[SOCKET] SID: %s", socketSid.c_str());
+                eventLog(EVENT_INFO, "Socket open, sid %s", socketSid.c_str());
             }
 
             // Send connect acknowledgment with auth payload (Socket.IO expects token here)
             String connectPayload = String("{\"token\":\"") + authToken + "\"}";
             sendPacket("40", connectPayload);
             socketConnected = true;
+            serverClockConnected();
 
             // Send bootup status
             if (!bootupReady)
@@ -326,18 +360,19 @@ void handleSocketIOPacket(const char *packet, size_t length)
             else
             {
                 // emitDevStatus("Reconnected");
+                metricAdd(reconnectMetric);
             }
         }
     }
     break;
 
     case '2': // Ping
-        DEBUG_PRINTLN("[SOCKET] Ping received, sending pong");
+        LOG_DEBUG("[SOCKET] Ping received, sending pong");
         sendPacket("3");
         break;
 
     case '3': // Pong
-        DEBUG_PRINTLN("[SOCKET] Pong received");
+        LOG_DEBUG("[SOCKET] Pong received");
         break;
 
     case '4': // Message
@@ -347,17 +382,36 @@ void handleSocketIOPacket(const char *packet, size_t length)
 
             if (messageType == '0')
             {
-                DEBUG_PRINTLN("[SOCKET] Connection acknowledged (40)");
+                LOG_INFO("[SOCKET] Connection acknowledged (40)");
+            }
+            else if (messageType == '3')
+            {
+                // Ack: 43<id>[args]
+                char *args = nullptr;
+                const uint32_t ackId = strtoul(packet + 2, &args, 10);
+                JsonDocument doc;
+                if (args != packet + 2 && !deserializeJson(doc, args) && doc.is<JsonArray>())
+                {
+                    JsonVariantConst time = doc[0];
+                    if (time["time"].is<int64_t>())
+                        time = time["time"];
+                    if (time.is<int64_t>())
+                        handleServerTimeAck(ackId, time.as<int64_t>());
+                }
             }
             else if (messageType == '2')
             {
                 // Event message: 42["event", data]
                 const char *eventData = packet + 2;
-                DEBUG_PRINTF("[SOCKET] Event received: %s\n", eventData);
+                LOG_DEBUG("[SOCKET] Event received: %s", eventData);
 
                 // Parse event (for input device, we mainly listen to 'connected' confirmation)
                 JsonDocument doc;
-                DeserializationError error = deserializeJson(doc, eventData);
+                DeserializationError error;
+                {
+                    PROFILE_SCOPE("json_rx");
+                    error = deserializeJson(doc, eventData);
+                }
 
                 if (!error && doc.is<JsonArray>())
                 {
@@ -365,15 +419,16 @@ void handleSocketIOPacket(const char *packet, size_t length)
                     if (arr.size() > 0)
                     {
                         String eventName = arr[0].as<String>();
-                        DEBUG_PRINTF("[SOCKET] Event name: %s\n", eventName.c_str());
+                        LOG_DEBUG("[SOCKET] Event name: %s", eventName.c_str());
 
                         if (eventName == "connected")
                         {
-                            DEBUG_PRINTLN("[SOCKET] Server confirmed connection!");
+                            LOG_INFO("[SOCKET] Server confirmed connection!");
                         }
                         //  ["app-cmd",{"operation":{"customCmd":"clear-call-bell","fieldIndex":2,"fieldValue":0}}]
                         else if (eventName == "app-cmd" && arr.size() > 1)
                         {
+                            PROFILE_SCOPE("app_cmd");
                             JsonObject eventPayload = arr[1].as<JsonObject>();
                             if (eventPayload["operation"].is<JsonObject>())
                             {
@@ -381,19 +436,49 @@ void handleSocketIOPacket(const char *packet, size_t length)
                                 if (operation["customCmd"].is<const char *>())
                                 {
                                     String customCmd = operation["customCmd"].as<String>();
-                                    DEBUG_PRINTF("[SOCKET] Custom Command: %s\n", customCmd.c_str());
+                                    LOG_INFO("[SOCKET] Custom Command: %s", customCmd.c_str());
+                                    if (customCmd != "lcd-image") // chunks report once per image
+                                        eventLog(EVENT_INFO, "Cmd %s [%d]=%d", customCmd.c_str(),
+                                                 (int)(operation["fieldIndex"] | 0), (int)(operation["fieldValue"] | 0));
                                     if (customCmd == "clear-call-bell" || customCmd == "output")
                                     {
                                         uint8_t fieldIndex = operation["fieldIndex"] | 0;
                                         uint8_t fieldValue = operation["fieldValue"] | 0;
-                                        DEBUG_PRINTF("[SOCKET] clear-call-bell - Index: %d, Value: %d\n", fieldIndex, fieldValue);
+                                        LOG_INFO("[SOCKET] clear-call-bell - Index: %d, Value: %d", fieldIndex, fieldValue);
                                         if (fieldIndex < SENSOR_COUNT && fieldValue >= 0)
                                             gpioInputs[fieldIndex]
                                                 .state = fieldValue == 1 ? LOW : HIGH;
                                         gpioInputs[fieldIndex].previousState = gpioInputs[fieldIndex].state;
                                         dataUpdateRequired = true;
                                     }
+#ifdef HAS_LCD_240x320
+                                    // {"customCmd":"lcd-page","fieldValue":1} shows the event console, 2 the
+                                    // serial's QR code, 0 the dashboard
+                                    else if (customCmd == "lcd-page")
+                                    {
+                                        const int page = operation["fieldValue"] | 0;
+                                        lcdUiSetPage(page == 1 ? UI_PAGE_CONSOLE : page == 2 ? UI_PAGE_QR : UI_PAGE_DASHBOARD);
+                                    }
+                                    else if (customCmd == "lcd-image")
+                                    {
+                                        handleImageChunk(operation["seq"] | -1, operation["x"] | 0, operation["y"] | 0,
+                                                         operation["data"] | "");
+                                    }
+#endif
+                                    else if (customCmd == "dev-metrics")
+                                    {
+                                        emitDevMetrics(true);
+                                    }
+#ifdef LOOP_PROFILER
+                                    // {"customCmd":"dev-profile"} reports the stage table, with
+                                    // "fieldValue":1 starts a new one after reporting
+                                    else if (customCmd == "dev-profile")
+                                    {
+                                        emitDevProfile(operation["fieldValue"] == 1);
+                                    }
+#endif
                                     // Handle custom commands as needed
+                                    metricObserve(cmdMetric, (uint32_t)(esp_timer_get_time() - receivedUs));
                                 }
                             }
                         }
@@ -404,18 +489,235 @@ void handleSocketIOPacket(const char *packet, size_t length)
         break;
 
     default:
-        DEBUG_PRINTF("[SOCKET] Unknown packet type: %c\n", packetType);
+        LOG_WARN("[SOCKET] Unknown packet type: %c", packetType);
+        eventLog(EVENT_WARN, "Unknown packet type '%c'", packetType);
         break;
     }
 }
 
+#ifdef HAS_LCD_240x320
+// ==================================================
+// Streamed LCD image (app-cmd "lcd-image")
+// ==================================================
+// {"customCmd":"lcd-image","seq":0,"x":0,"y":60,"data":"<base64 QOI>"}
+// seq 0 starts an image at (x, y); later chunks carry seq 1, 2, ... and
+// only data. Each chunk decodes to at most LCD_IMAGE_CHUNK_BYTES.
+void handleImageChunk(int32_t seq, int x, int y, const char *data)
+{
+    static uint8_t chunk[LCD_IMAGE_CHUNK_BYTES];
+    static int32_t nextSeq = -1; // -1: no image in progress
+    static uint32_t transferBytes = 0;
+
+    if (seq == 0)
+    {
+        lcdImageBegin(x, y);
+        nextSeq = 0;
+        transferBytes = 0;
+    }
+    if (seq != nextSeq)
+    {
+        LOG_WARN("[IMG] Chunk %ld out of order (expected %ld), image dropped", (long)seq, (long)nextSeq);
+        eventLog(EVENT_ERROR, "Image chunk %ld out of order", (long)seq);
+        nextSeq = -1;
+        return;
+    }
+
+    size_t len = 0;
+    const size_t dataLen = strlen(data);
+    if (mbedtls_base64_decode(chunk, sizeof(chunk), &len, (const unsigned char *)data, dataLen) != 0 ||
+        !lcdImageWrite(chunk, len))
+    {
+        LOG_WARN("[IMG] Chunk %ld invalid, image dropped", (long)seq);
+        eventLog(EVENT_ERROR, "Image chunk %ld invalid", (long)seq);
+        nextSeq = -1;
+        return;
+    }
+    transferBytes += dataLen;
+    nextSeq++;
+
+    const LcdImageStats &st = lcdImageStats();
+    if (!st.done)
+        return;
+    const uint32_t raw = st.width * st.height * 2;
+    LOG_INFO("[IMG] %lux%lu: %lu B QOI, %lu B base64, %lu B as RGB565 (%lu%%); %lu us, %lu KB/s RGB565 out, "
+             "%u B RAM",
+             (unsigned long)st.width, (unsigned long)st.height, (unsigned long)st.encodedBytes,
+             (unsigned long)transferBytes, (unsigned long)raw, (unsigned long)(st.encodedBytes * 100 / raw),
+             (unsigned long)st.micros, (unsigned long)(st.micros ? (uint64_t)raw * 1000 / st.micros : 0),
+             (unsigned)lcdImageRamBytes());
+    eventLog(EVENT_INFO, "Image %lux%lu, %lu B", (unsigned long)st.width, (unsigned long)st.height,
+             (unsigned long)st.encodedBytes);
+    nextSeq = -1;
+}
+#endif
+
+// ==================================================
+// Server clock (Socket.IO round trips)
+// ==================================================
+// 42<id>["dev-time"] asks the server for its clock; it acks with
+// 43<id>[<epoch ms>] or 43<id>[{"time":<epoch ms>}]. A burst after each
+// connect fills the estimator, then one request a minute keeps it
+// disciplined. Without NTP the wall clock is fed from it as well.
+#define TIME_BURST_REQUESTS 8
+#define TIME_BURST_INTERVAL_MS 2000
+#define TIME_REQUEST_INTERVAL_MS 60000
+#define TIME_REQUEST_TIMEOUT_MS 5000
+
+static uint32_t timeRequestId = 0;
+static int64_t timeRequestSentUs = -1; // -1: none in flight
+static uint32_t timeRequestsSinceConnect = 0;
+static unsigned long lastTimeRequest = 0;
+
+void serverClockConnected()
+{
+    timeRequestSentUs = -1;
+    timeRequestsSinceConnect = 0;
+}
+
+void serviceServerClock()
+{
+    const unsigned long now = millis();
+    if (timeRequestSentUs >= 0)
+    {
+        if (esp_timer_get_time() - timeRequestSentUs < (int64_t)TIME_REQUEST_TIMEOUT_MS * 1000)
+            return;
+        LOG_WARN("[TIME] Request %lu timed out", (unsigned long)timeRequestId);
+        timeRequestSentUs = -1;
+    }
+
+    const unsigned long interval =
+        timeRequestsSinceConnect < TIME_BURST_REQUESTS ? TIME_BURST_INTERVAL_MS : TIME_REQUEST_INTERVAL_MS;
+    if (timeRequestsSinceConnect > 0 && now - lastTimeRequest < interval)
+        return;
+
+    char packet[32];
+    snprintf(packet, sizeof(packet), "42%lu[\"dev-time\"]", (unsigned long)++timeRequestId);
+    lastTimeRequest = now;
+    timeRequestsSinceConnect++;
+    timeRequestSentUs = esp_timer_get_time();
+    sendPacket(packet);
+}
+
+void handleServerTimeAck(uint32_t id, int64_t serverMs)
+{
+    const int64_t receivedUs = esp_timer_get_time();
+    if (id != timeRequestId || timeRequestSentUs < 0)
+        return; // timed out, or not ours
+    const int64_t sentUs = timeRequestSentUs;
+    timeRequestSentUs = -1;
+
+    if (!serverClockAddSample(serverClock, sentUs, receivedUs, serverMs * 1000))
+        return;
+    const int64_t offsetUs = serverClockOffsetUs(serverClock, receivedUs);
+    clockSyncFrom(receivedUs + offsetUs); // ignored once NTP has synced
+    LOG_DEBUG("[TIME] RTT %ld ms, offset %lld ms +/- %ld ms, %ld ppb", (long)((receivedUs - sentUs) / 1000),
+              (long long)(offsetUs / 1000), (long)(serverClockUncertaintyUs(serverClock, receivedUs) / 1000),
+              (long)serverClock.freqPpb);
+}
+
+bool serverTimeMs(int64_t &nowMs, uint32_t &uncertaintyMs)
+{
+    if (!serverClock.valid)
+        return false;
+    const int64_t local = esp_timer_get_time();
+    nowMs = (local + serverClockOffsetUs(serverClock, local)) / 1000;
+    const int64_t u = serverClockUncertaintyUs(serverClock, local) / 1000 + 1;
+    uncertaintyMs = u > UINT32_MAX ? UINT32_MAX : (uint32_t)u;
+    return true;
+}
+
+// ==================================================
+// Metrics (dev-metrics event)
+// ==================================================
+// 42["dev-metrics",{"up":<s>,"m":{...}}] every METRICS_INTERVAL_MS, with
+// the histograms of that interval; the app-cmd {"customCmd":"dev-metrics"}
+// sends one at once, with bucket bounds and without starting a new
+// interval. Times are microseconds.
+#define METRICS_INTERVAL_MS 60000
+#define METRICS_PACKET_MAX 1024
+
+static const uint32_t LOOP_BOUNDS_US[] = {100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000};
+static const uint32_t LATENCY_BOUNDS_US[] = {250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000};
+
+static unsigned long lastMetricsSend = 0;
+
+void serviceMetrics()
+{
+    if (millis() - lastMetricsSend >= METRICS_INTERVAL_MS)
+        emitDevMetrics(false);
+}
+
+void setupMetrics()
+{
+    loopMetric = metricHistogram("loop_us", LOOP_BOUNDS_US, sizeof(LOOP_BOUNDS_US) / sizeof(LOOP_BOUNDS_US[0]));
+    emitMetric = metricHistogram("emit_us", LATENCY_BOUNDS_US, sizeof(LATENCY_BOUNDS_US) / sizeof(LATENCY_BOUNDS_US[0]));
+    cmdMetric = metricHistogram("cmd_us", LATENCY_BOUNDS_US, sizeof(LATENCY_BOUNDS_US) / sizeof(LATENCY_BOUNDS_US[0]));
+    rxMetric = metricCounter("rx");
+    txMetric = metricCounter("tx");
+    reconnectMetric = metricCounter("reconnects");
+    heapFreeMetric = metricGauge("heap_free");
+    heapBlockMetric = metricGauge("heap_block");
+    rssiMetric = metricGauge("rssi");
+    logQueueMetric = metricGauge("log_queue");
+    logDroppedMetric = metricGauge("log_dropped");
+}
+
+void emitDevMetrics(bool onDemand)
+{
+    // Gauges are sampled here rather than kept up to date
+    metricSet(heapFreeMetric, (int32_t)heap_caps_get_free_size(MALLOC_CAP_8BIT));
+    metricSet(heapBlockMetric, (int32_t)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+    metricSet(rssiMetric, WiFi.status() == WL_CONNECTED ? WiFi.RSSI() : 0);
+    metricSet(logQueueMetric, (int32_t)logPendingBytes());
+    metricSet(logDroppedMetric, (int32_t)logDropped());
+
+    static char packet[METRICS_PACKET_MAX];
+    const int prefix = snprintf(packet, sizeof(packet), "42[\"dev-metrics\",{\"up\":%lu,\"m\":", millis() / 1000);
+    const size_t length = metricsJson(packet + prefix, sizeof(packet) - prefix - 2, onDemand, !onDemand);
+    if (!onDemand)
+        lastMetricsSend = millis();
+    if (length == 0)
+    {
+        LOG_ERROR("[METRICS] Report does not fit in %d bytes", METRICS_PACKET_MAX);
+        return;
+    }
+    strcpy(packet + prefix + length, "}]");
+    sendPacket(packet);
+}
+
+#ifdef LOOP_PROFILER
+// ==================================================
+// Loop profiler (dev-profile event)
+// ==================================================
+// 42["dev-profile",{"mhz":<MHz>,"s":{"<stage>":{"n":..,"min":..,"avg":..,
+// "max":..,"p99":..}}}], times in CPU cycles. The same table goes to the
+// log when 'p' is typed on the serial console.
+void emitDevProfile(bool reset)
+{
+    static char packet[PROFILE_REPORT_MAX];
+    const int prefix = snprintf(packet, sizeof(packet), "42[\"dev-profile\",");
+    const size_t length = profileJson(packet + prefix, sizeof(packet) - prefix - 1);
+    if (length == 0)
+        LOG_ERROR("[PROF] Report does not fit in %d bytes", PROFILE_REPORT_MAX);
+    else
+    {
+        strcpy(packet + prefix + length, "]");
+        sendPacket(packet);
+    }
+    profileLog();
+    if (reset)
+        profileReset();
+}
+#endif
+
 // ==================================================
 // Send Socket.IO Packet (forward to socketIo)
 // ==================================================
 void sendPacket(const char *type, const String &data)
 {
     socketIo.sendPacket(type, data);
-    DEBUG_PRINTF("[SOCKET] Sent: %s%s\n", type, data.c_str());
+    metricAdd(txMetric);
+    LOG_DEBUG("[SOCKET] Sent: %s%s", type, data.c_str());
 }
 
 // ==================================================
@@ -423,6 +725,8 @@ void sendPacket(const char *type, const String &data)
 // ==================================================
 void emitDevData()
 {
+    PROFILE_SCOPE("emit");
+    const int64_t startUs = esp_timer_get_time();
     JsonDocument doc;
     JsonArray content = doc["content"].to<JsonArray>();
 
@@ -432,15 +736,28 @@ void emitDevData()
         content.add(gpioInputs[i].state == LOW ? 1 : 0);
     }
 
+    // Server-referenced timestamp, once the clock offset is known
+    int64_t nowMs;
+    uint32_t uncertaintyMs;
+    if (serverTimeMs(nowMs, uncertaintyMs))
+    {
+        doc["ts"] = nowMs;
+        doc["tsErr"] = uncertaintyMs;
+    }
+
     String jsonData;
-    serializeJson(doc, jsonData);
+    {
+        PROFILE_SCOPE("json_tx");
+        serializeJson(doc, jsonData);
+    }
 
     // Socket.IO event format: 42["event-name", data]
     String packet = "42[\"dev-data\"," + jsonData + "]";
 
     // send via SocketIO wrapper
     sendPacket(packet.c_str());
-    DEBUG_PRINTF("[DATA] Emitted: %s\n", packet.c_str());
+    metricObserve(emitMetric, (uint32_t)(esp_timer_get_time() - startUs));
+    LOG_DEBUG("[DATA] Emitted: %s", packet.c_str());
 }
 
 // ==================================================
@@ -452,7 +769,7 @@ void emitDevStatus(const String &status)
     String packet = "42[\"dev-status\",\"" + status + "\"]";
 
     sendPacket(packet.c_str());
-    DEBUG_PRINTF("[STATUS] Emitted: %s\n", packet.c_str());
+    LOG_DEBUG("[STATUS] Emitted: %s", packet.c_str());
 }
 
 // ==================================================
@@ -460,6 +777,7 @@ void emitDevStatus(const String &status)
 // ==================================================
 bool scanGpioInputs()
 {
+    PROFILE_SCOPE("gpio");
     bool changed = false;
 
     for (int i = 0; i < SENSOR_COUNT; i++)
@@ -467,16 +785,19 @@ bool scanGpioInputs()
 #ifdef USE_SIMULATED_GPIO_VALUES
         // uint32_t randomValue = esp_random();
         gpioInputs[i].state = esp_random() % 2 == 0 ? LOW : HIGH; // Randomly toggle state
-                                                                  // DEBUG_PRINTF("[randomValue] value: %d\n", randomValue);
+                                                                  // LOG_DEBUG("[randomValue] value: %d", randomValue);
 #else
         gpioInputs[i].state = digitalRead(gpioInputs[i].pin);
+        TRACE_GPIO(gpioInputs[i].pin, gpioInputs[i].state);
 #endif
         if (gpioInputs[i].state != gpioInputs[i].previousState)
         {
-            DEBUG_PRINTF("[GPIO] Pin %d changed: %d -> %d\n",
-                         gpioInputs[i].pin,
-                         gpioInputs[i].previousState,
-                         gpioInputs[i].state);
+            LOG_INFO("[GPIO] Pin %d changed: %d -> %d",
+                     gpioInputs[i].pin,
+                     gpioInputs[i].previousState,
+                     gpioInputs[i].state);
+            eventLog(EVENT_INFO, "GPIO %d: %d -> %d", gpioInputs[i].pin, gpioInputs[i].previousState,
+                     gpioInputs[i].state);
             gpioInputs[i].previousState = gpioInputs[i].state;
             changed = true;
         }
@@ -0,0 +1,93 @@
+#include "metrics.h"
+
+#include "json_out.h"
+
+static Metric table[METRICS_MAX];
+static uint8_t registered = 0;
+static Metric overflow; // updates past the table land here
+
+static Metric *add(const char *name, MetricType type, const uint32_t *bounds, uint8_t boundCount)
+{
+    if (registered >= METRICS_MAX)
+        return &overflow;
+    Metric &m = table[registered++];
+    m.name = name;
+    m.type = type;
+    m.bounds = bounds;
+    m.boundCount = boundCount < METRIC_BOUNDS_MAX ? boundCount : METRIC_BOUNDS_MAX;
+    return &m;
+}
+
+Metric *metricCounter(const char *name)
+{
+    return add(name, METRIC_COUNTER, nullptr, 0);
+}
+
+Metric *metricGauge(const char *name)
+{
+    return add(name, METRIC_GAUGE, nullptr, 0);
+}
+
+Metric *metricHistogram(const char *name, const uint32_t *bounds, uint8_t boundCount)
+{
+    return add(name, METRIC_HISTOGRAM, bounds, boundCount);
+}
+
+void metricObserve(Metric *m, uint32_t value)
+{
+    uint8_t bucket = 0;
+    while (bucket < m->boundCount && value > m->bounds[bucket])
+        bucket++;
+    m->buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    m->count.fetch_add(1, std::memory_order_relaxed);
+    m->sum.fetch_add(value, std::memory_order_relaxed);
+    uint32_t max = m->max.load(std::memory_order_relaxed);
+    while (value > max && !m->max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+        ;
+}
+
+size_t metricsJson(char *out, size_t size, bool withBounds, bool resetHistograms)
+{
+    if (size == 0)
+        return 0;
+    JsonOut json = {out, size, 0, false};
+    json.put("{");
+    for (uint8_t i = 0; i < registered; ++i)
+    {
+        Metric &m = table[i];
+        json.put("%s\"%s\":", i ? "," : "", m.name);
+        if (m.type != METRIC_HISTOGRAM)
+        {
+            json.put("%ld", (long)m.value.load(std::memory_order_relaxed));
+            continue;
+        }
+
+        // An observation racing the reset may have its count and its bucket
+        // land in different intervals, but nothing is lost
+        const uint32_t count = resetHistograms ? m.count.exchange(0, std::memory_order_relaxed)
+                                               : m.count.load(std::memory_order_relaxed);
+        const uint32_t sum = resetHistograms ? m.sum.exchange(0, std::memory_order_relaxed)
+                                             : m.sum.load(std::memory_order_relaxed);
+        const uint32_t max = resetHistograms ? m.max.exchange(0, std::memory_order_relaxed)
+                                             : m.max.load(std::memory_order_relaxed);
+        json.put("{\"n\":%lu,\"sum\":%lu,\"max\":%lu,\"b\":[", (unsigned long)count, (unsigned long)sum,
+                 (unsigned long)max);
+        for (uint8_t b = 0; b <= m.boundCount; ++b)
+        {
+            const uint32_t n = resetHistograms ? m.buckets[b].exchange(0, std::memory_order_relaxed)
+                                               : m.buckets[b].load(std::memory_order_relaxed);
+            json.put("%s%lu", b ? "," : "", (unsigned long)n);
+        }
+        json.put("]");
+        if (withBounds)
+        {
+            json.put(",\"le\":[");
+            for (uint8_t b = 0; b < m.boundCount; ++b)
+                json.put("%s%lu", b ? "," : "", (unsigned long)m.bounds[b]);
+            json.put("]");
+        }
+        json.put("}");
+    }
+    json.put("}");
+    return json.finish();
+}
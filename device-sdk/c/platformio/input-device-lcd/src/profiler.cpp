@@ -0,0 +1,161 @@
+#include "profiler.h"
+
+#ifdef LOOP_PROFILER
+
+#include <Arduino.h>
+#include <string.h>
+
+#include "dev_log.h"
+#include "json_out.h"
+
+struct ProfileRow
+{
+    const char *name;
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t buckets[PROFILE_BUCKETS];
+};
+
+static ProfileRow rows[PROFILE_STAGES_MAX + 1]; // the last one takes the overflow
+static uint8_t stageCount = 0;
+
+static uint8_t bucketOf(uint32_t cycles)
+{
+    if (cycles < (1u << PROFILE_MIN_CYCLES_LOG2))
+        return 0;
+    const int log2 = 31 - __builtin_clz(cycles);
+    const uint32_t sub = (cycles >> (log2 - 2)) & 3;
+    return (uint8_t)(1 + (log2 - PROFILE_MIN_CYCLES_LOG2) * 4 + sub);
+}
+
+static uint32_t bucketUpperBound(uint8_t bucket)
+{
+    if (bucket == 0)
+        return (1u << PROFILE_MIN_CYCLES_LOG2) - 1;
+    const int log2 = (bucket - 1) / 4 + PROFILE_MIN_CYCLES_LOG2;
+    const uint64_t upper = ((uint64_t)(5 + (bucket - 1) % 4) << (log2 - 2)) - 1;
+    return upper > UINT32_MAX ? UINT32_MAX : (uint32_t)upper;
+}
+
+static void clearRow(ProfileRow &row)
+{
+    const char *name = row.name;
+    memset(&row, 0, sizeof(row));
+    row.name = name;
+    row.min = UINT32_MAX;
+}
+
+uint8_t profileStage(const char *name)
+{
+    for (uint8_t i = 0; i < stageCount; ++i)
+        if (strcmp(rows[i].name, name) == 0)
+            return i;
+    if (stageCount >= PROFILE_STAGES_MAX)
+        return PROFILE_STAGES_MAX;
+    rows[stageCount].name = name;
+    clearRow(rows[stageCount]);
+    return stageCount++;
+}
+
+void profileRecord(uint8_t stage, uint32_t cycles)
+{
+    ProfileRow &row = rows[stage];
+    row.count++;
+    row.sum += cycles;
+    if (cycles < row.min)
+        row.min = cycles;
+    if (cycles > row.max)
+        row.max = cycles;
+    row.buckets[bucketOf(cycles)]++;
+}
+
+uint8_t profileStageCount()
+{
+    return stageCount;
+}
+
+bool profileStats(uint8_t stage, ProfileStats &out)
+{
+    if (stage >= stageCount)
+        return false;
+    const ProfileRow &row = rows[stage];
+    out.name = row.name;
+    out.count = row.count;
+    if (row.count == 0)
+    {
+        out.min = out.avg = out.max = out.p99 = 0;
+        return true;
+    }
+    out.min = row.min;
+    out.max = row.max;
+    out.avg = (uint32_t)(row.sum / row.count);
+
+    // Smallest bucket with at least 99% of the samples at or below it
+    const uint64_t rank = ((uint64_t)row.count * 99 + 99) / 100;
+    uint64_t seen = 0;
+    uint8_t bucket = 0;
+    while (bucket < PROFILE_BUCKETS - 1 && (seen += row.buckets[bucket]) < rank)
+        bucket++;
+    const uint32_t upper = bucketUpperBound(bucket);
+    out.p99 = upper < row.max ? upper : row.max;
+    return true;
+}
+
+void profileReset()
+{
+    for (uint8_t i = 0; i <= stageCount; ++i)
+        clearRow(rows[i]);
+}
+
+uint32_t profileCyclesPerUs()
+{
+#ifdef ESP_PLATFORM
+    return getCpuFrequencyMhz();
+#else
+    return 1000;
+#endif
+}
+
+size_t profileJson(char *out, size_t size)
+{
+    if (size == 0)
+        return 0;
+    JsonOut json = {out, size, 0, false};
+    json.put("{\"mhz\":%lu,\"s\":{", (unsigned long)profileCyclesPerUs());
+    ProfileStats st;
+    for (uint8_t i = 0; profileStats(i, st); ++i)
+        json.put("%s\"%s\":{\"n\":%lu,\"min\":%lu,\"avg\":%lu,\"max\":%lu,\"p99\":%lu}", i ? "," : "", st.name,
+                 (unsigned long)st.count, (unsigned long)st.min, (unsigned long)st.avg, (unsigned long)st.max,
+                 (unsigned long)st.p99);
+    json.put("}}");
+    return json.finish();
+}
+
+void profileLog()
+{
+    const double perUs = profileCyclesPerUs();
+    LOG_INFO("[PROF] %u stages at %lu MHz, times in us", (unsigned)stageCount, (unsigned long)profileCyclesPerUs());
+    ProfileStats st;
+    for (uint8_t i = 0; profileStats(i, st); ++i)
+        LOG_INFO("[PROF] %-10s n %8lu  min %9.1f  avg %9.1f  p99 %9.1f  max %9.1f", st.name, (unsigned long)st.count,
+                 st.min / perUs, st.avg / perUs, st.p99 / perUs, st.max / perUs);
+}
+
+void profileService()
+{
+    while (Serial.available() > 0)
+    {
+        const int c = Serial.read();
+        if (c == 'p')
+            profileLog();
+        else if (c == 'r')
+        {
+            profileReset();
+            LOG_INFO("[PROF] Reset");
+        }
+    }
+}
+
+#endif // LOOP_PROFILER
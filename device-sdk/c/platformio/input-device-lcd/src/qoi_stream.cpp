@@ -0,0 +1,165 @@
+#include "qoi_stream.h"
+
+#include <string.h>
+
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF 0x40
+#define QOI_OP_LUMA 0x80
+#define QOI_OP_RUN 0xC0
+#define QOI_OP_RGB 0xFE
+#define QOI_OP_RGBA 0xFF
+#define QOI_MASK_2 0xC0
+
+// Larger than any panel, smaller than anything that would overflow
+#define QOI_MAX_SIDE 4096
+
+void qoiStreamBegin(QoiStream &s, uint16_t background)
+{
+    memset(&s, 0, sizeof(s));
+    s.status = QOI_HEADER;
+    s.background = background;
+    s.px[3] = 255;
+}
+
+static inline uint8_t opLength(uint8_t op)
+{
+    if (op == QOI_OP_RGB)
+        return 4;
+    if (op == QOI_OP_RGBA)
+        return 5;
+    return (op & QOI_MASK_2) == QOI_OP_LUMA ? 2 : 1;
+}
+
+static inline uint16_t toRgb565(const uint8_t *px, uint16_t bg)
+{
+    uint16_t r = px[0], g = px[1], b = px[2];
+    const uint8_t a = px[3];
+    if (a != 255)
+    {
+        const uint16_t br = ((bg >> 11) & 0x1F) << 3, bgg = ((bg >> 5) & 0x3F) << 2, bb = (bg & 0x1F) << 3;
+        r = (uint16_t)((r * a + br * (255 - a)) / 255);
+        g = (uint16_t)((g * a + bgg * (255 - a)) / 255);
+        b = (uint16_t)((b * a + bb * (255 - a)) / 255);
+    }
+    return (uint16_t)(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3));
+}
+
+static bool parseHeader(QoiStream &s)
+{
+    const uint8_t *h = s.pending;
+    const uint32_t w = ((uint32_t)h[4] << 24) | ((uint32_t)h[5] << 16) | ((uint32_t)h[6] << 8) | h[7];
+    const uint32_t ht = ((uint32_t)h[8] << 24) | ((uint32_t)h[9] << 16) | ((uint32_t)h[10] << 8) | h[11];
+    if (memcmp(h, "qoif", 4) != 0 || w == 0 || ht == 0 || w > QOI_MAX_SIDE || ht > QOI_MAX_SIDE ||
+        (h[12] != 3 && h[12] != 4))
+        return false;
+    s.width = w;
+    s.height = ht;
+    s.pixelsLeft = w * ht;
+    return true;
+}
+
+// Applies one complete op to s.px; QOI_OP_RUN only sets s.run
+static void applyOp(QoiStream &s, const uint8_t *op)
+{
+    const uint8_t b1 = op[0];
+    if (b1 == QOI_OP_RGB)
+    {
+        s.px[0] = op[1];
+        s.px[1] = op[2];
+        s.px[2] = op[3];
+    }
+    else if (b1 == QOI_OP_RGBA)
+    {
+        memcpy(s.px, op + 1, 4);
+    }
+    else if ((b1 & QOI_MASK_2) == QOI_OP_INDEX)
+    {
+        memcpy(s.px, s.index[b1], 4);
+    }
+    else if ((b1 & QOI_MASK_2) == QOI_OP_DIFF)
+    {
+        s.px[0] += ((b1 >> 4) & 3) - 2;
+        s.px[1] += ((b1 >> 2) & 3) - 2;
+        s.px[2] += (b1 & 3) - 2;
+    }
+    else if ((b1 & QOI_MASK_2) == QOI_OP_LUMA)
+    {
+        const int vg = (b1 & 0x3F) - 32;
+        s.px[0] += vg - 8 + ((op[1] >> 4) & 0x0F);
+        s.px[1] += vg;
+        s.px[2] += vg - 8 + (op[1] & 0x0F);
+    }
+    else
+    {
+        s.run = (uint8_t)(b1 & 0x3F); // this pixel plus run more
+    }
+
+    const int hash = (s.px[0] * 3 + s.px[1] * 5 + s.px[2] * 7 + s.px[3] * 11) % 64;
+    memcpy(s.index[hash], s.px, 4);
+}
+
+size_t qoiStreamDecode(QoiStream &s, const uint8_t *&data, size_t &len, uint16_t *out, size_t maxPixels)
+{
+    if (s.status == QOI_HEADER)
+    {
+        while (len > 0 && s.pendingLen < QOI_HEADER_BYTES)
+        {
+            s.pending[s.pendingLen++] = *data++;
+            --len;
+        }
+        if (s.pendingLen < QOI_HEADER_BYTES)
+            return 0;
+        s.pendingLen = 0;
+        s.status = parseHeader(s) ? QOI_PIXELS : QOI_INVALID;
+    }
+    if (s.status != QOI_PIXELS)
+        return 0;
+
+    size_t n = 0;
+    uint16_t color = toRgb565(s.px, s.background);
+    while (n < maxPixels && s.pixelsLeft > 0)
+    {
+        if (s.run > 0)
+        {
+            s.run--;
+            out[n++] = color;
+            s.pixelsLeft--;
+            continue;
+        }
+
+        if (s.pendingLen == 0 && len == 0)
+            break;
+
+        // Whole ops are decoded in place; only one split across chunks is
+        // gathered in pending first
+        const uint8_t *op = data;
+        if (s.pendingLen == 0 && len >= opLength(*data))
+        {
+            const uint8_t oplen = opLength(*data);
+            data += oplen;
+            len -= oplen;
+        }
+        else
+        {
+            const uint8_t need = opLength(s.pendingLen ? s.pending[0] : *data);
+            while (len > 0 && s.pendingLen < need)
+            {
+                s.pending[s.pendingLen++] = *data++;
+                --len;
+            }
+            if (s.pendingLen < need)
+                break;
+            op = s.pending;
+            s.pendingLen = 0;
+        }
+
+        applyOp(s, op);
+        color = toRgb565(s.px, s.background);
+        out[n++] = color;
+        s.pixelsLeft--;
+    }
+
+    if (s.pixelsLeft == 0)
+        s.status = QOI_DONE;
+    return n;
+}
@@ -0,0 +1,129 @@
+#include "server_clock.h"
+
+#include <string.h>
+
+static int64_t abs64(int64_t v)
+{
+    return v < 0 ? -v : v;
+}
+
+// Change of an offset over dtUs at a frequency error of ppb
+static int64_t driftUs(int64_t dtUs, int64_t ppb)
+{
+    return dtUs * ppb / 1000000000;
+}
+
+static int64_t marginPpb(const ServerClock &c)
+{
+    return (int64_t)(c.freqLocked ? SERVER_CLOCK_LOCKED_PPM : SERVER_CLOCK_DRIFT_PPM) * 1000;
+}
+
+// Offset at localUs before the frequency term: slewing toward the estimate
+static int64_t phaseAt(const ServerClock &c, int64_t localUs)
+{
+    if (localUs >= c.slewEndUs)
+        return c.estimateUs;
+    if (localUs <= c.refUs)
+        return c.slewFromUs;
+    return c.slewFromUs + (c.estimateUs - c.slewFromUs) * (localUs - c.refUs) / (c.slewEndUs - c.refUs);
+}
+
+void serverClockInit(ServerClock &c)
+{
+    memset(&c, 0, sizeof(c));
+}
+
+bool serverClockAddSample(ServerClock &c, int64_t sentUs, int64_t receivedUs, int64_t serverUs)
+{
+    const int64_t rtt = receivedUs - sentUs;
+    if (rtt < 0 || rtt > SERVER_CLOCK_MAX_RTT_US)
+    {
+        c.rejected++;
+        return false;
+    }
+    c.accepted++;
+    const int64_t current = serverClockOffsetUs(c, receivedUs);
+
+    memmove(&c.samples[1], &c.samples[0], (SERVER_CLOCK_SAMPLES - 1) * sizeof(c.samples[0]));
+    c.samples[0] = {sentUs, receivedUs, serverUs};
+    if (c.count < SERVER_CLOCK_SAMPLES)
+        c.count++;
+
+    // Intersect newest first, each interval carried to receivedUs and
+    // widened by what the frequency error could have moved it since
+    int64_t lo = INT64_MIN, hi = INT64_MAX;
+    int used = 0;
+    for (; used < c.count; ++used)
+    {
+        const ServerClockSample &s = c.samples[used];
+        const int64_t age = receivedUs - s.receivedUs;
+        const int64_t drift = driftUs(age, c.freqPpb);
+        const int64_t margin = driftUs(age, marginPpb(c));
+        const int64_t sLo = s.serverUs - s.receivedUs + drift - margin;
+        const int64_t sHi = s.serverUs + SERVER_CLOCK_STAMP_US - s.sentUs + drift + margin;
+        const int64_t nLo = sLo > lo ? sLo : lo;
+        const int64_t nHi = sHi < hi ? sHi : hi;
+        if (nLo > nHi)
+            break; // this one and everything older disagree with the rest
+        lo = nLo;
+        hi = nHi;
+    }
+    const bool disagreed = used < c.count;
+    c.count = (uint8_t)used;
+    const int64_t estimate = lo + (hi - lo) / 2;
+    const int64_t halfWidth = (hi - lo + 1) / 2;
+
+    // Frequency from how the estimate moved over a long baseline. A
+    // disagreement may be a server step, so the baseline restarts there.
+    if (!c.valid || disagreed)
+    {
+        c.anchorUs = receivedUs;
+        c.anchorEstimateUs = estimate;
+    }
+    else if (receivedUs - c.anchorUs >= SERVER_CLOCK_BASELINE_US)
+    {
+        const int64_t measured = (estimate - c.anchorEstimateUs) * 1000000000 / (receivedUs - c.anchorUs);
+        if (abs64(measured) <= (int64_t)SERVER_CLOCK_DRIFT_PPM * 1000)
+        {
+            c.freqPpb = (int32_t)(c.freqLocked ? c.freqPpb + (measured - c.freqPpb) / 4 : measured);
+            c.freqLocked = true;
+        }
+        c.anchorUs = receivedUs;
+        c.anchorEstimateUs = estimate;
+    }
+
+    // Slew when the new estimate agrees with what was being handed out,
+    // step otherwise
+    const int64_t correction = estimate - current;
+    if (c.valid && abs64(correction) <= halfWidth)
+    {
+        c.slewFromUs = current;
+        c.slewEndUs = receivedUs + abs64(correction) * (1000000 / SERVER_CLOCK_SLEW_PPM);
+    }
+    else
+    {
+        if (c.valid)
+            c.steps++;
+        c.slewFromUs = estimate;
+        c.slewEndUs = receivedUs;
+    }
+    c.refUs = receivedUs;
+    c.estimateUs = estimate;
+    c.halfWidthUs = halfWidth;
+    c.valid = true;
+    return true;
+}
+
+int64_t serverClockOffsetUs(const ServerClock &c, int64_t localUs)
+{
+    if (!c.valid)
+        return 0;
+    return phaseAt(c, localUs) + driftUs(localUs - c.refUs, c.freqPpb);
+}
+
+int64_t serverClockUncertaintyUs(const ServerClock &c, int64_t localUs)
+{
+    if (!c.valid)
+        return INT64_MAX;
+    return c.halfWidthUs + abs64(c.estimateUs - phaseAt(c, localUs)) + driftUs(abs64(localUs - c.refUs), marginPpb(c));
+}
@@ -1,5 +1,8 @@
 #include "socketio_client.h"
 #include "config.h"
+#include "dev_log.h"
+#include "profiler.h"
+#include "traffic_trace.h"
 
 SocketIOClient *SocketIOClient::instance = nullptr;
 
@@ -39,6 +42,7 @@ void SocketIOClient::begin(const String &token)
 
 void SocketIOClient::loop()
 {
+    PROFILE_SCOPE("socket");
     ws.loop();
 }
 
@@ -47,6 +51,7 @@ void SocketIOClient::sendPacket(const char *type, const String &data)
     String packet = String(type);
     if (data.length() > 0)
         packet += data;
+    TRACE_RECORD(TRACE_OUT, packet.c_str(), packet.length());
     ws.sendTXT(packet);
 }
 
@@ -61,22 +66,25 @@ void SocketIOClient::wsEvent(WStype_t type, uint8_t *payload, size_t length)
     switch (type)
     {
     case WStype_DISCONNECTED:
+        TRACE_RECORD(TRACE_CLOSE, nullptr, 0);
         if (disconnectCb)
             disconnectCb();
         break;
 
     case WStype_CONNECTED:
+        TRACE_RECORD(TRACE_OPEN, nullptr, 0);
         if (connectCb)
             connectCb();
         break;
 
     case WStype_TEXT:
+        TRACE_RECORD(TRACE_IN, payload, length);
         if (packetCb && payload && length > 0)
             packetCb((const char *)payload, length);
         break;
 
     case WStype_ERROR:
-        DEBUG_PRINTLN("[SOCKET] WebSocket error");
+        LOG_ERROR("[SOCKET] WebSocket error");
         break;
 
     default:
@@ -0,0 +1,55 @@
+#include "sparkline.h"
+
+static void store(SparkHistory &h, uint32_t c, uint8_t code)
+{
+    const uint32_t bit = (c % SPARK_COLUMNS) * 2;
+    uint8_t &byte = h.bits[bit >> 3];
+    const int shift = 6 - (bit & 7);
+    byte = (uint8_t)((byte & ~(3 << shift)) | (code << shift));
+}
+
+uint8_t sparkColumn(const SparkHistory &h, uint32_t c)
+{
+    const uint32_t bit = (c % SPARK_COLUMNS) * 2;
+    return (h.bits[bit >> 3] >> (6 - (bit & 7))) & 3;
+}
+
+uint32_t sparkSample(SparkHistory &h, bool value, uint32_t nowMs)
+{
+    if (!h.started)
+    {
+        h.started = true;
+        h.periodStart = nowMs;
+    }
+
+    // Close finished periods; a gap longer than the whole ring only needs
+    // one ring's worth, after which the period restarts at nowMs.
+    uint32_t committed = 0;
+    while (nowMs - h.periodStart >= LCD_SPARK_PERIOD_MS)
+    {
+        if (committed == SPARK_COLUMNS)
+        {
+            h.periodStart = nowMs;
+            break;
+        }
+        const uint8_t code = h.hasSample ? (uint8_t)((h.openMin << 1) | h.openMax) : (h.last ? SPARK_ON : SPARK_OFF);
+        store(h, h.columns++, code);
+        h.periodStart += LCD_SPARK_PERIOD_MS;
+        h.hasSample = false;
+        committed++;
+    }
+
+    if (!h.hasSample)
+    {
+        h.openMin = value;
+        h.openMax = value;
+        h.hasSample = true;
+    }
+    else
+    {
+        h.openMin &= value;
+        h.openMax |= value;
+    }
+    h.last = value;
+    return committed;
+}
@@ -0,0 +1,84 @@
+#include "trace_record.h"
+
+#include <string.h>
+
+size_t traceVarint(uint8_t *out, uint32_t v)
+{
+    size_t n = 0;
+    while (v >= 0x80)
+    {
+        out[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    out[n++] = (uint8_t)v;
+    return n;
+}
+
+static bool readVarint(const uint8_t *&p, const uint8_t *end, uint32_t &v)
+{
+    v = 0;
+    for (int shift = 0; shift < 35; shift += 7)
+    {
+        if (p >= end)
+            return false;
+        const uint8_t byte = *p++;
+        v |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+bool traceParseFrame(const uint8_t *payload, size_t length, void (*onEvent)(const TraceEvent &event, void *ctx),
+                     void *ctx)
+{
+    if (length < 8)
+        return false;
+    const uint8_t *p = payload;
+    const uint8_t *const end = payload + length;
+    TraceEvent event = {};
+    memcpy(&event.timeUs, p, 8);
+    p += 8;
+    while (p < end)
+    {
+        event.kind = *p++;
+        uint32_t delta;
+        if (!readVarint(p, end, delta))
+            return false;
+        event.timeUs += delta;
+        event.data = nullptr;
+        event.length = 0;
+        switch (event.kind)
+        {
+        case TRACE_IN:
+        case TRACE_OUT:
+        {
+            uint32_t n;
+            if (!readVarint(p, end, n) || n > (size_t)(end - p))
+                return false;
+            event.data = p;
+            event.length = n;
+            p += n;
+            break;
+        }
+        case TRACE_GPIO:
+            if (end - p < 2)
+                return false;
+            event.pin = p[0];
+            event.level = p[1];
+            p += 2;
+            break;
+        case TRACE_LOST:
+            if (!readVarint(p, end, event.lost))
+                return false;
+            break;
+        case TRACE_OPEN:
+        case TRACE_CLOSE:
+            break;
+        default:
+            return false;
+        }
+        onEvent(event, ctx);
+    }
+    return true;
+}
@@ -0,0 +1,149 @@
+#include "traffic_trace.h"
+
+#ifdef TRAFFIC_TRACE
+
+#include <atomic>
+#include <esp_timer.h>
+#include <string.h>
+
+#include "dev_log.h"
+
+static_assert((TRAFFIC_TRACE_BYTES & (TRAFFIC_TRACE_BYTES - 1)) == 0, "TRAFFIC_TRACE_BYTES must be a power of two");
+
+// Kind, varints and length in front of the data, at most
+#define TRACE_RECORD_OVERHEAD 11
+#define TRACE_FRAME_MAX (8 + TRACE_RECORD_OVERHEAD + TRACE_DATA_MAX)
+
+// A ring entry: this header, then the data, padded to 4 bytes. One writer
+// (the loop task) and one reader (the drain), so head and tail suffice.
+struct TraceEntry
+{
+    uint32_t length;
+    uint8_t kind;
+    int64_t timeUs;
+};
+
+static uint8_t ring[TRAFFIC_TRACE_BYTES] __attribute__((aligned(8)));
+static std::atomic<uint32_t> head(0);
+static std::atomic<uint32_t> tail(0);
+static std::atomic<uint32_t> dropped(0);
+static uint32_t droppedReported = 0;
+
+// The frame being built by traceDrain()
+static uint8_t frame[TRACE_FRAME_MAX];
+static size_t frameLength = 0;
+static int64_t frameLastUs = 0;
+
+static void copyIn(uint32_t pos, const void *data, size_t length)
+{
+    const size_t at = pos & (TRAFFIC_TRACE_BYTES - 1);
+    const size_t first = length < TRAFFIC_TRACE_BYTES - at ? length : TRAFFIC_TRACE_BYTES - at;
+    memcpy(&ring[at], data, first);
+    memcpy(ring, (const uint8_t *)data + first, length - first);
+}
+
+static void copyOut(uint32_t pos, void *data, size_t length)
+{
+    const size_t at = pos & (TRAFFIC_TRACE_BYTES - 1);
+    const size_t first = length < TRAFFIC_TRACE_BYTES - at ? length : TRAFFIC_TRACE_BYTES - at;
+    memcpy(data, &ring[at], first);
+    memcpy((uint8_t *)data + first, ring, length - first);
+}
+
+static uint32_t entrySize(size_t length)
+{
+    return (uint32_t)((sizeof(TraceEntry) + length + 3) & ~(size_t)3);
+}
+
+void traceRecord(uint8_t kind, const void *data, size_t length)
+{
+    if (length > TRACE_DATA_MAX)
+        length = TRACE_DATA_MAX;
+    const uint32_t size = entrySize(length);
+    const uint32_t pos = head.load(std::memory_order_relaxed);
+    if (pos + size - tail.load(std::memory_order_acquire) > TRAFFIC_TRACE_BYTES)
+    {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    const TraceEntry entry = {(uint32_t)length, kind, esp_timer_get_time()};
+    copyIn(pos, &entry, sizeof(entry));
+    if (length)
+        copyIn(pos + sizeof(entry), data, length);
+    head.store(pos + size, std::memory_order_release);
+}
+
+void traceGpio(uint8_t pin, uint8_t level)
+{
+    // Level + 1 last recorded per pin; 0: none yet
+    static uint8_t recorded[64];
+    if (pin < sizeof(recorded))
+    {
+        if (recorded[pin] == level + 1)
+            return;
+        recorded[pin] = level + 1;
+    }
+    const uint8_t data[2] = {pin, level};
+    traceRecord(TRACE_GPIO, data, sizeof(data));
+}
+
+uint32_t traceDropped()
+{
+    return dropped.load(std::memory_order_relaxed);
+}
+
+static void flushFrame()
+{
+    if (frameLength > 8)
+        logSendFrame(LOG_FRAME_TRACE, frame, frameLength, nullptr, 0);
+    frameLength = 0;
+}
+
+// data is the record's body as trace_record.h lays it out, except that
+// IN and OUT text gets its length prefix here
+static void appendRecord(uint8_t kind, int64_t timeUs, const uint8_t *data, size_t length)
+{
+    if (frameLength + TRACE_RECORD_OVERHEAD + length > sizeof(frame))
+        flushFrame();
+    if (frameLength == 0)
+    {
+        memcpy(frame, &timeUs, 8);
+        frameLength = 8;
+        frameLastUs = timeUs;
+    }
+    frame[frameLength++] = kind;
+    frameLength += traceVarint(frame + frameLength, (uint32_t)(timeUs - frameLastUs));
+    frameLastUs = timeUs;
+    if (kind == TRACE_IN || kind == TRACE_OUT)
+        frameLength += traceVarint(frame + frameLength, (uint32_t)length);
+    memcpy(frame + frameLength, data, length);
+    frameLength += length;
+}
+
+void traceDrain()
+{
+    uint8_t data[TRACE_DATA_MAX];
+    uint32_t pos = tail.load(std::memory_order_relaxed);
+    const uint32_t end = head.load(std::memory_order_acquire);
+    while (pos != end)
+    {
+        TraceEntry entry;
+        copyOut(pos, &entry, sizeof(entry));
+        const size_t length = entry.length <= sizeof(data) ? entry.length : 0;
+        copyOut(pos + sizeof(entry), data, length);
+        pos += entrySize(length);
+        tail.store(pos, std::memory_order_release);
+        appendRecord(entry.kind, entry.timeUs, data, length);
+    }
+    const uint32_t lost = dropped.load(std::memory_order_relaxed);
+    if (lost != droppedReported)
+    {
+        uint8_t count[5];
+        appendRecord(TRACE_LOST, frameLength ? frameLastUs : esp_timer_get_time(), count,
+                     traceVarint(count, lost - droppedReported));
+        droppedReported = lost;
+    }
+    flushFrame();
+}
+
+#endif // TRAFFIC_TRACE
@@ -0,0 +1,170 @@
+#include "wall_clock.h"
+
+#include <Arduino.h>
+#include <atomic>
+#include <esp_sntp.h>
+#include <esp_timer.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// UTC minus esp_timer, moving linearly from `from` to `to` between
+// slewStart and slewEnd (equal when the last sync stepped)
+struct ClockState
+{
+    int64_t from;
+    int64_t to;
+    int64_t slewStart;
+    int64_t slewEnd;
+    ClockSyncInfo info;
+};
+
+// A seqlock, odd while a sync is being written. Writers (the SNTP callback
+// and clockSyncFrom() callers) take writeLock first.
+static ClockState state = {};
+static std::atomic<uint32_t> stateSeq(0);
+static std::atomic_flag writeLock = ATOMIC_FLAG_INIT;
+
+static char dateText[11] = "--";
+static char timeText[9] = "--:--:--";
+static int64_t formattedSecond = -1; // -1: the "not synced" texts
+static uint32_t formatCount = 0;
+
+static ClockState readState()
+{
+    while (true)
+    {
+        const uint32_t before = stateSeq.load(std::memory_order_acquire);
+        if (before & 1)
+            continue;
+        ClockState s;
+        memcpy(&s, &state, sizeof(s));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (stateSeq.load(std::memory_order_relaxed) == before)
+            return s;
+    }
+}
+
+static int64_t offsetAt(const ClockState &s, int64_t mono)
+{
+    if (mono >= s.slewEnd)
+        return s.to;
+    if (mono <= s.slewStart)
+        return s.from;
+    return s.from + (s.to - s.from) * (mono - s.slewStart) / (s.slewEnd - s.slewStart);
+}
+
+static void applySync(int64_t utc, bool sntp)
+{
+    while (writeLock.test_and_set(std::memory_order_acquire))
+        ;
+    ClockState s = state;
+    if (!sntp && s.info.sntp)
+    {
+        writeLock.clear(std::memory_order_release);
+        return;
+    }
+
+    const int64_t mono = esp_timer_get_time();
+    const int64_t target = utc - mono;
+    const int64_t current = s.info.syncs ? offsetAt(s, mono) : target;
+    const int64_t correction = target - current;
+    const int64_t size = correction < 0 ? -correction : correction;
+
+    s.from = current;
+    s.to = target;
+    s.slewStart = mono;
+    s.slewEnd = size <= CLOCK_SLEW_LIMIT_US ? mono + size * (1000000 / CLOCK_SLEW_PPM) : mono;
+    s.info.syncs++;
+    s.info.sntp = s.info.sntp || sntp;
+    s.info.lastCorrectionUs = correction;
+    s.info.lastSyncUs = mono;
+
+    stateSeq.store(stateSeq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&state, &s, sizeof(state));
+    stateSeq.store(stateSeq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    writeLock.clear(std::memory_order_release);
+}
+
+static void onSntpSync(struct timeval *tv)
+{
+    applySync((int64_t)tv->tv_sec * 1000000 + tv->tv_usec, true);
+}
+
+void clockBegin(const char *tz)
+{
+    sntp_set_time_sync_notification_cb(onSntpSync);
+    configTzTime(tz, CLOCK_NTP_SERVER_1, CLOCK_NTP_SERVER_2);
+    clockSetTimeZone(tz);
+}
+
+void clockSetTimeZone(const char *tz)
+{
+    setenv("TZ", tz, 1);
+    tzset();
+    formattedSecond = INT64_MIN; // re-format on the next read
+}
+
+void clockSyncFrom(int64_t utcUs)
+{
+    applySync(utcUs, false);
+}
+
+bool clockSynced()
+{
+    return readState().info.syncs > 0;
+}
+
+int64_t clockNowUs()
+{
+    const ClockState s = readState();
+    if (s.info.syncs == 0)
+        return 0;
+    const int64_t mono = esp_timer_get_time();
+    return mono + offsetAt(s, mono);
+}
+
+ClockSyncInfo clockSyncInfo()
+{
+    return readState().info;
+}
+
+static void formatNow()
+{
+    const int64_t now = clockNowUs();
+    const int64_t second = now > 0 ? now / 1000000 : -1;
+    if (second == formattedSecond)
+        return;
+    formattedSecond = second;
+    formatCount++;
+
+    if (second < 0)
+    {
+        strcpy(dateText, "--");
+        strcpy(timeText, "--:--:--");
+        return;
+    }
+    const time_t t = (time_t)second;
+    struct tm local;
+    localtime_r(&t, &local);
+    strftime(dateText, sizeof(dateText), "%Y-%m-%d", &local);
+    strftime(timeText, sizeof(timeText), "%H:%M:%S", &local);
+}
+
+const char *clockDateText()
+{
+    formatNow();
+    return dateText;
+}
+
+const char *clockTimeText()
+{
+    formatNow();
+    return timeText;
+}
+
+uint32_t clockFormatCount()
+{
+    return formatCount;
+}
@@ -0,0 +1,72 @@
+// Command-to-actuation latency: timestamps each app-cmd on its way through
+// the firmware.
+//
+//   CMD_STAMP(CMD_FRAME)      text frame in webSocketEvent (every frame)
+//   CMD_STAMP(CMD_PARSED)     processAppCmd has the parameters: opens a command
+//   CMD_STAMP(CMD_WRITTEN)    digitalWrite in setState
+//   CMD_STAMP(CMD_CONFIRMED)  the dev-data carrying the new state is sent:
+//                             closes every open command
+//
+// A command that writes several pins (output-all) keeps its first write;
+// one that writes none (sync) has writtenNs 0. Closed commands go into a
+// ring of CMD_LATENCY_SAMPLES, oldest overwritten, for cmdLatencyPop(), and
+// into running figures that CMD_LATENCY_REPORT() prints and resets.
+//
+// Times are nanoseconds: esp_timer on the ESP32 (1 us resolution); on the
+// host, virtual time plus the real time since it last moved, so both link
+// delays and the CPU spent inside one loop() show. Only the loop task may
+// stamp.
+//
+// Without CMD_LATENCY in config.h the macros compile to nothing.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config.h"
+
+#ifdef CMD_LATENCY
+
+#ifndef CMD_LATENCY_SAMPLES
+#define CMD_LATENCY_SAMPLES 64
+#endif
+#define CMD_LATENCY_OPEN_MAX 8 // commands awaiting their dev-data; more are dropped
+
+enum CmdStage : uint8_t
+{
+    CMD_FRAME,
+    CMD_PARSED,
+    CMD_WRITTEN,
+    CMD_CONFIRMED,
+};
+
+struct CmdLatencySample
+{
+    int64_t frameNs;
+    int64_t parsedNs;
+    int64_t writtenNs; // 0: the command wrote no pin
+    int64_t confirmedNs;
+};
+
+void cmdLatencyStamp(CmdStage stage);
+
+// The oldest closed command not yet popped; false if none
+bool cmdLatencyPop(CmdLatencySample &sample);
+// Closed commands overwritten before they were popped, and commands dropped
+// because CMD_LATENCY_OPEN_MAX were open, since boot
+uint32_t cmdLatencyOverwritten();
+uint32_t cmdLatencyDropped();
+
+// One DEBUG_PRINTF line: count, mean and max of each stage since the last
+// report, in microseconds
+void cmdLatencyReport();
+
+#define CMD_STAMP(stage) cmdLatencyStamp(stage)
+#define CMD_LATENCY_REPORT() cmdLatencyReport()
+
+#else
+
+#define CMD_STAMP(stage) ((void)0)
+#define CMD_LATENCY_REPORT() ((void)0)
+
+#endif // CMD_LATENCY
@@ -56,6 +56,12 @@
 #define LCD_DC_PIN 21
 #define LCD_RST_PIN 22
 #define LCD_BL_PIN 4
+
+// SPI write clock (Hz). Lower it for long wires or unstable modules.
+#define LCD_SPI_FREQ 40000000
+
+// Print fillScreen/fillRect frame times to Serial at boot
+// #define LCD_BENCHMARK
 #endif
 
 // ==================================================
@@ -64,6 +70,10 @@
 #define STATUS_REPORT_INTERVAL 60000 // Report status every 60s
 #define BLINK_INTERVAL 500           // Blink toggle interval (500ms)
 
+// Uncomment to timestamp app-cmds from frame arrival to relay write and
+// dev-data, with a [LAT] summary every status report (see cmd_latency.h)
+// #define CMD_LATENCY
+
 // ==================================================
 // Debug Configuration
 // ==================================================
@@ -5,20 +5,39 @@
 
 #ifdef HAS_LCD_240x320
 
+// ILI9341 driver built on the ESP-IDF SPI master driver.
+// Every bus access is a queued DMA transaction; drawing calls return as soon
+// as their descriptors are queued. Call waitIdle() before touching pixel
+// buffers handed to pushPixels() from another task or before measuring time.
 class LCD
 {
 public:
+    static const int16_t WIDTH = 240;
+    static const int16_t HEIGHT = 320;
+
     static void begin();
     static void setBacklight(uint8_t level); // 0..255
     static void fillScreen(uint16_t color);
+    static void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
     static void drawPixel(int16_t x, int16_t y, uint16_t color);
     static void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
 
+    // Push a w*h block of RGB565 pixels (native byte order, row-major).
+    static void pushPixels(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t *pixels);
+
+    // Draw a 1bpp bitmap (MSB first, rows padded to whole bytes) using fg/bg colors.
+    static void drawBitmap(int16_t x, int16_t y, int16_t w, int16_t h, const uint8_t *bitmap,
+                           uint16_t fg, uint16_t bg);
+
+    // Block until every queued transaction has been clocked out.
+    static void waitIdle();
+
 private:
     static void writeCommand(uint8_t cmd);
-    static void writeData(uint8_t data);
-    static void writeDataBuffer(const uint8_t *buf, size_t len);
+    static void writeData(const uint8_t *data, size_t len);
+    static void writePixels(const uint16_t *pixels, size_t count);
     static void setAddrWindow(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
+    static bool clip(int16_t &x, int16_t &y, int16_t &w, int16_t &h);
     static inline uint16_t color565(uint8_t r, uint8_t g, uint8_t b)
     {
         return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
@@ -0,0 +1,132 @@
+#include "cmd_latency.h"
+
+#ifdef CMD_LATENCY
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#ifndef ESP_PLATFORM
+#include <time.h>
+#endif
+
+static int64_t frameNs = 0;
+static CmdLatencySample pending[CMD_LATENCY_OPEN_MAX];
+static uint8_t pendingCount = 0;
+
+static CmdLatencySample ring[CMD_LATENCY_SAMPLES];
+static uint32_t ringHead = 0; // next to write
+static uint32_t ringTail = 0; // next to pop
+static uint32_t overwritten = 0;
+static uint32_t dropped = 0;
+
+// Since the last report: commands, and sum and max of each stage in ns
+// (arrival to parse, parse to write, write to dev-data, arrival to dev-data)
+static uint32_t reportCount = 0;
+static int64_t reportSum[4];
+static int64_t reportMax[4];
+
+static int64_t latencyNs()
+{
+#ifdef ESP_PLATFORM
+    return esp_timer_get_time() * 1000;
+#else
+    // esp_timer is the virtual clock, which stands still inside loop()
+    static int64_t virtualUs = -1;
+    static int64_t realBaseNs = 0;
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    const int64_t realNs = (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+    if (esp_timer_get_time() != virtualUs)
+    {
+        virtualUs = esp_timer_get_time();
+        realBaseNs = realNs;
+    }
+    return virtualUs * 1000 + (realNs - realBaseNs);
+#endif
+}
+
+static void closeSample(const CmdLatencySample &sample)
+{
+    if (ringHead - ringTail == CMD_LATENCY_SAMPLES)
+    {
+        ringTail++;
+        overwritten++;
+    }
+    ring[ringHead++ % CMD_LATENCY_SAMPLES] = sample;
+
+    const int64_t writtenNs = sample.writtenNs ? sample.writtenNs : sample.parsedNs;
+    const int64_t stages[4] = {sample.parsedNs - sample.frameNs, writtenNs - sample.parsedNs,
+                               sample.confirmedNs - writtenNs, sample.confirmedNs - sample.frameNs};
+    for (int i = 0; i < 4; i++)
+    {
+        reportSum[i] += stages[i];
+        if (stages[i] > reportMax[i])
+            reportMax[i] = stages[i];
+    }
+    reportCount++;
+}
+
+void cmdLatencyStamp(CmdStage stage)
+{
+    const int64_t now = latencyNs();
+    switch (stage)
+    {
+    case CMD_FRAME:
+        frameNs = now;
+        break;
+    case CMD_PARSED:
+        if (pendingCount == CMD_LATENCY_OPEN_MAX)
+        {
+            dropped++;
+            break;
+        }
+        pending[pendingCount++] = {frameNs, now, 0, 0};
+        break;
+    case CMD_WRITTEN:
+        for (uint8_t i = 0; i < pendingCount; i++)
+            if (!pending[i].writtenNs)
+                pending[i].writtenNs = now;
+        break;
+    case CMD_CONFIRMED:
+        for (uint8_t i = 0; i < pendingCount; i++)
+        {
+            pending[i].confirmedNs = now;
+            closeSample(pending[i]);
+        }
+        pendingCount = 0;
+        break;
+    }
+}
+
+bool cmdLatencyPop(CmdLatencySample &sample)
+{
+    if (ringTail == ringHead)
+        return false;
+    sample = ring[ringTail++ % CMD_LATENCY_SAMPLES];
+    return true;
+}
+
+uint32_t cmdLatencyOverwritten()
+{
+    return overwritten;
+}
+
+uint32_t cmdLatencyDropped()
+{
+    return dropped;
+}
+
+void cmdLatencyReport()
+{
+    if (!reportCount)
+        return;
+    DEBUG_PRINTF("[LAT] %u cmds, mean/max us: parse %.1f/%.1f, write %.1f/%.1f, dev-data %.1f/%.1f, "
+                 "total %.1f/%.1f\n",
+                 (unsigned)reportCount, reportSum[0] / 1e3 / reportCount, reportMax[0] / 1e3,
+                 reportSum[1] / 1e3 / reportCount, reportMax[1] / 1e3, reportSum[2] / 1e3 / reportCount,
+                 reportMax[2] / 1e3, reportSum[3] / 1e3 / reportCount, reportMax[3] / 1e3);
+    reportCount = 0;
+    for (int i = 0; i < 4; i++)
+        reportSum[i] = reportMax[i] = 0;
+}
+
+#endif // CMD_LATENCY
@@ -2,7 +2,8 @@
 
 #include "lcd.h"
 #include "config.h"
-#include <SPI.h>
+#include <driver/spi_master.h>
+#include <esp_heap_caps.h>
 
 // ILI9341 commands (subset)
 #define ILI9341_SWRESET 0x01
@@ -14,59 +15,178 @@
 #define ILI9341_MADCTL 0x36
 #define ILI9341_COLMOD 0x3A
 
+// Write clock. ILI9341 modules are typically fine at 40MHz; lower it in
+// config.h for long wires or breadboard setups.
+#ifndef LCD_SPI_FREQ
+#define LCD_SPI_FREQ 40000000
+#endif
+
+// Number of transaction descriptors that may be queued at once.
+#define LCD_QUEUE_DEPTH 8
+
+// Pixels per DMA line buffer (16 full panel rows, 7.5KB per buffer).
+#define LCD_LINE_PIXELS (LCD::WIDTH * 16)
+
+// --------------------------------------------------------------
+// Transaction queue
+// --------------------------------------------------------------
+// Descriptors are used as a ring: slot (n % LCD_QUEUE_DEPTH) holds the n-th
+// submitted transaction. The SPI driver completes transactions in order, so
+// a slot is free once the transaction LCD_QUEUE_DEPTH submissions back has
+// been reclaimed.
+static spi_device_handle_t lcdSpi = nullptr;
+static spi_transaction_t descriptors[LCD_QUEUE_DEPTH];
+static uint32_t submittedCount = 0;
+static uint32_t completedCount = 0;
+
+// Two DMA-capable buffers so one can be filled while the other is on the bus.
+// lineBufTicket[i] is the submission count after the last transaction that
+// reads buffer i; the buffer may be rewritten once completedCount reaches it.
+static uint16_t *lineBuf[2] = {nullptr, nullptr};
+static uint32_t lineBufTicket[2] = {0, 0};
+static uint8_t lineBufNext = 0;
+
+// DC level is carried in the descriptor's user field and applied right
+// before the transaction starts.
+static void IRAM_ATTR lcdSpiPreCallback(spi_transaction_t *t)
+{
+    gpio_set_level((gpio_num_t)LCD_DC_PIN, (int)(intptr_t)t->user);
+}
+
+static void reclaimOne()
+{
+    spi_transaction_t *done = nullptr;
+    spi_device_get_trans_result(lcdSpi, &done, portMAX_DELAY);
+    completedCount++;
+}
+
+static void waitForTicket(uint32_t ticket)
+{
+    while ((int32_t)(ticket - completedCount) > 0)
+        reclaimOne();
+}
+
+static spi_transaction_t *acquireDescriptor()
+{
+    if (submittedCount - completedCount >= LCD_QUEUE_DEPTH)
+        reclaimOne();
+
+    spi_transaction_t *t = &descriptors[submittedCount % LCD_QUEUE_DEPTH];
+    memset(t, 0, sizeof(*t));
+    return t;
+}
+
+static void submit(spi_transaction_t *t)
+{
+    spi_device_queue_trans(lcdSpi, t, portMAX_DELAY);
+    submittedCount++;
+}
+
+static uint8_t claimLineBuffer()
+{
+    uint8_t idx = lineBufNext;
+    lineBufNext ^= 1;
+    waitForTicket(lineBufTicket[idx]);
+    return idx;
+}
+
+static inline uint16_t toPanelOrder(uint16_t color)
+{
+    // ILI9341 expects RGB565 big-endian on the wire
+    return (uint16_t)((color >> 8) | (color << 8));
+}
+
+// --------------------------------------------------------------
+// Low-level writes
+// --------------------------------------------------------------
 void LCD::writeCommand(uint8_t cmd)
 {
-    digitalWrite(LCD_DC_PIN, LOW);
-    digitalWrite(LCD_CS_PIN, LOW);
-    SPI.transfer(cmd);
-    digitalWrite(LCD_CS_PIN, HIGH);
+    spi_transaction_t *t = acquireDescriptor();
+    t->flags = SPI_TRANS_USE_TXDATA;
+    t->length = 8;
+    t->tx_data[0] = cmd;
+    t->user = (void *)0; // DC low
+    submit(t);
 }
 
-void LCD::writeData(uint8_t data)
+void LCD::writeData(const uint8_t *data, size_t len)
 {
-    digitalWrite(LCD_DC_PIN, HIGH);
-    digitalWrite(LCD_CS_PIN, LOW);
-    SPI.transfer(data);
-    digitalWrite(LCD_CS_PIN, HIGH);
+    // Parameters (<= 4 bytes) travel inside the descriptor, so the caller's
+    // buffer does not need to outlive the call.
+    if (len == 0 || len > 4)
+        return;
+
+    spi_transaction_t *t = acquireDescriptor();
+    t->flags = SPI_TRANS_USE_TXDATA;
+    t->length = len * 8;
+    memcpy(t->tx_data, data, len);
+    t->user = (void *)1; // DC high
+    submit(t);
 }
 
-void LCD::writeDataBuffer(const uint8_t *buf, size_t len)
+void LCD::writePixels(const uint16_t *pixels, size_t count)
 {
-    digitalWrite(LCD_DC_PIN, HIGH);
-    digitalWrite(LCD_CS_PIN, LOW);
-    for (size_t i = 0; i < len; ++i)
-        SPI.transfer(buf[i]);
-    digitalWrite(LCD_CS_PIN, HIGH);
+    // pixels must be DMA-capable, already in panel byte order, and stay
+    // untouched until the transaction completes (see lineBufTicket).
+    spi_transaction_t *t = acquireDescriptor();
+    t->length = count * 16;
+    t->tx_buffer = pixels;
+    t->user = (void *)1;
+    submit(t);
 }
 
 void LCD::setAddrWindow(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1)
 {
-    writeCommand(ILI9341_CASET);
-    writeData(x0 >> 8);
-    writeData(x0 & 0xFF);
-    writeData(x1 >> 8);
-    writeData(x1 & 0xFF);
+    const uint8_t cols[4] = {(uint8_t)(x0 >> 8), (uint8_t)(x0 & 0xFF),
+                             (uint8_t)(x1 >> 8), (uint8_t)(x1 & 0xFF)};
+    const uint8_t rows[4] = {(uint8_t)(y0 >> 8), (uint8_t)(y0 & 0xFF),
+                             (uint8_t)(y1 >> 8), (uint8_t)(y1 & 0xFF)};
 
+    writeCommand(ILI9341_CASET);
+    writeData(cols, sizeof(cols));
     writeCommand(ILI9341_PASET);
-    writeData(y0 >> 8);
-    writeData(y0 & 0xFF);
-    writeData(y1 >> 8);
-    writeData(y1 & 0xFF);
-
+    writeData(rows, sizeof(rows));
     writeCommand(ILI9341_RAMWR);
 }
 
+bool LCD::clip(int16_t &x, int16_t &y, int16_t &w, int16_t &h)
+{
+    if (!lcdSpi || w <= 0 || h <= 0)
+        return false;
+    if (x < 0)
+    {
+        w += x;
+        x = 0;
+    }
+    if (y < 0)
+    {
+        h += y;
+        y = 0;
+    }
+    if (x + w > WIDTH)
+        w = WIDTH - x;
+    if (y + h > HEIGHT)
+        h = HEIGHT - y;
+    return w > 0 && h > 0;
+}
+
+void LCD::waitIdle()
+{
+    if (!lcdSpi)
+        return;
+    while (completedCount != submittedCount)
+        reclaimOne();
+}
+
+// --------------------------------------------------------------
+// Setup
+// --------------------------------------------------------------
 void LCD::begin()
 {
-    pinMode(LCD_CS_PIN, OUTPUT);
     pinMode(LCD_DC_PIN, OUTPUT);
     pinMode(LCD_RST_PIN, OUTPUT);
     pinMode(LCD_BL_PIN, OUTPUT);
 
-    // Initialize SPI with specified pins
-    SPI.begin(LCD_SCK_PIN, LCD_MISO_PIN, LCD_MOSI_PIN, LCD_CS_PIN);
-    digitalWrite(LCD_CS_PIN, HIGH);
-
     // hardware reset
     digitalWrite(LCD_RST_PIN, HIGH);
     delay(5);
@@ -75,19 +195,76 @@ void LCD::begin()
     digitalWrite(LCD_RST_PIN, HIGH);
     delay(150);
 
+    // SPI bus with DMA. The panel is write-only here, so MISO is left unused.
+    spi_bus_config_t buscfg = {};
+    buscfg.mosi_io_num = LCD_MOSI_PIN;
+    buscfg.miso_io_num = -1;
+    buscfg.sclk_io_num = LCD_SCK_PIN;
+    buscfg.quadwp_io_num = -1;
+    buscfg.quadhd_io_num = -1;
+    buscfg.max_transfer_sz = LCD_LINE_PIXELS * sizeof(uint16_t);
+
+    esp_err_t err = spi_bus_initialize(VSPI_HOST, &buscfg, SPI_DMA_CH_AUTO);
+    if (err != ESP_OK)
+    {
+        DEBUG_PRINTF("[LCD] spi_bus_initialize failed: %d\n", err);
+        return;
+    }
+
+    spi_device_interface_config_t devcfg = {};
+    devcfg.clock_speed_hz = LCD_SPI_FREQ;
+    devcfg.mode = 0;
+    devcfg.spics_io_num = LCD_CS_PIN;
+    devcfg.queue_size = LCD_QUEUE_DEPTH;
+    devcfg.pre_cb = lcdSpiPreCallback;
+
+    err = spi_bus_add_device(VSPI_HOST, &devcfg, &lcdSpi);
+    if (err != ESP_OK)
+    {
+        DEBUG_PRINTF("[LCD] spi_bus_add_device failed: %d\n", err);
+        lcdSpi = nullptr;
+        spi_bus_free(VSPI_HOST);
+        return;
+    }
+
+    for (int i = 0; i < 2; ++i)
+    {
+        lineBuf[i] = (uint16_t *)heap_caps_malloc(LCD_LINE_PIXELS * sizeof(uint16_t), MALLOC_CAP_DMA);
+        if (!lineBuf[i])
+        {
+            DEBUG_PRINTLN("[LCD] DMA line buffer allocation failed");
+            // Undo everything so that begin() can be called again
+            for (int j = 0; j < i; ++j)
+            {
+                heap_caps_free(lineBuf[j]);
+                lineBuf[j] = nullptr;
+            }
+            spi_bus_remove_device(lcdSpi);
+            lcdSpi = nullptr;
+            spi_bus_free(VSPI_HOST);
+            return;
+        }
+    }
+
     writeCommand(ILI9341_SWRESET);
+    waitIdle();
     delay(150);
     writeCommand(ILI9341_SLPOUT);
+    waitIdle();
     delay(120);
 
+    const uint8_t colmod = 0x55; // 16-bit/pixel
     writeCommand(ILI9341_COLMOD);
-    writeData(0x55); // 16-bit/pixel
+    writeData(&colmod, 1);
+    waitIdle();
     delay(10);
 
+    const uint8_t madctl = 0x48; // RGB order, orientation
     writeCommand(ILI9341_MADCTL);
-    writeData(0x48); // RGB order, orientation
+    writeData(&madctl, 1);
 
     writeCommand(ILI9341_DISPON);
+    waitIdle();
     delay(100);
 
     // set backlight on (use LEDC PWM)
@@ -102,41 +279,119 @@ void LCD::setBacklight(uint8_t level)
     ledcWrite(0, level);
 }
 
+// --------------------------------------------------------------
+// Drawing
+// --------------------------------------------------------------
 void LCD::drawPixel(int16_t x, int16_t y, uint16_t color)
 {
+    if (!lcdSpi || x < 0 || y < 0 || x >= WIDTH || y >= HEIGHT)
+        return;
+
+    const uint8_t px[2] = {(uint8_t)(color >> 8), (uint8_t)(color & 0xFF)};
     setAddrWindow(x, y, x, y);
-    writeData(color >> 8);
-    writeData(color & 0xFF);
+    writeData(px, sizeof(px));
 }
 
-void LCD::fillScreen(uint16_t color)
+void LCD::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
 {
-    const uint16_t w = 240;
-    const uint16_t h = 320;
-    setAddrWindow(0, 0, w - 1, h - 1);
+    if (!clip(x, y, w, h))
+        return;
+
+    setAddrWindow(x, y, x + w - 1, y + h - 1);
+
+    // Repeated-color fill: paint one line buffer once and queue it as many
+    // times as needed instead of streaming every pixel through the CPU.
+    uint32_t remaining = (uint32_t)w * h;
+    const uint32_t chunk = remaining < LCD_LINE_PIXELS ? remaining : LCD_LINE_PIXELS;
+    const uint8_t idx = claimLineBuffer();
+    const uint16_t wire = toPanelOrder(color);
+    for (uint32_t i = 0; i < chunk; ++i)
+        lineBuf[idx][i] = wire;
 
-    // send pixel data
-    digitalWrite(LCD_DC_PIN, HIGH);
-    digitalWrite(LCD_CS_PIN, LOW);
-    for (uint32_t i = 0; i < (uint32_t)w * h; ++i)
+    while (remaining > 0)
     {
-        SPI.transfer(color >> 8);
-        SPI.transfer(color & 0xFF);
+        const uint32_t n = remaining < chunk ? remaining : chunk;
+        writePixels(lineBuf[idx], n);
+        remaining -= n;
     }
-    digitalWrite(LCD_CS_PIN, HIGH);
+    lineBufTicket[idx] = submittedCount;
+}
+
+void LCD::fillScreen(uint16_t color)
+{
+    fillRect(0, 0, WIDTH, HEIGHT, color);
 }
 
 void LCD::drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
 {
-    for (int16_t i = 0; i < w; ++i)
+    if (w <= 0 || h <= 0)
+        return;
+
+    fillRect(x, y, w, 1, color);
+    fillRect(x, y + h - 1, w, 1, color);
+    fillRect(x, y + 1, 1, h - 2, color);
+    fillRect(x + w - 1, y + 1, 1, h - 2, color);
+}
+
+void LCD::pushPixels(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t *pixels)
+{
+    const int16_t stride = w;
+    const int16_t srcX = x < 0 ? -x : 0;
+    const int16_t srcY = y < 0 ? -y : 0;
+    if (!pixels || !clip(x, y, w, h))
+        return;
+
+    setAddrWindow(x, y, x + w - 1, y + h - 1);
+
+    // Source pixels may live in flash or non-DMA memory, so rows are copied
+    // (and byte-swapped) into the line buffers while the other one is on the bus.
+    const int16_t rowsPerChunk = LCD_LINE_PIXELS / w;
+    for (int16_t row = 0; row < h; row += rowsPerChunk)
     {
-        drawPixel(x + i, y, color);
-        drawPixel(x + i, y + h - 1, color);
+        const int16_t rows = (h - row) < rowsPerChunk ? (h - row) : rowsPerChunk;
+        const uint8_t idx = claimLineBuffer();
+        uint16_t *dst = lineBuf[idx];
+        for (int16_t r = 0; r < rows; ++r)
+        {
+            const uint16_t *src = pixels + (int32_t)(srcY + row + r) * stride + srcX;
+            for (int16_t c = 0; c < w; ++c)
+                *dst++ = toPanelOrder(src[c]);
+        }
+        writePixels(lineBuf[idx], (size_t)rows * w);
+        lineBufTicket[idx] = submittedCount;
     }
-    for (int16_t i = 0; i < h; ++i)
+}
+
+void LCD::drawBitmap(int16_t x, int16_t y, int16_t w, int16_t h, const uint8_t *bitmap,
+                     uint16_t fg, uint16_t bg)
+{
+    const int16_t strideBytes = (w + 7) / 8;
+    const int16_t srcX = x < 0 ? -x : 0;
+    const int16_t srcY = y < 0 ? -y : 0;
+    if (!bitmap || !clip(x, y, w, h))
+        return;
+
+    setAddrWindow(x, y, x + w - 1, y + h - 1);
+
+    const uint16_t fgWire = toPanelOrder(fg);
+    const uint16_t bgWire = toPanelOrder(bg);
+    const int16_t rowsPerChunk = LCD_LINE_PIXELS / w;
+    for (int16_t row = 0; row < h; row += rowsPerChunk)
     {
-        drawPixel(x, y + i, color);
-        drawPixel(x + w - 1, y + i, color);
+        const int16_t rows = (h - row) < rowsPerChunk ? (h - row) : rowsPerChunk;
+        const uint8_t idx = claimLineBuffer();
+        uint16_t *dst = lineBuf[idx];
+        for (int16_t r = 0; r < rows; ++r)
+        {
+            const uint8_t *src = bitmap + (int32_t)(srcY + row + r) * strideBytes;
+            for (int16_t c = 0; c < w; ++c)
+            {
+                const int16_t bit = srcX + c;
+                *dst++ = (src[bit >> 3] & (0x80 >> (bit & 7))) ? fgWire : bgWire;
+            }
+        }
+        writePixels(lineBuf[idx], (size_t)rows * w);
+        lineBufTicket[idx] = submittedCount;
     }
 }
 
@@ -21,6 +21,10 @@
 #include <ArduinoJson.h>
 #include "config.h"
 #include "main.h"
+#include "cmd_latency.h"
+#ifdef HAS_LCD_240x320
+#include "lcd.h"
+#endif
 
 // Global definitions
 WebSocketsClient webSocket;
@@ -42,6 +46,37 @@ bool stateChanged = true; // emit initial status
 // Global variables and function implementations remain in this file.
 // Declarations are provided by `include/main.h`.
 
+#if defined(HAS_LCD_240x320) && defined(LCD_BENCHMARK)
+// ==================================================
+// LCD frame-time benchmark (enable with LCD_BENCHMARK in config.h)
+// ==================================================
+// The host lcd_sim_output costs the same operations on the per-byte
+// SPI.transfer() driver this one replaced, for the before numbers.
+static void lcdBenchmark()
+{
+    const int runs = 10;
+    unsigned long start;
+
+    start = micros();
+    for (int i = 0; i < runs; i++)
+        LCD::fillScreen((i & 1) ? 0x0000 : 0xFFFF);
+    LCD::waitIdle();
+    DEBUG_PRINTF("[LCD-BENCH] fillScreen 240x320: %lu us/frame\n", (micros() - start) / runs);
+
+    start = micros();
+    for (int i = 0; i < runs; i++)
+        LCD::fillRect(20, 20, 200, 100, (i & 1) ? 0x001F : 0xF800);
+    LCD::waitIdle();
+    DEBUG_PRINTF("[LCD-BENCH] fillRect 200x100: %lu us/call\n", (micros() - start) / runs);
+
+    start = micros();
+    for (int i = 0; i < runs * 10; i++)
+        LCD::fillRect(i % 200, 150, 12, 12, 0x07E0);
+    LCD::waitIdle();
+    DEBUG_PRINTF("[LCD-BENCH] fillRect 12x12: %lu us/call\n", (micros() - start) / (runs * 10));
+}
+#endif
+
 // ==================================================
 // Setup
 // ==================================================
@@ -78,6 +113,9 @@ void setup()
 #ifdef HAS_LCD_240x320
         DEBUG_PRINTLN("[LCD] Initializing...");
         LCD::begin();
+#ifdef LCD_BENCHMARK
+        lcdBenchmark();
+#endif
         LCD::fillScreen(0x07E0);                 // Green
         LCD::drawRect(10, 10, 220, 100, 0x001F); // Blue rectangle
         LCD::setBacklight(255);
@@ -108,6 +146,7 @@ void loop()
     {
         emitDevData();
         lastStatusReport = millis();
+        CMD_LATENCY_REPORT();
     }
 
     // Send status when state changed
@@ -287,6 +326,7 @@ void webSocketEvent(WStype_t type, uint8_t *payload, size_t length)
 
     case WStype_TEXT:
     {
+        CMD_STAMP(CMD_FRAME);
         char buffer[1024];
         size_t len = (length < sizeof(buffer) - 1) ? length : sizeof(buffer) - 1;
         memcpy(buffer, payload, len);
@@ -447,6 +487,7 @@ void emitDevData()
     String packet = "42[\"dev-data\"," + jsonData + "]";
 
     webSocket.sendTXT(packet);
+    CMD_STAMP(CMD_CONFIRMED);
     DEBUG_PRINTF("[DATA] Emitted: %s\n", packet.c_str());
 }
 
@@ -500,6 +541,7 @@ void processAppCmd(const String &data)
             value = operation["fieldValue"].as<int8_t>();
         }
     }
+    CMD_STAMP(CMD_PARSED);
 
     DEBUG_PRINTF("[CMD] Parsed - cmd: %s, index: %d, value: %d\n",
                  cmd.c_str(), index, value);
@@ -564,6 +606,7 @@ void setState(uint8_t index, bool state)
     {
         gpioOutputs[index].state = state;
         digitalWrite(gpioOutputs[index].pin, state ? HIGH : LOW);
+        CMD_STAMP(CMD_WRITTEN);
         stateChanged = true;
 
         DEBUG_PRINTF("[GPIO] Pin %d set to %s\n",